@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+# Simulator self-performance suite.
+#
+# Runs every selfperf.ptx workload (alu, mem, diverge, atomic) under every
+# -compress_link mode with a GPU config, and records the host time, peak
+# RSS, simulated cycles per second and KIPS (thousands of simulated
+# instructions per host second) of each run. Results are appended to a CSV
+# file tagged with the date and git commit, and compared with a stored
+# baseline: a run is a regression when its KIPS drops or its peak RSS grows
+# by more than --tolerance. The exit status is 1 on a regression or a
+# failed result check.
+#
+# usage: run_selfperf.py [--config DIR] [--workloads alu,mem] [--modes 0,1,2,3]
+#                        [--scale N] [--results FILE] [--baseline FILE]
+#                        [--update-baseline] [--tolerance 0.10] [--option "-opt value"]...
+# (needs a built simulator and setup_environment; make -C benchmarks/selfperf run)
+#
+# No baseline.json is shipped: the numbers depend on the host, so store one
+# with make baseline on the machine that runs the suite.
+#
+# The runs share -gpgpu_ptx_cache_dir <work dir>/ptx_cache, so only the
+# first run after a change of selfperf.ptx or of the toolkit calls ptxas.
+
+import argparse
+import csv
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.environ.get('GPGPUSIM_ROOT', os.path.abspath(os.path.join(HERE, '..', '..')))
+WORKLOADS = ['alu', 'mem', 'diverge', 'atomic']
+MODES = ['0', '1', '2', '3']    # uncompressed, packed, unpacked, C-pack
+
+RESULT_FIELDS = ['date', 'commit', 'config', 'workload', 'compress_link', 'host_seconds',
+                 'sim_cycles', 'sim_insn', 'cycles_per_sec', 'kips', 'peak_rss_mb', 'check']
+
+
+def git_commit():
+    try:
+        return subprocess.check_output(['git', '-C', ROOT, 'rev-parse', '--short', 'HEAD'],
+                                       stderr=subprocess.DEVNULL).decode().strip()
+    except (OSError, subprocess.CalledProcessError):
+        return 'unknown'
+
+
+def run_one(args, workload, mode):
+    run_dir = os.path.join(args.work_dir, '%s_c%s' % (workload, mode))
+    if os.path.isdir(run_dir):
+        shutil.rmtree(run_dir)
+    shutil.copytree(args.config, run_dir)
+    with open(os.path.join(run_dir, 'gpgpusim.config'), 'a') as f:
+        f.write('\n# run_selfperf.py\n')
+        f.write('-gpgpu_ptx_use_cuobjdump 0\n')
+        f.write('-compress_link %s\n' % mode)
+        f.write('-gpgpu_stats_json stats.json\n')
+        f.write('-gpgpu_ptx_cache_dir %s\n' % os.path.abspath(os.path.join(args.work_dir, 'ptx_cache')))
+        for opt in args.option:
+            f.write(opt + '\n')
+
+    env = dict(os.environ)
+    lib_dir = os.path.join(ROOT, 'lib', os.environ.get('GPGPUSIM_CONFIG', ''))
+    env['LD_LIBRARY_PATH'] = lib_dir + ':' + env.get('LD_LIBRARY_PATH', '')
+    cmd = [os.path.join(HERE, 'selfperf'), os.path.join(HERE, 'selfperf.ptx'), workload, str(args.scale)]
+    start = time.time()
+    with open(os.path.join(run_dir, 'selfperf.out'), 'w') as out:
+        status = subprocess.call(cmd, cwd=run_dir, env=env, stdout=out, stderr=subprocess.STDOUT)
+    wall = time.time() - start
+
+    r = {'workload': workload, 'compress_link': mode, 'host_seconds': wall, 'peak_rss_mb': 0.0,
+         'sim_cycles': 0, 'sim_insn': 0, 'check': 'FAILED'}
+    with open(os.path.join(run_dir, 'selfperf.out')) as out:
+        for line in out:
+            m = re.match(r'selfperf: workload \S+ check (\S+) host_seconds (\S+) peak_rss_kb (\d+)', line)
+            if m:
+                r['check'] = m.group(1)
+                r['host_seconds'] = float(m.group(2))
+                r['peak_rss_mb'] = int(m.group(3)) / 1024.0
+    if status != 0 and r['check'] == 'ok':
+        r['check'] = 'FAILED'
+    try:
+        with open(os.path.join(run_dir, 'stats.json')) as f:
+            last = json.loads(f.readlines()[-1])   # JSON Lines, one object per kernel end
+        r['sim_cycles'] = int(last['cycle'])
+        r['sim_insn'] = int(last['stats']['gpu_tot_sim_insn'] + last['stats']['gpu_sim_insn'])
+    except (OSError, ValueError, IndexError, KeyError):
+        r['check'] = 'FAILED'
+    secs = max(r['host_seconds'], 1e-9)
+    r['cycles_per_sec'] = r['sim_cycles'] / secs
+    r['kips'] = r['sim_insn'] / secs / 1000.0
+    return r
+
+
+def main():
+    p = argparse.ArgumentParser(description='GPGPU-Sim self-performance suite')
+    p.add_argument('--config', default=os.path.join(ROOT, 'configs', 'GTX480'),
+                   help='directory with gpgpusim.config and its interconnect config')
+    p.add_argument('--workloads', default=','.join(WORKLOADS))
+    p.add_argument('--modes', default=','.join(MODES), help='-compress_link modes')
+    p.add_argument('--scale', type=int, default=1, help='problem size multiplier')
+    p.add_argument('--work-dir', default=os.path.join(HERE, 'runs'))
+    p.add_argument('--results', default=os.path.join(HERE, 'results.csv'))
+    p.add_argument('--baseline', default=os.path.join(HERE, 'baseline.json'), help='none = no comparison')
+    p.add_argument('--option', action='append', default=[],
+                   help='extra gpgpusim.config line, e.g. "-gpgpu_l2_prefetcher stride" (repeatable)')
+    p.add_argument('--update-baseline', action='store_true', help='store this run as the baseline')
+    p.add_argument('--tolerance', type=float, default=0.10, help='allowed relative KIPS drop / RSS growth')
+    args = p.parse_args()
+
+    results = []
+    for workload in args.workloads.split(','):
+        if workload not in WORKLOADS:
+            sys.exit('unknown workload %s' % workload)
+        for mode in args.modes.split(','):
+            r = run_one(args, workload, mode)
+            results.append(r)
+            print('%-8s compress_link %s  %8.2f s  %10d cycles  %9.1f cycles/s  %8.2f KIPS  %7.1f MB  %s'
+                  % (workload, mode, r['host_seconds'], r['sim_cycles'], r['cycles_per_sec'],
+                     r['kips'], r['peak_rss_mb'], r['check']))
+            sys.stdout.flush()
+
+    new_file = not os.path.exists(args.results)
+    date = time.strftime('%Y-%m-%d %H:%M:%S')
+    commit = git_commit()
+    with open(args.results, 'a') as f:
+        w = csv.DictWriter(f, fieldnames=RESULT_FIELDS)
+        if new_file:
+            w.writeheader()
+        for r in results:
+            row = dict(r, date=date, commit=commit, config=os.path.basename(os.path.normpath(args.config)))
+            w.writerow(row)
+    print('results appended to %s' % args.results)
+
+    failed = any(r['check'] != 'ok' for r in results)
+    regressed = False
+    if args.update_baseline:
+        baseline = {}
+        if os.path.exists(args.baseline):
+            with open(args.baseline) as f:
+                baseline = json.load(f)
+        for r in results:
+            if r['check'] == 'ok':
+                baseline['%s/%s' % (r['workload'], r['compress_link'])] = {
+                    'kips': r['kips'], 'cycles_per_sec': r['cycles_per_sec'],
+                    'peak_rss_mb': r['peak_rss_mb'], 'commit': commit}
+        with open(args.baseline, 'w') as f:
+            json.dump(baseline, f, indent=1, sort_keys=True)
+        print('baseline written to %s' % args.baseline)
+    elif args.baseline != 'none' and os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        print('%-8s %-13s %10s %10s %8s %9s %9s %8s' % ('workload', 'compress_link', 'KIPS', 'base', 'delta',
+                                                        'RSS MB', 'base', 'delta'))
+        for r in results:
+            b = baseline.get('%s/%s' % (r['workload'], r['compress_link']))
+            if b is None or r['check'] != 'ok':
+                continue
+            dk = r['kips'] / b['kips'] - 1 if b['kips'] else 0.0
+            dr = r['peak_rss_mb'] / b['peak_rss_mb'] - 1 if b['peak_rss_mb'] else 0.0
+            bad = dk < -args.tolerance or dr > args.tolerance
+            regressed = regressed or bad
+            print('%-8s %-13s %10.2f %10.2f %+7.1f%% %9.1f %9.1f %+7.1f%%%s'
+                  % (r['workload'], r['compress_link'], r['kips'], b['kips'], 100 * dk,
+                     r['peak_rss_mb'], b['peak_rss_mb'], 100 * dr, '  REGRESSION' if bad else ''))
+    elif args.baseline != 'none':
+        print('no baseline at %s (store one with --update-baseline)' % args.baseline)
+
+    if failed:
+        print('result check FAILED, see %s/*/selfperf.out' % args.work_dir)
+    sys.exit(1 if failed or regressed else 0)
+
+
+if __name__ == '__main__':
+    main()
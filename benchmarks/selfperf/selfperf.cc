@@ -0,0 +1,261 @@
+// Host program of the simulator self-performance suite (run_selfperf.py).
+//
+// Runs one of the kernels of selfperf.ptx on the simulated GPU. The PTX is
+// handed to GPGPU-Sim as a version 3 fat binary, so neither nvcc nor the
+// CUDA headers are needed to build it; the simulator config must set
+// -gpgpu_ptx_use_cuobjdump 0. At exit it checks the results and prints the
+// host time and peak RSS of the whole run:
+//   selfperf: workload <name> check <ok|FAILED> host_seconds <s> peak_rss_kb <kb>
+//
+// build: g++ -O2 -o selfperf selfperf.cc -L$GPGPUSIM_ROOT/lib/$GPGPUSIM_CONFIG -lcudart
+// usage: selfperf <selfperf.ptx> <alu|mem|diverge|atomic> [scale]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <vector>
+
+// the parts of the CUDA runtime API this program calls (libcuda/cuda_runtime_api.cc)
+struct dim3 {
+   unsigned x, y, z;
+};
+typedef int cudaError_t;
+enum cudaMemcpyKind { cudaMemcpyHostToHost = 0, cudaMemcpyHostToDevice, cudaMemcpyDeviceToHost };
+
+// fat binary layout of CUDA 3.x (__cudaFatFormat.h), only the PTX entries are used
+struct fat_ptx_entry {
+   const char *gpuProfileName;
+   const char *ptx;
+};
+struct fat_binary {
+   unsigned long magic;
+   unsigned long version;
+   unsigned long gpuInfoVersion;
+   const char *key;
+   const char *ident;
+   const char *usageMode;
+   fat_ptx_entry *ptx;
+   void *cubin;
+   void *debug;
+   void *debugInfo;
+   unsigned int flags;
+   void *exported;
+   void *imported;
+   void *dependends;
+   unsigned int characteristic;
+   void *elf;
+};
+
+extern "C" {
+cudaError_t cudaMalloc( void **devPtr, size_t size );
+cudaError_t cudaMemcpy( void *dst, const void *src, size_t count, enum cudaMemcpyKind kind );
+cudaError_t cudaMemset( void *devPtr, int value, size_t count );
+cudaError_t cudaConfigureCall( dim3 gridDim, dim3 blockDim, size_t sharedMem, void *stream );
+cudaError_t cudaSetupArgument( const void *arg, size_t size, size_t offset );
+cudaError_t cudaLaunch( const char *hostFun );
+cudaError_t cudaThreadSynchronize( void );
+void **__cudaRegisterFatBinary( void *fatCubin );
+void __cudaRegisterFunction( void **fatCubinHandle, const char *hostFun, char *deviceFun, const char *deviceName,
+                             int thread_limit, void *tid, void *bid, dim3 *bDim, dim3 *gDim );
+}
+
+enum workload_t { ALU = 0, MEM, DIVERGE, ATOMIC, N_WORKLOAD };
+static const char *workload_name[N_WORKLOAD] = { "alu", "mem", "diverge", "atomic" };
+static char host_fun[N_WORKLOAD];   // kernel handles, only their addresses matter
+
+static const unsigned CTA_SIZE = 256;
+
+static char *read_file( const char *name )
+{
+   FILE *f = fopen(name, "r");
+   if( f == NULL ) {
+      fprintf(stderr, "selfperf: cannot open %s\n", name);
+      exit(1);
+   }
+   fseek(f, 0, SEEK_END);
+   long size = ftell(f);
+   fseek(f, 0, SEEK_SET);
+   char *buf = (char*)malloc(size + 1);
+   if( fread(buf, 1, size, f) != (size_t)size ) {
+      fprintf(stderr, "selfperf: cannot read %s\n", name);
+      exit(1);
+   }
+   buf[size] = 0;
+   fclose(f);
+   return buf;
+}
+
+static void register_kernels( const char *ptx )
+{
+   static fat_ptx_entry entries[2] = { { "compute_20", NULL }, { NULL, NULL } };
+   static fat_binary bin;
+   entries[0].ptx = ptx;
+   memset(&bin, 0, sizeof(bin));
+   bin.magic = 0x1ee55a01;
+   bin.version = 3;
+   bin.ident = "selfperf.ptx";
+   bin.ptx = entries;
+   void **handle = __cudaRegisterFatBinary(&bin);
+   for( unsigned w=0; w < N_WORKLOAD; w++ ) {
+      char name[64];
+      snprintf(name, sizeof(name), "selfperf_%s", workload_name[w]);
+      __cudaRegisterFunction(handle, &host_fun[w], name, name, -1, NULL, NULL, NULL, NULL);
+   }
+}
+
+// arguments are packed at their natural alignment, as nvcc does
+struct arg_list {
+   size_t offset;
+   arg_list() : offset(0) {}
+   template<class T> void push( T v )
+   {
+      offset = (offset + sizeof(T) - 1) / sizeof(T) * sizeof(T);
+      cudaSetupArgument(&v, sizeof(T), offset);
+      offset += sizeof(T);
+   }
+};
+
+static void configure( unsigned n_cta )
+{
+   dim3 grid = { n_cta, 1, 1 };
+   dim3 block = { CTA_SIZE, 1, 1 };
+   cudaConfigureCall(grid, block, 0, NULL);
+}
+
+static double now()
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+int main( int argc, char **argv )
+{
+   if( argc < 3 ) {
+      fprintf(stderr, "usage: selfperf <selfperf.ptx> <alu|mem|diverge|atomic> [scale]\n");
+      return 1;
+   }
+   double start = now();
+   unsigned w = 0;
+   while( w < N_WORKLOAD && strcmp(argv[2], workload_name[w]) )
+      w++;
+   if( w == N_WORKLOAD ) {
+      fprintf(stderr, "selfperf: unknown workload %s\n", argv[2]);
+      return 1;
+   }
+   unsigned scale = (argc > 3)? strtoul(argv[3], NULL, 0) : 1;
+   register_kernels(read_file(argv[1]));
+
+   bool ok = true;
+   unsigned n_cta = 60 * scale;
+   unsigned n_thread = n_cta * CTA_SIZE;
+   switch( w ) {
+   case ALU: {
+      unsigned iters = 64;
+      void *d_out;
+      cudaMalloc(&d_out, n_thread * sizeof(float));
+      configure(n_cta);
+      arg_list args;
+      args.push(d_out);
+      args.push(iters);
+      cudaLaunch(&host_fun[ALU]);
+      cudaThreadSynchronize();
+      std::vector<float> out(n_thread);
+      cudaMemcpy(&out[0], d_out, n_thread * sizeof(float), cudaMemcpyDeviceToHost);
+      for( unsigned i=0; i < n_thread; i += 997 ) {
+         float a = (float)i, b = 1.0f;
+         for( unsigned k=0; k < iters; k++ ) {
+            a = fmaf(a, 0.5f, b);
+            b = fmaf(b, 0.5f, a);
+         }
+         ok = ok && out[i] == a + b;
+      }
+      break;
+   }
+   case MEM: {
+      // a mix of zeros, small and repeated values so the link compressors have work
+      unsigned n = 1024 * 1024 * scale, passes = 2;
+      std::vector<unsigned> in(n);
+      for( unsigned i=0; i < n; i++ ) {
+         switch( (i / 32) % 4 ) {
+         case 0:  in[i] = 0; break;
+         case 1:  in[i] = i & 0xff; break;
+         case 2:  in[i] = 0x01010101 * (i % 7); break;
+         default: in[i] = i * 2654435761u; break;
+         }
+      }
+      void *d_in, *d_out;
+      cudaMalloc(&d_in, n * sizeof(unsigned));
+      cudaMalloc(&d_out, n * sizeof(unsigned));
+      cudaMemcpy(d_in, &in[0], n * sizeof(unsigned), cudaMemcpyHostToDevice);
+      configure(n_cta);
+      arg_list args;
+      args.push(d_in);
+      args.push(d_out);
+      args.push(n);
+      args.push(passes);
+      cudaLaunch(&host_fun[MEM]);
+      cudaThreadSynchronize();
+      std::vector<unsigned> out(n);
+      cudaMemcpy(&out[0], d_out, n * sizeof(unsigned), cudaMemcpyDeviceToHost);
+      for( unsigned i=0; i < n; i += 101 )
+         ok = ok && out[i] == in[i] * 3 + 1;
+      break;
+   }
+   case DIVERGE: {
+      unsigned iters = 16;
+      void *d_out;
+      cudaMalloc(&d_out, n_thread * sizeof(unsigned));
+      configure(n_cta);
+      arg_list args;
+      args.push(d_out);
+      args.push(iters);
+      cudaLaunch(&host_fun[DIVERGE]);
+      cudaThreadSynchronize();
+      std::vector<unsigned> out(n_thread);
+      cudaMemcpy(&out[0], d_out, n_thread * sizeof(unsigned), cudaMemcpyDeviceToHost);
+      for( unsigned i=0; i < n_thread; i += 997 ) {
+         unsigned lane = i % CTA_SIZE, v = i;
+         for( unsigned k=0; k < iters * (1 + lane % 8); k++ ) {
+            if( lane & 1 ) {
+               v = v * 1664525 + 1013904223;
+            } else {
+               unsigned x = v ^ k;
+               v = (x << 5) + x;
+            }
+         }
+         ok = ok && out[i] == v;
+      }
+      break;
+   }
+   case ATOMIC: {
+      unsigned nbins = 64, iters = 16;
+      void *d_bins;
+      cudaMalloc(&d_bins, nbins * sizeof(unsigned));
+      cudaMemset(d_bins, 0, nbins * sizeof(unsigned));
+      configure(n_cta);
+      arg_list args;
+      args.push(d_bins);
+      args.push(nbins);
+      args.push(iters);
+      cudaLaunch(&host_fun[ATOMIC]);
+      cudaThreadSynchronize();
+      std::vector<unsigned> bins(nbins);
+      cudaMemcpy(&bins[0], d_bins, nbins * sizeof(unsigned), cudaMemcpyDeviceToHost);
+      unsigned long long total = 0;
+      for( unsigned b=0; b < nbins; b++ )
+         total += bins[b];
+      ok = total == (unsigned long long)n_thread * iters;
+      break;
+   }
+   }
+
+   struct rusage ru;
+   getrusage(RUSAGE_SELF, &ru);
+   printf("selfperf: workload %s check %s host_seconds %.3f peak_rss_kb %ld\n",
+          workload_name[w], ok? "ok" : "FAILED", now() - start, ru.ru_maxrss);
+   return ok? 0 : 2;
+}
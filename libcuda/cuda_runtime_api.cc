@@ -1309,19 +1309,28 @@ void extract_code_using_cuobjdump(){
    std::string app_binary = get_app_binary(); 
 
 	char fname[1024];
-	snprintf(fname,1024,"_cuobjdump_complete_output_XXXXXX");
-	int fd=mkstemp(fname);
-	close(fd);
-	// Running cuobjdump using dynamic link to current process
-	snprintf(command,1000,"md5sum %s ", app_binary.c_str());
-	printf("Running md5sum using \"%s\"\n", command);
-	system(command);
-	// Running cuobjdump using dynamic link to current process
-	snprintf(command,1000,"$GPGPUSIM_ROOT/bin/cuobjdump-shim -ptx -elf -sass %s > %s", app_binary.c_str(), fname);
-
-	printf("Running cuobjdump using \"%s\"\n", command);
+	// the output only depends on the binary and the cuobjdump used, so an
+	// earlier run may have kept it
+	std::string cache_file;
+	if (ptx_cache_enabled())
+		cache_file = ptx_cache_file_of("cuobjdump", "cuobjdump", app_binary.c_str());
 	bool parse_output = true; 
-	int result = system(command);
+	int result = 0;
+	if (ptx_cache_lookup(cache_file)) {
+		snprintf(fname,1024,"%s",cache_file.c_str());
+		printf("Using cached cuobjdump output \"%s\"\n", fname);
+	} else {
+		snprintf(fname,1024,"_cuobjdump_complete_output_XXXXXX");
+		int fd=mkstemp(fname);
+		close(fd);
+		// Running cuobjdump using dynamic link to current process
+		snprintf(command,1000,"$GPGPUSIM_ROOT/bin/cuobjdump-shim -ptx -elf -sass %s > %s", app_binary.c_str(), fname);
+
+		printf("Running cuobjdump using \"%s\"\n", command);
+		result = system(command);
+		if (!result && !cache_file.empty())
+			ptx_cache_store(fname, cache_file);
+	}
 	if(result) {
 		if (context->get_device()->get_gpgpu()->get_config().experimental_lib_support() && (result == 65280)) {  
 			// Some CUDA application may exclusively use kernels provided by CUDA
@@ -555,6 +555,7 @@ unsigned kernel_info_t::m_next_uid = 1;
 
 kernel_info_t::kernel_info_t( dim3 gridDim, dim3 blockDim, class function_info *entry )
 {
+    entry->ptx_analyze(); // reconvergence points of a kernel are found on its first launch
     m_kernel_entry=entry;
     m_grid_dim=gridDim;
     m_block_dim=blockDim;
@@ -33,6 +33,8 @@
 #include "ptx.tab.h"
 #include "ptx_sim.h"
 #include <stdio.h>
+#include <time.h>
+#include <pthread.h>
 
 #include "opcodes.h"
 #include "../statwrapper.h"
@@ -180,11 +182,21 @@ std::vector<ptx_instruction*> function_info::s_g_pc_to_insn;
 
 #define MAX_INST_SIZE 8 /*bytes*/
 
+double g_ptx_assemble_time = 0;
+
+double ptx_wall_time()
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
 void function_info::ptx_assemble()
 {
    if( m_assembled ) {
       return;
    }
+   double start = ptx_wall_time();
 
    // get the instructions into instruction memory...
    unsigned num_inst = m_instructions.size();
@@ -244,6 +256,27 @@ void function_info::ptx_assemble()
 
    printf("  done.\n");
    fflush(stdout);
+
+   m_assembled = true;
+   g_ptx_assemble_time += ptx_wall_time() - start;
+}
+
+static pthread_mutex_t g_ptx_analyze_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+void function_info::ptx_analyze()
+{
+   pthread_mutex_lock(&g_ptx_analyze_mutex);
+   analyze_locked();
+   pthread_mutex_unlock(&g_ptx_analyze_mutex);
+}
+
+void function_info::analyze_locked()
+{
+   if( m_analyzed || !m_assembled ) {
+      return;
+   }
+   m_analyzed = true; // before the callees, which may call back
+   double start = ptx_wall_time();
    printf("GPGPU-Sim PTX: finding reconvergence points for \'%s\'...\n", m_name.c_str() );
 
    create_basic_blocks();
@@ -271,14 +304,23 @@ void function_info::ptx_assemble()
    }
 
    printf("GPGPU-Sim PTX: pre-decoding instructions for \'%s\'...\n", m_name.c_str() );
-   for ( unsigned ii=0; ii < n; ii += m_instr_mem[ii]->inst_size() ) { // handle branch instructions
-      ptx_instruction *pI = m_instr_mem[ii];
-      pI->pre_decode();
+   std::list<ptx_instruction*>::iterator i;
+   for ( i=m_instructions.begin(); i != m_instructions.end(); i++ ) {
+      if ( !(*i)->is_label() ) 
+         (*i)->pre_decode();
    }
-   printf("GPGPU-Sim PTX: ... done pre-decoding instructions for \'%s\'.\n", m_name.c_str() );
+   printf("GPGPU-Sim PTX: ... done pre-decoding instructions for \'%s\' (analysis %.3f s).\n", 
+          m_name.c_str(), ptx_wall_time() - start );
    fflush(stdout);
 
-   m_assembled = true;
+   // device functions called from here run as part of the same launch
+   for ( i=m_instructions.begin(); i != m_instructions.end(); i++ ) {
+      if ( (*i)->get_opcode() == CALL_OP ) {
+         function_info *target = (*i)->func_addr().get_symbol()->get_pc();
+         if ( target ) 
+            target->analyze_locked();
+      }
+   }
 }
 
 addr_t shared_to_generic( unsigned smid, addr_t addr )
@@ -1846,6 +1888,7 @@ void functionalCoreSim::executeWarp(unsigned i, bool &allAtBarrier, bool & someO
     if(!m_warpAtBarrier[i] && m_liveThreadCount[i]!=0){
         warp_inst_t inst =getExecuteWarp(i);
         execute_warp_inst_t(inst,i);
+        if(m_gpu->get_sampler()->fast_forwarding()) m_gpu->get_sampler()->functional_insn(inst);
         if(inst.isatomic()) inst.do_atomic(true);
         if(inst.op==BARRIER_OP || inst.op==MEMORY_BARRIER_OP ) m_warpAtBarrier[i]=true;
         updateSIMTStack( i, &inst );
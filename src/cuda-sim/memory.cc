@@ -27,6 +27,7 @@
 
 #include "memory.h"
 #include <stdlib.h>
+#include <algorithm>
 #include "../debug.h"
 
 template<unsigned BSIZE> memory_space_impl<BSIZE>::memory_space_impl( std::string name, unsigned hash_size )
@@ -153,6 +154,52 @@ template<unsigned BSIZE> void memory_space_impl<BSIZE>::set_watch( addr_t addr,
    m_watchpoints[watchpoint]=addr;
 }
 
+template<unsigned BSIZE> void memory_space_impl<BSIZE>::save( FILE *fout ) const
+{
+   // layout: block size, page count, then {page index, BSIZE bytes} per page
+   unsigned bsize = BSIZE;
+   unsigned long long n_pages = m_data.size();
+   fwrite(&bsize, sizeof(bsize), 1, fout);
+   fwrite(&n_pages, sizeof(n_pages), 1, fout);
+   unsigned char buffer[BSIZE];
+   typename map_t::const_iterator i_page;
+   for (i_page = m_data.begin(); i_page != m_data.end(); ++i_page) {
+      mem_addr_t page = i_page->first;
+      i_page->second.read(0, BSIZE, buffer);
+      fwrite(&page, sizeof(page), 1, fout);
+      fwrite(buffer, BSIZE, 1, fout);
+   }
+}
+
+template<unsigned BSIZE> bool memory_space_impl<BSIZE>::load( FILE *fin )
+{
+   unsigned bsize = 0;
+   unsigned long long n_pages = 0;
+   if( fread(&bsize, sizeof(bsize), 1, fin) != 1 || bsize != BSIZE ) 
+      return false;
+   if( fread(&n_pages, sizeof(n_pages), 1, fin) != 1 ) 
+      return false;
+   m_data.clear();
+   unsigned char buffer[BSIZE];
+   for( unsigned long long n=0; n < n_pages; n++ ) {
+      mem_addr_t page;
+      if( fread(&page, sizeof(page), 1, fin) != 1 || fread(buffer, BSIZE, 1, fin) != 1 ) 
+         return false;
+      m_data[page].write(0, BSIZE, buffer);
+   }
+   return true;
+}
+
+template<unsigned BSIZE> void memory_space_impl<BSIZE>::get_pages( std::vector<mem_addr_t> &pages ) const
+{
+   pages.clear();
+   pages.reserve(m_data.size());
+   typename map_t::const_iterator i_page;
+   for (i_page = m_data.begin(); i_page != m_data.end(); ++i_page) 
+      pages.push_back(i_page->first);
+   std::sort(pages.begin(), pages.end());
+}
+
 template class memory_space_impl<32>;
 template class memory_space_impl<64>;
 template class memory_space_impl<8192>;
@@ -43,6 +43,7 @@
 #include <stdio.h>
 #include <string>
 #include <map>
+#include <vector>
 #include <stdlib.h>
 
 typedef address_type mem_addr_t;
@@ -107,6 +108,13 @@ public:
    virtual void read( mem_addr_t addr, size_t length, void *data ) const = 0;
    virtual void print( const char *format, FILE *fout ) const = 0;
    virtual void set_watch( addr_t addr, unsigned watchpoint ) = 0;
+   // binary dump/restore of all allocated pages (simulation checkpoints)
+   virtual void save( FILE *fout ) const = 0;
+   virtual bool load( FILE *fin ) = 0;
+   // page enumeration (kernel memory snapshots)
+   virtual unsigned get_page_size() const = 0;
+   virtual void get_pages( std::vector<mem_addr_t> &pages ) const = 0;
+   virtual void clear() = 0;
 };
 
 template<unsigned BSIZE> class memory_space_impl : public memory_space {
@@ -117,6 +125,11 @@ public:
    virtual void read( mem_addr_t addr, size_t length, void *data ) const;
    virtual void print( const char *format, FILE *fout ) const;
    virtual void set_watch( addr_t addr, unsigned watchpoint ); 
+   virtual void save( FILE *fout ) const;
+   virtual bool load( FILE *fin );
+   virtual unsigned get_page_size() const { return BSIZE; }
+   virtual void get_pages( std::vector<mem_addr_t> &pages ) const;
+   virtual void clear() { m_data.clear(); }
 
 private:
    void read_single_block( mem_addr_t blk_idx, mem_addr_t addr, size_t length, void *data) const; 
@@ -1174,7 +1174,11 @@ public:
 
    unsigned get_function_size() { return m_instructions.size();}
 
+   // ptx_assemble() lays out the instructions at load time; ptx_analyze()
+   // finds reconvergence points and pre-decodes on the first launch of a
+   // kernel, for the kernel and the functions it calls (thread safe, once)
    void ptx_assemble();
+   void ptx_analyze();
  
    unsigned ptx_get_inst_op( ptx_thread_info *thread );
    void add_param( const char *name, struct param_t value )
@@ -1274,6 +1278,7 @@ private:
    bool m_entry_point;
    bool m_extern;
    bool m_assembled;
+   bool m_analyzed;
    std::string m_name;
    ptx_instruction **m_instr_mem;
    unsigned m_start_PC;
@@ -1293,6 +1298,8 @@ private:
 
    symbol_table *m_symtab;
 
+   void analyze_locked();
+
    static std::vector<ptx_instruction*> s_g_pc_to_insn; // a direct mapping from PC to instruction
    static unsigned sm_next_uid;
 };
@@ -1439,6 +1446,8 @@ extern std::map<std::string,symbol_table*> g_sym_name_to_symbol_table;
 extern bool g_keep_intermediate_files;
 
 void gpgpu_ptx_assemble( std::string kname, void *kinfo );
+extern double g_ptx_assemble_time; // seconds spent in ptx_assemble() so far
+double ptx_wall_time();
 #include "../option_parser.h"
 void ptx_reg_options(option_parser_t opp);
 unsigned ptx_kernel_shmem_size( void *kernel_impl );
@@ -31,7 +31,9 @@
 #include "ptx_parser.h"
 #include <unistd.h>
 #include <dirent.h>
+#include <sys/stat.h>
 #include <fstream>
+#include <map>
 
 /// globals
 
@@ -52,6 +54,7 @@ extern int ptxinfo_debug;
 extern FILE *ptxinfo_in;
 
 static bool g_save_embedded_ptx;
+static char *g_ptx_cache_dir;
 bool g_keep_intermediate_files;
 bool m_ptx_save_converted_ptxplus;
 
@@ -69,6 +72,118 @@ void ptx_reg_options(option_parser_t opp)
                 &m_ptx_save_converted_ptxplus,
                 "Saved converted ptxplus to a file",
                 "0");
+   option_parser_register(opp, "-gpgpu_ptx_cache_dir", OPT_CSTR, &g_ptx_cache_dir,
+                "directory keeping cuobjdump output and ptxinfo between runs, keyed by a hash of the binary/PTX (empty = off)",
+                "");
+}
+
+bool ptx_cache_enabled() { return g_ptx_cache_dir && g_ptx_cache_dir[0]; }
+
+// 64-bit FNV-1a
+static unsigned long long ptx_cache_hash( unsigned long long h, const char *data, size_t len )
+{
+   for( size_t i=0; i < len; i++ ) {
+      h ^= (unsigned char)data[i];
+      h *= 0x100000001b3ULL;
+   }
+   return h;
+}
+
+// hashes the contents of a file into h, false if it cannot be read
+static bool ptx_cache_hash_file( unsigned long long &h, unsigned long long &len, const char *filename )
+{
+   FILE *fp = fopen(filename,"r");
+   if( !fp ) 
+      return false;
+   char buf[65536];
+   size_t n;
+   while( (n = fread(buf,1,sizeof(buf),fp)) > 0 ) {
+      h = ptx_cache_hash(h,buf,n);
+      len += n;
+   }
+   fclose(fp);
+   return true;
+}
+
+// hash of the tool that produces an entry: the shim in $GPGPUSIM_ROOT/bin,
+// the CUDA binary it runs and whether the shim filters its output, so that
+// a different toolkit never sees the entries of another
+static unsigned long long ptx_cache_tool_hash( const char *tool )
+{
+   static std::map<std::string,unsigned long long> tool_hash;
+   std::map<std::string,unsigned long long>::iterator t = tool_hash.find(tool);
+   if( t != tool_hash.end() ) 
+      return t->second;
+   const char *gpgpusim_root = getenv("GPGPUSIM_ROOT");
+   const char *cuda_path = getenv("CUDA_INSTALL_PATH");
+   const char *disable_shim = getenv("DISABLE_SHIM");
+   std::string files[2] = {
+      std::string(gpgpusim_root? gpgpusim_root : "") + "/bin/" + tool + "-shim",
+      std::string(cuda_path? cuda_path : "") + "/bin/" + tool
+   };
+   unsigned long long h = 0xcbf29ce484222325ULL;
+   for( unsigned i=0; i < 2; i++ ) {
+      unsigned long long len = 0;
+      if( !ptx_cache_hash_file(h,len,files[i].c_str()) ) 
+         h = ptx_cache_hash(h,files[i].c_str(),files[i].size()+1);
+   }
+   std::string shim = std::string("DISABLE_SHIM=") + (disable_shim? disable_shim : "");
+   h = ptx_cache_hash(h,shim.c_str(),shim.size());
+   tool_hash[tool] = h;
+   return h;
+}
+
+static std::string ptx_cache_name( const char *kind, const char *tool, unsigned long long h, unsigned long long len )
+{
+   char buf[128];
+   snprintf(buf,128,"/%s_%016llx_%016llx_%llu",kind,ptx_cache_tool_hash(tool),h,len);
+   return std::string(g_ptx_cache_dir) + buf;
+}
+
+std::string ptx_cache_file( const char *kind, const char *tool, const char *data )
+{
+   size_t len = strlen(data);
+   return ptx_cache_name(kind,tool,ptx_cache_hash(0xcbf29ce484222325ULL,data,len),len);
+}
+
+std::string ptx_cache_file_of( const char *kind, const char *tool, const char *filename )
+{
+   unsigned long long h = 0xcbf29ce484222325ULL;
+   unsigned long long len = 0;
+   if( !ptx_cache_hash_file(h,len,filename) ) 
+      return std::string();
+   return ptx_cache_name(kind,tool,h,len);
+}
+
+bool ptx_cache_lookup( const std::string &cache_file )
+{
+   return !cache_file.empty() && access(cache_file.c_str(),R_OK) == 0;
+}
+
+void ptx_cache_store( const char *filename, const std::string &cache_file )
+{
+   // written under a temporary name and renamed, so that a run sharing the
+   // directory never sees a partial file
+   mkdir(g_ptx_cache_dir,0777);
+   std::vector<char> tmp(cache_file.begin(),cache_file.end());
+   const char suffix[] = ".XXXXXX";
+   tmp.insert(tmp.end(),suffix,suffix+sizeof(suffix));
+   int fd = mkstemp(&tmp[0]);
+   FILE *in = fopen(filename,"r");
+   FILE *out = (fd >= 0)? fdopen(fd,"w") : NULL;
+   bool ok = in && out;
+   char buf[65536];
+   size_t n;
+   while( ok && (n = fread(buf,1,sizeof(buf),in)) > 0 ) 
+      ok = fwrite(buf,1,n,out) == n;
+   if( in ) fclose(in);
+   if( out && fclose(out) ) ok = false;
+   if( ok && rename(&tmp[0],cache_file.c_str()) == 0 ) {
+      printf("GPGPU-Sim PTX: cached %s as %s\n", filename, cache_file.c_str());
+   } else {
+      printf("GPGPU-Sim PTX: WARNING -- could not write %s to the cache\n", filename);
+      if( fd >= 0 ) unlink(&tmp[0]);
+   }
 }
 
 void print_ptx_file( const char *p, unsigned source_num, const char *filename )
@@ -159,6 +274,8 @@ symbol_table *gpgpu_ptx_sim_load_ptx_from_string( const char *p, unsigned source
        fprintf(fp,"%s",p);
        fclose(fp);
     }
+    double start = ptx_wall_time();
+    double assemble_start = g_ptx_assemble_time;
     symbol_table *symtab=init_parser(buf);
     ptx__scan_string(p);
     int errors = ptx_parse ();
@@ -179,11 +296,34 @@ symbol_table *gpgpu_ptx_sim_load_ptx_from_string( const char *p, unsigned source
        print_ptx_file(p,source_num,buf);
 
     printf("GPGPU-Sim PTX: finished parsing EMBEDDED .ptx file %s\n",buf);
+    double assemble = g_ptx_assemble_time - assemble_start;
+    printf("GPGPU-Sim PTX: load time for %s: parse %.3f s, assembly %.3f s (reconvergence analysis follows at first launch)\n",
+           buf, ptx_wall_time() - start - assemble, assemble);
     return symtab;
 }
 
 void gpgpu_ptxinfo_load_from_string( const char *p_for_info, unsigned source_num )
 {
+    char extra_flags[1024];
+    extra_flags[0]=0;
+
+#if CUDART_VERSION >= 3000
+    snprintf(extra_flags,1024,"--gpu-name=sm_20");
+#endif
+
+    std::string cache_file;
+    if( ptx_cache_enabled() ) {
+       cache_file = ptx_cache_file("ptxinfo","ptxas",(std::string(extra_flags) + "\n" + p_for_info).c_str());
+       if( ptx_cache_lookup(cache_file) ) {
+          printf("GPGPU-Sim PTX: using cached ptxinfo \"%s\"\n", cache_file.c_str());
+          ptxinfo_in = fopen(cache_file.c_str(),"r");
+          g_ptxinfo_filename = cache_file.c_str();
+          ptxinfo_parse();
+          fclose(ptxinfo_in);
+          return;
+       }
+    }
+
     char fname[1024];
     snprintf(fname,1024,"_ptx_XXXXXX");
     int fd=mkstemp(fname); 
@@ -212,12 +352,6 @@ void gpgpu_ptxinfo_load_from_string( const char *p_for_info, unsigned source_num
     char tempfile_ptxinfo[1024];
     snprintf(tempfile_ptxinfo,1024,"%sinfo",fname);
     char commandline[1024];
-    char extra_flags[1024];
-    extra_flags[0]=0;
-
-#if CUDART_VERSION >= 3000
-    snprintf(extra_flags,1024,"--gpu-name=sm_20");
-#endif
 
     snprintf(commandline,1024,"$GPGPUSIM_ROOT/bin/ptxas-shim %s -v %s --output-file  /dev/null 2> %s",
              extra_flags, fname2, tempfile_ptxinfo);
@@ -228,6 +362,8 @@ void gpgpu_ptxinfo_load_from_string( const char *p_for_info, unsigned source_num
        printf("               Ensure ptxas-shim is in your path.\n");
        exit(1);
     }
+    if( !cache_file.empty() ) 
+       ptx_cache_store(tempfile_ptxinfo,cache_file);
 
     ptxinfo_in = fopen(tempfile_ptxinfo,"r");
     g_ptxinfo_filename = tempfile_ptxinfo;
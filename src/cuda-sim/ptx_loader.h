@@ -36,4 +36,14 @@ void gpgpu_ptxinfo_load_from_string( const char *p_for_info, unsigned source_num
 char* gpgpu_ptx_sim_convert_ptx_and_sass_to_ptxplus(const std::string ptx_str, const std::string sass_str, const std::string elf_str);
 bool keep_intermediate_files();
 
+// on-disk cache of the output of external tools (-gpgpu_ptx_cache_dir):
+// ptx_cache_file*() name the entry for some input, ptx_cache_lookup() tells
+// whether it exists and ptx_cache_store() copies a tool's output file there.
+// The name also hashes the tool ("ptxas", "cuobjdump"), its shim and DISABLE_SHIM.
+bool ptx_cache_enabled();
+std::string ptx_cache_file( const char *kind, const char *tool, const char *data );
+std::string ptx_cache_file_of( const char *kind, const char *tool, const char *filename );
+bool ptx_cache_lookup( const std::string &cache_file );
+void ptx_cache_store( const char *filename, const std::string &cache_file );
+
 #endif
@@ -27,8 +27,8 @@
 
 
 #include <string.h>
+#include <algorithm>
 #include "addrdec.h"
-#include "gpu-sim.h"
 #include "../option_parser.h"
 
 
@@ -41,6 +41,10 @@ static void addrdec_getmasklimit(new_addr_type mask, unsigned char *high, unsign
 linear_to_raw_address_translation::linear_to_raw_address_translation()
 {
    addrdec_option = NULL;
+   addrdec_hash_option = NULL;
+   m_hash = ADDRDEC_HASH_NONE;
+   m_n_chip_bits = 0;
+   m_n_bk_bits = 0;
    ADDR_CHIP_S = 10;
    memset(addrdec_mklow,0,N_ADDRDEC);
    memset(addrdec_mkhigh,64,N_ADDRDEC);
@@ -62,6 +66,9 @@ void linear_to_raw_address_translation::addrdec_setoption(option_parser_t opp)
    option_parser_register(opp, "-gpgpu_mem_address_mask", OPT_INT32, &gpgpu_mem_address_mask, 
                "0 = old addressing mask, 1 = new addressing mask, 2 = new add. mask + flipped bank sel and chip sel bits",
                "0");
+   option_parser_register(opp, "-gpgpu_mem_addr_hash", OPT_CSTR, &addrdec_hash_option,
+               "hash the chip and bank with row bits (none, xor, pae)",
+               "none");
 }
 
 new_addr_type linear_to_raw_address_translation::partition_address( new_addr_type addr ) const 
@@ -103,12 +110,75 @@ void linear_to_raw_address_translation::addrdec_tlx(new_addr_type addr, addrdec_
       tlx->burst= addrdec_packbits(addrdec_mask[BURST], rest_of_addr, addrdec_mkhigh[BURST], addrdec_mklow[BURST]);
    }
 
+   if (m_hash != ADDRDEC_HASH_NONE) 
+      hash(tlx);
+   if (!m_region_offset.empty()) {
+      unsigned offset = m_region_offset[region_slot(tlx->row)];
+      if (offset) 
+         tlx->chip = (tlx->chip + offset) % m_n_channel;
+   }
+
    // combine the chip address and the lower bits of DRAM bank address to form the subpartition ID
    unsigned sub_partition_addr_mask = m_n_sub_partition_in_channel - 1; 
    tlx->sub_partition = tlx->chip * m_n_sub_partition_in_channel
                         + (tlx->bk & sub_partition_addr_mask); 
 }
 
+static unsigned addrdec_fold( unsigned v, unsigned bits )
+{
+   unsigned r = 0;
+   if (bits == 0) return 0;
+   for (; v; v >>= bits) 
+      r ^= v & ((1u << bits) - 1);
+   return r;
+}
+
+void linear_to_raw_address_translation::hash( addrdec_t *tlx ) const
+{
+   unsigned chip_hash = 0;
+   unsigned bk_hash = 0;
+   if (m_hash == ADDRDEC_HASH_XOR) {
+      chip_hash = addrdec_fold(tlx->row, m_n_chip_bits);
+      bk_hash = tlx->row & ((1u << m_n_bk_bits) - 1);
+   } else {
+      for (unsigned i=0;i<m_n_chip_bits;i++) 
+         chip_hash |= (unsigned)__builtin_parity(tlx->row & m_pae_chip[i]) << i;
+      for (unsigned i=0;i<m_n_bk_bits;i++) 
+         bk_hash |= (unsigned)__builtin_parity(tlx->row & m_pae_bk[i]) << i;
+   }
+   // a modulo add keeps a non power of two chip count one-to-one
+   if (gap) 
+      tlx->chip = (tlx->chip + chip_hash) % m_n_channel;
+   else 
+      tlx->chip ^= chip_hash;
+   tlx->bk ^= bk_hash;
+}
+
+void linear_to_raw_address_translation::set_region_offset( unsigned slot, unsigned offset )
+{
+   assert(slot < N_REGION);
+   if (m_region_offset.empty()) 
+      m_region_offset.assign(N_REGION, 0);
+   m_region_offset[slot] = offset % m_n_channel;
+}
+
+void linear_to_raw_address_translation::save_regions( FILE *fout ) const
+{
+   unsigned n = m_region_offset.size();
+   fwrite(&n, sizeof(n), 1, fout);
+   if (n) 
+      fwrite(&m_region_offset[0], 1, n, fout);
+}
+
+bool linear_to_raw_address_translation::load_regions( FILE *fin )
+{
+   unsigned n;
+   if (fread(&n, sizeof(n), 1, fin) != 1 || (n != 0 && n != N_REGION)) 
+      return false;
+   m_region_offset.assign(n, 0);
+   return n == 0 || fread(&m_region_offset[0], 1, n, fin) == n;
+}
+
 void linear_to_raw_address_translation::addrdec_parseoption(const char *option)
 {
    unsigned int dramid_start = 0;
@@ -322,6 +392,35 @@ void linear_to_raw_address_translation::init(unsigned int n_channel, unsigned in
    }
    printf("sub_partition_id_mask = %016llx\n", sub_partition_id_mask);
 
+   if (addrdec_hash_option == NULL || !strcmp(addrdec_hash_option, "none")) {
+      m_hash = ADDRDEC_HASH_NONE;
+   } else if (!strcmp(addrdec_hash_option, "xor")) {
+      m_hash = ADDRDEC_HASH_XOR;
+   } else if (!strcmp(addrdec_hash_option, "pae")) {
+      m_hash = ADDRDEC_HASH_PAE;
+   } else {
+      printf("GPGPU-Sim uArch: ERROR ** unknown address hash '%s'\n", addrdec_hash_option);
+      exit(1);
+   }
+   m_n_chip_bits = (n_channel > 1)? nchipbits : 0;
+   m_n_bk_bits = __builtin_popcountll(addrdec_mask[BK]);
+   assert(m_n_chip_bits <= MAX_HASH_BITS && m_n_bk_bits <= MAX_HASH_BITS);
+   if (m_hash == ADDRDEC_HASH_PAE) {
+      // fixed pseudo-random row bit subsets, the same on every run
+      unsigned n_row_bits = __builtin_popcountll(addrdec_mask[ROW]);
+      assert(n_row_bits > 0);
+      unsigned row_mask = (n_row_bits >= 32)? ~0u : (1u << n_row_bits) - 1;
+      unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+      for (unsigned i=0;i<MAX_HASH_BITS;i++) {
+         seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+         m_pae_chip[i] = ((unsigned)(seed >> 32) & row_mask) | (1u << (i % n_row_bits));
+         seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+         m_pae_bk[i] = ((unsigned)(seed >> 32) & row_mask) | (1u << ((i + m_n_chip_bits) % n_row_bits));
+      }
+   }
+   if (m_hash != ADDRDEC_HASH_NONE) 
+      printf("addr_dec_hash = %s (%u chip bits, %u bank bits)\n", addrdec_hash_option, m_n_chip_bits, m_n_bk_bits);
+
    if (run_test) {
       sweep_test(); 
    }
@@ -397,6 +496,100 @@ void addrdec_t::print( FILE *fp ) const
    fprintf(fp,"\tsub_partition:%x ", sub_partition);
 } 
 
+link_balancer::link_balancer( linear_to_raw_address_translation *mapping, unsigned n_channel,
+                              const std::vector<unsigned> &link_of_chip, unsigned n_link, float max_skew )
+   : m_link_of_chip(link_of_chip)
+{
+   m_mapping = mapping;
+   m_n_channel = n_channel;
+   m_n_link = n_link;
+   m_max_skew = max_skew;
+   m_traffic.assign(linear_to_raw_address_translation::N_REGION * n_link, 0);
+   m_link_total.assign(n_link, 0);
+   m_n_rebalance = 0;
+   m_n_moved = 0;
+   m_last_skew = 0;
+   m_last_expected = 0;
+}
+
+void link_balancer::record( const addrdec_t &tlx, unsigned bytes )
+{
+   unsigned link = m_link_of_chip[tlx.chip];
+   m_traffic[m_mapping->region_slot(tlx.row) * m_n_link + link] += bytes;
+   m_link_total[link] += bytes;
+}
+
+float link_balancer::skew( const std::vector<unsigned long long> &load ) const
+{
+   unsigned long long total = 0, max = 0;
+   for (unsigned l=0;l<m_n_link;l++) {
+      total += load[l];
+      max = std::max(max, load[l]);
+   }
+   return total? (float)max * m_n_link / total : 1.0f;
+}
+
+unsigned link_balancer::rebalance()
+{
+   const unsigned n_slot = linear_to_raw_address_translation::N_REGION;
+   std::vector<unsigned long long> load(m_n_link, 0);
+   std::vector<std::pair<unsigned long long,unsigned> > slots;
+   for (unsigned s=0;s<n_slot;s++) {
+      unsigned long long total = 0;
+      for (unsigned l=0;l<m_n_link;l++) {
+         load[l] += m_traffic[s * m_n_link + l];
+         total += m_traffic[s * m_n_link + l];
+      }
+      if (total) 
+         slots.push_back(std::make_pair(total, s));
+   }
+   m_last_skew = skew(load);
+   m_last_expected = m_last_skew;
+   unsigned moved = 0;
+   if (m_n_link > 1 && m_last_skew > m_max_skew) {
+      // heaviest regions first, each rotated to the links that keep the
+      // busiest link lowest; staying put wins ties
+      std::sort(slots.rbegin(), slots.rend());
+      for (unsigned i=0;i<slots.size();i++) {
+         unsigned s = slots[i].second;
+         const unsigned long long *t = &m_traffic[s * m_n_link];
+         for (unsigned l=0;l<m_n_link;l++) 
+            load[l] -= t[l];
+         unsigned best = 0;
+         unsigned long long best_max = (unsigned long long)-1;
+         for (unsigned d=0;d<m_n_link;d++) {
+            unsigned long long max = 0;
+            for (unsigned l=0;l<m_n_link;l++) 
+               max = std::max(max, load[(l + d) % m_n_link] + t[l]);
+            if (max < best_max) {
+               best_max = max;
+               best = d;
+            }
+         }
+         for (unsigned l=0;l<m_n_link;l++) 
+            load[(l + best) % m_n_link] += t[l];
+         if (best) {
+            m_mapping->set_region_offset(s, m_mapping->region_offset(s) + best);
+            moved++;
+         }
+      }
+      m_last_expected = skew(load);
+   }
+   m_n_rebalance++;
+   m_n_moved += moved;
+   std::fill(m_traffic.begin(), m_traffic.end(), 0);
+   return moved;
+}
+
+void link_balancer::print( FILE *fp ) const
+{
+   fprintf(fp, "link_balancer: rebalances = %u, regions moved = %u, last skew = %.3f (expected after = %.3f)\n",
+           m_n_rebalance, m_n_moved, m_last_skew, m_last_expected);
+   fprintf(fp, "link_balancer: traffic per link =");
+   for (unsigned l=0;l<m_n_link;l++) 
+      fprintf(fp, " %llu", m_link_total[l]);
+   fprintf(fp, "\n");
+}
 
 static long int powli( long int x, long int y ) // compute x to the y
 {
@@ -34,6 +34,7 @@
 #define ADDRDEC_H
 
 #include "../abstract_hardware_model.h"
+#include <vector>
 
 struct addrdec_t {
    void print( FILE *fp ) const;
@@ -47,6 +48,18 @@ struct addrdec_t {
    unsigned sub_partition; 
 };
 
+// Hashing of the chip and bank fields with row bits, so that power-of-two
+// strides do not pile up on one channel or bank. Both keep the mapping
+// one-to-one because the row is left as it is.
+//   xor  chip ^= XOR-fold of the row, bank ^= low row bits
+//   pae  every chip and bank bit is XORed with the parity of a fixed
+//        pseudo-random subset of the row bits (page address entropy)
+enum addrdec_hash_t {
+   ADDRDEC_HASH_NONE = 0,
+   ADDRDEC_HASH_XOR,
+   ADDRDEC_HASH_PAE
+};
+
 class linear_to_raw_address_translation {
 public:
    linear_to_raw_address_translation();
@@ -56,10 +69,22 @@ public:
    // accessors
    void addrdec_tlx(new_addr_type addr, addrdec_t *tlx) const; 
    new_addr_type partition_address( new_addr_type addr ) const;
+   enum addrdec_hash_t hash_type() const { return m_hash; }
+
+   // Regions (row hash slots) can be moved to other chips by an offset
+   // added to their chip field; see link_balancer. Only change these while
+   // no request is in flight and the L2 holds no line of the region.
+   static const unsigned N_REGION = 1024;
+   unsigned region_slot( unsigned row ) const { return (row * 2654435761u) >> 22; }
+   unsigned region_offset( unsigned slot ) const { return m_region_offset.empty()? 0 : m_region_offset[slot]; }
+   void set_region_offset( unsigned slot, unsigned offset );
+   void save_regions( FILE *fout ) const;
+   bool load_regions( FILE *fin );
 
 private:
    void addrdec_parseoption(const char *option);
    void sweep_test() const; // sanity check to ensure no overlapping
+   void hash( addrdec_t *tlx ) const;
 
    enum {
       CHIP  = 0,
@@ -83,6 +108,48 @@ private:
    unsigned int gap;
    int m_n_channel;
    int m_n_sub_partition_in_channel; 
+
+   char *addrdec_hash_option;
+   enum addrdec_hash_t m_hash;
+   unsigned m_n_chip_bits;
+   unsigned m_n_bk_bits;
+   static const unsigned MAX_HASH_BITS = 16;
+   unsigned m_pae_chip[MAX_HASH_BITS];   // row bits folded into each chip bit
+   unsigned m_pae_bk[MAX_HASH_BITS];     // row bits folded into each bank bit
+   std::vector<unsigned char> m_region_offset;
+};
+
+// Link-aware interleaving: the traffic of each region on each memory link
+// is counted over a kernel, and at the next kernel boundary the heaviest
+// regions are moved (by whole links) until the busiest link is within
+// max_skew of the mean. Chip c is assumed to sit on link link_of_chip[c],
+// and moving a region by d chips is assumed to move its traffic by d links
+// (exact for the cyclic partition-to-link binding).
+class link_balancer {
+public:
+   link_balancer( linear_to_raw_address_translation *mapping, unsigned n_channel,
+                  const std::vector<unsigned> &link_of_chip, unsigned n_link, float max_skew );
+
+   void record( const addrdec_t &tlx, unsigned bytes );
+   // rebalances from the traffic recorded since the last call; returns the
+   // number of regions moved
+   unsigned rebalance();
+   void print( FILE *fp ) const;
+
+private:
+   float skew( const std::vector<unsigned long long> &load ) const;
+
+   linear_to_raw_address_translation *m_mapping;
+   unsigned m_n_channel;
+   std::vector<unsigned> m_link_of_chip;
+   unsigned m_n_link;
+   float m_max_skew;
+   std::vector<unsigned long long> m_traffic;   // [slot * n_link + link] bytes
+   std::vector<unsigned long long> m_link_total;
+   unsigned m_n_rebalance;
+   unsigned m_n_moved;
+   float m_last_skew;
+   float m_last_expected;
 };
 
 #endif
@@ -0,0 +1,132 @@
+// Channel, bank and link skew of the address mapping (addrdec.cc) under
+// synthetic address streams.
+//
+// The mapping takes the simulator's own options (-gpgpu_mem_addr_mapping,
+// -gpgpu_mem_address_mask, -gpgpu_mem_addr_hash, ...) on the command line,
+// plus the partition count and the link interleaving. For every stream it
+// prints the busiest channel, bank and link relative to the mean (1.00 is
+// perfectly even). With -link_interleave adaptive the stream is run a
+// second time after link_balancer has moved its regions.
+//
+// usage: addrmap_skew [-n_mem 12] [-link_interleave block|cyclic|adaptive]
+//                     [-gpgpu_mem_addr_hash none|xor|pae] [...]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "../addrdec.h"
+#include "bench_rng.h"
+
+static unsigned g_n_mem;
+static unsigned g_n_sub_partition;
+static unsigned g_n_link;
+static char *g_interleave;
+static float g_max_skew;
+static unsigned g_n_req;
+static unsigned g_line;
+
+static unsigned link_of( unsigned chip )
+{
+   return strcmp(g_interleave, "block")? chip % g_n_link : chip / 6;
+}
+
+static bench_rng g_rng;
+
+enum stream_t { SEQ, STRIDE_2K, STRIDE_8K, STRIDE_64K, COLUMN, ARRAYS, RANDOM, N_STREAM };
+static const char *stream_name[] = { "sequential", "stride 2KB", "stride 8KB", "stride 64KB",
+                                     "2D column (pitch 12KB)", "8 arrays 16MB apart", "random" };
+
+static new_addr_type stream_addr( stream_t s, unsigned i )
+{
+   switch ( s ) {
+   case SEQ:        return (new_addr_type)i * g_line;
+   case STRIDE_2K:  return (new_addr_type)i * 2048;
+   case STRIDE_8K:  return (new_addr_type)i * 8192;
+   case STRIDE_64K: return ((new_addr_type)i * 65536) % (1ULL << 32) + (i >> 16) * g_line;
+   case COLUMN:     return (new_addr_type)(i % 1024) * 12288 + (i / 1024) * g_line;
+   case ARRAYS:     return (new_addr_type)(i % 8) * (16 << 20) + (i / 8) * g_line;
+   case RANDOM:     return (g_rng.next48() % (1ULL << 32)) & ~(new_addr_type)(g_line - 1);
+   default:         abort();
+   }
+}
+
+struct skew_t {
+   float chip, bank, link;
+};
+
+static float max_over_mean( const std::vector<unsigned long long> &count )
+{
+   unsigned long long total = 0, max = 0;
+   for ( unsigned i=0; i < count.size(); i++ ) {
+      total += count[i];
+      if ( count[i] > max ) max = count[i];
+   }
+   return total? (float)max * count.size() / total : 0.0f;
+}
+
+static skew_t run( const linear_to_raw_address_translation &map, stream_t s, unsigned n_bank, link_balancer *balancer )
+{
+   std::vector<unsigned long long> chip(g_n_mem, 0), bank(g_n_mem * n_bank, 0), link(g_n_link, 0);
+   g_rng.seed(1);
+   for ( unsigned i=0; i < g_n_req; i++ ) {
+      addrdec_t tlx;
+      map.addrdec_tlx(stream_addr(s, i), &tlx);
+      chip[tlx.chip]++;
+      bank[tlx.chip * n_bank + tlx.bk % n_bank]++;
+      link[link_of(tlx.chip)]++;
+      if ( balancer )
+         balancer->record(tlx, g_line);
+   }
+   skew_t r = { max_over_mean(chip), max_over_mean(bank), max_over_mean(link) };
+   return r;
+}
+
+int main( int argc, const char **argv )
+{
+   option_parser_t opp = option_parser_create();
+   linear_to_raw_address_translation map;
+   map.addrdec_setoption(opp);
+   option_parser_register(opp, "-n_mem", OPT_UINT32, &g_n_mem, "number of memory partitions", "12");
+   option_parser_register(opp, "-n_sub_partition", OPT_UINT32, &g_n_sub_partition, "sub partitions per partition", "2");
+   option_parser_register(opp, "-link_interleave", OPT_CSTR, &g_interleave, "block, cyclic or adaptive", "block");
+   option_parser_register(opp, "-max_skew", OPT_FLOAT, &g_max_skew, "adaptive: link skew that triggers a rebalance", "1.15");
+   option_parser_register(opp, "-n_req", OPT_UINT32, &g_n_req, "requests per stream", "1048576");
+   option_parser_register(opp, "-line", OPT_UINT32, &g_line, "request size in bytes", "128");
+   option_parser_cmdline(opp, argc, argv);
+
+   g_n_link = (g_n_mem + 5) / 6;
+   map.init(g_n_mem, g_n_sub_partition);
+   // banks per partition from the decoded bank field
+   unsigned n_bank = 1;
+   for ( unsigned i=0; i < (1u << 20); i++ ) {
+      addrdec_t tlx;
+      map.addrdec_tlx((new_addr_type)i * 64, &tlx);
+      while ( tlx.bk >= n_bank ) n_bank *= 2;
+   }
+
+   bool adaptive = !strcmp(g_interleave, "adaptive");
+   std::vector<unsigned> link_of_chip(g_n_mem);
+   for ( unsigned c=0; c < g_n_mem; c++ )
+      link_of_chip[c] = link_of(c);
+
+   printf("%u partitions, %u banks, %u links (%s), %u requests of %u bytes\n",
+          g_n_mem, n_bank, g_n_link, g_interleave, g_n_req, g_line);
+   printf("%-24s %8s %8s %8s%s\n", "stream", "channel", "bank", "link", adaptive? "  link after rebalance (regions moved)" : "");
+   for ( unsigned s=0; s < N_STREAM; s++ ) {
+      for ( unsigned r=0; r < linear_to_raw_address_translation::N_REGION; r++ )
+         map.set_region_offset(r, 0);
+      link_balancer balancer(&map, g_n_mem, link_of_chip, g_n_link, g_max_skew);
+      skew_t k = run(map, (stream_t)s, n_bank, adaptive? &balancer : NULL);
+      printf("%-24s %8.2f %8.2f %8.2f", stream_name[s], k.chip, k.bank, k.link);
+      if ( adaptive ) {
+         unsigned moved = balancer.rebalance();
+         skew_t a = run(map, (stream_t)s, n_bank, NULL);
+         printf("  %8.2f (%u)", a.link, moved);
+      }
+      printf("\n");
+   }
+   option_parser_destroy(opp);
+   return 0;
+}
@@ -0,0 +1,23 @@
+#ifndef BENCH_RNG_H
+#define BENCH_RNG_H
+
+// Random numbers of the standalone benchmarks (this directory and
+// src/intersim2/bench): a 64-bit linear congruential generator, so a seed
+// gives the same request streams, and checksums, on every platform.
+class bench_rng {
+public:
+   bench_rng( unsigned long long seed = 1 ) : m_state(seed) {}
+
+   void seed( unsigned long long s ) { m_state = s; }
+   // 31 random bits
+   unsigned next() { step(); return (unsigned)(m_state >> 33); }
+   // 48 random bits
+   unsigned long long next48() { step(); return m_state >> 16; }
+
+private:
+   void step() { m_state = m_state * 6364136223846793005ULL + 1442695040888963407ULL; }
+
+   unsigned long long m_state;
+};
+
+#endif
@@ -0,0 +1,255 @@
+// Standalone benchmark of the DRAM request scheduler (dram_sched_queue.h).
+//
+// A channel of banks is fed by synthetic request streams from a number of
+// sources and drained through the scheduler with a simple bank timing
+// model (row hit, row miss, read/write turnaround). For each stream and
+// policy it prints the row-hit rate, the mean and per-source latencies and
+// the host time spent per request, next to the list/map based FR-FCFS the
+// simulator used before, which it must match request for request.
+//
+// usage: dram_sched_bench [cycles] [seed]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <list>
+#include <map>
+#include <vector>
+
+#include "../dram_sched_queue.h"
+#include "bench_rng.h"
+
+struct bench_req {
+   unsigned bank;
+   unsigned row;
+   unsigned src;
+   bool write;
+   unsigned long long arrival;
+};
+
+// the previous FR-FCFS implementation (per-bank lists and row maps)
+class legacy_frfcfs {
+public:
+   legacy_frfcfs( unsigned n_banks )
+      : m_queue(n_banks), m_bins(n_banks), m_last_row(n_banks, (std::list<std::list<bench_req*>::iterator>*)NULL)
+   {
+      m_num_pending = 0;
+   }
+   unsigned size() const { return m_num_pending; }
+   void add( bench_req *req )
+   {
+      m_num_pending++;
+      m_queue[req->bank].push_front(req);
+      m_bins[req->bank][req->row].push_front(m_queue[req->bank].begin());
+   }
+   bench_req *schedule( unsigned bank, unsigned curr_row, bool &activate )
+   {
+      activate = false;
+      if ( m_last_row[bank] == NULL ) {
+         if ( m_queue[bank].empty() )
+            return NULL;
+         bin_map::iterator bin = m_bins[bank].find(curr_row);
+         if ( bin == m_bins[bank].end() ) {
+            bin = m_bins[bank].find(m_queue[bank].back()->row);
+            activate = true;
+         }
+         m_last_row[bank] = &bin->second;
+      }
+      std::list<bench_req*>::iterator next = m_last_row[bank]->back();
+      bench_req *req = *next;
+      m_last_row[bank]->pop_back();
+      m_queue[bank].erase(next);
+      if ( m_last_row[bank]->empty() ) {
+         m_bins[bank].erase(req->row);
+         m_last_row[bank] = NULL;
+      }
+      m_num_pending--;
+      return req;
+   }
+private:
+   typedef std::map<unsigned, std::list<std::list<bench_req*>::iterator> > bin_map;
+   std::vector<std::list<bench_req*> > m_queue;
+   std::vector<bin_map> m_bins;
+   std::vector<std::list<std::list<bench_req*>::iterator>*> m_last_row;
+   unsigned m_num_pending;
+};
+
+enum stream_t { STREAMING, RANDOM, MIXED, WRITES, N_STREAM };
+static const char *stream_name[] = { "streaming", "random", "mixed", "write-heavy" };
+
+static const unsigned N_BANKS = 16;
+static const unsigned N_SOURCES = 16;
+static const unsigned QUEUE_SIZE = 64;
+static const unsigned T_HIT = 4;        // column access
+static const unsigned T_MISS = 4 + 25;  // precharge + activate + column access
+static const unsigned T_TURN = 8;       // read/write bus turnaround
+
+static bench_rng g_rng;
+
+struct source_t {
+   unsigned long long addr;
+   bool streaming;
+   unsigned rate;  // requests per 100 cycles
+   unsigned write_pct;
+};
+
+struct result_t {
+   unsigned long long served;
+   unsigned long long row_hits;
+   unsigned long long latency;
+   double min_src_latency;
+   double max_src_latency;
+   double ns_per_req;
+   unsigned long long checksum; // order of service
+};
+
+static void setup_sources( stream_t stream, std::vector<source_t> &src )
+{
+   src.resize(N_SOURCES);
+   for ( unsigned s=0; s < N_SOURCES; s++ ) {
+      source_t &e = src[s];
+      e.addr = (unsigned long long)g_rng.next() << 8;
+      e.streaming = (stream == STREAMING) || (stream == MIXED && s < N_SOURCES/2) || (stream == WRITES && s % 2);
+      e.rate = (stream == MIXED && s < N_SOURCES/2)? 40 : 10;
+      e.write_pct = (stream == WRITES)? 40 : 5;
+   }
+}
+
+template<class SCHED> static result_t run( SCHED &sched, stream_t stream, unsigned long long cycles, unsigned seed )
+{
+   g_rng.seed(seed);
+   std::vector<source_t> src;
+   setup_sources(stream, src);
+   std::vector<bench_req> pool(QUEUE_SIZE);
+   std::vector<bench_req*> free_reqs;
+   for ( unsigned i=0; i < QUEUE_SIZE; i++ )
+      free_reqs.push_back(&pool[i]);
+   std::vector<unsigned long long> bank_ready(N_BANKS, 0);
+   std::vector<unsigned> curr_row(N_BANKS, 0);
+   std::vector<unsigned long long> src_latency(N_SOURCES, 0), src_served(N_SOURCES, 0);
+   bool last_write = false;
+   unsigned long long bus_ready = 0;
+
+   result_t r;
+   memset(&r, 0, sizeof(r));
+   struct timespec t0, t1;
+   clock_gettime(CLOCK_MONOTONIC, &t0);
+   for ( unsigned long long now=0; now < cycles; now++ ) {
+      for ( unsigned s=0; s < N_SOURCES && !free_reqs.empty(); s++ ) {
+         source_t &e = src[s];
+         if ( g_rng.next() % 100 >= e.rate )
+            continue;
+         e.addr = e.streaming? e.addr + 64 : (unsigned long long)g_rng.next() << 6;
+         bench_req *req = free_reqs.back();
+         free_reqs.pop_back();
+         req->bank = (e.addr >> 8) % N_BANKS;
+         req->row = (unsigned)(e.addr >> 14);
+         req->src = s;
+         req->write = g_rng.next() % 100 < e.write_pct;
+         req->arrival = now;
+         sched.add(req);
+      }
+      for ( unsigned b=0; b < N_BANKS; b++ ) {
+         if ( bank_ready[b] > now || bus_ready > now )
+            continue;
+         bool activate = false;
+         bench_req *req = sched.schedule(b, curr_row[b], activate);
+         if ( req == NULL )
+            continue;
+         unsigned long long t = activate? T_MISS : T_HIT;
+         if ( req->write != last_write )
+            bus_ready = now + T_TURN;
+         last_write = req->write;
+         bank_ready[b] = now + t;
+         curr_row[b] = req->row;
+         r.served++;
+         r.row_hits += !activate;
+         r.latency += now + t - req->arrival;
+         r.checksum = r.checksum * 31 + (req - &pool[0]) * 7 + b;
+         src_latency[req->src] += now + t - req->arrival;
+         src_served[req->src]++;
+         free_reqs.push_back(req);
+      }
+   }
+   clock_gettime(CLOCK_MONOTONIC, &t1);
+   double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+   r.ns_per_req = r.served? ns / r.served : 0.0;
+   r.min_src_latency = 1e30;
+   for ( unsigned s=0; s < N_SOURCES; s++ ) {
+      if ( !src_served[s] )
+         continue;
+      double l = (double)src_latency[s] / src_served[s];
+      if ( l < r.min_src_latency ) r.min_src_latency = l;
+      if ( l > r.max_src_latency ) r.max_src_latency = l;
+   }
+   return r;
+}
+
+// adapts dram_sched_queue to the interface of legacy_frfcfs
+class queue_sched {
+public:
+   queue_sched( const dram_sched_config &config ) : m_queue(N_BANKS, QUEUE_SIZE, config) { m_now = 0; }
+   void add( bench_req *req ) { m_now = req->arrival; m_queue.add(req, req->bank, req->row, req->src, req->write, req->arrival); }
+   bench_req *schedule( unsigned bank, unsigned curr_row, bool &activate ) { return m_queue.schedule(bank, curr_row, m_now, activate); }
+private:
+   dram_sched_queue<bench_req> m_queue;
+   unsigned long long m_now;
+};
+
+static void print_result( const char *name, const result_t &r )
+{
+   printf("  %-14s served %8llu  row hits %5.1f%%  latency %7.1f  per source %7.1f .. %7.1f  %6.1f ns/req\n",
+          name, r.served, r.served? 100.0 * r.row_hits / r.served : 0.0,
+          r.served? (double)r.latency / r.served : 0.0, r.min_src_latency, r.max_src_latency, r.ns_per_req);
+}
+
+int main( int argc, char **argv )
+{
+   unsigned long long cycles = (argc > 1)? strtoull(argv[1], NULL, 0) : 1000000;
+   unsigned seed = (argc > 2)? strtoul(argv[2], NULL, 0) : 1;
+
+   dram_sched_config config;
+   memset(&config, 0, sizeof(config));
+   config.m_bliss_threshold = 4;
+   config.m_bliss_clear = 10000;
+   config.m_atlas_quantum = 10000;
+   config.m_atlas_cap = 5000;
+
+   int status = 0;
+   for ( unsigned s=0; s < N_STREAM; s++ ) {
+      stream_t stream = (stream_t)s;
+      printf("%s (%llu cycles)\n", stream_name[s], cycles);
+
+      legacy_frfcfs legacy(N_BANKS);
+      result_t base = run(legacy, stream, cycles, seed);
+      print_result("legacy", base);
+
+      config.m_policy = DRAM_SCHED_FRFCFS;
+      config.m_write_high = 0;
+      config.m_write_low = 0;
+      queue_sched frfcfs(config);
+      result_t r = run(frfcfs, stream, cycles, seed);
+      print_result("frfcfs", r);
+      if ( r.checksum != base.checksum || r.served != base.served ) {
+         printf("  ERROR: frfcfs does not match the legacy scheduler\n");
+         status = 1;
+      }
+
+      config.m_write_high = 24;
+      config.m_write_low = 8;
+      queue_sched drain(config);
+      print_result("frfcfs+drain", run(drain, stream, cycles, seed));
+      config.m_write_high = 0;
+      config.m_write_low = 0;
+
+      config.m_policy = DRAM_SCHED_BLISS;
+      queue_sched bliss(config);
+      print_result("bliss", run(bliss, stream, cycles, seed));
+
+      config.m_policy = DRAM_SCHED_ATLAS;
+      queue_sched atlas(config);
+      print_result("atlas", run(atlas, stream, cycles, seed));
+   }
+   return status;
+}
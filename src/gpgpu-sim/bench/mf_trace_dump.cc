@@ -0,0 +1,190 @@
+// Reader of the binary mem_fetch traces of -gpgpu_mf_trace (mf_trace.h).
+//
+//   events   prints every event in cycle order
+//   latency  prints the cycles requests spend in each mem_fetch_status,
+//            the issue to delete latency per access type, the L1 / L2
+//            outcomes and the mean compressed size on the memory links
+//   index    prints the blocks of each file
+//
+// Only events in [from, to) are read; blocks outside the range are not
+// inflated. Requests still in flight at the end are left out of latency.
+//
+// usage: mf_trace_dump <prefix> [events|latency|index] [from_cycle] [to_cycle]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+
+#include "../mf_trace.h"
+
+#define MF_TUP_BEGIN(X) static const char *status_str[] = {
+#define MF_TUP(X) #X
+#define MF_TUP_END(X) };
+#include "../mem_fetch_status.tup"
+#undef MF_TUP_BEGIN
+#undef MF_TUP
+#undef MF_TUP_END
+static const unsigned n_status = sizeof(status_str) / sizeof(status_str[0]);
+
+// cache_request_status (gpu-cache.h)
+static const char *outcome_str[] = { "HIT", "HIT_RESERVED", "MISS", "RESERVATION_FAIL" };
+static const unsigned n_outcome = 4;
+
+static void print_event( const mf_trace_event &e )
+{
+   printf("%12llu %10u %-9s", e.cycle, e.uid, mf_trace_event_name(e.type));
+   switch( e.type ) {
+   case MFT_ISSUE:
+      printf(" sid=%u w=%u acc=%u size=%u addr=0x%llx\n", e.where, e.aux, e.arg, e.value, e.addr);
+      break;
+   case MFT_STATUS:
+      printf(" %s\n", (e.arg < n_status)? status_str[e.arg] : "?");
+      break;
+   case MFT_L1:
+   case MFT_L2:
+      printf(" at=%u %s\n", e.where, (e.arg < n_outcome)? outcome_str[e.arg] : "?");
+      break;
+   case MFT_LINK:
+      printf(" sub_partition=%u %s\n", e.where, e.arg? "up" : "down");
+      break;
+   case MFT_LINK_COMP:
+      printf(" src=%u %s bits=%u\n", e.where, e.arg? "up" : "down", e.value);
+      break;
+   case MFT_DRAM:
+      printf(" chip=%u bank=%u row=%u\n", e.where, e.arg, e.value);
+      break;
+   default:
+      printf("\n");
+   }
+}
+
+struct inflight {
+   unsigned long long issue;
+   unsigned long long since;
+   unsigned char status;
+   unsigned char access;
+};
+
+static void latency( mf_trace_reader &r, unsigned long long to )
+{
+   std::map<unsigned,inflight> live;
+   std::vector<unsigned long long> status_cycles(n_status, 0), status_visits(n_status, 0);
+   std::vector<unsigned long long> acc_latency(256, 0), acc_count(256, 0);
+   unsigned long long outcome[2][n_outcome];
+   memset(outcome, 0, sizeof(outcome));
+   unsigned long long comp_bits[2] = {0,0}, comp_n[2] = {0,0};
+   unsigned long long n_events = 0, n_done = 0;
+
+   mf_trace_event e;
+   while( r.next(e) && e.cycle < to ) {
+      n_events++;
+      std::map<unsigned,inflight>::iterator i = live.find(e.uid);
+      switch( e.type ) {
+      case MFT_ISSUE: {
+         inflight f = { e.cycle, e.cycle, 0, e.arg };
+         live[e.uid] = f;
+         break;
+      }
+      case MFT_STATUS:
+         if( i != live.end() ) {
+            inflight &f = i->second;
+            if( f.status < n_status ) {
+               status_cycles[f.status] += e.cycle - f.since;
+               status_visits[f.status]++;
+            }
+            f.status = e.arg;
+            f.since = e.cycle;
+         }
+         break;
+      case MFT_L1:
+      case MFT_L2:
+         if( e.arg < n_outcome )
+            outcome[e.type == MFT_L2][e.arg]++;
+         break;
+      case MFT_LINK_COMP:
+         comp_bits[e.arg != 0] += e.value;
+         comp_n[e.arg != 0]++;
+         break;
+      case MFT_DELETE:
+         if( i != live.end() ) {
+            acc_latency[i->second.access] += e.cycle - i->second.issue;
+            acc_count[i->second.access]++;
+            n_done++;
+            live.erase(i);
+         }
+         break;
+      }
+   }
+
+   printf("%llu events, %llu requests completed, %zu in flight at the end\n", n_events, n_done, live.size());
+   printf("\n%-36s %14s %14s %10s\n", "status", "visits", "cycles", "mean");
+   for( unsigned s=0; s < n_status; s++ ) {
+      if( status_visits[s] )
+         printf("%-36s %14llu %14llu %10.1f\n", status_str[s], status_visits[s], status_cycles[s],
+                (double)status_cycles[s] / status_visits[s]);
+   }
+   printf("\n%-36s %14s %10s\n", "issue to delete, access type", "requests", "mean");
+   for( unsigned a=0; a < 256; a++ ) {
+      if( acc_count[a] )
+         printf("%-36u %14llu %10.1f\n", a, acc_count[a], (double)acc_latency[a] / acc_count[a]);
+   }
+   printf("\n%-8s", "outcome");
+   for( unsigned o=0; o < n_outcome; o++ )
+      printf(" %16s", outcome_str[o]);
+   printf("\n");
+   for( unsigned l=0; l < 2; l++ ) {
+      printf("%-8s", l? "L2" : "L1");
+      for( unsigned o=0; o < n_outcome; o++ )
+         printf(" %16llu", outcome[l][o]);
+      printf("\n");
+   }
+   for( unsigned d=0; d < 2; d++ ) {
+      if( comp_n[d] )
+         printf("\nlink %-4s %llu compressed blocks, mean %.1f bits", d? "up" : "down", comp_n[d],
+                (double)comp_bits[d] / comp_n[d]);
+   }
+   printf("\n");
+}
+
+int main( int argc, char **argv )
+{
+   if( argc < 2 ) {
+      fprintf(stderr, "usage: mf_trace_dump <prefix> [events|latency|index] [from_cycle] [to_cycle]\n");
+      return 1;
+   }
+   const char *mode = (argc > 2)? argv[2] : "events";
+   unsigned long long from = (argc > 3)? strtoull(argv[3], NULL, 0) : 0;
+   unsigned long long to = (argc > 4)? strtoull(argv[4], NULL, 0) : (unsigned long long)-1;
+
+   mf_trace_reader r;
+   if( !r.open(argv[1]) ) {
+      fprintf(stderr, "mf_trace_dump: no trace files %s.0.mft ...\n", argv[1]);
+      return 1;
+   }
+   if( !strcmp(mode, "index") ) {
+      for( unsigned f=0; f < r.num_files(); f++ ) {
+         const mf_trace_file &tf = r.file(f);
+         printf("%s.%u.mft: %u blocks, %llu events%s\n", argv[1], f, tf.num_blocks(), tf.num_events(),
+                tf.indexed()? "" : " (no index)");
+         for( unsigned b=0; b < tf.num_blocks(); b++ ) {
+            const mf_trace_block &blk = tf.block(b);
+            printf("  %6u offset %12llu bytes %10u events %8u cycles %llu-%llu uids %u-%u\n", b, blk.offset,
+                   blk.comp_bytes, blk.n_events, blk.first_cycle, blk.last_cycle, blk.min_uid, blk.max_uid);
+         }
+      }
+      return 0;
+   }
+   r.seek(from);
+   if( !strcmp(mode, "latency") ) {
+      latency(r, to);
+   } else if( !strcmp(mode, "events") ) {
+      mf_trace_event e;
+      while( r.next(e) && e.cycle < to )
+         print_event(e);
+   } else {
+      fprintf(stderr, "mf_trace_dump: unknown mode %s\n", mode);
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,212 @@
+// Standalone benchmark of the warp scoreboard (scoreboard.cc).
+//
+// The warps of one core issue a synthetic instruction stream: each warp
+// checks its next instruction against the scoreboard every cycle, issues
+// it when there is no hazard and releases its destination registers when
+// it completes (a few cycles for ALU operations, hundreds for global
+// loads). For a small and a large register count it prints the issued
+// instructions, a checksum of the issue decisions and the host time per
+// scheduler check, next to the std::set scoreboard the simulator used
+// before, which it must match cycle for cycle.
+//
+// usage: scoreboard_bench [cycles] [seed]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <set>
+#include <vector>
+
+#include "../scoreboard.h"
+#include "bench_rng.h"
+
+// normally set by the PTX parser (largest register number of the kernels loaded)
+unsigned g_max_regs_per_thread = 0;
+unsigned warp_inst_t::sm_next_uid = 0;
+
+// the previous scoreboard (a std::set of pending registers per warp)
+class legacy_scoreboard {
+public:
+   legacy_scoreboard( unsigned sid, unsigned n_warps )
+      : reg_table(n_warps), longopregs(n_warps)
+   {
+      m_sid = sid;
+   }
+   void reserveRegisters( const warp_inst_t *inst )
+   {
+      for ( unsigned r=0; r < 4; r++ ) {
+         if ( inst->out[r] > 0 ) {
+            if ( reg_table[inst->warp_id()].find(inst->out[r]) != reg_table[inst->warp_id()].end() ) {
+               printf("Error: trying to reserve an already reserved register (sid=%d, wid=%d, regnum=%d).",
+                      m_sid, inst->warp_id(), inst->out[r]);
+               abort();
+            }
+            reg_table[inst->warp_id()].insert(inst->out[r]);
+         }
+      }
+      if ( inst->is_load() && inst->space.get_type() == global_space ) {
+         for ( unsigned r=0; r < 4; r++ )
+            if ( inst->out[r] > 0 )
+               longopregs[inst->warp_id()].insert(inst->out[r]);
+      }
+   }
+   void releaseRegisters( const warp_inst_t *inst )
+   {
+      for ( unsigned r=0; r < 4; r++ ) {
+         if ( inst->out[r] > 0 ) {
+            reg_table[inst->warp_id()].erase(inst->out[r]);
+            longopregs[inst->warp_id()].erase(inst->out[r]);
+         }
+      }
+   }
+   bool checkCollision( unsigned wid, const inst_t *inst ) const
+   {
+      std::set<int> inst_regs;
+      for ( unsigned r=0; r < 4; r++ ) {
+         if ( inst->out[r] > 0 ) inst_regs.insert(inst->out[r]);
+         if ( inst->in[r] > 0 ) inst_regs.insert(inst->in[r]);
+      }
+      if ( inst->pred > 0 ) inst_regs.insert(inst->pred);
+      if ( inst->ar1 > 0 ) inst_regs.insert(inst->ar1);
+      if ( inst->ar2 > 0 ) inst_regs.insert(inst->ar2);
+      for ( std::set<int>::const_iterator it=inst_regs.begin(); it != inst_regs.end(); it++ )
+         if ( reg_table[wid].find(*it) != reg_table[wid].end() )
+            return true;
+      return false;
+   }
+   bool pendingWrites( unsigned wid ) const { return !reg_table[wid].empty(); }
+private:
+   unsigned m_sid;
+   std::vector<std::set<unsigned> > reg_table;
+   std::vector<std::set<unsigned> > longopregs;
+};
+
+static const unsigned N_WARPS = 48;
+static const unsigned IN_FLIGHT = 8;     // outstanding instructions per warp
+static const unsigned LOAD_PCT = 25;
+static const unsigned ALU_LATENCY = 4;   // plus up to 20
+static const unsigned LOAD_LATENCY = 200; // plus up to 400
+
+static bench_rng g_rng;
+
+struct bench_warp {
+   warp_inst_t next;
+   warp_inst_t in_flight[IN_FLIGHT];
+   unsigned long long done[IN_FLIGHT];  // 0 = free slot
+};
+
+static unsigned random_reg( unsigned n_regs )
+{
+   return 1 + g_rng.next() % n_regs;
+}
+
+// the next instruction of a warp: up to 2 destinations, 3 sources and a predicate
+static void next_inst( bench_warp &w, unsigned n_regs )
+{
+   inst_t &inst = w.next;
+   bool load = g_rng.next() % 100 < LOAD_PCT;
+   inst.op = load? LOAD_OP : ALU_OP;
+   inst.memory_op = no_memory_op;
+   inst.space = load? memory_space_t(global_space) : memory_space_t();
+   unsigned n_out = 1 + g_rng.next() % 2;
+   unsigned n_in = g_rng.next() % 4;
+   for ( unsigned r=0; r < 4; r++ ) {
+      inst.out[r] = 0;
+      inst.in[r] = 0;
+   }
+   inst.out[0] = random_reg(n_regs);
+   if ( n_out > 1 ) {
+      unsigned r = random_reg(n_regs);
+      inst.out[1] = (r != inst.out[0])? r : 0;
+   }
+   for ( unsigned r=0; r < n_in; r++ )
+      inst.in[r] = random_reg(n_regs);
+   inst.pred = (g_rng.next() % 8 == 0)? (int)random_reg(n_regs) : 0;
+   inst.ar1 = 0;
+   inst.ar2 = 0;
+   inst.latency = load? LOAD_LATENCY + g_rng.next() % 400 : ALU_LATENCY + g_rng.next() % 20;
+}
+
+struct result_t {
+   unsigned long long checks;
+   unsigned long long issued;
+   unsigned long long checksum;
+   double ns;
+};
+
+template <class SCOREBOARD>
+static result_t run( unsigned n_regs, unsigned long long cycles, unsigned seed )
+{
+   g_max_regs_per_thread = n_regs;
+   SCOREBOARD sb(0, N_WARPS);
+   std::vector<bench_warp> warps(N_WARPS);
+   g_rng.seed(seed);
+   for ( unsigned w=0; w < N_WARPS; w++ ) {
+      for ( unsigned i=0; i < IN_FLIGHT; i++ )
+         warps[w].done[i] = 0;
+      next_inst(warps[w], n_regs);
+   }
+
+   active_mask_t mask;
+   mask.set();
+   result_t r = { 0, 0, 0, 0.0 };
+   struct timespec t0, t1;
+   clock_gettime(CLOCK_MONOTONIC, &t0);
+   for ( unsigned long long now=1; now <= cycles; now++ ) {
+      for ( unsigned w=0; w < N_WARPS; w++ ) {
+         bench_warp &warp = warps[w];
+         unsigned free_slot = IN_FLIGHT;
+         for ( unsigned i=0; i < IN_FLIGHT; i++ ) {
+            if ( warp.done[i] == now ) {
+               sb.releaseRegisters(&warp.in_flight[i]);
+               warp.done[i] = 0;
+            }
+            if ( warp.done[i] == 0 )
+               free_slot = i;
+         }
+         r.checks++;
+         if ( free_slot == IN_FLIGHT || sb.checkCollision(w, &warp.next) ) {
+            r.checksum = r.checksum * 31 + sb.pendingWrites(w);
+            continue;
+         }
+         warp_inst_t &inst = warp.in_flight[free_slot];
+         inst = warp.next;
+         inst.issue(mask, w, now, w);
+         sb.reserveRegisters(&inst);
+         warp.done[free_slot] = now + inst.latency;
+         r.issued++;
+         r.checksum = r.checksum * 31 + now * 7 + w;
+         next_inst(warp, n_regs);
+      }
+   }
+   clock_gettime(CLOCK_MONOTONIC, &t1);
+   r.ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+   return r;
+}
+
+static void print_result( const char *name, const result_t &r )
+{
+   printf("  %-8s checks %10llu  issued %10llu  checksum %016llx  %6.1f ns/check\n",
+          name, r.checks, r.issued, r.checksum, r.checks? r.ns / r.checks : 0.0);
+}
+
+int main( int argc, char **argv )
+{
+   unsigned long long cycles = (argc > 1)? strtoull(argv[1], NULL, 0) : 200000;
+   unsigned seed = (argc > 2)? strtoul(argv[2], NULL, 0) : 1;
+   static const unsigned reg_counts[] = { 32, 255 };
+
+   int status = 0;
+   for ( unsigned i=0; i < sizeof(reg_counts) / sizeof(reg_counts[0]); i++ ) {
+      printf("%u registers, %u warps (%llu cycles)\n", reg_counts[i], N_WARPS, cycles);
+      result_t base = run<legacy_scoreboard>(reg_counts[i], cycles, seed);
+      print_result("legacy", base);
+      result_t r = run<Scoreboard>(reg_counts[i], cycles, seed);
+      print_result("bitset", r);
+      if ( r.checksum != base.checksum || r.issued != base.issued ) {
+         printf("  ERROR: the scoreboard does not match the legacy scoreboard\n");
+         status = 1;
+      }
+   }
+   return status;
+}
@@ -0,0 +1,127 @@
+// Host time per interconnect cycle of the queueing crossbar
+// (local_interconnect.h, -network_mode 2) under synthetic GPU traffic.
+//
+// The traffic is the one of src/intersim2/bench/icnt_step_bench: shader
+// nodes send read and write requests to random memory nodes, and memory
+// nodes answer after a fixed latency. The results print in the same
+// columns, so the two can be compared on the same node counts ("crossbar
+// (fly k=27 n=1)" there is 15 shaders and 12 memory nodes). The -icnt_xbar_*
+// options of the simulator are taken on the command line.
+//
+// usage: xbar_bench [-cycles 100000] [-rate 0.1] [-n_shader 15] [-n_mem 12]
+//                   [-icnt_xbar_latency 4] [...]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <deque>
+#include <vector>
+
+#include "../local_interconnect.h"
+#include "bench_rng.h"
+
+struct bench_packet {
+   bool write;
+   bool reply;
+   unsigned src;       // shader
+   unsigned long long issue;
+   unsigned long long ready;   // reply leaves the memory node
+   unsigned id;
+};
+
+static const unsigned REQ_SIZE = 8;       // read request, write ack
+static const unsigned DATA_SIZE = 136;    // write request, read reply
+static const unsigned MEM_LATENCY = 100;  // request arrival to reply
+static const unsigned WRITE_PCT = 30;
+
+static bench_rng g_rng;
+
+static unsigned long long g_cycles;
+static float g_rate;
+static unsigned g_n_shader;
+static unsigned g_n_mem;
+
+int main( int argc, const char **argv )
+{
+   option_parser_t opp = option_parser_create();
+   local_icnt_config config;
+   config.reg_options(opp);
+   option_parser_register(opp, "-cycles", OPT_UINT64, &g_cycles, "interconnect cycles to run", "100000");
+   option_parser_register(opp, "-rate", OPT_FLOAT, &g_rate, "requests per shader per cycle", "0.1");
+   option_parser_register(opp, "-n_shader", OPT_UINT32, &g_n_shader, "shader nodes", "15");
+   option_parser_register(opp, "-n_mem", OPT_UINT32, &g_n_mem, "memory nodes", "12");
+   option_parser_cmdline(opp, argc, argv);
+
+   local_interconnect icnt(config);
+   icnt.create(g_n_shader, g_n_mem);
+   icnt.init();
+
+   std::vector<bench_packet> pool(g_n_shader * 64);
+   std::vector<bench_packet*> free_packets;
+   for ( unsigned i=0; i < pool.size(); i++ ) {
+      pool[i].id = i;
+      free_packets.push_back(&pool[i]);
+   }
+   std::vector<std::deque<bench_packet*> > mem_queue(g_n_mem);
+   unsigned threshold = (unsigned)(g_rate * (1u << 31));
+
+   unsigned long long delivered = 0, round_trip = 0, checksum = 0;
+   g_rng.seed(1);
+   struct timespec t0, t1;
+   clock_gettime(CLOCK_MONOTONIC, &t0);
+   for ( unsigned long long now=0; now < g_cycles; now++ ) {
+      for ( unsigned s=0; s < g_n_shader && !free_packets.empty(); s++ ) {
+         if ( g_rng.next() >= threshold )
+            continue;
+         bool write = g_rng.next() % 100 < WRITE_PCT;
+         unsigned size = write? DATA_SIZE : REQ_SIZE;
+         unsigned mem = g_rng.next() % g_n_mem;
+         if ( !icnt.has_buffer(s, size) )
+            continue;
+         bench_packet *p = free_packets.back();
+         free_packets.pop_back();
+         p->write = write;
+         p->reply = false;
+         p->src = s;
+         p->issue = now;
+         icnt.push(s, g_n_shader + mem, p, size);
+      }
+      for ( unsigned m=0; m < g_n_mem; m++ ) {
+         bench_packet *p = (bench_packet*)icnt.pop(g_n_shader + m);
+         if ( p ) {
+            p->ready = now + MEM_LATENCY;
+            mem_queue[m].push_back(p);
+         }
+         if ( mem_queue[m].empty() || mem_queue[m].front()->ready > now )
+            continue;
+         p = mem_queue[m].front();
+         unsigned size = p->write? REQ_SIZE : DATA_SIZE;
+         if ( !icnt.has_buffer(g_n_shader + m, size) )
+            continue;
+         mem_queue[m].pop_front();
+         p->reply = true;
+         icnt.push(g_n_shader + m, p->src, p, size);
+      }
+      for ( unsigned s=0; s < g_n_shader; s++ ) {
+         bench_packet *p = (bench_packet*)icnt.pop(s);
+         if ( !p )
+            continue;
+         delivered++;
+         round_trip += now - p->issue;
+         checksum = checksum * 31 + now * 7 + p->id;
+         free_packets.push_back(p);
+      }
+      icnt.advance();
+   }
+   clock_gettime(CLOCK_MONOTONIC, &t1);
+   double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+
+   printf("%llu cycles, %.3f requests per shader per cycle\n", g_cycles, g_rate);
+   printf("%-24s %3u+%-3u delivered %9llu  round trip %7.1f  checksum %016llx  %8.1f ns/cycle\n",
+          "local crossbar", g_n_shader, g_n_mem, delivered, delivered? (double)round_trip / delivered : 0.0,
+          checksum, g_cycles? ns / g_cycles : 0.0);
+   icnt.display_stats();
+   option_parser_destroy(opp);
+   return 0;
+}
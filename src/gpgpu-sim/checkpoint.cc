@@ -0,0 +1,393 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "checkpoint.h"
+#include "gpu-sim.h"
+#include "shader.h"
+#include "l2cache.h"
+#include "mydelayqueue.h"
+#include "comp.h"
+#include "../cuda-sim/memory.h"
+
+extern unsigned long long  gpu_sim_cycle;
+extern unsigned long long  gpu_tot_sim_cycle;
+
+static const char CHECKPOINT_MAGIC[8] = {'G','P','G','P','U','C','K','P'};
+static const unsigned CHECKPOINT_VERSION = 6;
+// payload layout of each section, bumped when the section changes
+static const unsigned SECTION_VERSION = 1;
+static const unsigned N_COUNTERS = 14;
+
+void checkpoint_config::reg_options( option_parser_t opp )
+{
+    option_parser_register(opp, "-checkpoint_write", OPT_CSTR, &m_write_prefix,
+                "Write a checkpoint at kernel boundaries to <prefix>.k<kernel uid> (none = off)",
+                "none");
+    option_parser_register(opp, "-checkpoint_kernel_period", OPT_UINT32, &m_kernel_period,
+                "Write a checkpoint after every N finished kernels",
+                "1");
+    option_parser_register(opp, "-checkpoint_cycle_period", OPT_UINT64, &m_cycle_period,
+                "Write a checkpoint at the first kernel boundary after every N cycles (0 = use -checkpoint_kernel_period)",
+                "0");
+    option_parser_register(opp, "-checkpoint_restore", OPT_CSTR, &m_restore_file,
+                "Resume from a checkpoint file: earlier kernel launches run functionally, untimed (none = off)",
+                "none");
+}
+
+checkpoint_manager::checkpoint_manager( const checkpoint_config &config, gpgpu_sim *gpu )
+    : m_config(config), m_gpu(gpu)
+{
+    m_last_uid = 0;
+    m_kernels_since_write = 0;
+    m_last_write_cycle = 0;
+    m_restore_pending = false;
+    m_restore_uid = 0;
+    if( m_config.restore_enabled() ) {
+        if( !read_header(m_config.m_restore_file) ) {
+            printf("GPGPU-Sim uArch: ERROR ** cannot read checkpoint \"%s\"\n", m_config.m_restore_file);
+            abort();
+        }
+        m_restore_pending = true;
+        printf("GPGPU-Sim uArch: resuming from checkpoint \"%s\" after kernel uid %u (%s)\n",
+               m_config.m_restore_file, m_restore_uid, m_restore_name.c_str());
+    }
+}
+
+void checkpoint_manager::kernel_done( const kernel_info_t &kernel )
+{
+    m_last_uid = kernel.get_uid();
+    m_last_name = kernel.name();
+    m_kernels_since_write++;
+}
+
+void checkpoint_manager::kernel_boundary()
+{
+    if( !m_config.write_enabled() || m_kernels_since_write == 0 )
+        return;
+    if( m_config.m_cycle_period ) {
+        if( gpu_tot_sim_cycle - m_last_write_cycle < m_config.m_cycle_period )
+            return;
+    } else if( m_kernels_since_write < m_config.m_kernel_period ) {
+        return;
+    }
+
+    char filename[1024];
+    snprintf(filename, 1024, "%s.k%u", m_config.m_write_prefix, m_last_uid);
+    if( write(filename) )
+        printf("GPGPU-Sim uArch: checkpoint after kernel uid %u written to \"%s\" @ gpu_tot_sim_cycle %llu\n",
+               m_last_uid, filename, gpu_tot_sim_cycle);
+    else
+        printf("GPGPU-Sim uArch: WARNING ** failed to write checkpoint \"%s\"\n", filename);
+    m_kernels_since_write = 0;
+    m_last_write_cycle = gpu_tot_sim_cycle;
+}
+
+launch_skip_t checkpoint_manager::skip_kernel( const kernel_info_t &kernel )
+{
+    if( !m_restore_pending )
+        return LAUNCH_TIMED;
+    unsigned uid = kernel.get_uid();
+    if( uid > m_restore_uid ) {
+        // the checkpointed launch was never reached (different host path)
+        printf("GPGPU-Sim uArch: ERROR ** kernel uid %u launched before the checkpointed kernel uid %u was seen\n",
+               uid, m_restore_uid);
+        abort();
+    }
+    if( uid == m_restore_uid ) {
+        if( kernel.name() != m_restore_name ) {
+            printf("GPGPU-Sim uArch: ERROR ** checkpoint was taken after kernel \'%s\', launch uid %u is \'%s\'\n",
+                   m_restore_name.c_str(), uid, kernel.name().c_str());
+            abort();
+        }
+        if( !restore(m_config.m_restore_file) ) {
+            printf("GPGPU-Sim uArch: ERROR ** failed to restore checkpoint \"%s\"\n", m_config.m_restore_file);
+            abort();
+        }
+        m_restore_pending = false;
+        m_last_uid = uid;
+        m_last_name = kernel.name();
+        m_last_write_cycle = gpu_tot_sim_cycle;
+        printf("GPGPU-Sim uArch: restored checkpoint at kernel uid %u @ gpu_tot_sim_cycle %llu\n",
+               uid, gpu_tot_sim_cycle);
+        return LAUNCH_COVERED;
+    }
+    // the host may read what the kernel writes before the checkpointed launch
+    printf("GPGPU-Sim uArch: kernel uid %u \'%s\' executed functionally (before checkpoint)\n",
+           uid, kernel.name().c_str());
+    return LAUNCH_FUNCTIONAL;
+}
+
+void checkpoint_manager::get_cache_signature( const cache_config &config, cache_signature_t &sig )
+{
+    if( config.disabled() )
+        return;
+    sig.nset = config.get_nset();
+    sig.assoc = config.get_assoc();
+    sig.line_size = config.get_line_sz();
+    sig.replacement = config.get_replacement_policy();
+    sig.set_index = config.get_set_index_function();
+    sig.sectored = config.is_sectored();
+}
+
+void checkpoint_manager::get_signature( signature_t &sig ) const
+{
+    const shader_core_config *shader_config = m_gpu->m_shader_config;
+    const memory_config *mem_config = m_gpu->m_memory_config;
+    memset(&sig, 0, sizeof(sig));
+    sig.n_shader = shader_config->num_shader();
+    sig.n_mem_sub_partition = mem_config->m_n_mem_sub_partition;
+    sig.n_mem_link = mem_config->m_n_mem_link;
+    get_cache_signature(shader_config->m_L1D_config, sig.l1d);
+    get_cache_signature(mem_config->m_L2_config, sig.l2);
+    sig.l2_prefetcher = mem_config->m_L2_prefetch_config.m_type;
+    sig.compress_link = mem_config->compress_link;
+    sig.addr_hash = mem_config->m_address_mapping.hash_type();
+    sig.link_interleave = mem_config->m_link_interleave;
+}
+
+long checkpoint_manager::begin_section( FILE *fout, unsigned tag ) const
+{
+    unsigned long long length = 0;
+    fwrite(&tag, sizeof(tag), 1, fout);
+    fwrite(&SECTION_VERSION, sizeof(SECTION_VERSION), 1, fout);
+    long start = ftell(fout);
+    fwrite(&length, sizeof(length), 1, fout);
+    return start;
+}
+
+void checkpoint_manager::end_section( FILE *fout, long start ) const
+{
+    // patch the payload length in the section header
+    long end = ftell(fout);
+    unsigned long long length = end - start - sizeof(unsigned long long);
+    fseek(fout, start, SEEK_SET);
+    fwrite(&length, sizeof(length), 1, fout);
+    fseek(fout, end, SEEK_SET);
+}
+
+bool checkpoint_manager::write( const char *filename ) const
+{
+    FILE *fout = fopen(filename, "wb");
+    if( !fout )
+        return false;
+
+    // header
+    signature_t sig;
+    get_signature(sig);
+    unsigned name_len = m_last_name.size();
+    unsigned sig_size = sizeof(sig);
+    fwrite(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC), 1, fout);
+    fwrite(&CHECKPOINT_VERSION, sizeof(CHECKPOINT_VERSION), 1, fout);
+    fwrite(&m_last_uid, sizeof(m_last_uid), 1, fout);
+    fwrite(&name_len, sizeof(name_len), 1, fout);
+    fwrite(m_last_name.c_str(), name_len, 1, fout);
+    fwrite(&sig_size, sizeof(sig_size), 1, fout);
+    fwrite(&sig, sizeof(sig), 1, fout);
+
+    long start;
+    start = begin_section(fout, SEC_GLOBAL_MEM);
+    m_gpu->get_global_memory()->save(fout);
+    end_section(fout, start);
+    start = begin_section(fout, SEC_TEX_MEM);
+    m_gpu->get_tex_memory()->save(fout);
+    end_section(fout, start);
+    start = begin_section(fout, SEC_SURF_MEM);
+    m_gpu->get_surf_memory()->save(fout);
+    end_section(fout, start);
+
+    start = begin_section(fout, SEC_COUNTERS);
+    unsigned long long counters[N_COUNTERS] = {
+        gpu_tot_sim_cycle, m_gpu->gpu_tot_sim_insn, m_gpu->gpu_tot_issued_cta,
+        m_gpu->m_total_bw,
+        m_gpu->m_8Bw_bw, m_gpu->m_16Bw_bw, m_gpu->m_32Bw_bw, m_gpu->m_64Bw_bw, m_gpu->m_128Bw_bw,
+        m_gpu->m_8Br_bw, m_gpu->m_16Br_bw, m_gpu->m_32Br_bw, m_gpu->m_64Br_bw, m_gpu->m_128Br_bw
+    };
+    fwrite(&N_COUNTERS, sizeof(N_COUNTERS), 1, fout);
+    fwrite(counters, sizeof(counters), 1, fout);
+    unsigned long long n_range = m_gpu->m_malloc_list->size();
+    unsigned range_size = sizeof(m_gpu->m_malloc_list->front().second);
+    fwrite(&n_range, sizeof(n_range), 1, fout);
+    fwrite(&range_size, sizeof(range_size), 1, fout);
+    for( auto it = m_gpu->m_malloc_list->begin(); it != m_gpu->m_malloc_list->end(); it++ )
+        fwrite(&it->second, sizeof(it->second), 1, fout);
+    end_section(fout, start);
+
+    // the L2 lines below are placed by the moved regions
+    start = begin_section(fout, SEC_ADDRMAP);
+    m_gpu->m_memory_config->m_address_mapping.save_regions(fout);
+    end_section(fout, start);
+
+    start = begin_section(fout, SEC_L1D);
+    for( unsigned i=0; i < m_gpu->m_shader_config->n_simt_clusters; i++ )
+        m_gpu->m_cluster[i]->save_L1D(fout);
+    end_section(fout, start);
+
+    start = begin_section(fout, SEC_L2);
+    for( unsigned i=0; i < m_gpu->m_memory_config->m_n_mem_sub_partition; i++ )
+        m_gpu->m_memory_sub_partition[i]->save(fout);
+    end_section(fout, start);
+
+    start = begin_section(fout, SEC_LINK);
+    for( unsigned i=0; i < m_gpu->m_memory_config->m_n_mem_link; i++ )
+        m_gpu->m_memory_link[i]->save_stat(fout);
+    end_section(fout, start);
+
+    start = begin_section(fout, SEC_COMP);
+    if( g_comp )
+        g_comp->save(fout);
+    end_section(fout, start);
+
+    start = begin_section(fout, SEC_END);
+    end_section(fout, start);
+
+    bool ok = !ferror(fout);
+    fclose(fout);
+    return ok;
+}
+
+bool checkpoint_manager::read_header( const char *filename )
+{
+    FILE *fin = fopen(filename, "rb");
+    if( !fin )
+        return false;
+    char magic[8];
+    unsigned version = 0;
+    unsigned name_len = 0;
+    bool ok = fread(magic, sizeof(magic), 1, fin) == 1
+           && !memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic))
+           && fread(&version, sizeof(version), 1, fin) == 1
+           && version == CHECKPOINT_VERSION
+           && fread(&m_restore_uid, sizeof(m_restore_uid), 1, fin) == 1
+           && fread(&name_len, sizeof(name_len), 1, fin) == 1;
+    if( ok ) {
+        std::string name(name_len, '\0');
+        ok = name_len == 0 || fread(&name[0], name_len, 1, fin) == 1;
+        m_restore_name = name;
+    }
+    fclose(fin);
+    return ok;
+}
+
+bool checkpoint_manager::load_section( FILE *fin, unsigned tag, bool warm_state )
+{
+    switch( tag ) {
+    case SEC_GLOBAL_MEM: return m_gpu->get_global_memory()->load(fin);
+    case SEC_TEX_MEM: return m_gpu->get_tex_memory()->load(fin);
+    case SEC_SURF_MEM: return m_gpu->get_surf_memory()->load(fin);
+    case SEC_COUNTERS: {
+        unsigned long long counters[N_COUNTERS];
+        unsigned n_counters, range_size;
+        unsigned long long n_range;
+        if( fread(&n_counters, sizeof(n_counters), 1, fin) != 1 || n_counters != N_COUNTERS
+            || fread(counters, sizeof(counters), 1, fin) != 1 || fread(&n_range, sizeof(n_range), 1, fin) != 1
+            || fread(&range_size, sizeof(range_size), 1, fin) != 1 )
+            return false;
+        gpu_tot_sim_cycle = counters[0];
+        m_gpu->gpu_tot_sim_insn = counters[1];
+        m_gpu->gpu_tot_issued_cta = counters[2];
+        m_gpu->m_total_bw = counters[3];
+        m_gpu->m_8Bw_bw = counters[4];
+        m_gpu->m_16Bw_bw = counters[5];
+        m_gpu->m_32Bw_bw = counters[6];
+        m_gpu->m_64Bw_bw = counters[7];
+        m_gpu->m_128Bw_bw = counters[8];
+        m_gpu->m_8Br_bw = counters[9];
+        m_gpu->m_16Br_bw = counters[10];
+        m_gpu->m_32Br_bw = counters[11];
+        m_gpu->m_64Br_bw = counters[12];
+        m_gpu->m_128Br_bw = counters[13];
+        // per-range traffic only carries over with the same malloc.config
+        if( n_range == m_gpu->m_malloc_list->size() && range_size == sizeof(m_gpu->m_malloc_list->front().second) ) {
+            for( auto it = m_gpu->m_malloc_list->begin(); it != m_gpu->m_malloc_list->end(); it++ ) {
+                if( fread(&it->second, sizeof(it->second), 1, fin) != 1 )
+                    return false;
+            }
+        }
+        return true;
+    }
+    case SEC_L1D:
+        if( !warm_state ) return true;
+        for( unsigned i=0; i < m_gpu->m_shader_config->n_simt_clusters; i++ ) {
+            if( !m_gpu->m_cluster[i]->load_L1D(fin) )
+                return false;
+        }
+        return true;
+    case SEC_L2:
+        if( !warm_state ) return true;
+        for( unsigned i=0; i < m_gpu->m_memory_config->m_n_mem_sub_partition; i++ ) {
+            if( !m_gpu->m_memory_sub_partition[i]->load(fin) )
+                return false;
+        }
+        return true;
+    case SEC_LINK:
+        if( !warm_state ) return true;
+        for( unsigned i=0; i < m_gpu->m_memory_config->m_n_mem_link; i++ ) {
+            if( !m_gpu->m_memory_link[i]->load_stat(fin) )
+                return false;
+        }
+        return true;
+    case SEC_COMP:
+        if( !warm_state || !g_comp ) return true;
+        return g_comp->load(fin);
+    case SEC_ADDRMAP:
+        if( !warm_state ) return true;
+        return m_gpu->m_memory_config->m_address_mapping.load_regions(fin);
+    default:
+        // unknown section from a newer writer
+        return true;
+    }
+}
+
+bool checkpoint_manager::restore( const char *filename )
+{
+    FILE *fin = fopen(filename, "rb");
+    if( !fin )
+        return false;
+
+    char magic[8];
+    unsigned version, uid, name_len, sig_size;
+    signature_t sig, cur;
+    if( fread(magic, sizeof(magic), 1, fin) != 1 || fread(&version, sizeof(version), 1, fin) != 1
+        || fread(&uid, sizeof(uid), 1, fin) != 1 || fread(&name_len, sizeof(name_len), 1, fin) != 1
+        || fseek(fin, name_len, SEEK_CUR) || fread(&sig_size, sizeof(sig_size), 1, fin) != 1 ) {
+        fclose(fin);
+        return false;
+    }
+    // a signature of another size comes from a different build: no warm state
+    memset(&sig, 0, sizeof(sig));
+    if( sig_size == sizeof(sig) ? fread(&sig, sizeof(sig), 1, fin) != 1 : fseek(fin, sig_size, SEEK_CUR) != 0 ) {
+        fclose(fin);
+        return false;
+    }
+    get_signature(cur);
+    bool warm_state = sig_size == sizeof(sig) && !memcmp(&sig, &cur, sizeof(sig));
+    if( !warm_state )
+        printf("GPGPU-Sim uArch: WARNING ** checkpoint cache/link configuration differs, restoring memory and counters only\n");
+
+    bool ok = true;
+    while( ok ) {
+        unsigned tag, section_version;
+        unsigned long long length;
+        if( fread(&tag, sizeof(tag), 1, fin) != 1 || fread(&section_version, sizeof(section_version), 1, fin) != 1
+            || fread(&length, sizeof(length), 1, fin) != 1 ) {
+            ok = false;
+            break;
+        }
+        if( tag == SEC_END )
+            break;
+        long start = ftell(fin);
+        if( section_version != SECTION_VERSION || !load_section(fin, tag, warm_state) ) {
+            if( tag >= SEC_L1D ) {
+                printf("GPGPU-Sim uArch: WARNING ** checkpoint section %u does not match this configuration, skipped\n", tag);
+            } else {
+                ok = false;
+                break;
+            }
+        }
+        fseek(fin, start + length, SEEK_SET);
+    }
+    fclose(fin);
+    return ok;
+}
@@ -0,0 +1,111 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include "../option_parser.h"
+#include "../abstract_hardware_model.h"
+#include "gpu-misc.h"
+
+//--------------------------------------------------------------------
+// Simulation checkpoints
+//
+// A checkpoint is written at a kernel boundary, when the timing model is
+// drained (no CTA, warp, MSHR, DRAM or link queue entry is in flight), so
+// the state that carries over to the next kernel is the functional memory,
+// the L1D/L2 tag arrays, the link compressor history and the cumulative
+// counters. To resume, the same application is run again with
+// -checkpoint_restore: kernel launches before the checkpointed one are
+// executed functionally (not timed), so the host still reads their
+// results, and at the checkpointed launch the saved state is loaded.
+//
+// File layout: header (with the size of the signature), then sections
+// {tag, payload version, byte length, payload}. The microarchitectural
+// sections (caches, compressor, links) are only loaded when the
+// cache/link configuration matches, so one checkpoint can seed a
+// parameter sweep; memory and counters are always restored.
+//--------------------------------------------------------------------
+struct checkpoint_config {
+    void reg_options( option_parser_t opp );
+
+    bool write_enabled() const { return m_write_prefix && strcmp(m_write_prefix,"none"); }
+    bool restore_enabled() const { return m_restore_file && strcmp(m_restore_file,"none"); }
+
+    char *m_write_prefix;
+    unsigned m_kernel_period;
+    unsigned long long m_cycle_period;
+    char *m_restore_file;
+};
+
+class checkpoint_manager {
+public:
+    checkpoint_manager( const checkpoint_config &config, class gpgpu_sim *gpu );
+
+    // gpgpu_sim::set_kernel_done
+    void kernel_done( const kernel_info_t &kernel );
+    // gpgpu_sim::update_stats, with the pipeline drained
+    void kernel_boundary();
+    // kernel launch: how a launch before the restored checkpoint is run
+    launch_skip_t skip_kernel( const kernel_info_t &kernel );
+
+private:
+    enum section_t {
+        SEC_GLOBAL_MEM = 1,
+        SEC_TEX_MEM,
+        SEC_SURF_MEM,
+        SEC_COUNTERS,
+        SEC_L1D,
+        SEC_L2,
+        SEC_LINK,
+        SEC_COMP,
+        SEC_ADDRMAP,
+        SEC_END
+    };
+
+    // everything that places or replaces a line
+    struct cache_signature_t {
+        unsigned nset;
+        unsigned assoc;
+        unsigned line_size;
+        int replacement;
+        int set_index;
+        int sectored;
+    };
+
+    struct signature_t {
+        unsigned n_shader;
+        unsigned n_mem_sub_partition;
+        unsigned n_mem_link;
+        cache_signature_t l1d;
+        cache_signature_t l2;
+        int l2_prefetcher;
+        int compress_link;
+        int addr_hash;
+        int link_interleave;
+    };
+
+    static void get_cache_signature( const class cache_config &config, cache_signature_t &sig );
+    void get_signature( signature_t &sig ) const;
+    bool write( const char *filename ) const;
+    bool restore( const char *filename );
+    long begin_section( FILE *fout, unsigned tag ) const;
+    void end_section( FILE *fout, long start ) const;
+    bool load_section( FILE *fin, unsigned tag, bool warm_state );
+    bool read_header( const char *filename );
+
+    const checkpoint_config &m_config;
+    class gpgpu_sim *m_gpu;
+
+    unsigned m_last_uid;
+    std::string m_last_name;
+    unsigned m_kernels_since_write;
+    unsigned long long m_last_write_cycle;
+
+    // restore
+    bool m_restore_pending;
+    unsigned m_restore_uid;
+    std::string m_restore_name;
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <limits.h>
 #include "comp.h"
+#include "stat_registry.h"
 
 compressor *g_comp;
 
@@ -52,10 +53,7 @@ void virtual_stream_comp::init() {
     std::sort(patternInfoVector.begin(), patternInfoVector.end());
 }
 
-unsigned virtual_stream_comp::compress(virtual_stream_id id, unsigned char *in, new_addr_type addr, size_t size) {
-    assert(size==BYTES_PER_BLK);
-
-    // 1. find an existing stream
+virtual_stream *virtual_stream_comp::get_stream(virtual_stream_id id) {
     auto it = vsmap.find(id);
     if (it==vsmap.end()) {
         virtual_stream *new_stream = new virtual_stream(id, fifo_depth);
@@ -63,7 +61,14 @@ unsigned virtual_stream_comp::compress(virtual_stream_id id, unsigned char *in,
         it = vsmap.find(id);
     }
     assert(it!=vsmap.end());
-    virtual_stream *vs = it->second;
+    return it->second;
+}
+
+unsigned virtual_stream_comp::compress(virtual_stream_id id, unsigned char *in, new_addr_type addr, size_t size) {
+    assert(size==BYTES_PER_BLK);
+
+    // 1. find an existing stream
+    virtual_stream *vs = get_stream(id);
 
     // 2. compress a block
     mblock new_block;
@@ -104,6 +109,53 @@ unsigned virtual_stream_comp::compress(virtual_stream_id id, unsigned char *in,
     return block_length;
 }
 
+void virtual_stream_comp::warm(virtual_stream_id id, unsigned char *in, new_addr_type addr, size_t size) {
+    assert(size==BYTES_PER_BLK);
+
+    // only shift the words into the history FIFO; patterns are not profiled
+    virtual_stream *vs = get_stream(id);
+    for (int i=0; i<WORDS_PER_BLK; i++) {
+        mword new_word = 0ull;
+        for (int j=0; j<8; j++) {
+            new_word = (new_word<<8) | in[i*8+(7-j)];
+        }
+        vs->push(new_word);
+    }
+}
+
+void virtual_stream_comp::save(FILE *fd) const {
+    // only the history FIFOs are saved; the pattern profile restarts empty
+    unsigned long long n_stream = vsmap.size();
+    fwrite(&n_stream, sizeof(n_stream), 1, fd);
+    for (auto it=vsmap.begin(); it!=vsmap.end(); ++it) {
+        virtual_stream_id id = it->first;
+        unsigned long long n_word = it->second->size();
+        fwrite(&id, sizeof(id), 1, fd);
+        fwrite(&n_word, sizeof(n_word), 1, fd);
+        for (auto w=it->second->begin(); w!=it->second->end(); ++w) {
+            mword word = *w;
+            fwrite(&word, sizeof(word), 1, fd);
+        }
+    }
+}
+
+bool virtual_stream_comp::load(FILE *fd) {
+    unsigned long long n_stream = 0;
+    if (fread(&n_stream, sizeof(n_stream), 1, fd) != 1) return false;
+    for (unsigned long long i=0; i<n_stream; i++) {
+        virtual_stream_id id;
+        unsigned long long n_word;
+        if (fread(&id, sizeof(id), 1, fd) != 1) return false;
+        if (fread(&n_word, sizeof(n_word), 1, fd) != 1) return false;
+        virtual_stream *vs = get_stream(id);
+        if (n_word != vs->size()) return false;
+        for (auto w=vs->begin(); w!=vs->end(); ++w) {
+            if (fread(&(*w), sizeof(mword), 1, fd) != 1) return false;
+        }
+    }
+    return true;
+}
+
 void virtual_stream_comp::dump_profile(FILE *fd) {
     dump_pattern_info(fd);
     //dump_escape_info(fd);
@@ -231,6 +283,37 @@ void virtual_stream_comp::dump_pattern_info(FILE *fd) {
 
 }
 
+// per-pattern word counts of reads (stream id bit 63 clear) and writes, as in dump_pattern_info
+void virtual_stream_comp::pattern_stats(const void *arg, stat_writer &out) {
+    const virtual_stream_comp *comp = (const virtual_stream_comp *) arg;
+    const char *dir[2] = { "rd", "wr" };
+    for (unsigned d=0; d<2; d++) {
+        unsigned long long total = 0ull;
+        unsigned long long escape = 0ull;
+        for (auto it2 = comp->vsmap.begin(); it2 != comp->vsmap.end(); ++it2) {
+            if ((it2->first>>63) == d) {
+                total += it2->second->prof_data->get_word_count();
+                escape += it2->second->prof_data->get_escape_count();
+            }
+        }
+        out.value(string(dir[d]) + ".total", total);
+        for (auto it = comp->patternInfoVector.begin(); it!=comp->patternInfoVector.end(); ++it) {
+            unsigned long long this_pattern_count = 0ull;
+            for (auto it2 = comp->vsmap.begin(); it2 != comp->vsmap.end(); ++it2) {
+                if ((it2->first>>63) == d) {
+                    this_pattern_count += it2->second->prof_data->get_pattern_count(it->ID);
+                }
+            }
+            out.value(string(dir[d]) + "." + it->name, this_pattern_count);
+        }
+        out.value(string(dir[d]) + ".ESC", escape);
+    }
+}
+
+void virtual_stream_comp::reg_stats(stat_registry &stats) const {
+    stats.reg_group("comp", pattern_stats, this);
+}
+
 void virtual_stream_comp::dump_escape_info(FILE *fd) {
     map<unsigned long long, unsigned long long> map_total;
     // 1. merge escape maps
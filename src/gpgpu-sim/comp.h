@@ -18,6 +18,8 @@
 typedef unsigned long long mword;
 typedef unsigned long long virtual_stream_id;
 
+class stat_registry;
+
 #define VSC_FIFO_DEPTH  32
 #define WORDS_PER_BLK   16
 #define BYTES_PER_BLK   (WORDS_PER_BLK*8)
@@ -161,7 +163,14 @@ public:
     compressor() {}
 
     virtual unsigned compress(virtual_stream_id id, unsigned char *in, new_addr_type addr, size_t size) { return 0; }
+    // update the history a stateful compressor keeps, without profiling (fast-forward warm-up)
+    virtual void warm(virtual_stream_id id, unsigned char *in, new_addr_type addr, size_t size) {}
+    // checkpoint of the compressor history (stateless compressors keep nothing)
+    virtual void save(FILE *fd) const {}
+    virtual bool load(FILE *fd) { return true; }
     virtual void dump_profile(FILE *fd) {}
+    // named statistics for -gpgpu_stats_json / -gpgpu_stats_csv
+    virtual void reg_stats(stat_registry &stats) const {}
 };
 
 class virtual_stream_comp : public compressor {
@@ -172,9 +181,16 @@ public:
     void init();
     //void registerPatternInfo(string name, unsigned opcodeSize);
     unsigned compress(virtual_stream_id id, unsigned char *in, new_addr_type addr, size_t size);
+    void warm(virtual_stream_id id, unsigned char *in, new_addr_type addr, size_t size);
+    void save(FILE *fd) const;
+    bool load(FILE *fd);
     void dump_profile(FILE *fd);
     void dump_pattern_info(FILE *fd);
     void dump_escape_info(FILE *fd);
+    void reg_stats(stat_registry &stats) const;
+private:
+    static void pattern_stats(const void *comp, class stat_writer &out);
+    virtual_stream *get_stream(virtual_stream_id id);
 public:
     vector<PatternInfo> patternInfoVector;
     int fifo_depth;
@@ -222,6 +238,24 @@ public:
         }
     }
 
+    void warm(virtual_stream_id id, unsigned char*in, new_addr_type addr, size_t size) {
+        assert(size==128);
+        CACHELINE_DATA raw_buffer;
+        for (unsigned i=0; i<_MAX_BYTES_PER_LINE; i++) {
+            raw_buffer.byte[i] = in[i];
+        }
+        prev_data = raw_buffer.dword[_MAX_DWORDS_PER_LINE-1];
+    }
+    void save(FILE *fd) const {
+        fwrite(&prev_data, sizeof(prev_data), 1, fd);
+        fwrite(&total_line_cnt, sizeof(total_line_cnt), 1, fd);
+        fwrite(comp_line_size_cnt, sizeof(comp_line_size_cnt), 1, fd);
+    }
+    bool load(FILE *fd) {
+        return (fread(&prev_data, sizeof(prev_data), 1, fd) == 1)
+            && (fread(&total_line_cnt, sizeof(total_line_cnt), 1, fd) == 1)
+            && (fread(comp_line_size_cnt, sizeof(comp_line_size_cnt), 1, fd) == 1);
+    }
     unsigned compress(virtual_stream_id id, unsigned char*in, new_addr_type addr, size_t size) {
         assert(size==128);
         // copy
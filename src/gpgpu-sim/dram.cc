@@ -34,6 +34,7 @@
 #include "mem_fetch.h"
 #include "l2cache.h"
 #include "comp.h"
+#include <algorithm>
 
 #ifdef DRAM_VERIFY
 int PRINT_CYCLE = 0;
@@ -194,8 +195,10 @@ void dram_t::scheduler_fifo()
       dram_req_t *head_mrqq = mrqq->top();
       head_mrqq->data->set_status(IN_PARTITION_MC_BANK_ARB_QUEUE,gpu_sim_cycle+gpu_tot_sim_cycle);
       bkn = head_mrqq->bk;
-      if (!bk[bkn]->mrq) 
+      if (!bk[bkn]->mrq) {
          bk[bkn]->mrq = mrqq->pop();
+         mf_trace(MFT_DRAM, gpu_sim_cycle+gpu_tot_sim_cycle, head_mrqq->data->get_request_uid(), id, bkn, head_mrqq->row);
+      }
    }
 }
 
@@ -421,6 +424,58 @@ void dram_t::cycle()
 #endif
 }
 
+bool dram_t::idle() const
+{
+   if( !mrqq->empty() || rwq->get_n_element() || !returnq->empty() || que_length() )
+      return false;
+   for (unsigned j=0;j<m_config->nbk;j++) {
+      if( bk[j]->mrq )
+         return false;
+   }
+   return true;
+}
+
+#define SUB2ZERO(x,n) x = ((x) > (n))? (x-(n)) : 0;
+
+void dram_t::skip_cycles( unsigned long long n )
+{
+   assert( idle() );
+   // cycles with a timing constraint still pending count as activity
+   unsigned active = std::max(std::max(RRDc, CCDc), std::max(RTWc, WTRc));
+   for (unsigned j=0;j<m_config->nbk;j++) {
+      active = std::max(active, std::max(std::max(bk[j]->RCDc, bk[j]->RASc), bk[j]->RCc));
+      active = std::max(active, std::max(bk[j]->RPc, bk[j]->RCDWRc));
+      bk[j]->n_idle += n;
+   }
+   if( active > n ) active = n;
+   n_activity += active;
+   n_activity_partial += active;
+   n_nop += n;
+   n_nop_partial += n;
+   n_cmd += n;
+   n_cmd_partial += n;
+
+   SUB2ZERO(RRDc,n);
+   SUB2ZERO(CCDc,n);
+   SUB2ZERO(RTWc,n);
+   SUB2ZERO(WTRc,n);
+   for (unsigned j=0;j<m_config->nbk;j++) {
+      SUB2ZERO(bk[j]->RCDc,n);
+      SUB2ZERO(bk[j]->RASc,n);
+      SUB2ZERO(bk[j]->RCc,n);
+      SUB2ZERO(bk[j]->RPc,n);
+      SUB2ZERO(bk[j]->RCDWRc,n);
+      SUB2ZERO(bk[j]->WTPc,n);
+      SUB2ZERO(bk[j]->RTPc,n);
+   }
+   for (unsigned j=0; j<m_config->nbkgrp; j++) {
+      SUB2ZERO(bkgrp[j]->CCDLc,n);
+      SUB2ZERO(bkgrp[j]->RTPLc,n);
+   }
+   // the queue is empty on every skipped cycle (dram_log(SAMPLELOG))
+   StatAddSamples(mrqq_Dist, que_length(), n);
+}
+
 //if mrq is being serviced by dram, gets popped after CL latency fulfilled
 class mem_fetch* dram_t::return_queue_pop() 
 {
@@ -475,6 +530,19 @@ void dram_t::visualize() const
       m_frfcfs_scheduler->print(stdout);
 }
 
+void dram_t::reg_stats( stat_registry &r ) const
+{
+   char name[32];
+   snprintf(name, sizeof(name), "dram[%u].", id);
+   std::string n(name);
+   r.reg_counter(n + "n_cmd", &n_cmd);
+   r.reg_counter(n + "n_activity", &n_activity);
+   r.reg_counter(n + "n_rd", &n_rd);
+   r.reg_counter(n + "n_wr", &n_wr);
+   r.reg_ratio(n + "bw_util", &bwutil, &n_cmd);
+   r.reg_ratio(n + "dram_eff", &bwutil, &n_activity);
+}
+
 void dram_t::print_stat( FILE* simFile ) 
 {
    fprintf(simFile,"DRAM (%d): n_cmd=%d n_nop=%d n_act=%d n_pre=%d n_req=%d n_rd=%d n_write=%d bw_util=%.4g ",
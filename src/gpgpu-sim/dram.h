@@ -94,26 +94,34 @@ class dram_t
 public:
    dram_t( unsigned int parition_id, const struct memory_config *config, class memory_stats_t *stats, 
            class memory_partition_unit *mp );
+   virtual ~dram_t() {}
 
-   bool full() const;
-   void print( FILE* simFile ) const;
-   void visualize() const;
-   void print_stat( FILE* simFile );
-   unsigned que_length() const; 
+   virtual bool full() const;
+   virtual void print( FILE* simFile ) const;
+   virtual void visualize() const;
+   virtual void print_stat( FILE* simFile );
+   virtual unsigned que_length() const; 
    bool returnq_full() const;
    unsigned int queue_limit() const;
    void visualizer_print( gzFile visualizer_file );
 
    class mem_fetch* return_queue_pop();
    class mem_fetch* return_queue_top();
-   void push( class mem_fetch *data );
-   void cycle();
+   virtual void push( class mem_fetch *data );
+   virtual void cycle();
+   // no request anywhere in the DRAM: cycle() only counts down the timing
+   // constraints and collects stats, which skip_cycles() does in bulk
+   virtual bool idle() const;
+   virtual void skip_cycles( unsigned long long n );
    void dram_log (int task);
 
    class memory_partition_unit *m_memory_partition_unit;
    unsigned int id;
 
    // Power Model
+   // n_cmd, n_activity, bw_util and dram_eff of print_stat as dram[id].*
+   void reg_stats( class stat_registry &r ) const;
+
    void set_dram_power_stats(unsigned &cmd,
 								unsigned &activity,
 								unsigned &nop,
@@ -123,9 +131,12 @@ public:
 								unsigned &wr,
 								unsigned &req) const;
 
-private:
+protected:
    void scheduler_fifo();
    void scheduler_frfcfs();
+   // stats of a request entering the scheduler queue / reaching its bank
+   void account_queued( dram_req_t *req );
+   void account_mrq_latency( dram_req_t *req );
 
    const struct memory_config *m_config;
 
@@ -31,26 +31,73 @@
 #include "shader.h"
 #include "../cuda-sim/memory.h"
 #include "mem_latency_stat.h"
+#include "parallel.h"
 
 extern gpgpu_sim* g_the_gpu;
 extern memory_space *g_global_mem;
 extern memory_space *g_tex_mem;
 
+void dram_sched_config::reg_options( option_parser_t opp )
+{
+   option_parser_register(opp, "-gpgpu_dram_sched_policy", OPT_CSTR, &m_policy_string,
+               "FR-FCFS request priority (frfcfs, bliss, atlas)",
+               "frfcfs");
+   option_parser_register(opp, "-gpgpu_dram_write_drain", OPT_CSTR, &m_write_drain_string,
+               "hold writes until <high> are queued, then drain them to <low> {<high>:<low> | 0 = off}",
+               "0");
+   option_parser_register(opp, "-gpgpu_dram_bliss", OPT_CSTR, &m_bliss_string,
+               "BLISS blacklisting {<consecutive requests>:<clearing interval>}",
+               "4:10000");
+   option_parser_register(opp, "-gpgpu_dram_atlas", OPT_CSTR, &m_atlas_string,
+               "ATLAS ranking {<quantum>:<starvation cap>} in cycles",
+               "10000:5000");
+}
+
+void dram_sched_config::init( unsigned queue_size )
+{
+   if ( !strcmp(m_policy_string,"frfcfs") )
+      m_policy = DRAM_SCHED_FRFCFS;
+   else if ( !strcmp(m_policy_string,"bliss") )
+      m_policy = DRAM_SCHED_BLISS;
+   else if ( !strcmp(m_policy_string,"atlas") )
+      m_policy = DRAM_SCHED_ATLAS;
+   else {
+      printf("GPGPU-Sim uArch: ERROR ** unknown DRAM scheduling policy '%s'\n", m_policy_string);
+      exit(1);
+   }
+   m_write_high = 0;
+   m_write_low = 0;
+   if ( sscanf(m_write_drain_string, "%u:%u", &m_write_high, &m_write_low) == 1 )
+      m_write_low = m_write_high / 2;
+   assert( m_write_low <= m_write_high );
+   // writes that can never reach the high watermark would only be served
+   // on banks without reads
+   if ( queue_size && m_write_high > queue_size ) {
+      printf("GPGPU-Sim uArch: WARNING ** -gpgpu_dram_write_drain high watermark %u exceeds the %u entry scheduler queue, clamped\n",
+             m_write_high, queue_size);
+      m_write_high = queue_size;
+      if ( m_write_low > m_write_high )
+         m_write_low = m_write_high / 2;
+   }
+   m_bliss_threshold = 4;
+   m_bliss_clear = 10000;
+   sscanf(m_bliss_string, "%u:%u", &m_bliss_threshold, &m_bliss_clear);
+   m_atlas_quantum = 10000;
+   m_atlas_cap = 5000;
+   sscanf(m_atlas_string, "%u:%u", &m_atlas_quantum, &m_atlas_cap);
+   if ( m_bliss_clear == 0 ) m_bliss_clear = 1;
+   if ( m_atlas_quantum == 0 ) m_atlas_quantum = 1;
+}
+
 frfcfs_scheduler::frfcfs_scheduler( const memory_config *config, dram_t *dm, memory_stats_t *stats )
+   : m_queue( config->nbk, config->gpgpu_frfcfs_dram_sched_queue_size, config->m_dram_sched_config )
 {
    m_config = config;
    m_stats = stats;
-   m_num_pending = 0;
    m_dram = dm;
-   m_queue = new std::list<dram_req_t*>[m_config->nbk];
-   m_bins = new std::map<unsigned,std::list<std::list<dram_req_t*>::iterator> >[ m_config->nbk ];
-   m_last_row = new std::list<std::list<dram_req_t*>::iterator>*[ m_config->nbk ];
    curr_row_service_time = new unsigned[m_config->nbk];
    row_service_timestamp = new unsigned[m_config->nbk];
    for ( unsigned i=0; i < m_config->nbk; i++ ) {
-      m_queue[i].clear();
-      m_bins[i].clear();
-      m_last_row[i] = NULL;
       curr_row_service_time[i] = 0;
       row_service_timestamp[i] = 0;
    }
@@ -59,10 +106,8 @@ frfcfs_scheduler::frfcfs_scheduler( const memory_config *config, dram_t *dm, mem
 
 void frfcfs_scheduler::add_req( dram_req_t *req )
 {
-   m_num_pending++;
-   m_queue[req->bk].push_front(req);
-   std::list<dram_req_t*>::iterator ptr = m_queue[req->bk].begin();
-   m_bins[req->bk][req->row].push_front( ptr ); //newest reqs to the front
+   m_queue.add( req, req->bk, req->row, m_queue.source(req->data->get_sid()), 
+                req->data->get_is_write(), gpu_sim_cycle + gpu_tot_sim_cycle );
 }
 
 void frfcfs_scheduler::data_collection(unsigned int bank)
@@ -83,42 +128,19 @@ void frfcfs_scheduler::data_collection(unsigned int bank)
 
 dram_req_t *frfcfs_scheduler::schedule( unsigned bank, unsigned curr_row )
 {
-   if ( m_last_row[bank] == NULL ) {
-      if ( m_queue[bank].empty() )
-         return NULL;
-
-      std::map<unsigned,std::list<std::list<dram_req_t*>::iterator> >::iterator bin_ptr = m_bins[bank].find( curr_row );
-      if ( bin_ptr == m_bins[bank].end()) {
-         dram_req_t *req = m_queue[bank].back();
-         bin_ptr = m_bins[bank].find( req->row );
-         assert( bin_ptr != m_bins[bank].end() ); // where did the request go???
-         m_last_row[bank] = &(bin_ptr->second);
-         data_collection(bank);
-      } else {
-         m_last_row[bank] = &(bin_ptr->second);
-
-      }
-   }
-   std::list<dram_req_t*>::iterator next = m_last_row[bank]->back();
-   dram_req_t *req = (*next);
+   bool activate = false;
+   dram_req_t *req = m_queue.schedule( bank, curr_row, gpu_sim_cycle + gpu_tot_sim_cycle, activate );
+   if ( req == NULL )
+      return NULL;
+   if ( activate )
+      data_collection(bank);
 
    m_stats->concurrent_row_access[m_dram->id][bank]++;
    m_stats->row_access[m_dram->id][bank]++;
-   m_last_row[bank]->pop_back();
-
-   m_queue[bank].erase(next);
-   if ( m_last_row[bank]->empty() ) {
-      m_bins[bank].erase( req->row );
-      m_last_row[bank] = NULL;
-   }
 #ifdef DEBUG_FAST_IDEAL_SCHED
-   if ( req )
-      printf("%08u : DRAM(%u) scheduling memory request to bank=%u, row=%u\n", 
-             (unsigned)gpu_sim_cycle, m_dram->id, req->bk, req->row );
+   printf("%08u : DRAM(%u) scheduling memory request to bank=%u, row=%u\n", 
+          (unsigned)gpu_sim_cycle, m_dram->id, req->bk, req->row );
 #endif
-   assert( req != NULL && m_num_pending != 0 ); 
-   m_num_pending--;
-
    return req;
 }
 
@@ -126,34 +148,52 @@ dram_req_t *frfcfs_scheduler::schedule( unsigned bank, unsigned curr_row )
 void frfcfs_scheduler::print( FILE *fp )
 {
    for ( unsigned b=0; b < m_config->nbk; b++ ) {
-      printf(" %u: queue length = %u\n", b, (unsigned)m_queue[b].size() );
+      printf(" %u: queue length = %u\n", b, m_queue.size(b) );
    }
+   m_queue.print(stdout);
 }
 
-void dram_t::scheduler_frfcfs()
+void dram_t::account_queued( dram_req_t *req )
 {
-   unsigned mrq_latency;
-   frfcfs_scheduler *sched = m_frfcfs_scheduler;
-   while ( !mrqq->empty() && (!m_config->gpgpu_frfcfs_dram_sched_queue_size || sched->num_pending() < m_config->gpgpu_frfcfs_dram_sched_queue_size)) {
-      dram_req_t *req = mrqq->pop();
+   // Power stats
+   //if(req->data->get_type() != READ_REPLY && req->data->get_type() != WRITE_ACK)
+   sim_thread_pool::add(m_stats->total_n_access, 1);
+
+   if(req->data->get_type() == WRITE_REQUEST){
+      sim_thread_pool::add(m_stats->total_n_writes, 1);
+   } else if(req->data->get_type() == READ_REQUEST){
+      sim_thread_pool::add(m_stats->total_n_reads, 1);
+   }
 
-      // Power stats
-      //if(req->data->get_type() != READ_REPLY && req->data->get_type() != WRITE_ACK)
-      m_stats->total_n_access++;
+   req->data->set_status(IN_PARTITION_MC_INPUT_QUEUE,gpu_sim_cycle+gpu_tot_sim_cycle);
+   mem_fetch *mf = req->data;
+   assert(mf!=NULL);
+   sim_thread_pool::lock();
+   g_the_gpu->update_traffic(mf);
+   sim_thread_pool::unlock();
+}
 
-      if(req->data->get_type() == WRITE_REQUEST){
-    	  m_stats->total_n_writes++;
-      } else if(req->data->get_type() == READ_REQUEST){
-    	  m_stats->total_n_reads++;
+void dram_t::account_mrq_latency( dram_req_t *req )
+{
+   if (m_config->gpgpu_memlatency_stat) {
+      unsigned mrq_latency = gpu_sim_cycle + gpu_tot_sim_cycle - req->timestamp;
+      req->timestamp = gpu_tot_sim_cycle + gpu_sim_cycle;
+      sim_thread_pool::lock();
+      m_stats->mrq_lat_table[LOGB2(mrq_latency)]++;
+      if (mrq_latency > m_stats->max_mrq_latency) {
+         m_stats->max_mrq_latency = mrq_latency;
       }
+      sim_thread_pool::unlock();
+   }
+}
 
-      req->data->set_status(IN_PARTITION_MC_INPUT_QUEUE,gpu_sim_cycle+gpu_tot_sim_cycle);
+void dram_t::scheduler_frfcfs()
+{
+   frfcfs_scheduler *sched = m_frfcfs_scheduler;
+   while ( !mrqq->empty() && (!m_config->gpgpu_frfcfs_dram_sched_queue_size || sched->num_pending() < m_config->gpgpu_frfcfs_dram_sched_queue_size)) {
+      dram_req_t *req = mrqq->pop();
+      account_queued(req);
       sched->add_req(req);
-      {
-          mem_fetch *mf = req->data;
-          assert(mf!=NULL);
-          g_the_gpu->update_traffic(mf);
-      }
    }
 
    dram_req_t *req;
@@ -168,14 +208,8 @@ void dram_t::scheduler_frfcfs()
             req->data->set_status(IN_PARTITION_MC_BANK_ARB_QUEUE,gpu_sim_cycle+gpu_tot_sim_cycle);
             prio = (prio+1)%m_config->nbk;
             bk[b]->mrq = req;
-            if (m_config->gpgpu_memlatency_stat) {
-               mrq_latency = gpu_sim_cycle + gpu_tot_sim_cycle - bk[b]->mrq->timestamp;
-               bk[b]->mrq->timestamp = gpu_tot_sim_cycle + gpu_sim_cycle;
-               m_stats->mrq_lat_table[LOGB2(mrq_latency)]++;
-               if (mrq_latency > m_stats->max_mrq_latency) {
-                  m_stats->max_mrq_latency = mrq_latency;
-               }
-            }
+            mf_trace(MFT_DRAM, gpu_sim_cycle+gpu_tot_sim_cycle, req->data->get_request_uid(), id, b, req->row);
+            account_mrq_latency(req);
 
             break;
          }
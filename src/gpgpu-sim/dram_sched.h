@@ -29,11 +29,10 @@
 #define dram_sched_h_INCLUDED
 
 #include "dram.h"
+#include "dram_sched_queue.h"
 #include "shader.h"
 #include "gpu-sim.h"
 #include "gpu-misc.h"
-#include <list>
-#include <map>
 
 class frfcfs_scheduler {
 public:
@@ -42,15 +41,12 @@ public:
    void data_collection(unsigned bank);
    dram_req_t *schedule( unsigned bank, unsigned curr_row );
    void print( FILE *fp );
-   unsigned num_pending() const { return m_num_pending;}
+   unsigned num_pending() const { return m_queue.size();}
 
 private:
    const memory_config *m_config;
    dram_t *m_dram;
-   unsigned m_num_pending;
-   std::list<dram_req_t*>                                    *m_queue;
-   std::map<unsigned,std::list<std::list<dram_req_t*>::iterator> >    *m_bins;
-   std::list<std::list<dram_req_t*>::iterator>                 **m_last_row;
+   dram_sched_queue<dram_req_t> m_queue;
    unsigned *curr_row_service_time; //one set of variables for each bank.
    unsigned *row_service_timestamp; //tracks when scheduler began servicing current row
 
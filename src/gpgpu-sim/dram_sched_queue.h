@@ -0,0 +1,354 @@
+#ifndef DRAM_SCHED_QUEUE_H
+#define DRAM_SCHED_QUEUE_H
+
+#include <assert.h>
+#include <stdio.h>
+#include <vector>
+#include "../option_parser.h"
+
+//--------------------------------------------------------------------
+// Request queues of the FR-FCFS DRAM scheduler.
+//
+// All pending requests of a channel live in one node pool that grows to
+// the scheduler queue size once and is then reused, so queueing a request
+// does not allocate. Each bank links its nodes oldest-first, and also
+// hashes them by row into buckets kept oldest-first, so the oldest request
+// to the open row is the first match in one short bucket.
+//
+// Policies (all fall back to FR-FCFS: open-row hits, then the oldest):
+//   frfcfs  the classic policy; a row stays open until it has no requests
+//   bliss   a source served more than <threshold> times in a row is
+//           blacklisted until the next clearing; other sources go first
+//   atlas   sources that attained the least service over the past quanta
+//           go first; requests older than the starvation cap go first of all
+// With write drain (high watermark > 0) writes wait while reads are
+// pending until <high> of them are queued, and are then served down to
+// <low>, so the data bus turns around less often.
+//--------------------------------------------------------------------
+enum dram_sched_policy_t {
+   DRAM_SCHED_FRFCFS = 0,
+   DRAM_SCHED_BLISS,
+   DRAM_SCHED_ATLAS
+};
+
+struct dram_sched_config {
+   void reg_options( option_parser_t opp );
+   // queue_size: requests the scheduler holds (0 = unbounded)
+   void init( unsigned queue_size );
+
+   char *m_policy_string;
+   char *m_write_drain_string;
+   char *m_bliss_string;
+   char *m_atlas_string;
+   enum dram_sched_policy_t m_policy;
+   unsigned m_write_high;     // 0 = no write drain
+   unsigned m_write_low;
+   unsigned m_bliss_threshold;
+   unsigned m_bliss_clear;    // cycles between blacklist clearings
+   unsigned m_atlas_quantum;  // cycles per ranking quantum
+   unsigned m_atlas_cap;      // starvation cap in cycles
+};
+
+template<class REQ> class dram_sched_queue {
+public:
+   static const unsigned MAX_SOURCES = 64;  // the last one collects requests without a core
+   static const unsigned N_BUCKET = 16;      // row buckets per bank
+
+   dram_sched_queue( unsigned n_banks, unsigned capacity, const dram_sched_config &config )
+      : m_config(config)
+   {
+      m_n_banks = n_banks;
+      m_nodes.reserve(capacity);
+      m_free.reserve(capacity);
+      m_head.assign(n_banks, NIL);
+      m_tail.assign(n_banks, NIL);
+      m_bucket_head.assign(n_banks * N_BUCKET, NIL);
+      m_bucket_tail.assign(n_banks * N_BUCKET, NIL);
+      m_bank_size.assign(n_banks, 0);
+      m_bank_writes.assign(n_banks, 0);
+      m_open_row.assign(n_banks, 0);
+      m_open_valid.assign(n_banks, false);
+      m_size = 0;
+      m_writes = 0;
+      m_draining = false;
+      m_last_src = MAX_SOURCES;
+      m_streak = 0;
+      m_next_clear = config.m_bliss_clear;
+      m_next_quantum = config.m_atlas_quantum;
+      for ( unsigned s=0; s < MAX_SOURCES; s++ ) {
+         m_blacklisted[s] = false;
+         m_attained[s] = 0;
+         m_quantum_service[s] = 0;
+      }
+      m_n_blacklist = 0;
+      m_n_drains = 0;
+      m_n_activates = 0;
+      m_n_row_hits = 0;
+   }
+
+   unsigned size() const { return m_size; }
+   unsigned size( unsigned bank ) const { return m_bank_size[bank]; }
+   unsigned writes() const { return m_writes; }
+
+   static unsigned source( unsigned sid ) { return (sid == (unsigned)-1)? MAX_SOURCES-1 : sid % (MAX_SOURCES-1); }
+
+   void add( REQ *req, unsigned bank, unsigned row, unsigned src, bool write, unsigned long long now )
+   {
+      unsigned n;
+      if ( m_free.empty() ) {
+         n = m_nodes.size();
+         m_nodes.push_back(node());
+      } else {
+         n = m_free.back();
+         m_free.pop_back();
+      }
+      node &e = m_nodes[n];
+      e.req = req;
+      e.row = row;
+      e.bank = bank;
+      e.src = src;
+      e.write = write;
+      e.arrival = now;
+      // newest at the tail of the bank list and of its row bucket
+      e.prev = m_tail[bank];
+      e.next = NIL;
+      if ( e.prev != NIL ) m_nodes[e.prev].next = n; else m_head[bank] = n;
+      m_tail[bank] = n;
+      unsigned b = bucket(bank, row);
+      e.bprev = m_bucket_tail[b];
+      e.bnext = NIL;
+      if ( e.bprev != NIL ) m_nodes[e.bprev].bnext = n; else m_bucket_head[b] = n;
+      m_bucket_tail[b] = n;
+      m_size++;
+      m_bank_size[bank]++;
+      if ( write ) {
+         m_writes++;
+         m_bank_writes[bank]++;
+      }
+   }
+
+   // Next request of this bank (NULL if none); activate is set when it
+   // opens a new row.
+   REQ *schedule( unsigned bank, unsigned curr_row, unsigned long long now, bool &activate )
+   {
+      activate = false;
+      if ( m_bank_size[bank] == 0 )
+         return NULL;
+      update_epochs(now);
+      int want_write = write_class(bank);
+
+      unsigned open_row = m_open_valid[bank]? m_open_row[bank] : curr_row;
+      unsigned n = NIL;
+      switch ( m_config.m_policy ) {
+      case DRAM_SCHED_BLISS:
+         n = row_hit(bank, open_row, want_write, true);
+         if ( n == NIL ) n = oldest(bank, want_write, true);
+         break;
+      case DRAM_SCHED_ATLAS:
+         n = atlas_pick(bank, open_row, want_write, now);
+         break;
+      default:
+         break;
+      }
+      if ( n == NIL ) {
+         n = row_hit(bank, open_row, want_write, false);
+         if ( n == NIL && open_row != curr_row )
+            n = row_hit(bank, curr_row, want_write, false);
+         if ( n == NIL )
+            n = oldest(bank, want_write, false);
+      }
+      assert( n != NIL );
+      node &e = m_nodes[n];
+      if ( e.row == open_row || e.row == curr_row ) {
+         m_n_row_hits++;
+      } else {
+         activate = true;
+         m_n_activates++;
+      }
+      m_open_row[bank] = e.row;
+      m_open_valid[bank] = true;
+      served(e.src);
+      REQ *req = e.req;
+      remove(n);
+      return req;
+   }
+
+   void print( FILE *fp ) const
+   {
+      static const char *policy[] = { "frfcfs", "bliss", "atlas" };
+      fprintf(fp, "   scheduler %s: row hits = %llu, activates = %llu, write drains = %llu, blacklistings = %llu\n",
+              policy[m_config.m_policy], m_n_row_hits, m_n_activates, m_n_drains, m_n_blacklist);
+   }
+
+private:
+   static const unsigned NIL = (unsigned)-1;
+
+   struct node {
+      REQ *req;
+      unsigned long long arrival;
+      unsigned row;
+      unsigned bank;
+      unsigned src;
+      unsigned prev, next;   // bank list, oldest first
+      unsigned bprev, bnext; // row bucket, oldest first
+      bool write;
+   };
+
+   unsigned bucket( unsigned bank, unsigned row ) const
+   {
+      return bank * N_BUCKET + ((row * 0x9E3779B1u) >> 28) % N_BUCKET;
+   }
+
+   // -1: any request, 0: reads only, 1: writes only
+   int write_class( unsigned bank )
+   {
+      if ( m_config.m_write_high == 0 )
+         return -1;
+      if ( !m_draining && m_writes >= m_config.m_write_high ) {
+         m_draining = true;
+         m_n_drains++;
+      } else if ( m_draining && m_writes <= m_config.m_write_low ) {
+         m_draining = false;
+      }
+      unsigned writes = m_bank_writes[bank];
+      unsigned reads = m_bank_size[bank] - writes;
+      if ( m_draining )
+         return writes? 1 : -1;
+      return reads? 0 : -1;
+   }
+
+   bool allowed( const node &e, int want_write, bool skip_blacklisted ) const
+   {
+      if ( want_write >= 0 && e.write != (want_write == 1) )
+         return false;
+      return !skip_blacklisted || !m_blacklisted[e.src];
+   }
+
+   unsigned row_hit( unsigned bank, unsigned row, int want_write, bool skip_blacklisted ) const
+   {
+      for ( unsigned n=m_bucket_head[bucket(bank,row)]; n != NIL; n=m_nodes[n].bnext ) {
+         const node &e = m_nodes[n];
+         if ( e.row == row && allowed(e, want_write, skip_blacklisted) )
+            return n;
+      }
+      return NIL;
+   }
+
+   unsigned oldest( unsigned bank, int want_write, bool skip_blacklisted ) const
+   {
+      for ( unsigned n=m_head[bank]; n != NIL; n=m_nodes[n].next ) {
+         if ( allowed(m_nodes[n], want_write, skip_blacklisted) )
+            return n;
+      }
+      return NIL;
+   }
+
+   // starving requests first, then the least attained service, row hits, age
+   unsigned atlas_pick( unsigned bank, unsigned open_row, int want_write, unsigned long long now ) const
+   {
+      unsigned best = NIL;
+      for ( unsigned n=m_head[bank]; n != NIL; n=m_nodes[n].next ) {
+         const node &e = m_nodes[n];
+         if ( !allowed(e, want_write, false) )
+            continue;
+         if ( now - e.arrival > m_config.m_atlas_cap )
+            return n; // the oldest starving request
+         if ( best == NIL ) {
+            best = n;
+            continue;
+         }
+         const node &b = m_nodes[best];
+         if ( m_attained[e.src] != m_attained[b.src] ) {
+            if ( m_attained[e.src] < m_attained[b.src] )
+               best = n;
+         } else if ( e.row == open_row && b.row != open_row ) {
+            best = n;
+         }
+      }
+      return best;
+   }
+
+   void served( unsigned src )
+   {
+      m_quantum_service[src]++;
+      if ( m_config.m_policy != DRAM_SCHED_BLISS )
+         return;
+      if ( src == m_last_src ) {
+         m_streak++;
+         if ( m_streak > m_config.m_bliss_threshold && !m_blacklisted[src] ) {
+            m_blacklisted[src] = true;
+            m_n_blacklist++;
+         }
+      } else {
+         m_last_src = src;
+         m_streak = 1;
+      }
+   }
+
+   void update_epochs( unsigned long long now )
+   {
+      if ( m_config.m_policy == DRAM_SCHED_BLISS && now >= m_next_clear ) {
+         for ( unsigned s=0; s < MAX_SOURCES; s++ )
+            m_blacklisted[s] = false;
+         m_next_clear = now + m_config.m_bliss_clear;
+      }
+      if ( m_config.m_policy == DRAM_SCHED_ATLAS && now >= m_next_quantum ) {
+         // exponentially weighted attained service (weight 7/8 on the past)
+         for ( unsigned s=0; s < MAX_SOURCES; s++ ) {
+            m_attained[s] = (m_attained[s] * 7 + m_quantum_service[s] * 8) / 8;
+            m_quantum_service[s] = 0;
+         }
+         m_next_quantum = now + m_config.m_atlas_quantum;
+      }
+   }
+
+   void remove( unsigned n )
+   {
+      node &e = m_nodes[n];
+      if ( e.prev != NIL ) m_nodes[e.prev].next = e.next; else m_head[e.bank] = e.next;
+      if ( e.next != NIL ) m_nodes[e.next].prev = e.prev; else m_tail[e.bank] = e.prev;
+      unsigned b = bucket(e.bank, e.row);
+      if ( e.bprev != NIL ) m_nodes[e.bprev].bnext = e.bnext; else m_bucket_head[b] = e.bnext;
+      if ( e.bnext != NIL ) m_nodes[e.bnext].bprev = e.bprev; else m_bucket_tail[b] = e.bprev;
+      m_size--;
+      m_bank_size[e.bank]--;
+      if ( e.write ) {
+         m_writes--;
+         m_bank_writes[e.bank]--;
+      }
+      m_free.push_back(n);
+   }
+
+   const dram_sched_config &m_config;
+   unsigned m_n_banks;
+   std::vector<node> m_nodes;
+   std::vector<unsigned> m_free;
+   std::vector<unsigned> m_head, m_tail;
+   std::vector<unsigned> m_bucket_head, m_bucket_tail;
+   std::vector<unsigned> m_bank_size, m_bank_writes;
+   std::vector<unsigned> m_open_row;
+   std::vector<bool> m_open_valid;
+   unsigned m_size;
+   unsigned m_writes;
+   bool m_draining;
+
+   // BLISS
+   unsigned m_last_src;
+   unsigned m_streak;
+   bool m_blacklisted[MAX_SOURCES];
+   unsigned long long m_next_clear;
+   // ATLAS
+   unsigned long long m_attained[MAX_SOURCES];
+   unsigned long long m_quantum_service[MAX_SOURCES];
+   unsigned long long m_next_quantum;
+
+   unsigned long long m_n_blacklist;
+   unsigned long long m_n_drains;
+   unsigned long long m_n_activates;
+   unsigned long long m_n_row_hits;
+};
+
+// assign() takes NIL by reference, so it needs a definition
+template<class REQ> const unsigned dram_sched_queue<REQ>::NIL;
+
+#endif
@@ -27,8 +27,14 @@
 
 #include "gpu-cache.h"
 #include "stat-tool.h"
+#include "gpu-sim.h"
+#include "comp.h"
+#include "l2_prefetcher.h"
+#include "../cuda-sim/memory.h"
 #include <assert.h>
 
+extern gpgpu_sim *g_the_gpu;
+
 #define MAX_DEFAULT_CACHE_SIZE_MULTIBLIER 4
 // used to allocate memory that is large enough to adapt the changes in cache size across kernels
 
@@ -111,9 +117,254 @@ unsigned l2_cache_config::set_index(new_addr_type addr) const{
 	}
 }
 
+/****************************************************************** Replacement ******************************************************************/
+
+set_dueling::set_dueling()
+{
+    m_psel = PSEL_MAX/2;
+    m_access[0] = m_access[1] = 0;
+    m_hit[0] = m_hit[1] = 0;
+}
+
+int set_dueling::leader( unsigned set_index ) const
+{
+    // complement-select: 1 of 32 sets leads for each policy
+    unsigned lo = set_index & 0x1F;
+    unsigned hi = (set_index >> 5) & 0x1F;
+    if ( lo == hi ) 
+        return 0;
+    if ( lo == (~hi & 0x1F) ) 
+        return 1;
+    return -1;
+}
+
+bool set_dueling::use_second( unsigned set_index ) const
+{
+    int l = leader(set_index);
+    if ( l >= 0 ) 
+        return l == 1;
+    return m_psel > PSEL_MAX/2;
+}
+
+void set_dueling::access( unsigned set_index, bool hit )
+{
+    int l = leader(set_index);
+    if ( l < 0 ) 
+        return;
+    m_access[l]++;
+    if ( hit ) {
+        m_hit[l]++;
+    } else if ( l == 0 ) {
+        if ( m_psel < PSEL_MAX ) m_psel++;
+    } else {
+        if ( m_psel > 0 ) m_psel--;
+    }
+}
+
+void set_dueling::print( FILE *fp, const char *first, const char *second ) const
+{
+    fprintf( fp, "\t\tSet dueling: %s leaders hit rate = %.3g (%u accesses), %s leaders hit rate = %.3g (%u accesses), followers use %s\n",
+             first, m_access[0]? (float)m_hit[0]/m_access[0] : 0.0f, m_access[0],
+             second, m_access[1]? (float)m_hit[1]/m_access[1] : 0.0f, m_access[1],
+             (m_psel > PSEL_MAX/2)? second : first );
+}
+
+void set_dueling::save( FILE *fout ) const
+{
+    unsigned state[5] = { m_psel, m_access[0], m_access[1], m_hit[0], m_hit[1] };
+    fwrite(state, sizeof(state), 1, fout);
+}
+
+bool set_dueling::load( FILE *fin )
+{
+    unsigned state[5];
+    if( fread(state, sizeof(state), 1, fin) != 1 ) 
+        return false;
+    m_psel = state[0];
+    m_access[0] = state[1];
+    m_access[1] = state[2];
+    m_hit[0] = state[3];
+    m_hit[1] = state[4];
+    return true;
+}
+
+replacement_policy *replacement_policy::create( enum replacement_policy_t type )
+{
+    switch ( type ) {
+    case LRU: return new lru_policy();
+    case FIFO: return new fifo_policy();
+    case SRRIP: return new srrip_policy();
+    case BRRIP: return new brrip_policy();
+    case DRRIP: return new drrip_policy();
+    case SHIP: return new ship_policy();
+    case COMP_AWARE: return new comp_aware_policy();
+    default: abort();
+    }
+}
+
+static bool replaceable( const cache_block_t &line ) 
+{
+    return line.m_status != INVALID && line.m_status != RESERVED;
+}
+
+unsigned lru_policy::victim( unsigned set_index, const cache_block_t *set, unsigned assoc ) const
+{
+    unsigned victim = (unsigned)-1;
+    unsigned timestamp = (unsigned)-1;
+    for (unsigned way=0; way<assoc; way++) {
+        if ( replaceable(set[way]) && set[way].m_last_access_time < timestamp ) {
+            timestamp = set[way].m_last_access_time;
+            victim = way;
+        }
+    }
+    assert( victim != (unsigned)-1 );
+    return victim;
+}
+
+unsigned fifo_policy::victim( unsigned set_index, const cache_block_t *set, unsigned assoc ) const
+{
+    unsigned victim = (unsigned)-1;
+    unsigned timestamp = (unsigned)-1;
+    for (unsigned way=0; way<assoc; way++) {
+        if ( replaceable(set[way]) && set[way].m_alloc_time < timestamp ) {
+            timestamp = set[way].m_alloc_time;
+            victim = way;
+        }
+    }
+    assert( victim != (unsigned)-1 );
+    return victim;
+}
+
+unsigned srrip_policy::victim( unsigned set_index, const cache_block_t *set, unsigned assoc ) const
+{
+    // first line with the largest RRPV; the set is aged when it is replaced
+    unsigned victim = (unsigned)-1;
+    for (unsigned way=0; way<assoc; way++) {
+        if ( replaceable(set[way]) && (victim == (unsigned)-1 || set[way].m_rrpv > set[victim].m_rrpv) ) 
+            victim = way;
+    }
+    assert( victim != (unsigned)-1 );
+    return victim;
+}
+
+void srrip_policy::on_evict( unsigned set_index, cache_block_t *set, unsigned assoc, unsigned way )
+{
+    // age the set until the victim reaches RRPV_MAX
+    unsigned char age = RRPV_MAX - set[way].m_rrpv;
+    if ( age == 0 ) 
+        return;
+    for (unsigned w=0; w<assoc; w++) {
+        if ( set[w].m_status != INVALID ) 
+            set[w].m_rrpv = (set[w].m_rrpv + age > RRPV_MAX)? RRPV_MAX : set[w].m_rrpv + age;
+    }
+}
+
+ship_policy::ship_policy()
+    : m_shct(SHCT_SIZE, 1)
+{
+    m_n_insert = 0;
+    m_n_distant = 0;
+    m_n_evict = 0;
+    m_n_evict_reused = 0;
+}
+
+void ship_policy::on_hit( unsigned set_index, cache_block_t &line )
+{
+    line.m_rrpv = 0;
+    line.m_reused = true;
+    if ( m_shct[line.m_signature] < SHCT_MAX ) 
+        m_shct[line.m_signature]++;
+}
+
+void ship_policy::on_evict( unsigned set_index, cache_block_t *set, unsigned assoc, unsigned way )
+{
+    m_n_evict++;
+    if ( set[way].m_reused ) 
+        m_n_evict_reused++;
+    else if ( m_shct[set[way].m_signature] > 0 ) 
+        m_shct[set[way].m_signature]--;
+    srrip_policy::on_evict(set_index, set, assoc, way);
+}
+
+void ship_policy::on_insert( unsigned set_index, cache_block_t &line, const mem_fetch *mf )
+{
+    unsigned long long sig;
+    if ( mf && mf->get_pc() != (address_type)-1 ) 
+        sig = mf->get_pc();
+    else 
+        sig = line.m_block_addr >> 14; // 16KB memory region
+    sig ^= sig >> 14;
+    line.m_signature = sig % SHCT_SIZE;
+    m_n_insert++;
+    if ( m_shct[line.m_signature] == 0 ) {
+        m_n_distant++;
+        line.m_rrpv = RRPV_MAX;
+    } else {
+        line.m_rrpv = RRPV_MAX-1;
+    }
+}
+
+void ship_policy::print( FILE *fp ) const
+{
+    fprintf( fp, "\t\tSHiP: distant insertions = %u of %u, reused evictions = %u of %u (%.3g)\n",
+             m_n_distant, m_n_insert, m_n_evict_reused, m_n_evict,
+             m_n_evict? (float)m_n_evict_reused/m_n_evict : 0.0f );
+}
+
+void ship_policy::save( FILE *fout ) const
+{
+    fwrite(&m_shct[0], sizeof(unsigned char), SHCT_SIZE, fout);
+    unsigned counters[4] = { m_n_insert, m_n_distant, m_n_evict, m_n_evict_reused };
+    fwrite(counters, sizeof(counters), 1, fout);
+}
+
+bool ship_policy::load( FILE *fin )
+{
+    unsigned counters[4];
+    if( fread(&m_shct[0], sizeof(unsigned char), SHCT_SIZE, fin) != SHCT_SIZE 
+        || fread(counters, sizeof(counters), 1, fin) != 1 ) 
+        return false;
+    m_n_insert = counters[0];
+    m_n_distant = counters[1];
+    m_n_evict = counters[2];
+    m_n_evict_reused = counters[3];
+    return true;
+}
+
+unsigned comp_aware_policy::victim( unsigned set_index, const cache_block_t *set, unsigned assoc ) const
+{
+    unsigned victim = srrip_policy::victim(set_index, set, assoc);
+    if ( !m_duel.use_second(set_index) ) 
+        return victim;
+    // the largest line within one RRPV step of the SRRIP victim
+    unsigned char min_rrpv = set[victim].m_rrpv? set[victim].m_rrpv - 1 : 0;
+    for (unsigned way=0; way<assoc; way++) {
+        if ( replaceable(set[way]) && set[way].m_rrpv >= min_rrpv && set[way].m_comp_size > set[victim].m_comp_size ) 
+            victim = way;
+    }
+    return victim;
+}
+
+// Compressed size estimate used by the compression-aware policy. It uses the
+// stateless bit-plane compressor on the current functional memory contents,
+// so it neither disturbs the link compressor's dictionaries nor needs the
+// data to be carried through the timing model.
+static unsigned line_comp_size( new_addr_type block_addr, unsigned line_sz )
+{
+    if ( line_sz != 128 ) 
+        return line_sz * 8;
+    static BPCompressor bpc;
+    unsigned char buffer[128];
+    g_the_gpu->get_global_memory()->read(block_addr, 128, buffer);
+    return bpc.compress(0, buffer, block_addr, 128);
+}
+
+/****************************************************************** Tag array ******************************************************************/
+
 tag_array::~tag_array() 
 {
     delete[] m_lines;
+    delete m_policy;
 }
 
 tag_array::tag_array( cache_config &config,
@@ -129,6 +380,11 @@ tag_array::tag_array( cache_config &config,
 void tag_array::update_cache_parameters(cache_config &config)
 {
 	m_config=config;
+	if ( m_config.m_replacement_policy != m_policy_type ) {
+		delete m_policy;
+		m_policy_type = m_config.m_replacement_policy;
+		m_policy = replacement_policy::create(m_policy_type);
+	}
 }
 
 tag_array::tag_array( cache_config &config,
@@ -147,22 +403,23 @@ void tag_array::init( int core_id, int type_id )
     m_miss = 0;
     m_pending_hit = 0;
     m_res_fail = 0;
+    m_sector_miss = 0;
     // initialize snapshot counters for visualizer
     m_prev_snapshot_access = 0;
     m_prev_snapshot_miss = 0;
     m_prev_snapshot_pending_hit = 0;
     m_core_id = core_id; 
     m_type_id = type_id;
+    m_policy_type = m_config.m_replacement_policy;
+    m_policy = replacement_policy::create(m_policy_type);
 }
 
-enum cache_request_status tag_array::probe( new_addr_type addr, unsigned &idx ) const {
+enum cache_request_status tag_array::probe( new_addr_type addr, unsigned &idx, sector_mask_t sectors, sector_mask_t written ) const {
     //assert( m_config.m_write_policy == READ_ONLY );
     unsigned set_index = m_config.set_index(addr);
     new_addr_type tag = m_config.tag(addr);
 
     unsigned invalid_line = (unsigned)-1;
-    unsigned valid_line = (unsigned)-1;
-    unsigned valid_timestamp = (unsigned)-1;
 
     bool all_reserved = true;
 
@@ -171,6 +428,10 @@ enum cache_request_status tag_array::probe( new_addr_type addr, unsigned &idx )
         unsigned index = set_index*m_config.m_assoc+way;
         cache_block_t *line = &m_lines[index];
         if (line->m_tag == tag) {
+            if ( m_config.m_sectored && line->m_status != INVALID ) {
+                idx = index;
+                return probe_sectors( *line, sectors, written );
+            }
             if ( line->m_status == RESERVED ) {
                 idx = index;
                 return HIT_RESERVED;
@@ -186,22 +447,8 @@ enum cache_request_status tag_array::probe( new_addr_type addr, unsigned &idx )
         }
         if (line->m_status != RESERVED) {
             all_reserved = false;
-            if (line->m_status == INVALID) {
+            if (line->m_status == INVALID) 
                 invalid_line = index;
-            } else {
-                // valid line : keep track of most appropriate replacement candidate
-                if ( m_config.m_replacement_policy == LRU ) {
-                    if ( line->m_last_access_time < valid_timestamp ) {
-                        valid_timestamp = line->m_last_access_time;
-                        valid_line = index;
-                    }
-                } else if ( m_config.m_replacement_policy == FIFO ) {
-                    if ( line->m_alloc_time < valid_timestamp ) {
-                        valid_timestamp = line->m_alloc_time;
-                        valid_line = index;
-                    }
-                }
-            }
         }
     }
     if ( all_reserved ) {
@@ -211,42 +458,91 @@ enum cache_request_status tag_array::probe( new_addr_type addr, unsigned &idx )
 
     if ( invalid_line != (unsigned)-1 ) {
         idx = invalid_line;
-    } else if ( valid_line != (unsigned)-1) {
-        idx = valid_line;
-    } else abort(); // if an unreserved block exists, it is either invalid or replaceable 
+    } else {
+        // if an unreserved block exists, it is either invalid or replaceable 
+        unsigned base = set_index*m_config.m_assoc;
+        idx = base + m_policy->victim(set_index, &m_lines[base], m_config.m_assoc);
+    }
 
     return MISS;
 }
 
-enum cache_request_status tag_array::access( new_addr_type addr, unsigned time, unsigned &idx )
+enum cache_request_status tag_array::probe_sectors( const cache_block_t &line, sector_mask_t sectors, sector_mask_t written ) const
+{
+    if ( line.m_status == RESERVED ) {
+        // one fill per line is in flight; sectors it does not bring wait for it
+        if ( sectors & ~(line.m_sector_valid | line.m_sector_pending) ) 
+            return RESERVATION_FAIL;
+        return HIT_RESERVED;
+    }
+    // a write to a present line fills the sectors it overwrites completely in
+    // place; a partly written sector that is not valid has to be fetched first
+    if ( (sectors & ~(line.m_sector_valid | written)) == 0 ) 
+        return HIT;
+    return MISS; // sector miss: only the missing sectors are fetched into this line
+}
+
+bool tag_array::sector_miss( unsigned idx, new_addr_type addr ) const
+{
+    const cache_block_t &line = m_lines[idx];
+    return m_config.m_sectored && line.m_status != INVALID && line.m_tag == m_config.tag(addr);
+}
+
+sector_mask_t tag_array::access_sectors( const mem_fetch *mf ) const
+{
+    return (mf && m_config.m_sectored)? mf->get_sector_mask() : FULL_SECTOR_MASK;
+}
+
+sector_mask_t tag_array::missing_sectors( new_addr_type addr, sector_mask_t sectors ) const
+{
+    unsigned idx;
+    enum cache_request_status status = probe(addr, idx, sectors);
+    if ( status != RESERVATION_FAIL && m_config.m_sectored && sector_miss(idx, addr) ) 
+        return sectors & ~m_lines[idx].m_sector_valid;
+    return sectors;
+}
+
+enum cache_request_status tag_array::access( new_addr_type addr, unsigned time, unsigned &idx, const mem_fetch *mf )
 {
     bool wb=false;
     cache_block_t evicted;
-    enum cache_request_status result = access(addr,time,idx,wb,evicted);
+    enum cache_request_status result = access(addr,time,idx,wb,evicted,mf);
     assert(!wb);
     return result;
 }
 
-enum cache_request_status tag_array::access( new_addr_type addr, unsigned time, unsigned &idx, bool &wb, cache_block_t &evicted ) 
+enum cache_request_status tag_array::access( new_addr_type addr, unsigned time, unsigned &idx, bool &wb, cache_block_t &evicted, const mem_fetch *mf ) 
 {
     m_access++;
     shader_cache_access_log(m_core_id, m_type_id, 0); // log accesses to cache
-    enum cache_request_status status = probe(addr,idx);
+    enum cache_request_status status = probe(addr, idx, access_sectors(mf), mf? mf->get_written_sectors() : 0);
     switch (status) {
     case HIT_RESERVED: 
         m_pending_hit++;
     case HIT: 
         m_lines[idx].m_last_access_time=time; 
+        m_policy->on_access(idx/m_config.m_assoc, true);
+        m_policy->on_hit(idx/m_config.m_assoc, m_lines[idx]);
         break;
     case MISS:
         m_miss++;
         shader_cache_access_log(m_core_id, m_type_id, 1); // log cache misses
-        if ( m_config.m_alloc_policy == ON_MISS ) {
+        m_policy->on_access(idx/m_config.m_assoc, false);
+        if ( sector_miss(idx, addr) ) {
+            m_sector_miss++;
+            if ( m_config.m_alloc_policy == ON_MISS ) {
+                // the line stays; it is reserved until the missing sectors arrive
+                cache_block_t &line = m_lines[idx];
+                line.m_sector_pending = access_sectors(mf) & ~line.m_sector_valid;
+                line.m_status = RESERVED;
+                line.m_last_access_time = time;
+            }
+        } else if ( m_config.m_alloc_policy == ON_MISS ) {
             if( m_lines[idx].m_status == MODIFIED ) {
                 wb = true;
                 evicted = m_lines[idx];
             }
-            m_lines[idx].allocate( m_config.tag(addr), m_config.block_addr(addr), time );
+            allocate_line( idx, addr, time, mf );
         }
         break;
     case RESERVATION_FAIL:
@@ -261,20 +557,86 @@ enum cache_request_status tag_array::access( new_addr_type addr, unsigned time,
     return status;
 }
 
-void tag_array::fill( new_addr_type addr, unsigned time )
+void tag_array::allocate_line( unsigned idx, new_addr_type addr, unsigned time, const mem_fetch *mf )
+{
+    unsigned set_index = idx / m_config.m_assoc;
+    cache_block_t *set = &m_lines[set_index*m_config.m_assoc];
+    if ( m_lines[idx].m_status != INVALID ) 
+        m_policy->on_evict(set_index, set, m_config.m_assoc, idx % m_config.m_assoc);
+    m_lines[idx].allocate( m_config.tag(addr), m_config.block_addr(addr), time, access_sectors(mf) );
+    m_policy->on_insert(set_index, m_lines[idx], mf);
+}
+
+void tag_array::fill_line( cache_block_t &line, unsigned time )
+{
+    line.fill(time);
+    if ( m_policy->compression_aware() ) 
+        line.m_comp_size = line_comp_size(line.m_block_addr, m_config.get_line_sz());
+}
+
+void tag_array::fill( new_addr_type addr, unsigned time, const mem_fetch *mf )
 {
     assert( m_config.m_alloc_policy == ON_FILL );
     unsigned idx;
-    enum cache_request_status status = probe(addr,idx);
+    enum cache_request_status status = probe(addr, idx, access_sectors(mf));
     assert(status==MISS); // MSHR should have prevented redundant memory request
-    m_lines[idx].allocate( m_config.tag(addr), m_config.block_addr(addr), time );
-    m_lines[idx].fill(time);
+    if ( sector_miss(idx, addr) ) {
+        m_lines[idx].m_sector_valid |= access_sectors(mf);
+        return;
+    }
+    allocate_line( idx, addr, time, mf );
+    fill_line( m_lines[idx], time );
 }
 
 void tag_array::fill( unsigned index, unsigned time ) 
 {
     assert( m_config.m_alloc_policy == ON_MISS );
-    m_lines[index].fill(time);
+    fill_line( m_lines[index], time );
+}
+
+enum cache_request_status tag_array::warm( new_addr_type addr, unsigned time, bool dirty, bool &wb, cache_block_t &evicted )
+{
+    // Warm-up runs while the timing model is stopped, so every access carries
+    // the same timestamp. Keep the replacement order by ageing the lines that
+    // were more recent than the touched one instead of advancing time; all
+    // stamps stay <= time and the next detailed access is still the youngest.
+    unsigned idx;
+    enum cache_request_status status = probe(addr,idx);
+    if ( status == RESERVATION_FAIL ) 
+        return status;
+    cache_block_t &line = m_lines[idx];
+    if ( status == MISS && sector_miss(idx, addr) ) {
+        // the missing sectors are warmed into the line that holds the others
+        line.m_sector_valid = FULL_SECTOR_MASK;
+        status = HIT;
+    }
+    bool hit = (status == HIT || status == HIT_RESERVED);
+    unsigned old_access = (line.m_status != INVALID)? line.m_last_access_time : 0;
+    unsigned old_alloc = (line.m_status != INVALID)? line.m_alloc_time : 0;
+    unsigned set_index = m_config.set_index(addr);
+    for (unsigned way=0; way<m_config.m_assoc; way++) {
+        cache_block_t &other = m_lines[set_index*m_config.m_assoc+way];
+        if ( &other == &line || other.m_status == INVALID ) 
+            continue;
+        if ( other.m_last_access_time > old_access ) 
+            other.m_last_access_time--;
+        if ( !hit && other.m_alloc_time > old_alloc ) 
+            other.m_alloc_time--;
+    }
+    if ( hit ) {
+        line.m_last_access_time = time;
+        m_policy->on_hit(set_index, line);
+    } else {
+        if ( line.m_status == MODIFIED ) {
+            wb = true;
+            evicted = line;
+        }
+        allocate_line( idx, addr, time, NULL );
+        fill_line( line, time );
+    }
+    if ( dirty && (line.m_status == VALID || line.m_status == MODIFIED) ) 
+        line.set_modified( FULL_SECTOR_MASK );
+    return status;
 }
 
 void tag_array::flush() 
@@ -283,6 +645,38 @@ void tag_array::flush()
         m_lines[i].m_status = INVALID;
 }
 
+void tag_array::save( FILE *fout ) const
+{
+    unsigned n_lines = m_config.get_num_lines();
+    unsigned line_size = sizeof(cache_block_t);
+    fwrite(&n_lines, sizeof(n_lines), 1, fout);
+    fwrite(&line_size, sizeof(line_size), 1, fout);
+    fwrite(m_lines, sizeof(cache_block_t), n_lines, fout);
+    unsigned counters[5] = { m_access, m_miss, m_pending_hit, m_res_fail, m_sector_miss };
+    fwrite(counters, sizeof(counters), 1, fout);
+    m_policy->save(fout);
+}
+
+bool tag_array::load( FILE *fin )
+{
+    unsigned n_lines = 0, line_size = 0;
+    if( fread(&n_lines, sizeof(n_lines), 1, fin) != 1 || n_lines != m_config.get_num_lines() ) 
+        return false;
+    if( fread(&line_size, sizeof(line_size), 1, fin) != 1 || line_size != sizeof(cache_block_t) ) 
+        return false;
+    if( fread(m_lines, sizeof(cache_block_t), n_lines, fin) != n_lines ) 
+        return false;
+    unsigned counters[5];
+    if( fread(counters, sizeof(counters), 1, fin) != 1 ) 
+        return false;
+    m_access = counters[0];
+    m_miss = counters[1];
+    m_pending_hit = counters[2];
+    m_res_fail = counters[3];
+    m_sector_miss = counters[4];
+    return m_policy->load(fin);
+}
+
 float tag_array::windowed_miss_rate( ) const
 {
     unsigned n_access    = m_access - m_prev_snapshot_access;
@@ -308,6 +702,10 @@ void tag_array::print( FILE *stream, unsigned &total_access, unsigned &total_mis
     fprintf( stream, "\t\tAccess = %d, Miss = %d (%.3g), PendingHit = %d (%.3g)\n", 
              m_access, m_miss, (float) m_miss / m_access, 
              m_pending_hit, (float) m_pending_hit / m_access);
+    if ( m_config.m_sectored ) 
+        fprintf( stream, "\t\tSectorMiss = %d (%.3g of misses)\n", 
+                 m_sector_miss, (float) m_sector_miss / m_miss );
+    m_policy->print(stream);
     total_misses+=m_miss;
     total_access+=m_access;
 }
@@ -349,64 +747,156 @@ bool was_read_sent( const std::list<cache_event> &events )
 }
 /****************************************************************** MSHR ******************************************************************/
 
+mshr_table::mshr_table( unsigned num_entries, unsigned max_merged )
+    : m_num_entries(num_entries),
+      m_max_merged(max_merged)
+{
+    m_entries.resize(num_entries);
+    m_merged.assign(num_entries * max_merged, (mem_fetch*)NULL);
+    m_free.reserve(num_entries);
+    for ( unsigned e=num_entries; e > 0; e-- ) {
+        m_entries[e-1].m_valid = false;
+        m_free.push_back(e-1);
+    }
+    unsigned n_slots = 1;
+    while ( n_slots < 2*num_entries ) 
+        n_slots <<= 1;
+    m_index.assign(n_slots, EMPTY);
+    m_index_mask = n_slots - 1;
+    m_n_used = 0;
+    m_ready.assign(num_entries, 0);
+    m_ready_head = 0;
+    m_n_ready = 0;
+}
+
+unsigned mshr_table::slot( new_addr_type block_addr ) const{
+    unsigned long long h = block_addr * 0x9E3779B97F4A7C15ULL;
+    return (unsigned)(h >> 32) & m_index_mask;
+}
+
+unsigned mshr_table::find( new_addr_type block_addr ) const{
+    for ( unsigned i=slot(block_addr); m_index[i] != EMPTY; i=(i+1) & m_index_mask ) {
+        if ( m_entries[m_index[i]].m_block_addr == block_addr ) 
+            return m_index[i];
+    }
+    return EMPTY;
+}
+
+/// Frees the entry; the index is kept without tombstones by shifting back
+/// the entries that probed past its slot
+void mshr_table::release( unsigned entry ){
+    unsigned i = slot(m_entries[entry].m_block_addr);
+    while ( m_index[i] != entry ) 
+        i = (i+1) & m_index_mask;
+    unsigned j = i;
+    while ( true ) {
+        j = (j+1) & m_index_mask;
+        if ( m_index[j] == EMPTY ) 
+            break;
+        unsigned home = slot(m_entries[m_index[j]].m_block_addr);
+        // move j into the hole at i unless its home lies cyclically in (i, j]
+        bool stays = (i <= j)? (home > i && home <= j) : (home > i || home <= j);
+        if ( !stays ) {
+            m_index[i] = m_index[j];
+            i = j;
+        }
+    }
+    m_index[i] = EMPTY;
+    m_entries[entry].m_valid = false;
+    m_free.push_back(entry);
+    m_n_used--;
+}
+
 /// Checks if there is a pending request to the lower memory level already
 bool mshr_table::probe( new_addr_type block_addr ) const{
-    table::const_iterator a = m_data.find(block_addr);
-    return a != m_data.end();
+    return find(block_addr) != EMPTY;
+}
+
+/// Checks if the pending request brings all these sectors (merging is allowed)
+bool mshr_table::probe( new_addr_type block_addr, sector_mask_t sectors ) const{
+    unsigned e = find(block_addr);
+    return e != EMPTY && (sectors & ~m_entries[e].m_sectors) == 0;
 }
 
 /// Checks if there is space for tracking a new memory access
 bool mshr_table::full( new_addr_type block_addr ) const{
-    table::const_iterator i=m_data.find(block_addr);
-    if ( i != m_data.end() )
-        return i->second.m_list.size() >= m_max_merged;
+    unsigned e = find(block_addr);
+    if ( e != EMPTY )
+        return m_entries[e].m_count >= m_max_merged;
     else
-        return m_data.size() >= m_num_entries;
+        return m_n_used >= m_num_entries;
 }
 
 /// Add or merge this access
 void mshr_table::add( new_addr_type block_addr, mem_fetch *mf ){
-	m_data[block_addr].m_list.push_back(mf);
-	assert( m_data.size() <= m_num_entries );
-	assert( m_data[block_addr].m_list.size() <= m_max_merged );
-	// indicate that this MSHR entry contains an atomic operation
-	if ( mf->isatomic() ) {
-		m_data[block_addr].m_has_atomic = true;
-	}
+    unsigned e = find(block_addr);
+    if ( e == EMPTY ) {
+        assert( m_n_used < m_num_entries );
+        e = m_free.back();
+        m_free.pop_back();
+        m_n_used++;
+        mshr_entry &entry = m_entries[e];
+        entry.m_block_addr = block_addr;
+        entry.m_head = 0;
+        entry.m_count = 0;
+        entry.m_valid = true;
+        entry.m_has_atomic = false;
+        entry.m_sectors = 0;
+        unsigned i = slot(block_addr);
+        while ( m_index[i] != EMPTY ) 
+            i = (i+1) & m_index_mask;
+        m_index[i] = e;
+    }
+    mshr_entry &entry = m_entries[e];
+    assert( entry.m_count < m_max_merged );
+    m_merged[e*m_max_merged + (entry.m_head + entry.m_count) % m_max_merged] = mf;
+    entry.m_count++;
+    entry.m_sectors |= mf->get_sector_mask();
+    // indicate that this MSHR entry contains an atomic operation
+    if ( mf->isatomic() ) {
+        entry.m_has_atomic = true;
+    }
 }
 
 /// Accept a new cache fill response: mark entry ready for processing
 void mshr_table::mark_ready( new_addr_type block_addr, bool &has_atomic ){
     assert( !busy() );
-    table::iterator a = m_data.find(block_addr);
-    assert( a != m_data.end() ); // don't remove same request twice
-    m_current_response.push_back( block_addr );
-    has_atomic = a->second.m_has_atomic;
-    assert( m_current_response.size() <= m_data.size() );
+    unsigned e = find(block_addr);
+    assert( e != EMPTY ); // don't remove same request twice
+    assert( m_n_ready < m_n_used );
+    m_ready[(m_ready_head + m_n_ready) % m_num_entries] = e;
+    m_n_ready++;
+    has_atomic = m_entries[e].m_has_atomic;
 }
 
 /// Returns next ready access
 mem_fetch *mshr_table::next_access(){
     assert( access_ready() );
-    new_addr_type block_addr = m_current_response.front();
-    assert( !m_data[block_addr].m_list.empty() );
-    mem_fetch *result = m_data[block_addr].m_list.front();
-    m_data[block_addr].m_list.pop_front();
-    if ( m_data[block_addr].m_list.empty() ) {
+    unsigned e = m_ready[m_ready_head];
+    mshr_entry &entry = m_entries[e];
+    assert( entry.m_count > 0 );
+    mem_fetch *result = m_merged[e*m_max_merged + entry.m_head];
+    entry.m_head = (entry.m_head + 1) % m_max_merged;
+    entry.m_count--;
+    if ( entry.m_count == 0 ) {
         // release entry
-        m_data.erase(block_addr);
-        m_current_response.pop_front();
+        release(e);
+        m_ready_head = (m_ready_head + 1) % m_num_entries;
+        m_n_ready--;
     }
     return result;
 }
 
 void mshr_table::display( FILE *fp ) const{
     fprintf(fp,"MSHR contents\n");
-    for ( table::const_iterator e=m_data.begin(); e!=m_data.end(); ++e ) {
-        unsigned block_addr = e->first;
-        fprintf(fp,"MSHR: tag=0x%06x, atomic=%d %zu entries : ", block_addr, e->second.m_has_atomic, e->second.m_list.size());
-        if ( !e->second.m_list.empty() ) {
-            mem_fetch *mf = e->second.m_list.front();
+    for ( unsigned e=0; e < m_num_entries; e++ ) {
+        const mshr_entry &entry = m_entries[e];
+        if ( !entry.m_valid ) 
+            continue;
+        unsigned block_addr = entry.m_block_addr;
+        fprintf(fp,"MSHR: tag=0x%06x, atomic=%d, sectors=%x %u entries : ", block_addr, entry.m_has_atomic, entry.m_sectors, entry.m_count);
+        if ( entry.m_count ) {
+            mem_fetch *mf = m_merged[e*m_max_merged + entry.m_head];
             fprintf(fp,"%p :",mf);
             mf->print(fp);
         } else {
@@ -704,14 +1194,15 @@ void baseline_cache::fill(mem_fetch *mf, unsigned time){
     if ( m_config.m_alloc_policy == ON_MISS )
         m_tag_array->fill(e->second.m_cache_index,time);
     else if ( m_config.m_alloc_policy == ON_FILL )
-        m_tag_array->fill(e->second.m_block_addr,time);
+        m_tag_array->fill(e->second.m_block_addr,time,mf); // sectors fetched by mf
     else abort();
+    mf->set_sector_mask( e->second.m_sector_mask );
     bool has_atomic = false;
     m_mshrs.mark_ready(e->second.m_block_addr, has_atomic);
     if (has_atomic) {
         assert(m_config.m_alloc_policy == ON_MISS);
         cache_block_t &block = m_tag_array->get_block(e->second.m_cache_index);
-        block.m_status = MODIFIED; // mark line as dirty for atomic operation
+        block.set_modified( block.m_sector_valid ); // mark line as dirty for atomic operation
     }
     m_extra_mf_fields.erase(mf);
     m_bandwidth_management.use_fill_port(mf); 
@@ -747,25 +1238,37 @@ void baseline_cache::send_read_request(new_addr_type addr, new_addr_type block_a
 void baseline_cache::send_read_request(new_addr_type addr, new_addr_type block_addr, unsigned cache_index, mem_fetch *mf,
 		unsigned time, bool &do_miss, bool &wb, cache_block_t &evicted, std::list<cache_event> &events, bool read_only, bool wa){
 
+    // a sectored cache only fetches the sectors it misses, and merges into a
+    // pending request only if that request brings all of them
+    sector_mask_t sectors = FULL_SECTOR_MASK;
     bool mshr_hit = m_mshrs.probe(block_addr);
+    if ( m_config.m_sectored ) {
+        sectors = m_tag_array->missing_sectors(block_addr, mf->get_sector_mask());
+        mshr_hit = m_mshrs.probe(block_addr, sectors);
+    }
     bool mshr_avail = !m_mshrs.full(block_addr);
     if ( mshr_hit && mshr_avail ) {
     	if(read_only)
-    		m_tag_array->access(block_addr,time,cache_index);
+    		m_tag_array->access(block_addr,time,cache_index,mf);
     	else
-    		m_tag_array->access(block_addr,time,cache_index,wb,evicted);
+    		m_tag_array->access(block_addr,time,cache_index,wb,evicted,mf);
 
         m_mshrs.add(block_addr,mf);
         do_miss = true;
-    } else if ( !mshr_hit && mshr_avail && (m_miss_queue.size() < m_config.m_miss_queue_size) ) {
+    } else if ( !mshr_hit && !m_mshrs.probe(block_addr) && mshr_avail && (m_miss_queue.size() < m_config.m_miss_queue_size) ) {
     	if(read_only)
-    		m_tag_array->access(block_addr,time,cache_index);
+    		m_tag_array->access(block_addr,time,cache_index,mf);
     	else
-    		m_tag_array->access(block_addr,time,cache_index,wb,evicted);
+    		m_tag_array->access(block_addr,time,cache_index,wb,evicted,mf);
 
+        m_extra_mf_fields[mf] = extra_mf_fields(block_addr,cache_index, mf->get_data_size(), mf->get_sector_mask());
+        if ( m_config.m_sectored ) {
+            mf->set_sector_mask( sectors );
+            mf->set_data_size( sector_count(sectors) * SECTOR_SIZE );
+        } else {
+            mf->set_data_size( m_config.get_line_sz() );
+        }
         m_mshrs.add(block_addr,mf);
-        m_extra_mf_fields[mf] = extra_mf_fields(block_addr,cache_index, mf->get_data_size());
-        mf->set_data_size( m_config.get_line_sz() );
         m_miss_queue.push_back(mf);
         mf->set_status(m_miss_queue_status,time);
         if(!wa)
@@ -782,15 +1285,25 @@ void data_cache::send_write_request(mem_fetch *mf, cache_event request, unsigned
     mf->set_status(m_miss_queue_status,time);
 }
 
+/// Writeback of an evicted line (only its dirty sectors if sectored)
+mem_fetch *data_cache::alloc_writeback( const cache_block_t &evicted ){
+    if ( !m_config.m_sectored || !evicted.m_sector_dirty ) 
+        return m_memfetch_creator->alloc(evicted.m_block_addr, m_wrbk_type, m_config.get_line_sz(), true);
+    mem_fetch *wb = m_memfetch_creator->alloc(evicted.m_block_addr, m_wrbk_type,
+                                              sector_count(evicted.m_sector_dirty) * SECTOR_SIZE, true);
+    wb->set_sector_mask( evicted.m_sector_dirty );
+    return wb;
+}
+
 
 /****** Write-hit functions (Set by config file) ******/
 
 /// Write-back hit: Mark block as modified
 cache_request_status data_cache::wr_hit_wb(new_addr_type addr, unsigned cache_index, mem_fetch *mf, unsigned time, std::list<cache_event> &events, enum cache_request_status status ){
 	new_addr_type block_addr = m_config.block_addr(addr);
-	m_tag_array->access(block_addr,time,cache_index); // update LRU state
+	m_tag_array->access(block_addr,time,cache_index,mf); // update LRU state
 	cache_block_t &block = m_tag_array->get_block(cache_index);
-	block.m_status = MODIFIED;
+	block.set_modified( mf->get_sector_mask() );
 
 	return HIT;
 }
@@ -801,9 +1314,9 @@ cache_request_status data_cache::wr_hit_wt(new_addr_type addr, unsigned cache_in
 		return RESERVATION_FAIL; // cannot handle request this cycle
 
 	new_addr_type block_addr = m_config.block_addr(addr);
-	m_tag_array->access(block_addr,time,cache_index); // update LRU state
+	m_tag_array->access(block_addr,time,cache_index,mf); // update LRU state
 	cache_block_t &block = m_tag_array->get_block(cache_index);
-	block.m_status = MODIFIED;
+	block.set_modified( mf->get_sector_mask() );
 
 	// generate a write-through
 	send_write_request(mf, WRITE_REQUEST_SENT, time, events);
@@ -849,11 +1362,14 @@ data_cache::wr_miss_wa( new_addr_type addr,
 
     // Write allocate, maximum 3 requests (write miss, read request, write back request)
     // Conservatively ensure the worst-case request can be handled this cycle
-    bool mshr_hit = m_mshrs.probe(block_addr);
+    bool mshr_pending = m_mshrs.probe(block_addr);
+    bool mshr_hit = mshr_pending;
+    if ( m_config.m_sectored ) 
+        mshr_hit = m_mshrs.probe(block_addr, m_tag_array->missing_sectors(block_addr, mf->get_sector_mask()));
     bool mshr_avail = !m_mshrs.full(block_addr);
     if(miss_queue_full(2) 
         || (!(mshr_hit && mshr_avail) 
-        && !(!mshr_hit && mshr_avail 
+        && !(!mshr_pending && mshr_avail 
         && (m_miss_queue.size() < m_config.m_miss_queue_size))))
         return RESERVATION_FAIL;
 
@@ -889,8 +1405,7 @@ data_cache::wr_miss_wa( new_addr_type addr,
         // If evicted block is modified and not a write-through
         // (already modified lower level)
         if( wb && (m_config.m_write_policy != WRITE_THROUGH) ) { 
-            mem_fetch *wb = m_memfetch_creator->alloc(evicted.m_block_addr,
-                m_wrbk_type,m_config.get_line_sz(),true);
+            mem_fetch *wb = alloc_writeback(evicted);
             m_miss_queue.push_back(wb);
             wb->set_status(m_miss_queue_status,time);
         }
@@ -931,13 +1446,13 @@ data_cache::rd_hit_base( new_addr_type addr,
                          enum cache_request_status status )
 {
     new_addr_type block_addr = m_config.block_addr(addr);
-    m_tag_array->access(block_addr,time,cache_index);
+    m_tag_array->access(block_addr,time,cache_index,mf);
     // Atomics treated as global read/write requests - Perform read, mark line as
     // MODIFIED
     if(mf->isatomic()){ 
         assert(mf->get_access_type() == GLOBAL_ACC_R);
         cache_block_t &block = m_tag_array->get_block(cache_index);
-        block.m_status = MODIFIED;  // mark line as dirty
+        block.set_modified( mf->get_sector_mask() );  // mark line as dirty
     }
     return HIT;
 }
@@ -971,8 +1486,7 @@ data_cache::rd_miss_base( new_addr_type addr,
         // If evicted block is modified and not a write-through
         // (already modified lower level)
         if(wb && (m_config.m_write_policy != WRITE_THROUGH) ){ 
-            mem_fetch *wb = m_memfetch_creator->alloc(evicted.m_block_addr,
-                m_wrbk_type,m_config.get_line_sz(),true);
+            mem_fetch *wb = alloc_writeback(evicted);
         send_write_request(wb, WRITE_BACK_REQUEST_SENT, time, events);
     }
         return MISS;
@@ -993,11 +1507,11 @@ read_only_cache::access( new_addr_type addr,
     assert(!mf->get_is_write());
     new_addr_type block_addr = m_config.block_addr(addr);
     unsigned cache_index = (unsigned)-1;
-    enum cache_request_status status = m_tag_array->probe(block_addr,cache_index);
+    enum cache_request_status status = m_tag_array->probe(block_addr,cache_index,mf->get_sector_mask());
     enum cache_request_status cache_status = RESERVATION_FAIL;
 
     if ( status == HIT ) {
-        cache_status = m_tag_array->access(block_addr,time,cache_index); // update LRU state
+        cache_status = m_tag_array->access(block_addr,time,cache_index,mf); // update LRU state
     }else if ( status != RESERVATION_FAIL ) {
         if(!miss_queue_full(0)){
             bool do_miss=false;
@@ -1075,7 +1589,7 @@ data_cache::access( new_addr_type addr,
     new_addr_type block_addr = m_config.block_addr(addr);
     unsigned cache_index = (unsigned)-1;
     enum cache_request_status probe_status
-        = m_tag_array->probe( block_addr, cache_index );
+        = m_tag_array->probe( block_addr, cache_index, mf->get_sector_mask(), mf->get_written_sectors() );
     enum cache_request_status access_status
         = process_tag_probe( wr, probe_status, addr, cache_index, mf, time, events );
     m_stats.inc_stats(mf->get_access_type(),
@@ -1105,7 +1619,66 @@ l2_cache::access( new_addr_type addr,
                   unsigned time,
                   std::list<cache_event> &events )
 {
-    return data_cache::access( addr, mf, time, events );
+    if ( !m_prefetcher || mf->get_access_type() == L1_WRBK_ACC ) 
+        return data_cache::access( addr, mf, time, events );
+
+    // a demand access to a prefetched line makes the prefetch useful
+    new_addr_type block_addr = m_config.block_addr(addr);
+    unsigned cache_index = (unsigned)-1;
+    enum cache_request_status probe_status = m_tag_array->probe( block_addr, cache_index, mf->get_sector_mask(), mf->get_written_sectors() );
+    enum cache_request_status status = data_cache::access( addr, mf, time, events );
+    if ( status == RESERVATION_FAIL ) 
+        return status;
+    if ( probe_status == HIT || probe_status == HIT_RESERVED ) {
+        cache_block_t &block = m_tag_array->get_block(cache_index);
+        if ( block.m_prefetched ) {
+            block.m_prefetched = false;
+            m_prefetcher->useful( probe_status == HIT_RESERVED );
+        }
+    }
+    m_prefetcher->demand_access( block_addr, mf->get_pc(), status == MISS, time );
+    return status;
+}
+
+l2_cache::~l2_cache()
+{
+    delete m_prefetcher;
+}
+
+bool l2_cache::prefetch_pending() const
+{
+    return m_prefetcher && m_prefetcher->has_candidate();
+}
+
+void l2_cache::issue_prefetch( unsigned time )
+{
+    while ( m_prefetcher && m_prefetcher->has_candidate() ) {
+        new_addr_type block_addr = m_prefetcher->pop_candidate();
+        // already cached or in flight: nothing to do
+        unsigned cache_index = (unsigned)-1;
+        if ( m_tag_array->probe( block_addr, cache_index ) != MISS || m_mshrs.probe(block_addr) ) 
+            continue;
+        if ( m_mshrs.full(block_addr) || miss_queue_full(1) ) 
+            return;
+        mem_fetch *mf = m_memfetch_creator->alloc( block_addr, L2_PREFETCH_R, m_config.get_line_sz(), false );
+        std::list<cache_event> events;
+        enum cache_request_status status = data_cache::access( block_addr, mf, time, events );
+        if ( status != MISS ) {
+            delete mf;
+            return;
+        }
+        if ( m_tag_array->probe( block_addr, cache_index ) == HIT_RESERVED ) 
+            m_tag_array->get_block(cache_index).m_prefetched = true;
+        m_prefetcher->issued();
+        return;
+    }
+}
+
+void l2_cache::print(FILE *fp, unsigned &accesses, unsigned &misses) const
+{
+    baseline_cache::print(fp, accesses, misses);
+    if ( m_prefetcher ) 
+        m_prefetcher->print(fp);
 }
 
 /// Access function for tex_cache
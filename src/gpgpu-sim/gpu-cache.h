@@ -30,10 +30,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <vector>
 #include "gpu-misc.h"
 #include "mem_fetch.h"
 #include "../abstract_hardware_model.h"
-#include "../tr1_hash_map.h"
 
 #include "addrdec.h"
 
@@ -69,8 +69,16 @@ struct cache_block_t {
         m_fill_time=0;
         m_last_access_time=0;
         m_status=INVALID;
+        m_rrpv=0;
+        m_reused=false;
+        m_signature=0;
+        m_comp_size=0;
+        m_prefetched=false;
+        m_sector_valid=0;
+        m_sector_dirty=0;
+        m_sector_pending=0;
     }
-    void allocate( new_addr_type tag, new_addr_type block_addr, unsigned time )
+    void allocate( new_addr_type tag, new_addr_type block_addr, unsigned time, sector_mask_t sectors = FULL_SECTOR_MASK )
     {
         m_tag=tag;
         m_block_addr=block_addr;
@@ -78,12 +86,26 @@ struct cache_block_t {
         m_last_access_time=time;
         m_fill_time=0;
         m_status=RESERVED;
+        m_reused=false;
+        m_comp_size=0;
+        m_prefetched=false;
+        m_sector_valid=0;
+        m_sector_dirty=0;
+        m_sector_pending=sectors;
     }
     void fill( unsigned time )
     {
         assert( m_status == RESERVED );
-        m_status=VALID;
+        m_status=m_sector_dirty? MODIFIED : VALID;
         m_fill_time=time;
+        m_sector_valid|=m_sector_pending;
+        m_sector_pending=0;
+    }
+    void set_modified( sector_mask_t sectors )
+    {
+        m_status=MODIFIED;
+        m_sector_valid|=sectors;
+        m_sector_dirty|=sectors;
     }
 
     new_addr_type    m_tag;
@@ -92,11 +114,26 @@ struct cache_block_t {
     unsigned         m_last_access_time;
     unsigned         m_fill_time;
     cache_block_state    m_status;
+    // replacement state (see replacement_policy)
+    unsigned char    m_rrpv;        // re-reference prediction value (RRIP)
+    bool             m_reused;      // hit since it was inserted (SHiP)
+    unsigned short   m_signature;   // signature it was inserted with (SHiP)
+    unsigned         m_comp_size;   // compressed size in bits, 0 = unknown
+    bool             m_prefetched;  // allocated by a prefetch, no demand hit yet
+    // sector state; a non-sectored cache keeps all four sectors together
+    sector_mask_t    m_sector_valid;
+    sector_mask_t    m_sector_dirty;
+    sector_mask_t    m_sector_pending; // requested by the fill in flight
 };
 
 enum replacement_policy_t {
     LRU,
-    FIFO
+    FIFO,
+    SRRIP,
+    BRRIP,
+    DRRIP,
+    SHIP,
+    COMP_AWARE
 };
 
 enum write_policy_t {
@@ -140,6 +177,7 @@ public:
         m_config_stringPrefShared = NULL;
         m_data_port_width = 0;
         m_set_index_function = LINEAR_SET_FUNCTION;
+        m_sectored = false;
     }
     void init(char * config, FuncCache status)
     {
@@ -147,6 +185,12 @@ public:
         assert( config );
         char rp, wp, ap, mshr_type, wap, sif;
 
+        // optional cache type prefix: 'S:' = sectored, 'N:' = normal
+        m_sectored = false;
+        if ( (config[0] == 'S' || config[0] == 'N') && config[1] == ':' ) {
+            m_sectored = (config[0] == 'S');
+            config += 2;
+        }
 
         int ntok = sscanf(config,"%u:%u:%u,%c:%c:%c:%c:%c,%c:%u:%u,%u:%u,%u",
                           &m_nset, &m_line_sz, &m_assoc, &rp, &wp, &ap, &wap,
@@ -164,6 +208,11 @@ public:
         switch (rp) {
         case 'L': m_replacement_policy = LRU; break;
         case 'F': m_replacement_policy = FIFO; break;
+        case 'S': m_replacement_policy = SRRIP; break;
+        case 'B': m_replacement_policy = BRRIP; break;
+        case 'D': m_replacement_policy = DRRIP; break;
+        case 'H': m_replacement_policy = SHIP; break;
+        case 'C': m_replacement_policy = COMP_AWARE; break;
         default: exit_parse_error();
         }
         switch (wp) {
@@ -187,6 +236,11 @@ public:
         m_line_sz_log2 = LOGB2(m_line_sz);
         m_nset_log2 = LOGB2(m_nset);
         m_valid = true;
+        if ( m_sectored && m_line_sz != SECTOR_SIZE * SECTOR_CHUNK_SIZE ) {
+            printf("GPGPU-Sim uArch: ERROR ** sectored caches need %u byte lines (%s)\n",
+                   SECTOR_SIZE * SECTOR_CHUNK_SIZE, m_config_string );
+            abort();
+        }
 
         switch(wap){
         case 'W': m_write_alloc_policy = WRITE_ALLOCATE; break;
@@ -222,6 +276,7 @@ public:
         }
     }
     bool disabled() const { return m_disabled;}
+    bool is_sectored() const { return m_sectored;}
     unsigned get_line_sz() const
     {
         assert( m_valid );
@@ -232,12 +287,16 @@ public:
         assert( m_valid );
         return m_nset * m_assoc;
     }
+    unsigned get_nset() const { assert( m_valid ); return m_nset; }
+    unsigned get_assoc() const { assert( m_valid ); return m_assoc; }
+    enum replacement_policy_t get_replacement_policy() const { return m_replacement_policy; }
+    enum set_index_function get_set_index_function() const { return m_set_index_function; }
 
     void print( FILE *fp ) const
     {
-        fprintf( fp, "Size = %d B (%d Set x %d-way x %d byte line)\n", 
+        fprintf( fp, "Size = %d B (%d Set x %d-way x %d byte line%s)\n", 
                  m_line_sz * m_nset * m_assoc,
-                 m_nset, m_assoc, m_line_sz );
+                 m_nset, m_assoc, m_line_sz, m_sectored? ", sectored" : "" );
     }
 
     virtual unsigned set_index( new_addr_type addr ) const
@@ -280,13 +339,14 @@ protected:
 
     bool m_valid;
     bool m_disabled;
+    bool m_sectored;    // 'S:' prefix: 4 x 32B sectors per line
     unsigned m_line_sz;
     unsigned m_line_sz_log2;
     unsigned m_nset;
     unsigned m_nset_log2;
     unsigned m_assoc;
 
-    enum replacement_policy_t m_replacement_policy; // 'L' = LRU, 'F' = FIFO
+    enum replacement_policy_t m_replacement_policy; // 'L' = LRU, 'F' = FIFO, 'S' = SRRIP, 'B' = BRRIP, 'D' = DRRIP, 'H' = SHiP, 'C' = compression-aware
     enum write_policy_t m_write_policy;             // 'T' = write through, 'B' = write back, 'R' = read only
     enum allocation_policy_t m_alloc_policy;        // 'm' = allocate on miss, 'f' = allocate on fill
     enum mshr_config_t m_mshr_type;
@@ -334,23 +394,164 @@ private:
 	linear_to_raw_address_translation *m_address_mapping;
 };
 
+/// Set dueling: a few leader sets always use one of two policies, and the
+/// misses in them move a saturating counter that selects the policy of all
+/// other (follower) sets.
+class set_dueling {
+public:
+    set_dueling();
+
+    /// 0 or 1 for the leader sets of the first or second policy, -1 otherwise
+    int leader( unsigned set_index ) const;
+    bool use_second( unsigned set_index ) const;
+    void access( unsigned set_index, bool hit );
+
+    void print( FILE *fp, const char *first, const char *second ) const;
+    void save( FILE *fout ) const;
+    bool load( FILE *fin );
+
+private:
+    static const unsigned PSEL_MAX = 1023; // 10-bit policy selector
+    unsigned m_psel;
+    unsigned m_access[2]; // per leader group
+    unsigned m_hit[2];
+};
+
+/// Replacement policy of a tag_array. The tag array itself finds hits and
+/// invalid lines; the policy picks the victim among the valid lines of a
+/// full set and keeps its per-line state in cache_block_t through the hooks.
+class replacement_policy {
+public:
+    virtual ~replacement_policy() {}
+    static replacement_policy *create( enum replacement_policy_t type );
+
+    /// Way to evict; at least one line of the set is neither INVALID nor RESERVED
+    virtual unsigned victim( unsigned set_index, const cache_block_t *set, unsigned assoc ) const = 0;
+    virtual void on_access( unsigned set_index, bool hit ) {}
+    virtual void on_hit( unsigned set_index, cache_block_t &line ) {}
+    /// set[way] is valid and about to be replaced
+    virtual void on_evict( unsigned set_index, cache_block_t *set, unsigned assoc, unsigned way ) {}
+    /// line was just allocated (mf is NULL for warm-up accesses)
+    virtual void on_insert( unsigned set_index, cache_block_t &line, const mem_fetch *mf ) {}
+    /// victim() looks at cache_block_t::m_comp_size
+    virtual bool compression_aware() const { return false; }
+
+    virtual void print( FILE *fp ) const {}
+    virtual void save( FILE *fout ) const {}
+    virtual bool load( FILE *fin ) { return true; }
+};
+
+class lru_policy : public replacement_policy {
+public:
+    unsigned victim( unsigned set_index, const cache_block_t *set, unsigned assoc ) const;
+};
+
+class fifo_policy : public replacement_policy {
+public:
+    unsigned victim( unsigned set_index, const cache_block_t *set, unsigned assoc ) const;
+};
+
+/// Static RRIP (Jaleel et al., ISCA 2010) with 2-bit RRPVs: lines are
+/// inserted with a long re-reference interval and promoted on a hit.
+class srrip_policy : public replacement_policy {
+public:
+    srrip_policy() { m_bimodal_cnt = 0; }
+    unsigned victim( unsigned set_index, const cache_block_t *set, unsigned assoc ) const;
+    void on_hit( unsigned set_index, cache_block_t &line ) { line.m_rrpv = 0; }
+    void on_evict( unsigned set_index, cache_block_t *set, unsigned assoc, unsigned way );
+    void on_insert( unsigned set_index, cache_block_t &line, const mem_fetch *mf ) { line.m_rrpv = insert_rrpv(set_index); }
+
+protected:
+    static const unsigned char RRPV_MAX = 3;
+    virtual unsigned char insert_rrpv( unsigned set_index ) { return RRPV_MAX-1; }
+    /// bimodal insertion: distant, and long once every 32 insertions
+    unsigned char bimodal_rrpv() { return (++m_bimodal_cnt % 32)? RRPV_MAX : RRPV_MAX-1; }
+
+    unsigned m_bimodal_cnt;
+};
+
+class brrip_policy : public srrip_policy {
+protected:
+    unsigned char insert_rrpv( unsigned set_index ) { return bimodal_rrpv(); }
+};
+
+/// Dynamic RRIP: SRRIP or BRRIP insertion chosen by set dueling
+class drrip_policy : public srrip_policy {
+public:
+    void on_access( unsigned set_index, bool hit ) { m_duel.access(set_index,hit); }
+    void print( FILE *fp ) const { m_duel.print(fp,"SRRIP","BRRIP"); }
+    void save( FILE *fout ) const { m_duel.save(fout); }
+    bool load( FILE *fin ) { return m_duel.load(fin); }
+protected:
+    unsigned char insert_rrpv( unsigned set_index ) { return m_duel.use_second(set_index)? bimodal_rrpv() : RRPV_MAX-1; }
+    set_dueling m_duel;
+};
+
+/// SHiP (Wu et al., MICRO 2011) on top of SRRIP: a table of counters indexed
+/// by the signature (PC, or memory region if there is none) of the inserting
+/// access learns which signatures are re-referenced, and lines of signatures
+/// that never are get inserted with a distant re-reference interval.
+class ship_policy : public srrip_policy {
+public:
+    ship_policy();
+    void on_hit( unsigned set_index, cache_block_t &line );
+    void on_evict( unsigned set_index, cache_block_t *set, unsigned assoc, unsigned way );
+    void on_insert( unsigned set_index, cache_block_t &line, const mem_fetch *mf );
+    void print( FILE *fp ) const;
+    void save( FILE *fout ) const;
+    bool load( FILE *fin );
+private:
+    static const unsigned SHCT_SIZE = 16384;
+    static const unsigned char SHCT_MAX = 3;
+    std::vector<unsigned char> m_shct;
+    unsigned m_n_insert;
+    unsigned m_n_distant;   // insertions predicted dead
+    unsigned m_n_evict;
+    unsigned m_n_evict_reused;
+};
+
+/// Compression-aware RRIP: among the lines that are (nearly) due for
+/// eviction, evict the least compressible one, so the lines that stay cost
+/// less link bandwidth to refetch. Set dueling against plain SRRIP victim
+/// selection keeps it from hurting workloads where the hit rate matters more.
+class comp_aware_policy : public srrip_policy {
+public:
+    unsigned victim( unsigned set_index, const cache_block_t *set, unsigned assoc ) const;
+    void on_access( unsigned set_index, bool hit ) { m_duel.access(set_index,hit); }
+    bool compression_aware() const { return true; }
+    void print( FILE *fp ) const { m_duel.print(fp,"SRRIP","compression-aware"); }
+    void save( FILE *fout ) const { m_duel.save(fout); }
+    bool load( FILE *fin ) { return m_duel.load(fin); }
+private:
+    set_dueling m_duel;
+};
+
 class tag_array {
 public:
     // Use this constructor
     tag_array(cache_config &config, int core_id, int type_id );
     ~tag_array();
 
-    enum cache_request_status probe( new_addr_type addr, unsigned &idx ) const;
-    enum cache_request_status access( new_addr_type addr, unsigned time, unsigned &idx );
-    enum cache_request_status access( new_addr_type addr, unsigned time, unsigned &idx, bool &wb, cache_block_t &evicted );
+    // written: sectors the access overwrites completely (mem_fetch::get_written_sectors)
+    enum cache_request_status probe( new_addr_type addr, unsigned &idx, sector_mask_t sectors = FULL_SECTOR_MASK, sector_mask_t written = 0 ) const;
+    // sectors of the access that have to be fetched (all of them unless the line is present)
+    sector_mask_t missing_sectors( new_addr_type addr, sector_mask_t sectors ) const;
+    enum cache_request_status access( new_addr_type addr, unsigned time, unsigned &idx, const mem_fetch *mf = NULL );
+    enum cache_request_status access( new_addr_type addr, unsigned time, unsigned &idx, bool &wb, cache_block_t &evicted, const mem_fetch *mf = NULL );
 
-    void fill( new_addr_type addr, unsigned time );
+    void fill( new_addr_type addr, unsigned time, const mem_fetch *mf = NULL );
     void fill( unsigned idx, unsigned time );
 
+    // functional warm-up: install/touch the line without MSHRs or stat counters
+    enum cache_request_status warm( new_addr_type addr, unsigned time, bool dirty, bool &wb, cache_block_t &evicted );
+
     unsigned size() const { return m_config.get_num_lines();}
     cache_block_t &get_block(unsigned idx) { return m_lines[idx];}
 
     void flush(); // flash invalidate all entries
+    // binary dump/restore of the lines (simulation checkpoints)
+    void save( FILE *fout ) const;
+    bool load( FILE *fin );
     void new_window();
 
     void print( FILE *stream, unsigned &total_access, unsigned &total_misses ) const;
@@ -367,10 +568,17 @@ protected:
                int type_id,
                cache_block_t* new_lines );
     void init( int core_id, int type_id );
+    enum cache_request_status probe_sectors( const cache_block_t &line, sector_mask_t sectors, sector_mask_t written ) const;
+    bool sector_miss( unsigned idx, new_addr_type addr ) const;
+    sector_mask_t access_sectors( const mem_fetch *mf ) const;
+    void allocate_line( unsigned idx, new_addr_type addr, unsigned time, const mem_fetch *mf );
+    void fill_line( cache_block_t &line, unsigned time );
 
 protected:
 
     cache_config &m_config;
+    replacement_policy *m_policy;
+    enum replacement_policy_t m_policy_type;
 
     cache_block_t *m_lines; /* nbanks x nset x assoc lines in total */
 
@@ -378,6 +586,7 @@ protected:
     unsigned m_miss;
     unsigned m_pending_hit; // number of cache miss that hit a line that is allocated but not filled
     unsigned m_res_fail;
+    unsigned m_sector_miss; // misses on a present line of a sectored cache
 
     // performance counters for calculating the amount of misses within a time window
     unsigned m_prev_snapshot_access;
@@ -390,17 +599,12 @@ protected:
 
 class mshr_table {
 public:
-    mshr_table( unsigned num_entries, unsigned max_merged )
-    : m_num_entries(num_entries),
-    m_max_merged(max_merged)
-#if (tr1_hash_map_ismap == 0)
-    ,m_data(2*num_entries)
-#endif
-    {
-    }
+    mshr_table( unsigned num_entries, unsigned max_merged );
 
     /// Checks if there is a pending request to the lower memory level already
     bool probe( new_addr_type block_addr ) const;
+    /// Checks if the pending request brings all these sectors (merging is allowed)
+    bool probe( new_addr_type block_addr, sector_mask_t sectors ) const;
     /// Checks if there is space for tracking a new memory access
     bool full( new_addr_type block_addr ) const;
     /// Add or merge this access
@@ -410,7 +614,7 @@ public:
     /// Accept a new cache fill response: mark entry ready for processing
     void mark_ready( new_addr_type block_addr, bool &has_atomic );
     /// Returns true if ready accesses exist
-    bool access_ready() const {return !m_current_response.empty();}
+    bool access_ready() const {return m_n_ready != 0;}
     /// Returns next ready access
     mem_fetch *next_access();
     void display( FILE *fp ) const;
@@ -427,17 +631,34 @@ private:
     const unsigned m_num_entries;
     const unsigned m_max_merged;
 
+    // Everything is sized at construction so the miss paths never allocate:
+    // the entries are a fixed pool, each with a ring of m_max_merged merged
+    // requests in m_merged, found through an open-addressed (linear probing)
+    // index of twice the pool size.
     struct mshr_entry {
-        std::list<mem_fetch*> m_list;
+        new_addr_type m_block_addr;
+        unsigned m_head;          // oldest merged request in the ring
+        unsigned m_count;
+        bool m_valid;
         bool m_has_atomic; 
-        mshr_entry() : m_has_atomic(false) { }
+        sector_mask_t m_sectors;  // sectors requested from the lower level
     }; 
-    typedef tr1_hash_map<new_addr_type,mshr_entry> table;
-    table m_data;
-
-    // it may take several cycles to process the merged requests
-    bool m_current_response_ready;
-    std::list<new_addr_type> m_current_response;
+    static const unsigned EMPTY = (unsigned)-1;
+    unsigned slot( new_addr_type block_addr ) const;
+    unsigned find( new_addr_type block_addr ) const; // pool index or EMPTY
+    void release( unsigned entry );
+
+    std::vector<mshr_entry> m_entries;
+    std::vector<mem_fetch*> m_merged;   // m_max_merged per entry
+    std::vector<unsigned> m_free;       // unused pool entries
+    std::vector<unsigned> m_index;      // pool index per slot or EMPTY
+    unsigned m_index_mask;
+    unsigned m_n_used;
+
+    // entries whose fill arrived; it may take several cycles to process the merged requests
+    std::vector<unsigned> m_ready;
+    unsigned m_ready_head;
+    unsigned m_n_ready;
 };
 
 
@@ -520,7 +741,8 @@ public:
     unsigned get_stats(enum mem_access_type *access_type, unsigned num_access_type, enum cache_request_status *access_status, unsigned num_access_status)  const;
     void get_sub_stats(struct cache_sub_stats &css) const;
 
-    void sample_cache_port_utility(bool data_port_busy, bool fill_port_busy); 
+    void sample_cache_port_utility(bool data_port_busy, bool fill_port_busy);
+    void sample_idle_cache_port(unsigned long long n) { m_cache_port_available_cycles += n; } 
 private:
     bool check_valid(int type, int status) const;
 
@@ -594,6 +816,14 @@ public:
     mem_fetch *next_access(){return m_mshrs.next_access();}
     // flash invalidate all entries in cache
     void flush(){m_tag_array->flush();}
+    /// Functional warm-up of the tag state (used by the sampling controller)
+    enum cache_request_status warm( new_addr_type addr, unsigned time, bool dirty, bool &wb, cache_block_t &evicted )
+    {
+        return m_tag_array->warm(addr,time,dirty,wb,evicted);
+    }
+    /// Checkpoint the tag state (only valid when no miss is outstanding)
+    void save( FILE *fout ) const { m_tag_array->save(fout); }
+    bool load( FILE *fin ) { return m_tag_array->load(fin); }
     void print(FILE *fp, unsigned &accesses, unsigned &misses) const;
     void display_state( FILE *fp ) const;
 
@@ -612,6 +842,11 @@ public:
     bool data_port_free() const { return m_bandwidth_management.data_port_free(); } 
     bool fill_port_free() const { return m_bandwidth_management.fill_port_free(); } 
 
+    /// Nothing to send, no port busy and no access ready: cycle() would only sample port stats
+    bool idle() const { return m_miss_queue.empty() && data_port_free() && fill_port_free() && !access_ready(); }
+    /// Stats of n cycle() calls on an idle cache (cycle skipping)
+    void idle_cycle( unsigned long long n ) { m_stats.sample_idle_cache_port(n); }
+
 protected:
     // Constructor that can be used by derived classes with custom tag arrays
     baseline_cache( const char *name,
@@ -640,17 +875,19 @@ protected:
 
     struct extra_mf_fields {
         extra_mf_fields()  { m_valid = false;}
-        extra_mf_fields( new_addr_type a, unsigned i, unsigned d ) 
+        extra_mf_fields( new_addr_type a, unsigned i, unsigned d, sector_mask_t s ) 
         {
             m_valid = true;
             m_block_addr = a;
             m_cache_index = i;
             m_data_size = d;
+            m_sector_mask = s;
         }
         bool m_valid;
         new_addr_type m_block_addr;
         unsigned m_cache_index;
         unsigned m_data_size;
+        sector_mask_t m_sector_mask;
     };
 
     typedef std::map<mem_fetch*,extra_mf_fields> extra_mf_fields_lookup;
@@ -814,6 +1051,8 @@ protected:
                              cache_event request,
                              unsigned time,
                              std::list<cache_event> &events);
+    /// Writeback of an evicted line (only its dirty sectors if sectored)
+    mem_fetch *alloc_writeback( const cache_block_t &evicted );
 
     // Member Function pointers - Set by configuration options
     // to the functions below each grouping
@@ -960,15 +1199,28 @@ public:
     l2_cache(const char *name,  cache_config &config,
             int core_id, int type_id, mem_fetch_interface *memport,
             mem_fetch_allocator *mfcreator, enum mem_fetch_status status )
-            : data_cache(name,config,core_id,type_id,memport,mfcreator,status, L2_WR_ALLOC_R, L2_WRBK_ACC){}
+            : data_cache(name,config,core_id,type_id,memport,mfcreator,status, L2_WR_ALLOC_R, L2_WRBK_ACC)
+    {
+        m_prefetcher = NULL;
+    }
 
-    virtual ~l2_cache() {}
+    virtual ~l2_cache();
 
     virtual enum cache_request_status
         access( new_addr_type addr,
                 mem_fetch *mf,
                 unsigned time,
                 std::list<cache_event> &events );
+
+    /// Takes ownership of the prefetcher trained by the demand accesses
+    void set_prefetcher( class l2_prefetcher *prefetcher ) { m_prefetcher = prefetcher; }
+    bool prefetch_pending() const;
+    /// Sends the next useful prefetch candidate as an L2_PREFETCH_R miss
+    void issue_prefetch( unsigned time );
+    void print(FILE *fp, unsigned &accesses, unsigned &misses) const;
+
+private:
+    class l2_prefetcher *m_prefetcher;
 };
 
 /*****************************************************************************/
@@ -1013,6 +1265,8 @@ public:
     bool access_ready() const{return !m_result_fifo.empty();}
     /// Pop next ready access (includes both accesses that "HIT" and those that "MISS")
     mem_fetch *next_access(){return m_result_fifo.pop();}
+    /// No request, fragment or result in flight: cycle() does nothing
+    bool idle() const { return m_request_fifo.empty() && m_fragment_fifo.empty() && m_rob.empty() && m_result_fifo.empty(); }
     void display_state( FILE *fp ) const;
 
     // accessors for cache bandwidth availability - stubs for now 
@@ -26,6 +26,9 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "gpu-misc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 unsigned int LOGB2( unsigned int v ) {
    unsigned int shift;
@@ -41,3 +44,34 @@ unsigned int LOGB2( unsigned int v ) {
 
    return r;
 }
+
+bool kernel_uid_list::parse( const char *list ) 
+{
+   m_ranges.clear();
+   if( !list || !strcmp(list,"none") ) 
+      return true;
+   bool ok = true;
+   char *buf = strdup(list);
+   for( char *tok = strtok(buf,","); tok; tok = strtok(NULL,",") ) {
+      unsigned first, last;
+      int n = sscanf(tok,"%u-%u",&first,&last);
+      if( n == 1 ) 
+         last = first;
+      if( n < 1 || last < first ) {
+         ok = false;
+         break;
+      }
+      m_ranges.push_back(std::make_pair(first,last));
+   }
+   free(buf);
+   return ok;
+}
+
+bool kernel_uid_list::contains( unsigned uid ) const
+{
+   for( unsigned i=0; i < m_ranges.size(); i++ ) {
+      if( uid >= m_ranges[i].first && uid <= m_ranges[i].second ) 
+         return true;
+   }
+   return false;
+}
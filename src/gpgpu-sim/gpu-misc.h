@@ -29,6 +29,9 @@
 #ifndef GPU_MISC_H
 #define GPU_MISC_H
 
+#include <vector>
+#include <utility>
+
 //enables a verbose printout of all L1 cache misses and all MSHR status changes 
 //good for a single shader configuration
 #define DEBUGL1MISS 0
@@ -38,5 +41,23 @@ unsigned int LOGB2( unsigned int v );
 #define gs_min2(a,b) (((a)<(b))?(a):(b))
 #define min3(x,y,z) (((x)<(y) && (x)<(z))?(x):(gs_min2((y),(z))))
 
+// kernel launch uid ranges given as an option string, e.g. "1-3,7" ("none" = empty)
+class kernel_uid_list {
+public:
+    bool parse( const char *list );
+    bool empty() const { return m_ranges.empty(); }
+    bool contains( unsigned uid ) const;
+private:
+    std::vector<std::pair<unsigned,unsigned> > m_ranges;
+};
+
+// how a kernel launch is run when a checkpoint restore or a snapshot
+// replay leaves it out of the timing simulation
+enum launch_skip_t {
+    LAUNCH_TIMED = 0,       // simulated as usual
+    LAUNCH_FUNCTIONAL,      // executed functionally, so the host reads its results
+    LAUNCH_COVERED          // not executed, a restored memory image holds its writes
+};
+
 #endif
 
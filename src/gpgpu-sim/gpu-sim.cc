@@ -51,6 +51,7 @@
 #include "stat-tool.h"
 #include "l2cache.h"
 #include "mydelayqueue.h"
+#include "parallel.h"
 
 #include "../cuda-sim/ptx-stats.h"
 #include "../statwrapper.h"
@@ -142,6 +143,9 @@ void power_config::reg_options(class OptionParser * opp)
 
 void memory_config::reg_options(class OptionParser * opp)
 {
+    m_L2_prefetch_config.reg_options(opp);
+    m_dram_sched_config.reg_options(opp);
+    m_stacked_dram_config.reg_options(opp);
     option_parser_register(opp, "-gpgpu_dram_scheduler", OPT_INT32, &scheduler_type, 
                                 "0 = fifo, 1 = FR-FCFS (defaul)", "1");
     option_parser_register(opp, "-gpgpu_dram_partition_queues", OPT_CSTR, &gpgpu_L2_queue_config, 
@@ -153,7 +157,7 @@ void memory_config::reg_options(class OptionParser * opp)
                            "0");
     option_parser_register(opp, "-gpgpu_cache:dl2", OPT_CSTR, &m_L2_config.m_config_string, 
                    "unified banked L2 data cache config "
-                   " {<nsets>:<bsize>:<assoc>,<rep>:<wr>:<alloc>:<wr_alloc>,<mshr>:<N>:<merge>,<mq>}",
+                   " {[S:]<nsets>:<bsize>:<assoc>,<rep>:<wr>:<alloc>:<wr_alloc>,<mshr>:<N>:<merge>,<mq>} (S: = 32B sectors)",
                    "64:128:8,L:B:m:N,A:16:4,4");
     option_parser_register(opp, "-gpgpu_cache:dl2_texture_only", OPT_BOOL, &m_L2_texure_only, 
                            "L2 cache used for texture only",
@@ -201,6 +205,13 @@ void memory_config::reg_options(class OptionParser * opp)
     option_parser_register(opp, "-n_flit_per_mem_cycle", OPT_DOUBLE, 
                           &n_flit_per_mem_cycle, "The number of FLITS transfers per a memory cycle.",
                           "6.");
+    option_parser_register(opp, "-gpgpu_mem_link_interleave", OPT_CSTR, &gpgpu_mem_link_interleave,
+                          "memory partitions on the links: block (6 consecutive per link), cyclic, "
+                          "adaptive (cyclic, hot regions moved between links at kernel boundaries)",
+                          "block");
+    option_parser_register(opp, "-gpgpu_mem_link_max_skew", OPT_FLOAT, &m_link_max_skew,
+                          "adaptive interleaving: busiest link traffic over the mean that triggers a rebalance",
+                          "1.15");
 
     m_address_mapping.addrdec_setoption(opp);
 }
@@ -226,15 +237,15 @@ void shader_core_config::reg_options(class OptionParser * opp)
                    "4:256:4,L:R:f:N,A:2:32,4" );
     option_parser_register(opp, "-gpgpu_cache:dl1", OPT_CSTR, &m_L1D_config.m_config_string,
                    "per-shader L1 data cache config "
-                   " {<nsets>:<bsize>:<assoc>,<rep>:<wr>:<alloc>:<wr_alloc>,<mshr>:<N>:<merge>,<mq> | none}",
+                   " {[S:]<nsets>:<bsize>:<assoc>,<rep>:<wr>:<alloc>:<wr_alloc>,<mshr>:<N>:<merge>,<mq> | none} (S: = 32B sectors)",
                    "none" );
     option_parser_register(opp, "-gpgpu_cache:dl1PrefL1", OPT_CSTR, &m_L1D_config.m_config_stringPrefL1,
                    "per-shader L1 data cache config "
-                   " {<nsets>:<bsize>:<assoc>,<rep>:<wr>:<alloc>:<wr_alloc>,<mshr>:<N>:<merge>,<mq> | none}",
+                   " {[S:]<nsets>:<bsize>:<assoc>,<rep>:<wr>:<alloc>:<wr_alloc>,<mshr>:<N>:<merge>,<mq> | none} (S: = 32B sectors)",
                    "none" );
     option_parser_register(opp, "-gpgpu_cache:dl1PreShared", OPT_CSTR, &m_L1D_config.m_config_stringPrefShared,
                    "per-shader L1 data cache config "
-                   " {<nsets>:<bsize>:<assoc>,<rep>:<wr>:<alloc>:<wr_alloc>,<mshr>:<N>:<merge>,<mq> | none}",
+                   " {[S:]<nsets>:<bsize>:<assoc>,<rep>:<wr>:<alloc>:<wr_alloc>,<mshr>:<N>:<merge>,<mq> | none} (S: = 32B sectors)",
                    "none" );
     option_parser_register(opp, "-gmem_skip_L1D", OPT_BOOL, &gmem_skip_L1D, 
                    "global memory access skip L1D cache (implements -Xptxas -dlcm=cg, default=no skip)",
@@ -354,6 +365,9 @@ void shader_core_config::reg_options(class OptionParser * opp)
     option_parser_register(opp, "-gpgpu_max_insn_issue_per_warp", OPT_INT32, &gpgpu_max_insn_issue_per_warp,
                             "Max number of instructions that can be issued per warp in one cycle by scheduler",
                             "2");
+    option_parser_register(opp, "-gpgpu_core_cycle_skip", OPT_BOOL, &gpgpu_core_cycle_skip,
+                            "Skip the pipeline of cores that cannot make progress until a memory response or a new CTA arrives (same results, less host time)",
+                            "0");
     option_parser_register(opp, "-gpgpu_simt_core_sim_order", OPT_INT32, &simt_core_sim_order,
                             "Select the simulation order of cores in a cluster (0=Fix, 1=Round-Robin)",
                             "1");
@@ -383,6 +397,12 @@ void gpgpu_sim_config::reg_options(option_parser_t opp)
     gpgpu_functional_sim_config::reg_options(opp);
     m_shader_config.reg_options(opp);
     m_memory_config.reg_options(opp);
+    m_sampling_config.reg_options(opp);
+    m_checkpoint_config.reg_options(opp);
+    m_snapshot_config.reg_options(opp);
+    m_stat_config.reg_options(opp);
+    m_host_prof_config.reg_options(opp);
+    m_mf_trace_config.reg_options(opp);
     power_config::reg_options(opp);
    option_parser_register(opp, "-gpgpu_max_cycle", OPT_INT32, &gpu_max_cycle_opt, 
                "terminates gpu simulation early (0 = no limit)",
@@ -421,6 +441,15 @@ void gpgpu_sim_config::reg_options(option_parser_t opp)
                   "500.0:2000.0:2000.0:2000.0");
    option_parser_register(opp, "-gpgpu_max_concurrent_kernel", OPT_INT32, &max_concurrent_kernel,
                           "maximum kernels that can run concurrently on GPU", "8" );
+   option_parser_register(opp, "-gpgpu_sim_threads", OPT_UINT32, &gpgpu_sim_threads,
+                          "number of host threads stepping the timing model (1 = serial)", "1" );
+   option_parser_register(opp, "-gpgpu_parallel_cores", OPT_BOOL, &gpgpu_parallel_cores,
+                          "step the SIMT core clusters in parallel (requires -gpgpu_sim_threads > 1; no speedup yet, "
+                          "most of a cluster's cycle runs in ordered sections)", "0" );
+   option_parser_register(opp, "-gpgpu_parallel_mem", OPT_BOOL, &gpgpu_parallel_mem,
+                          "step the memory partitions and L2 sub partitions in parallel (requires -gpgpu_sim_threads > 1)", "1" );
+   option_parser_register(opp, "-gpgpu_event_skip", OPT_BOOL, &gpgpu_event_skip,
+                          "skip clock edges on which every unit only waits for a timed event (requires -gpgpu_core_cycle_skip)", "0" );
    option_parser_register(opp, "-gpgpu_cflog_interval", OPT_INT32, &gpgpu_cflog_interval, 
                "Interval between each snapshot in control flow logger", 
                "0");
@@ -502,6 +531,11 @@ bool gpgpu_sim::get_more_cta_left() const
       if( m_total_cta_launched >= m_config.gpu_max_cta_opt )
           return false;
    }
+   return kernel_ctas_left();
+}
+
+bool gpgpu_sim::kernel_ctas_left() const
+{
    for(unsigned n=0; n < m_running_kernels.size(); n++ ) {
        if( m_running_kernels[n] && !m_running_kernels[n]->no_more_ctas_to_run() ) 
            return true;
@@ -541,6 +575,7 @@ void gpgpu_sim::set_kernel_done( kernel_info_t *kernel )
 { 
     unsigned uid = kernel->get_uid();
     m_finished_kernel.push_back(uid);
+    m_checkpoint->kernel_done(*kernel);
     std::vector<kernel_info_t*>::iterator k;
     for( k=m_running_kernels.begin(); k!=m_running_kernels.end(); k++ ) {
         if( *k == kernel ) {
@@ -629,16 +664,39 @@ gpgpu_sim::gpgpu_sim( const gpgpu_sim_config &config )
     m_memory_partition_unit = new memory_partition_unit*[m_memory_config->m_n_mem];
     m_memory_sub_partition = new memory_sub_partition*[m_memory_config->m_n_mem_sub_partition];
     for (unsigned i=0;i<m_memory_config->m_n_mem;i++) {
-        m_memory_partition_unit[i] = new memory_partition_unit(i, m_memory_link[i/6], m_memory_config, m_memory_stats);
+        m_memory_partition_unit[i] = new memory_partition_unit(i, m_memory_link[m_memory_config->link_of(i)], m_memory_config, m_memory_stats);
         for (unsigned p = 0; p < m_memory_config->m_n_sub_partition_per_memory_channel; p++) {
             unsigned submpid = i * m_memory_config->m_n_sub_partition_per_memory_channel + p; 
             m_memory_sub_partition[submpid] = m_memory_partition_unit[i]->get_sub_partition(p); 
         }
     }
 
+    m_link_balancer = NULL;
+    if (m_memory_config->m_link_interleave == LINK_INTERLEAVE_ADAPTIVE) {
+        std::vector<unsigned> link_of_chip(m_memory_config->m_n_mem);
+        for (unsigned i=0;i<m_memory_config->m_n_mem;i++) 
+            link_of_chip[i] = m_memory_config->link_of(i);
+        m_link_balancer = new link_balancer(&m_memory_config->m_address_mapping, m_memory_config->m_n_mem,
+                                            link_of_chip, m_memory_config->m_n_mem_link, m_memory_config->m_link_max_skew);
+    }
+
     icnt_wrapper_init();
     icnt_create(m_shader_config->n_simt_clusters,m_memory_config->m_n_mem_sub_partition);
 
+    m_sampler = new sampling_controller(m_config.m_sampling_config, this);
+    m_checkpoint = new checkpoint_manager(m_config.m_checkpoint_config, this);
+    m_snapshot = new kernel_snapshot(m_config.m_snapshot_config, this);
+
+    m_thread_pool = NULL;
+    if( m_config.gpgpu_sim_threads > 1 ) {
+        m_thread_pool = new sim_thread_pool(m_config.gpgpu_sim_threads);
+        printf("GPGPU-Sim uArch: stepping the timing model with %u threads\n", m_config.gpgpu_sim_threads);
+    }
+    m_cluster_stepped.resize(m_shader_config->n_simt_clusters, 0);
+    m_more_cta_left = false;
+    m_event_skip_cycles = 0;
+    m_event_skips = 0;
+
     time_vector_create(NUM_MEM_REQ_STAT);
     fprintf(stdout, "GPGPU-Sim uArch: performance model initialization complete.\n");
 
@@ -659,6 +717,12 @@ gpgpu_sim::gpgpu_sim( const gpgpu_sim_config &config )
     	//g_comp = new BPCompressor();
 	printf("DALE: BPC\n");
     }
+
+    m_stat_registry = new stat_registry(m_config.m_stat_config);
+    host_prof_init(m_config.m_host_prof_config);
+    mf_trace_init(m_config.m_mf_trace_config);
+    if (m_stat_registry->enabled())
+        reg_stats();
 }
 
 int gpgpu_sim::shared_mem_size() const
@@ -718,6 +782,7 @@ void gpgpu_sim::reinit_clock_domains(void)
    dram_time = 0;
    icnt_time = 0;
    l2_time = 0;
+   core_edges = dram_edges = icnt_edges = l2_edges = 0;
 }
 
 bool gpgpu_sim::active()
@@ -773,6 +838,20 @@ void gpgpu_sim::init()
     if (g_network_mode)
        icnt_init();
 
+    m_sampler->kernel_begin();
+
+    // the memory system is drained between kernels, so hot regions can move
+    // to other links; their lines are dropped from the L2 like
+    // -gpgpu_flush_l2_cache does
+    if (m_link_balancer) {
+        unsigned moved = m_link_balancer->rebalance();
+        if (moved) {
+            for (unsigned i=0;i<m_memory_config->m_n_mem_sub_partition;i++) 
+                m_memory_sub_partition[i]->flushL2();
+            printf("GPGPU-Sim uArch: link balancer moved %u regions, L2 invalidated\n", moved);
+        }
+    }
+
     // McPAT initialization function. Called on first launch of GPU
 #ifdef GPGPUSIM_POWER_MODEL
     if(m_config.g_power_simulation_enabled){
@@ -785,13 +864,22 @@ void gpgpu_sim::update_stats() {
     m_memory_stats->memlatstat_lat_pw();
     gpu_tot_sim_cycle += gpu_sim_cycle;
     gpu_tot_sim_insn += gpu_sim_insn;
+    m_checkpoint->kernel_boundary();
 }
 
 void gpgpu_sim::print_stats()
 {
+    // gpu_print_stat() clears the kernel list
+    std::vector<std::string> kernel_names = m_executed_kernel_names;
+    std::vector<unsigned> kernel_uids = m_executed_kernel_uids;
     ptx_file_line_stats_write_file();
     gpu_print_stat();
 
+    if (m_sampler->enabled()) {
+        m_sampler->kernel_end();
+        m_sampler->print(stdout);
+    }
+
     if (g_network_mode) {
         printf("----------------------------Interconnect-DETAILS--------------------------------\n" );
         icnt_display_stats();
@@ -801,6 +889,8 @@ void gpgpu_sim::print_stats()
     for (unsigned i=0;i<m_memory_config->m_n_mem_link;i++) {
         m_memory_link[i]->print_stat();
     }
+    if (m_link_balancer) 
+        m_link_balancer->print(stdout);
 
     printf("Malloc list\n");
     for (auto it = m_malloc_list->begin(); it != m_malloc_list->end(); it++) {
@@ -819,6 +909,91 @@ void gpgpu_sim::print_stats()
     printf(" 128Br: %f\n", m_128Br_bw*1./m_total_bw);
 
     //g_comp->dump_profile(stdout);
+
+    m_stat_registry->snapshot(kernel_names, kernel_uids, gpu_tot_sim_cycle+gpu_sim_cycle);
+}
+
+// counters exported by -gpgpu_stats_json / -gpgpu_stats_csv
+void gpgpu_sim::reg_stats()
+{
+    stat_registry &r = *m_stat_registry;
+    r.reg_counter("gpu_sim_cycle", &gpu_sim_cycle);
+    r.reg_counter("gpu_tot_sim_cycle", &gpu_tot_sim_cycle);
+    r.reg_counter("gpu_sim_insn", &gpu_sim_insn);
+    r.reg_counter("gpu_tot_sim_insn", &gpu_tot_sim_insn);
+    r.reg_counter("gpu_tot_issued_cta", &gpu_tot_issued_cta);
+    r.reg_ratio("gpu_ipc", &gpu_sim_insn, &gpu_sim_cycle);
+    r.reg_histogram("shader_cycle_distro", m_shader_stats->shader_cycle_distro, m_shader_config->warp_size+3);
+    r.reg_group("total", total_stats, this);
+    for (unsigned i=0;i<m_memory_config->m_n_mem;i++) 
+        m_memory_partition_unit[i]->reg_stats(r);
+
+    r.reg_counter("traffic.total_bytes", &m_total_bw);
+    const char *size_name[10] = { "8Bw", "16Bw", "32Bw", "64Bw", "128Bw", "8Br", "16Br", "32Br", "64Br", "128Br" };
+    const unsigned long long *size_bw[10] = { &m_8Bw_bw, &m_16Bw_bw, &m_32Bw_bw, &m_64Bw_bw, &m_128Bw_bw,
+                                              &m_8Br_bw, &m_16Br_bw, &m_32Br_bw, &m_64Br_bw, &m_128Br_bw };
+    for (unsigned i=0;i<10;i++) 
+        r.reg_ratio(std::string("traffic.") + size_name[i], size_bw[i], &m_total_bw);
+    if (!m_malloc_list->empty()) 
+        r.reg_group("malloc", malloc_stats, this);
+
+    for (unsigned i=0;i<m_memory_config->m_n_mem_link;i++) 
+        m_memory_link[i]->reg_stats(r);
+    g_comp->reg_stats(r);
+}
+
+// share of the traffic in each malloc.config range, keyed start-end
+void gpgpu_sim::malloc_stats( const void *gpu, stat_writer &out )
+{
+    const gpgpu_sim *g = (const gpgpu_sim *)gpu;
+    for (auto it = g->m_malloc_list->begin(); it != g->m_malloc_list->end(); it++) {
+        char range[64];
+        snprintf(range, 64, "%llx-%llx", it->first.first, it->first.second);
+        out.value(range, g->m_total_bw? it->second*1./g->m_total_bw : NAN);
+    }
+}
+
+// the whole-GPU lines of gpu_print_stat: IPC and the L1 / L2 totals
+void gpgpu_sim::total_stats( const void *gpu, stat_writer &out )
+{
+    const gpgpu_sim *g = (const gpgpu_sim *)gpu;
+    unsigned long long tot_cycle = gpu_tot_sim_cycle + gpu_sim_cycle;
+    out.value("gpu_tot_ipc", tot_cycle? (double)(g->gpu_tot_sim_insn + g->gpu_sim_insn) / tot_cycle : NAN);
+
+    const char *l1_name[4] = { "L1I", "L1D", "L1C", "L1T" };
+    for (unsigned c=0;c<4;c++) {
+        struct cache_sub_stats css, total_css;
+        total_css.clear();
+        for (unsigned i=0;i<g->m_shader_config->n_simt_clusters;i++) {
+            css.clear();
+            switch (c) {
+            case 0: g->m_cluster[i]->get_L1I_sub_stats(css); break;
+            case 1: g->m_cluster[i]->get_L1D_sub_stats(css); break;
+            case 2: g->m_cluster[i]->get_L1C_sub_stats(css); break;
+            default: g->m_cluster[i]->get_L1T_sub_stats(css); break;
+            }
+            total_css += css;
+        }
+        std::string n = std::string(l1_name[c]) + "_total_cache_";
+        out.value(n + "accesses", total_css.accesses);
+        out.value(n + "misses", total_css.misses);
+        out.value(n + "pending_hits", total_css.pending_hits);
+        out.value(n + "reservation_fails", total_css.res_fails);
+    }
+
+    if (!g->m_memory_config->m_L2_config.disabled()) {
+        struct cache_sub_stats l2_css, total_l2_css;
+        total_l2_css.clear();
+        for (unsigned i=0;i<g->m_memory_config->m_n_mem_sub_partition;i++) {
+            l2_css.clear();
+            g->m_memory_sub_partition[i]->get_L2cache_sub_stats(l2_css);
+            total_l2_css += l2_css;
+        }
+        out.value("L2_total_cache_accesses", total_l2_css.accesses);
+        out.value("L2_total_cache_misses", total_l2_css.misses);
+        out.value("L2_total_cache_pending_hits", total_l2_css.pending_hits);
+        out.value("L2_total_cache_reservation_fails", total_l2_css.res_fails);
+    }
 }
 
 void gpgpu_sim::deadlock_check()
@@ -985,6 +1160,8 @@ void gpgpu_sim::gpu_print_stat()
    // performance counter for stalls due to congestion.
    printf("gpu_stall_dramfull = %d\n", gpu_stall_dramfull);
    printf("gpu_stall_icnt2sh    = %d\n", gpu_stall_icnt2sh );
+   if (m_config.gpgpu_event_skip) 
+      printf("gpgpu_event_skip_cycles = %llu (%llu skips)\n", m_event_skip_cycles, m_event_skips);
 
    time_t curr_time;
    time(&curr_time);
@@ -1100,24 +1277,24 @@ void shader_core_ctx::mem_instruction_stats(const warp_inst_t &inst)
     case reg_space:
         break;
     case shared_space:
-        m_stats->gpgpu_n_shmem_insn += active_count; 
+        sim_thread_pool::add(m_stats->gpgpu_n_shmem_insn, active_count); 
         break;
     case const_space:
-        m_stats->gpgpu_n_const_insn += active_count;
+        sim_thread_pool::add(m_stats->gpgpu_n_const_insn, active_count);
         break;
     case param_space_kernel:
     case param_space_local:
-        m_stats->gpgpu_n_param_insn += active_count;
+        sim_thread_pool::add(m_stats->gpgpu_n_param_insn, active_count);
         break;
     case tex_space:
-        m_stats->gpgpu_n_tex_insn += active_count;
+        sim_thread_pool::add(m_stats->gpgpu_n_tex_insn, active_count);
         break;
     case global_space:
     case local_space:
         if( inst.is_store() )
-            m_stats->gpgpu_n_store_insn += active_count;
+            sim_thread_pool::add(m_stats->gpgpu_n_store_insn, active_count);
         else 
-            m_stats->gpgpu_n_load_insn += active_count;
+            sim_thread_pool::add(m_stats->gpgpu_n_load_insn, active_count);
         break;
     default:
         abort();
@@ -1136,6 +1313,7 @@ void shader_core_ctx::mem_instruction_stats(const warp_inst_t &inst)
 
 void shader_core_ctx::issue_block2core( kernel_info_t &kernel ) 
 {
+    wake();
     set_max_cta(kernel);
 
     // find a free CTA context 
@@ -1200,33 +1378,89 @@ void dram_t::dram_log( int task )
    }
 }
 
-//Find next clock domain and increment its time
-int gpgpu_sim::next_clock_domain(void) 
+//Find next clock domain without incrementing its time
+int gpgpu_sim::peek_clock_domain(void) const
 {
    double smallest = min3(core_time,icnt_time,dram_time);
    int mask = 0x00;
    if ( l2_time <= smallest ) {
       smallest = l2_time;
       mask |= L2 ;
-      l2_time += m_config.l2_period;
    }
-   if ( icnt_time <= smallest ) {
+   if ( icnt_time <= smallest ) 
       mask |= ICNT;
-      icnt_time += m_config.icnt_period;
-   }
-   if ( dram_time <= smallest ) {
+   if ( dram_time <= smallest ) 
       mask |= DRAM;
-      dram_time += m_config.dram_period;
-   }
-   if ( core_time <= smallest ) {
+   if ( core_time <= smallest ) 
       mask |= CORE;
-      core_time += m_config.core_period;
-   }
    return mask;
 }
 
+//Find next clock domain and increment its time
+int gpgpu_sim::next_clock_domain(void) 
+{
+   int mask = peek_clock_domain();
+   if ( mask & L2 ) 
+      l2_time = ++l2_edges * m_config.l2_period;
+   if ( mask & ICNT ) 
+      icnt_time = ++icnt_edges * m_config.icnt_period;
+   if ( mask & DRAM ) 
+      dram_time = ++dram_edges * m_config.dram_period;
+   if ( mask & CORE ) 
+      core_time = ++core_edges * m_config.core_period;
+   return mask;
+}
+
+void gpgpu_sim::core_cycle_task( void *gpu, unsigned cluster_id )
+{
+    HOST_PROF_SCOPE(HP_CLUSTER);
+    gpgpu_sim *g = (gpgpu_sim*)gpu;
+    g->m_cluster_stepped[cluster_id] = g->m_cluster[cluster_id]->get_not_completed() || g->m_more_cta_left;
+    if( g->m_cluster_stepped[cluster_id] )
+        g->m_cluster[cluster_id]->core_cycle();
+}
+
+void gpgpu_sim::dram_cycle_task( void *gpu, unsigned i )
+{
+    gpgpu_sim *g = (gpgpu_sim*)gpu;
+    g->m_memory_partition_unit[i]->dram_cycle(); // Issue the dram command (scheduler + delay model)
+    g->update_dram_power_stats(i);
+}
+
+void gpgpu_sim::update_dram_power_stats( unsigned i )
+{
+    // Update performance counters for DRAM
+    power_mem_stat_t *pwr = m_power_stats->pwr_mem_stat;
+    m_memory_partition_unit[i]->set_dram_power_stats(pwr->n_cmd[CURRENT_STAT_IDX][i], pwr->n_activity[CURRENT_STAT_IDX][i],
+                   pwr->n_nop[CURRENT_STAT_IDX][i], pwr->n_act[CURRENT_STAT_IDX][i], pwr->n_pre[CURRENT_STAT_IDX][i],
+                   pwr->n_rd[CURRENT_STAT_IDX][i], pwr->n_wr[CURRENT_STAT_IDX][i], pwr->n_req[CURRENT_STAT_IDX][i]);
+}
+
+void gpgpu_sim::icnt_to_sub_partition( unsigned i )
+{
+    //move memory request from interconnect into memory partition (if not backed up)
+    //Note:This needs to be called in DRAM clock domain if there is no L2 cache in the system
+    if ( m_memory_sub_partition[i]->full() ) {
+       gpu_stall_dramfull++;
+    } else {
+        mem_fetch* mf = (mem_fetch*) icnt_pop( m_shader_config->mem2device(i) );
+        if (mf && m_link_balancer) 
+            m_link_balancer->record(mf->get_tlx_addr(), mf->get_data_size());
+        m_memory_sub_partition[i]->push( mf, gpu_sim_cycle + gpu_tot_sim_cycle );
+    }
+}
+
+void gpgpu_sim::cache_cycle_task( void *gpu, unsigned i )
+{
+    gpgpu_sim *g = (gpgpu_sim*)gpu;
+    g->m_memory_sub_partition[i]->cache_cycle(gpu_sim_cycle+gpu_tot_sim_cycle);
+}
+
 void gpgpu_sim::issue_block2core()
 {
+    // fast-forwarded CTAs are executed functionally and never reach a core
+    m_sampler->issue_block2core();
+
     unsigned last_issued = m_last_cluster_issue; 
     for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) {
         unsigned idx = (i + last_issued + 1) % m_shader_config->n_simt_clusters;
@@ -1240,17 +1474,160 @@ void gpgpu_sim::issue_block2core()
 
 unsigned long long g_single_step=0; // set this in gdb to single step the pipeline
 
+// Number of edges of a clock domain, edges_done * period onwards, that fall
+// before 'before' and no later than 'until'. The estimate from the division
+// is corrected with the same products next_clock_domain() computes.
+static unsigned long long edges_before( unsigned long long edges_done, double period, double before, double until )
+{
+   double bound = std::min(before, until);
+   unsigned long long n = 0;
+   if( bound != HUGE_VAL && bound / period > edges_done ) 
+      n = (unsigned long long)(bound / period) - edges_done;
+   while( n && !((edges_done + n - 1) * period < before && (edges_done + n - 1) * period <= until) ) 
+      n--;
+   while( (edges_done + n) * period < before && (edges_done + n) * period <= until ) 
+      n++;
+   return n;
+}
+
+// Event skipping: while every core sleeps (-gpgpu_core_cycle_skip), the
+// interconnect, L2 and DRAM are idle and the only requests in flight sit in
+// the memory links or in fixed-latency queues, no clock edge changes any
+// state before the earliest of those events. The edges up to that event are
+// not stepped; the stats they would have collected are applied in bulk.
+void gpgpu_sim::skip_idle_edges()
+{
+   HOST_PROF_SCOPE(HP_EVENT_SKIP);
+   if( g_single_step || g_interactive_debugger_enabled || m_sampler->enabled() ) 
+      return;
+#ifdef GPGPUSIM_POWER_MODEL
+   if( m_config.g_power_simulation_enabled ) 
+      return;
+#endif
+
+   bool more_cta_left = get_more_cta_left();
+   for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) {
+      if( !m_cluster[i]->quiescent(m_cluster[i]->get_not_completed() || more_cta_left) ) 
+         return;
+   }
+   if( more_cta_left ) {
+      for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
+         if( m_cluster[i]->can_issue_block() ) 
+            return;
+   }
+   if( !::icnt_idle() ) 
+      return;
+
+   // earliest cycle at which a queued request becomes ready
+   unsigned long long next_event = (unsigned long long)-1;
+   for (unsigned i=0;i<m_memory_config->m_n_mem_sub_partition;i++) 
+      if( !m_memory_sub_partition[i]->quiescent(next_event) ) 
+         return;
+   for (unsigned i=0;i<m_memory_config->m_n_mem;i++) 
+      if( !m_memory_partition_unit[i]->quiescent(next_event) ) 
+         return;
+   unsigned long long max_dram = (unsigned long long)-1;
+   for (unsigned i=0;i<m_memory_config->m_n_mem_link;i++) 
+      if( !m_memory_link[i]->quiescent(next_event, max_dram) ) 
+         return;
+
+   // periodic work on the core clock runs on its own edge
+   unsigned long long max_core = m_config.gpu_stat_sample_freq - gpu_sim_cycle % m_config.gpu_stat_sample_freq - 1;
+   max_core = std::min(max_core, 100000 - gpu_sim_cycle % 100000 - 1);
+   unsigned long long next_stat = stat_tool_next_event(gpu_sim_cycle);
+   if( next_stat != (unsigned long long)-1 ) 
+      max_core = std::min(max_core, (next_stat > gpu_sim_cycle)? next_stat - gpu_sim_cycle - 1 : 0);
+   unsigned long long next_row = m_stat_registry->next_sample();
+   if( next_row != (unsigned long long)-1 ) {
+      unsigned long long now = gpu_sim_cycle + gpu_tot_sim_cycle;
+      max_core = std::min(max_core, (next_row > now + 1)? next_row - now - 1 : 0);
+   }
+   if( m_config.gpu_max_cycle_opt ) {
+      unsigned long long now = gpu_sim_cycle + gpu_tot_sim_cycle;
+      max_core = std::min(max_core, (m_config.gpu_max_cycle_opt > now)? m_config.gpu_max_cycle_opt - now - 1 : 0);
+   }
+
+   // Stepping next_clock_domain() would take every edge (of any domain)
+   // before the core edge past max_core and before the DRAM edge past
+   // max_dram, and stop right after the core edge reaching next_event.
+   unsigned long long now = gpu_sim_cycle + gpu_tot_sim_cycle;
+   if( now >= next_event ) 
+      return;
+   double before = std::min((core_edges + max_core) * m_config.core_period, 
+                            (max_dram == (unsigned long long)-1)? HUGE_VAL : (dram_edges + max_dram) * m_config.dram_period);
+   double until = HUGE_VAL;
+   if( next_event != (unsigned long long)-1 ) 
+      until = (core_edges + (next_event - now) - 1) * m_config.core_period;
+   unsigned long long n_core = edges_before(core_edges, m_config.core_period, before, until);
+   unsigned long long n_icnt = edges_before(icnt_edges, m_config.icnt_period, before, until);
+   unsigned long long n_l2 = edges_before(l2_edges, m_config.l2_period, before, until);
+   unsigned long long n_dram = edges_before(dram_edges, m_config.dram_period, before, until);
+   if( !n_core && !n_icnt && !n_l2 && !n_dram ) 
+      return;
+   core_time = (core_edges += n_core) * m_config.core_period;
+   icnt_time = (icnt_edges += n_icnt) * m_config.icnt_period;
+   l2_time = (l2_edges += n_l2) * m_config.l2_period;
+   dram_time = (dram_edges += n_dram) * m_config.dram_period;
+   gpu_sim_cycle += n_core;
+   m_event_skips++;
+   m_event_skip_cycles += n_core;
+
+   if( n_core ) {
+      m_power_stats->pwr_mem_stat->core_cache_stats[CURRENT_STAT_IDX].clear();
+      for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) {
+         m_cluster_stepped[i] = m_cluster[i]->get_not_completed() || more_cta_left;
+         if( m_cluster_stepped[i] ) 
+            m_cluster[i]->skip_cycles(n_core);
+         m_cluster[i]->get_icnt_stats(m_power_stats->pwr_mem_stat->n_simt_to_mem[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_mem_to_simt[CURRENT_STAT_IDX][i]);
+         m_cluster[i]->get_cache_stats(m_power_stats->pwr_mem_stat->core_cache_stats[CURRENT_STAT_IDX]);
+      }
+      float temp=0;
+      for (unsigned i=0;i<m_shader_config->num_shader();i++)
+        temp+=m_shader_stats->m_pipeline_duty_cycle[i];
+      temp=temp/m_shader_config->num_shader();
+      // one float add per skipped edge, as cycle() would do
+      for (unsigned long long c=0;c<n_core;c++) {
+         for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
+            if( m_cluster_stepped[i] ) 
+               *active_sms+=m_cluster[i]->get_n_active_sms();
+         *average_pipeline_duty_cycle=((*average_pipeline_duty_cycle)+temp);
+      }
+   }
+   if( n_icnt ) 
+      ::icnt_skip(n_icnt);
+   if( n_dram ) {
+      for (unsigned i=0;i<m_memory_config->m_n_mem_link;i++) 
+         m_memory_link[i]->skip(n_dram, m_memory_config->n_flit_per_mem_cycle);
+      for (unsigned i=0;i<m_memory_config->m_n_mem;i++) {
+         m_memory_partition_unit[i]->skip_cycles(n_dram);
+         update_dram_power_stats(i);
+      }
+   }
+   if( n_l2 ) {
+      m_power_stats->pwr_mem_stat->l2_cache_stats[CURRENT_STAT_IDX].clear();
+      for (unsigned i=0;i<m_memory_config->m_n_mem_sub_partition;i++) {
+         m_memory_sub_partition[i]->skip_cycles(n_l2);
+         m_memory_sub_partition[i]->accumulate_L2cache_stats(m_power_stats->pwr_mem_stat->l2_cache_stats[CURRENT_STAT_IDX]);
+      }
+   }
+}
+
 void gpgpu_sim::cycle()
 {
+   if( m_config.gpgpu_event_skip ) 
+      skip_idle_edges();
+
    int clock_mask = next_clock_domain();
 
    if (clock_mask & CORE ) {
        // shader core loading (pop from ICNT into core) follows CORE clock
+      HOST_PROF_SCOPE(HP_CORE_ICNT);
       for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
          m_cluster[i]->icnt_cycle(); 
    }
     if (clock_mask & ICNT) {
         // pop from memory controller to interconnect
+        HOST_PROF_SCOPE(HP_MEM_ICNT);
         for (unsigned i=0;i<m_memory_config->m_n_mem_sub_partition;i++) {
             mem_fetch* mf = m_memory_sub_partition[i]->top();
             if (mf) {
@@ -1289,6 +1666,7 @@ void gpgpu_sim::cycle()
     //}
     //}
     if (clock_mask & DRAM) {
+        HOST_PROF_SCOPE(HP_LINK);
         for (unsigned i=0;i<m_memory_config->m_n_mem_link;i++) {
             // link interface: 45Gbps x 16-bit = 720Gbps = 90GBps
             // A DRAM clock (924MHz) = 48 link clock(45GHz) = 96B (48 x 16-bit) = 6 FLIT
@@ -1297,16 +1675,17 @@ void gpgpu_sim::cycle()
     }
 
    if (clock_mask & DRAM) {
-      for (unsigned i=0;i<m_memory_config->m_n_mem;i++){
-         m_memory_partition_unit[i]->dram_cycle(); // Issue the dram command (scheduler + delay model)
-         // Update performance counters for DRAM
-         m_memory_partition_unit[i]->set_dram_power_stats(m_power_stats->pwr_mem_stat->n_cmd[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_activity[CURRENT_STAT_IDX][i],
-                        m_power_stats->pwr_mem_stat->n_nop[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_act[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_pre[CURRENT_STAT_IDX][i],
-                        m_power_stats->pwr_mem_stat->n_rd[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_wr[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_req[CURRENT_STAT_IDX][i]);
+      HOST_PROF_SCOPE(HP_DRAM);
+      if( parallel_mem() ) {
+         m_thread_pool->run(m_memory_config->m_n_mem, dram_cycle_task, this);
+      } else {
+         for (unsigned i=0;i<m_memory_config->m_n_mem;i++)
+            dram_cycle_task(this, i);
       }
    }
 
     if (clock_mask & DRAM) {
+        HOST_PROF_SCOPE(HP_LINK);
         for (unsigned i=0;i<m_memory_config->m_n_mem_link;i++) {
             // link interface: 45Gbps x 16-bit = 720Gbps = 90GBps
             // A DRAM clock (924MHz) = 48 link clock(45GHz) = 96B (48 x 16-bit) = 6 FLIT
@@ -1316,43 +1695,67 @@ void gpgpu_sim::cycle()
 
    // L2 operations follow L2 clock domain
    if (clock_mask & L2) {
+      HOST_PROF_SCOPE(HP_L2);
        m_power_stats->pwr_mem_stat->l2_cache_stats[CURRENT_STAT_IDX].clear();
-      for (unsigned i=0;i<m_memory_config->m_n_mem_sub_partition;i++) {
-          //move memory request from interconnect into memory partition (if not backed up)
-          //Note:This needs to be called in DRAM clock domain if there is no L2 cache in the system
-          if ( m_memory_sub_partition[i]->full() ) {
-             gpu_stall_dramfull++;
-          } else {
-              mem_fetch* mf = (mem_fetch*) icnt_pop( m_shader_config->mem2device(i) );
-              m_memory_sub_partition[i]->push( mf, gpu_sim_cycle + gpu_tot_sim_cycle );
-          }
-          m_memory_sub_partition[i]->cache_cycle(gpu_sim_cycle+gpu_tot_sim_cycle);
+      for (unsigned i=0;i<m_memory_config->m_n_mem_link;i++) 
+         m_memory_link[i]->snapshot_flit_cnt();
+      if( parallel_mem() ) {
+         // a sub partition's cache cycle never looks at the icnt or at other sub
+         // partitions, so all icnt pops can go first
+         for (unsigned i=0;i<m_memory_config->m_n_mem_sub_partition;i++) 
+            icnt_to_sub_partition(i);
+         m_thread_pool->run(m_memory_config->m_n_mem_sub_partition, cache_cycle_task, this);
+      } else {
+         for (unsigned i=0;i<m_memory_config->m_n_mem_sub_partition;i++) {
+            icnt_to_sub_partition(i);
+            cache_cycle_task(this, i);
+         }
+      }
+      for (unsigned i=0;i<m_memory_config->m_n_mem_sub_partition;i++) 
           m_memory_sub_partition[i]->accumulate_L2cache_stats(m_power_stats->pwr_mem_stat->l2_cache_stats[CURRENT_STAT_IDX]);
-       }
    }
 
    if (clock_mask & ICNT) {
+      HOST_PROF_SCOPE(HP_ICNT);
       icnt_transfer();
    }
 
    if (clock_mask & CORE) {
       // L1 cache + shader core pipeline stages
       m_power_stats->pwr_mem_stat->core_cache_stats[CURRENT_STAT_IDX].clear();
-      for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) {
-         if (m_cluster[i]->get_not_completed() || get_more_cta_left() ) {
-               m_cluster[i]->core_cycle();
-               *active_sms+=m_cluster[i]->get_n_active_sms();
+      // CTAs are only issued after the cores step, so this holds for the whole loop
+      m_more_cta_left = get_more_cta_left();
+      {
+         HOST_PROF_SCOPE(HP_CORE);
+         if( m_thread_pool && m_config.gpgpu_parallel_cores ) {
+            m_thread_pool->run(m_shader_config->n_simt_clusters, core_cycle_task, this);
+         } else {
+            for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
+               core_cycle_task(this, i);
          }
-         // Update core icnt/cache stats for GPUWattch
-         m_cluster[i]->get_icnt_stats(m_power_stats->pwr_mem_stat->n_simt_to_mem[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_mem_to_simt[CURRENT_STAT_IDX][i]);
-         m_cluster[i]->get_cache_stats(m_power_stats->pwr_mem_stat->core_cache_stats[CURRENT_STAT_IDX]);
       }
-      float temp=0;
-      for (unsigned i=0;i<m_shader_config->num_shader();i++){
-        temp+=m_shader_stats->m_pipeline_duty_cycle[i];
+      {
+         HOST_PROF_SCOPE(HP_CORE_STATS);
+         for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) {
+            if (m_cluster_stepped[i]) {
+                  *active_sms+=m_cluster[i]->get_n_active_sms();
+                  m_cluster[i]->commit_deferred_stats();
+                  if (m_cluster[i]->get_last_retire_sid() >= 0) {
+                      gpu_sim_insn_last_update_sid = m_cluster[i]->get_last_retire_sid();
+                      gpu_sim_insn_last_update = gpu_sim_cycle;
+                  }
+            }
+            // Update core icnt/cache stats for GPUWattch
+            m_cluster[i]->get_icnt_stats(m_power_stats->pwr_mem_stat->n_simt_to_mem[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_mem_to_simt[CURRENT_STAT_IDX][i]);
+            m_cluster[i]->get_cache_stats(m_power_stats->pwr_mem_stat->core_cache_stats[CURRENT_STAT_IDX]);
+         }
+         float temp=0;
+         for (unsigned i=0;i<m_shader_config->num_shader();i++){
+           temp+=m_shader_stats->m_pipeline_duty_cycle[i];
+         }
+         temp=temp/m_shader_config->num_shader();
+         *average_pipeline_duty_cycle=((*average_pipeline_duty_cycle)+temp);
       }
-      temp=temp/m_shader_config->num_shader();
-      *average_pipeline_duty_cycle=((*average_pipeline_duty_cycle)+temp);
         //cout<<"Average pipeline duty cycle: "<<*average_pipeline_duty_cycle<<endl;
 
 
@@ -1360,18 +1763,25 @@ void gpgpu_sim::cycle()
           asm("int $03");
       }
       gpu_sim_cycle++;
+      m_sampler->cycle();
+      m_stat_registry->sample(gpu_sim_cycle+gpu_tot_sim_cycle);
       if( g_interactive_debugger_enabled ) 
          gpgpu_debug();
 
       // McPAT main cycle (interface with McPAT)
 #ifdef GPGPUSIM_POWER_MODEL
       if(m_config.g_power_simulation_enabled){
+          HOST_PROF_SCOPE(HP_POWER);
           mcpat_cycle(m_config, getShaderCoreConfig(), m_gpgpusim_wrapper, m_power_stats, m_config.gpu_stat_sample_freq, gpu_tot_sim_cycle, gpu_sim_cycle, gpu_tot_sim_insn, gpu_sim_insn);
       }
 #endif
 
-      issue_block2core();
+      {
+         HOST_PROF_SCOPE(HP_ISSUE);
+         issue_block2core();
+      }
       
+      HOST_PROF_SCOPE(HP_PERIODIC);
       // Depending on configuration, flush the caches once all of threads are completed.
       int all_threads_complete = 1;
       if (m_config.gpgpu_flush_l1_cache) {
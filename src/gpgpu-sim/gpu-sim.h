@@ -33,6 +33,15 @@
 #include "../trace.h"
 #include "addrdec.h"
 #include "shader.h"
+#include "sampling.h"
+#include "checkpoint.h"
+#include "snapshot.h"
+#include "stat_registry.h"
+#include "host_prof.h"
+#include "mf_trace.h"
+#include "l2_prefetcher.h"
+#include "dram_sched_queue.h"
+#include "stacked_dram.h"
 #include <iostream>
 #include <fstream>
 #include <list>
@@ -144,6 +153,12 @@ struct power_config {
 
 
 
+enum link_interleave_t {
+   LINK_INTERLEAVE_BLOCK = 0,
+   LINK_INTERLEAVE_CYCLIC,
+   LINK_INTERLEAVE_ADAPTIVE
+};
+
 struct memory_config {
    memory_config()
    {
@@ -209,17 +224,39 @@ struct memory_config {
       m_n_mem_sub_partition = m_n_mem * m_n_sub_partition_per_memory_channel; 
       fprintf(stdout, "Total number of memory sub partition = %u\n", m_n_mem_sub_partition); 
       m_n_mem_link = (m_n_mem+5)/6;
+      if (!strcmp(gpgpu_mem_link_interleave, "block")) {
+         m_link_interleave = LINK_INTERLEAVE_BLOCK;
+      } else if (!strcmp(gpgpu_mem_link_interleave, "cyclic")) {
+         m_link_interleave = LINK_INTERLEAVE_CYCLIC;
+      } else if (!strcmp(gpgpu_mem_link_interleave, "adaptive")) {
+         m_link_interleave = LINK_INTERLEAVE_ADAPTIVE;
+      } else {
+         printf("GPGPU-Sim uArch: ERROR ** unknown link interleaving '%s'\n", gpgpu_mem_link_interleave);
+         exit(1);
+      }
 
       m_address_mapping.init(m_n_mem, m_n_sub_partition_per_memory_channel);
       m_L2_config.init(&m_address_mapping);
+      m_L2_prefetch_config.init();
+      m_dram_sched_config.init(gpgpu_frfcfs_dram_sched_queue_size);
+      m_stacked_dram_config.init();
 
       m_valid = true;
       icnt_flit_size = 32; // Default 32
    }
    void reg_options(class OptionParser * opp);
 
+   // memory link of a memory partition
+   unsigned link_of( unsigned partition ) const
+   {
+      return (m_link_interleave == LINK_INTERLEAVE_BLOCK)? partition / 6 : partition % m_n_mem_link;
+   }
+
    bool m_valid;
    mutable l2_cache_config m_L2_config;
+   l2_prefetch_config m_L2_prefetch_config;
+   dram_sched_config m_dram_sched_config;
+   stacked_dram_config m_stacked_dram_config;
    bool m_L2_texure_only;
 
    char *gpgpu_dram_timing_opt;
@@ -234,6 +271,9 @@ struct memory_config {
    unsigned m_n_mem_sub_partition;
    unsigned gpu_n_mem_per_ctrlr;
    unsigned m_n_mem_link;
+   char *gpgpu_mem_link_interleave;
+   enum link_interleave_t m_link_interleave;
+   float m_link_max_skew;
 
    unsigned rop_latency;
    unsigned dram_latency;
@@ -272,7 +312,8 @@ struct memory_config {
    unsigned data_command_freq_ratio; // frequency ratio between DRAM data bus and command bus (2 for GDDR3, 4 for GDDR5)
    unsigned dram_atom_size; // number of bytes transferred per read or write command 
 
-   linear_to_raw_address_translation m_address_mapping;
+   // mutable: the link balancer moves regions between kernels
+   mutable linear_to_raw_address_translation m_address_mapping;
 
    unsigned icnt_flit_size;
 };
@@ -294,6 +335,8 @@ public:
         m_shader_config.init();
         ptx_set_tex_cache_linesize(m_shader_config.m_L1T_config.get_line_sz());
         m_memory_config.init();
+        m_sampling_config.init();
+        m_snapshot_config.init();
         init_clock_domains(); 
         power_config::init();
         Trace::init();
@@ -327,6 +370,12 @@ private:
     bool m_valid;
     shader_core_config m_shader_config;
     memory_config m_memory_config;
+    sampling_config m_sampling_config;
+    checkpoint_config m_checkpoint_config;
+    snapshot_config m_snapshot_config;
+    stat_registry_config m_stat_config;
+    host_prof_config m_host_prof_config;
+    mf_trace_config m_mf_trace_config;
     // clock domains - frequency
     double core_freq;
     double icnt_freq;
@@ -350,6 +399,12 @@ private:
     char * gpgpu_clock_domains;
     unsigned max_concurrent_kernel;
 
+    // host threads used to step the timing model (1 = serial)
+    unsigned gpgpu_sim_threads;
+    bool gpgpu_parallel_cores;
+    bool gpgpu_parallel_mem;
+    bool gpgpu_event_skip;
+
     // visualizer
     bool  g_visualizer_enabled;
     char *g_visualizer_filename;
@@ -398,6 +453,7 @@ public:
 
    unsigned threads_per_core() const;
    bool get_more_cta_left() const;
+   bool kernel_ctas_left() const;
    kernel_info_t *select_kernel();
 
    const gpgpu_sim_config &get_config() const { return m_config; }
@@ -426,6 +482,15 @@ public:
     */
     simt_core_cluster * getSIMTCluster();
 
+    //! Sampled simulation controller (fast-forward, warm-up and extrapolation)
+    class sampling_controller *get_sampler() { return m_sampler; }
+    //! Kernel-boundary checkpoint writer / restorer
+    class checkpoint_manager *get_checkpoint() { return m_checkpoint; }
+    //! Kernel launch memory snapshot recorder / single-kernel replay
+    class kernel_snapshot *get_snapshot() { return m_snapshot; }
+    //! Named statistics exported as JSON / CSV time series
+    class stat_registry *get_stat_registry() { return m_stat_registry; }
+
     void update_traffic(mem_fetch *mf) {
         unsigned data_size = mf->get_data_size();
         m_total_bw += data_size;
@@ -467,6 +532,8 @@ private:
    // clocks
    void reinit_clock_domains(void);
    int  next_clock_domain(void);
+   int  peek_clock_domain(void) const;
+   void skip_idle_edges();
    void issue_block2core();
    void print_dram_stats(FILE *fout) const;
    void shader_print_runtime_stat( FILE *fout );
@@ -475,6 +542,9 @@ private:
    void shader_print_scheduler_stat( FILE* fout, bool print_dynamic_info ) const;
    void visualizer_printstat();
    void print_shader_cycle_distro( FILE *fout ) const;
+   void reg_stats();
+   static void malloc_stats( const void *gpu, class stat_writer &out );
+   static void total_stats( const void *gpu, class stat_writer &out );
 
    void gpgpu_debug();
 
@@ -496,6 +566,23 @@ private:
    unsigned long long m_128Br_bw;
    class std::list<std::pair<addr_range, unsigned long long>> *m_malloc_list;
    class memory_link **m_memory_link;
+   class sampling_controller *m_sampler;
+   class link_balancer *m_link_balancer;
+   class checkpoint_manager *m_checkpoint;
+   class kernel_snapshot *m_snapshot;
+   class stat_registry *m_stat_registry;
+   class sim_thread_pool *m_thread_pool;
+   std::vector<char> m_cluster_stepped; // clusters stepped in the current core cycle
+   bool m_more_cta_left;
+
+   static void core_cycle_task( void *gpu, unsigned cluster_id );
+   static void dram_cycle_task( void *gpu, unsigned partition_id );
+   static void cache_cycle_task( void *gpu, unsigned sub_partition_id );
+   void icnt_to_sub_partition( unsigned sub_partition_id );
+   bool parallel_mem() const { return m_thread_pool && m_config.gpgpu_parallel_mem; }
+   void update_dram_power_stats( unsigned partition_id );
+   unsigned long long m_event_skip_cycles; // core cycles skipped by skip_idle_edges()
+   unsigned long long m_event_skips;
 
    std::vector<kernel_info_t*> m_running_kernels;
    unsigned m_last_issued_kernel;
@@ -505,11 +592,16 @@ private:
    unsigned m_last_cluster_issue;
    float * average_pipeline_duty_cycle;
    float * active_sms;
-   // time of next rising edge 
+   // time of next rising edge (edges so far times the period, so that
+   // skip_idle_edges() computes the same times without stepping)
    double core_time;
    double icnt_time;
    double dram_time;
    double l2_time;
+   unsigned long long core_edges;
+   unsigned long long icnt_edges;
+   unsigned long long dram_edges;
+   unsigned long long l2_edges;
 
    // debug
    bool gpu_deadlock;
@@ -538,6 +630,9 @@ private:
    std::string executed_kernel_info_string(); //< format the kernel information into a string for stat printout
    void clear_executed_kernel_info(); //< clear the kernel information after stat printout
 
+   friend class sampling_controller;
+   friend class checkpoint_manager;
+
 public:
    unsigned long long  gpu_sim_insn;
    unsigned long long  gpu_tot_sim_insn;
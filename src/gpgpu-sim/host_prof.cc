@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "host_prof.h"
+
+void host_prof_config::reg_options( option_parser_t opp )
+{
+   option_parser_register(opp, "-gpgpu_host_prof_trace", OPT_CSTR, &m_trace_file,
+                          "Write the host time profile scopes as Chrome trace-event JSON (needs a HOST_PROF=1 build, none = off)",
+                          "none");
+   option_parser_register(opp, "-gpgpu_host_prof_trace_max", OPT_UINT32, &m_trace_max,
+                          "Trace events kept per thread for -gpgpu_host_prof_trace",
+                          "1000000");
+}
+
+#if HOST_PROF_ON
+
+static const char *zone_name[HP_N_ZONE] = {
+   "event_skip", "core.icnt_pop", "icnt.mem_push", "link", "dram", "l2", "icnt",
+   "core", "core.cluster", "core.stats", "power", "core.issue", "periodic", "compress"
+};
+
+__thread host_prof_thread *g_host_prof_thread = NULL;
+
+static bool g_host_prof_started = false;
+static host_prof_config g_host_prof_config;
+static pthread_mutex_t g_host_prof_mutex = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<host_prof_thread*> g_host_prof_threads;
+static unsigned long long g_host_prof_start_ticks;
+static double g_host_prof_start_ns;
+
+static double wall_ns()
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+host_prof_thread *host_prof_thread_create()
+{
+   host_prof_thread *t = new host_prof_thread;
+   memset(t->ticks, 0, sizeof(t->ticks));
+   memset(t->calls, 0, sizeof(t->calls));
+   t->max_events = (g_host_prof_started && g_host_prof_config.trace_enabled())? g_host_prof_config.m_trace_max : 0;
+   pthread_mutex_lock(&g_host_prof_mutex);
+   t->id = g_host_prof_threads.size();
+   g_host_prof_threads.push_back(t);
+   pthread_mutex_unlock(&g_host_prof_mutex);
+   g_host_prof_thread = t;
+   return t;
+}
+
+static void write_trace( double ns_per_tick )
+{
+   FILE *f = fopen(g_host_prof_config.m_trace_file, "w");
+   if( f == NULL ) {
+      printf("GPGPU-Sim uArch: ERROR ** could not open -gpgpu_host_prof_trace file %s\n", g_host_prof_config.m_trace_file);
+      return;
+   }
+   fprintf(f, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+   bool first = true;
+   for( unsigned i=0; i < g_host_prof_threads.size(); i++ ) {
+      const host_prof_thread *t = g_host_prof_threads[i];
+      fprintf(f, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %u, \"args\": {\"name\": \"thread %u\"}}",
+              first? "" : ",\n", t->id, t->id);
+      first = false;
+      for( unsigned e=0; e < t->events.size(); e++ ) {
+         const host_prof_event &ev = t->events[e];
+         // microseconds since host_prof_init()
+         double ts = (double)(long long)(ev.start - g_host_prof_start_ticks) * ns_per_tick / 1000;
+         double dur = (double)(ev.end - ev.start) * ns_per_tick / 1000;
+         fprintf(f, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+                 zone_name[ev.zone], t->id, ts, dur);
+      }
+   }
+   fprintf(f, "\n]}\n");
+   fclose(f);
+   printf("GPGPU-Sim uArch: host profile trace written to %s\n", g_host_prof_config.m_trace_file);
+}
+
+static void host_prof_report()
+{
+   unsigned long long ticks = host_prof_ticks() - g_host_prof_start_ticks;
+   double wall = wall_ns() - g_host_prof_start_ns;
+   double ns_per_tick = ticks? wall / ticks : 0.0;
+
+   pthread_mutex_lock(&g_host_prof_mutex);
+   printf("\n----------------------------Host-time-profile-----------------------------------\n");
+   printf("wall time = %.3f s, %zu threads (zones include the zones nested in them)\n", wall / 1e9, g_host_prof_threads.size());
+   printf("%-16s %14s %12s %8s %10s %8s\n", "zone", "calls", "seconds", "% wall", "ns/call", "threads");
+   for( unsigned z=0; z < HP_N_ZONE; z++ ) {
+      unsigned long long zone_ticks = 0, calls = 0;
+      unsigned n_thread = 0;
+      for( unsigned i=0; i < g_host_prof_threads.size(); i++ ) {
+         zone_ticks += g_host_prof_threads[i]->ticks[z];
+         calls += g_host_prof_threads[i]->calls[z];
+         if( g_host_prof_threads[i]->calls[z] )
+            n_thread++;
+      }
+      if( !calls )
+         continue;
+      double ns = zone_ticks * ns_per_tick;
+      printf("%-16s %14llu %12.3f %8.2f %10.1f %8u\n", zone_name[z], calls, ns / 1e9,
+             wall? 100 * ns / wall : 0.0, ns / calls, n_thread);
+   }
+   printf("----------------------------END-of-Host-time-profile----------------------------\n");
+   if( g_host_prof_config.trace_enabled() )
+      write_trace(ns_per_tick);
+   pthread_mutex_unlock(&g_host_prof_mutex);
+   fflush(stdout);
+}
+
+void host_prof_init( const host_prof_config &config )
+{
+   if( g_host_prof_started )
+      return;
+   g_host_prof_started = true;
+   g_host_prof_config = config;
+   g_host_prof_start_ns = wall_ns();
+   g_host_prof_start_ticks = host_prof_ticks();
+   atexit(host_prof_report);
+}
+
+#else
+
+void host_prof_init( const host_prof_config &config )
+{
+   if( config.trace_enabled() )
+      printf("GPGPU-Sim uArch: WARNING ** -gpgpu_host_prof_trace ignored, rebuild with HOST_PROF=1\n");
+}
+
+#endif
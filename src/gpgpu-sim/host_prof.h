@@ -0,0 +1,118 @@
+#ifndef HOST_PROF_H
+#define HOST_PROF_H
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "../option_parser.h"
+
+//--------------------------------------------------------------------
+// Host time profile of the timing model
+//
+// Built in with HOST_PROF=1 (-DHOST_PROF_ON=1); otherwise HOST_PROF_SCOPE
+// expands to nothing. Each HOST_PROF_SCOPE(zone) reads the time stamp
+// counter on entry and exit and adds the difference to its zone in a
+// buffer owned by the calling thread, so worker threads of
+// -gpgpu_sim_threads never share a counter. Zones nest (compress runs
+// inside link), the time of a zone includes the zones inside it.
+// At exit a table of calls, seconds and share of the wall time since the
+// GPU was created is printed per zone. With -gpgpu_host_prof_trace every
+// scope is also kept as an event (up to -gpgpu_host_prof_trace_max per
+// thread) and written as Chrome trace-event JSON (chrome://tracing,
+// ui.perfetto.dev).
+//--------------------------------------------------------------------
+enum host_prof_zone {
+   HP_EVENT_SKIP = 0,   // skip_idle_edges()
+   HP_CORE_ICNT,        // cores pop replies from the icnt
+   HP_MEM_ICNT,         // sub partitions push replies into the icnt
+   HP_LINK,             // memory link up / down steps
+   HP_DRAM,
+   HP_L2,
+   HP_ICNT,             // icnt_transfer()
+   HP_CORE,             // core pipelines (all clusters)
+   HP_CLUSTER,          // one cluster, on the thread that steps it
+   HP_CORE_STATS,       // per-cycle core stats gathering
+   HP_POWER,
+   HP_ISSUE,            // issue_block2core()
+   HP_PERIODIC,         // cache flushes, liveness, visualizer, deadlock check
+   HP_COMPRESS,         // g_comp->compress
+   HP_N_ZONE
+};
+
+struct host_prof_config {
+   void reg_options( option_parser_t opp );
+
+   bool trace_enabled() const { return m_trace_file && strcmp(m_trace_file,"none"); }
+
+   char *m_trace_file;
+   unsigned m_trace_max;    // events kept per thread
+};
+
+// starts the wall clock and registers the exit report
+void host_prof_init( const host_prof_config &config );
+
+#if HOST_PROF_ON
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline unsigned long long host_prof_ticks() { return __rdtsc(); }
+#else
+#include <time.h>
+static inline unsigned long long host_prof_ticks()
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+#endif
+
+struct host_prof_event {
+   unsigned zone;
+   unsigned long long start;
+   unsigned long long end;
+};
+
+struct host_prof_thread {
+   unsigned id;
+   unsigned long long ticks[HP_N_ZONE];
+   unsigned long long calls[HP_N_ZONE];
+   std::vector<host_prof_event> events;
+   size_t max_events;
+};
+
+extern __thread host_prof_thread *g_host_prof_thread;
+host_prof_thread *host_prof_thread_create();
+
+static inline void host_prof_add( host_prof_zone zone, unsigned long long start, unsigned long long end )
+{
+   host_prof_thread *t = g_host_prof_thread;
+   if( t == NULL )
+      t = host_prof_thread_create();
+   t->ticks[zone] += end - start;
+   t->calls[zone]++;
+   if( t->events.size() < t->max_events ) {
+      host_prof_event e = { (unsigned)zone, start, end };
+      t->events.push_back(e);
+   }
+}
+
+class host_prof_scope {
+public:
+   host_prof_scope( host_prof_zone zone ) : m_zone(zone), m_start(host_prof_ticks()) {}
+   ~host_prof_scope() { host_prof_add(m_zone, m_start, host_prof_ticks()); }
+private:
+   host_prof_zone m_zone;
+   unsigned long long m_start;
+};
+
+#define HOST_PROF_NAME2(line) host_prof_scope_##line
+#define HOST_PROF_NAME(line) HOST_PROF_NAME2(line)
+#define HOST_PROF_SCOPE(zone) host_prof_scope HOST_PROF_NAME(__LINE__)(zone)
+
+#else
+
+#define HOST_PROF_SCOPE(zone) do {} while (0)
+
+#endif
+
+#endif
@@ -39,6 +39,8 @@ typedef void (*icnt_push_p)(unsigned input, unsigned output, void* data, unsigne
 typedef void* (*icnt_pop_p)(unsigned output);
 typedef void (*icnt_transfer_p)( );
 typedef bool (*icnt_busy_p)( );
+typedef bool (*icnt_idle_p)( );
+typedef void (*icnt_skip_p)( unsigned long long cycles );
 typedef void (*icnt_drain_p)( );
 typedef void (*icnt_display_stats_p)( );
 typedef void (*icnt_display_overall_stats_p)( );
@@ -52,6 +54,8 @@ extern icnt_push_p       icnt_push;
 extern icnt_pop_p        icnt_pop;
 extern icnt_transfer_p   icnt_transfer;
 extern icnt_busy_p       icnt_busy;
+extern icnt_idle_p       icnt_idle;
+extern icnt_skip_p       icnt_skip;
 extern icnt_drain_p      icnt_drain;
 extern icnt_display_stats_p icnt_display_stats;
 extern icnt_display_overall_stats_p icnt_display_overall_stats;
@@ -61,6 +65,7 @@ extern int g_network_mode;
 
 enum network_mode {
    INTERSIM = 1,
+   LOCAL_XBAR = 2,
    N_NETWORK_MODE
 };
 
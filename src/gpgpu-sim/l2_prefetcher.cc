@@ -0,0 +1,260 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "l2_prefetcher.h"
+#include "addrdec.h"
+#include "gpu-sim.h"
+#include "mydelayqueue.h"
+
+void l2_prefetch_config::reg_options( option_parser_t opp )
+{
+    option_parser_register(opp, "-gpgpu_l2_prefetcher", OPT_CSTR, &m_type_string,
+                "L2 prefetcher (none, next_line, stride, spatial)",
+                "none");
+    option_parser_register(opp, "-gpgpu_l2_prefetch_degree", OPT_UINT32, &m_max_degree,
+                "maximum L2 prefetch degree (the throttle moves between 0 and this)",
+                "4");
+    option_parser_register(opp, "-gpgpu_l2_prefetch_queue", OPT_UINT32, &m_queue_size,
+                "prefetch candidates queued per L2 bank (oldest dropped when full)",
+                "16");
+    option_parser_register(opp, "-gpgpu_l2_prefetch_epoch", OPT_UINT32, &m_epoch,
+                "core cycles between L2 prefetch throttling decisions",
+                "2048");
+    option_parser_register(opp, "-gpgpu_l2_prefetch_link_high", OPT_FLOAT, &m_link_high,
+                "memory link utilization above which the L2 prefetch degree is lowered",
+                "0.8");
+}
+
+void l2_prefetch_config::init()
+{
+    if( !strcmp(m_type_string,"none") )
+        m_type = L2_PREFETCH_NONE;
+    else if( !strcmp(m_type_string,"next_line") )
+        m_type = L2_PREFETCH_NEXT_LINE;
+    else if( !strcmp(m_type_string,"stride") )
+        m_type = L2_PREFETCH_STRIDE;
+    else if( !strcmp(m_type_string,"spatial") )
+        m_type = L2_PREFETCH_SPATIAL;
+    else {
+        printf("GPGPU-Sim uArch: ERROR ** unknown L2 prefetcher '%s'\n", m_type_string);
+        exit(1);
+    }
+    if( m_queue_size == 0 )
+        m_queue_size = 1;
+    if( m_epoch == 0 )
+        m_epoch = 1;
+}
+
+l2_prefetcher *l2_prefetcher::create( const l2_prefetch_config &config, unsigned line_sz, unsigned sub_partition_id,
+                                      const linear_to_raw_address_translation *address_mapping, memory_link *link )
+{
+    switch( config.m_type ) {
+    case L2_PREFETCH_NONE: return NULL;
+    case L2_PREFETCH_NEXT_LINE: return new next_line_prefetcher(config, line_sz, sub_partition_id, address_mapping, link);
+    case L2_PREFETCH_STRIDE: return new stride_prefetcher(config, line_sz, sub_partition_id, address_mapping, link);
+    case L2_PREFETCH_SPATIAL: return new spatial_prefetcher(config, line_sz, sub_partition_id, address_mapping, link);
+    default: abort();
+    }
+}
+
+l2_prefetcher::l2_prefetcher( const l2_prefetch_config &config, unsigned line_sz, unsigned sub_partition_id,
+                              const linear_to_raw_address_translation *address_mapping, memory_link *link )
+    : m_config(config)
+{
+    m_line_sz = line_sz;
+    m_degree = (config.m_max_degree > 1)? config.m_max_degree/2 : config.m_max_degree;
+    m_sub_partition_id = sub_partition_id;
+    m_address_mapping = address_mapping;
+    m_link = link;
+    m_epoch_end = config.m_epoch;
+    m_epoch_issued = 0;
+    m_epoch_useful = 0;
+    m_link_transfer = 0;
+    m_link_total = 0;
+    m_n_demand_miss = 0;
+    m_n_issued = 0;
+    m_n_useful = 0;
+    m_n_late = 0;
+    m_n_throttle_up = 0;
+    m_n_throttle_down = 0;
+}
+
+void l2_prefetcher::demand_access( new_addr_type block_addr, address_type pc, bool miss, unsigned time )
+{
+    if( time >= m_epoch_end )
+        throttle(time);
+    if( miss )
+        m_n_demand_miss++;
+    observe(block_addr, pc, miss);
+}
+
+void l2_prefetcher::useful( bool late )
+{
+    m_n_useful++;
+    m_epoch_useful++;
+    if( late )
+        m_n_late++;
+}
+
+new_addr_type l2_prefetcher::pop_candidate()
+{
+    new_addr_type block_addr = m_queue.front();
+    m_queue.pop_front();
+    return block_addr;
+}
+
+bool l2_prefetcher::candidate( new_addr_type block_addr )
+{
+    addrdec_t tlx;
+    m_address_mapping->addrdec_tlx(block_addr, &tlx);
+    if( tlx.sub_partition != m_sub_partition_id )
+        return false;
+    for( unsigned i=0; i < m_queue.size(); i++ )
+        if( m_queue[i] == block_addr )
+            return true;
+    if( m_queue.size() >= m_config.m_queue_size )
+        m_queue.pop_front();
+    m_queue.push_back(block_addr);
+    return true;
+}
+
+void l2_prefetcher::throttle( unsigned time )
+{
+    unsigned long long transfer = 0, total = 0;
+    if( m_link )
+        m_link->get_flit_cnt_snapshot(transfer, total);
+    float link_util = (total > m_link_total)? (float)(transfer - m_link_transfer) / (total - m_link_total) : 0.0f;
+    m_link_transfer = transfer;
+    m_link_total = total;
+
+    // too few prefetches to judge their accuracy: only the link decides
+    bool measured = m_epoch_issued >= 8;
+    float accuracy = measured? (float)m_epoch_useful / m_epoch_issued : 1.0f;
+    if( link_util > m_config.m_link_high ) {
+        if( m_degree > 0 ) { m_degree--; m_n_throttle_down++; }
+    } else if( measured && accuracy < 0.4f ) {
+        // keep prefetching a little, otherwise the accuracy cannot recover
+        if( m_degree > 1 ) { m_degree--; m_n_throttle_down++; }
+    } else if( accuracy > 0.75f && link_util < m_config.m_link_high / 2 ) {
+        if( m_degree < m_config.m_max_degree ) { m_degree++; m_n_throttle_up++; }
+    }
+    m_epoch_issued = 0;
+    m_epoch_useful = 0;
+    m_epoch_end = time + m_config.m_epoch;
+}
+
+void l2_prefetcher::print( FILE *fp ) const
+{
+    unsigned long long n_bytes = (unsigned long long)m_n_issued * m_line_sz;
+    fprintf(fp, "\t\tPrefetch (%s): issued = %u, useful = %u (late %u), accuracy = %.3g, coverage = %.3g, bytes = %llu, degree = %u (up %u, down %u)\n",
+            name(), m_n_issued, m_n_useful, m_n_late,
+            m_n_issued? (float)m_n_useful / m_n_issued : 0.0f,
+            (m_n_useful + m_n_demand_miss)? (float)m_n_useful / (m_n_useful + m_n_demand_miss) : 0.0f,
+            n_bytes, m_degree, m_n_throttle_up, m_n_throttle_down);
+}
+
+void next_line_prefetcher::observe( new_addr_type block_addr, address_type pc, bool miss )
+{
+    if( !miss )
+        return;
+    // the next lines of this sub partition lie within a few interleaving chunks
+    unsigned found = 0;
+    for( unsigned k=1; k <= 32 && found < m_degree; k++ ) {
+        if( candidate(block_addr + (new_addr_type)k * m_line_sz) )
+            found++;
+    }
+}
+
+stride_prefetcher::stride_prefetcher( const l2_prefetch_config &config, unsigned line_sz, unsigned sub_partition_id,
+                                      const linear_to_raw_address_translation *address_mapping, memory_link *link )
+    : l2_prefetcher(config, line_sz, sub_partition_id, address_mapping, link)
+{
+    entry_t empty = { 0, 0, 0, 0, false };
+    m_table.assign(N_ENTRY, empty);
+}
+
+void stride_prefetcher::observe( new_addr_type block_addr, address_type pc, bool miss )
+{
+    entry_t &e = m_table[(pc >> 3) % N_ENTRY];
+    if( !e.valid || e.pc != pc ) {
+        e.valid = true;
+        e.pc = pc;
+        e.last_addr = block_addr;
+        e.stride = 0;
+        e.confidence = 0;
+        return;
+    }
+    long long stride = (long long)block_addr - (long long)e.last_addr;
+    if( stride == 0 )
+        return;
+    if( stride == e.stride ) {
+        if( e.confidence < 3 )
+            e.confidence++;
+    } else {
+        if( e.confidence > 0 )
+            e.confidence--;
+        if( e.confidence == 0 )
+            e.stride = stride;
+    }
+    e.last_addr = block_addr;
+    if( e.confidence >= 2 ) {
+        for( unsigned k=1; k <= m_degree; k++ )
+            candidate(block_addr + e.stride * (long long)k);
+    }
+}
+
+spatial_prefetcher::spatial_prefetcher( const l2_prefetch_config &config, unsigned line_sz, unsigned sub_partition_id,
+                                        const linear_to_raw_address_translation *address_mapping, memory_link *link )
+    : l2_prefetcher(config, line_sz, sub_partition_id, address_mapping, link)
+{
+    m_lines_per_region = REGION_SIZE / line_sz;
+    assert( m_lines_per_region > 0 && m_lines_per_region <= 32 );
+    generation_t empty_gen = { 0, 0, 0, 0, false };
+    m_active.assign(N_ACTIVE, empty_gen);
+    pattern_t empty_pattern = { 0, false };
+    m_patterns.assign(N_PATTERN, empty_pattern);
+    m_n_access = 0;
+}
+
+void spatial_prefetcher::observe( new_addr_type block_addr, address_type pc, bool miss )
+{
+    m_n_access++;
+    new_addr_type region = block_addr / REGION_SIZE;
+    unsigned offset = (block_addr % REGION_SIZE) / m_line_sz;
+
+    unsigned lru = 0;
+    for( unsigned i=0; i < N_ACTIVE; i++ ) {
+        generation_t &g = m_active[i];
+        if( g.valid && g.region == region ) {
+            g.footprint |= 1u << offset;
+            g.last_use = m_n_access;
+            return;
+        }
+        if( !g.valid || (m_active[lru].valid && g.last_use < m_active[lru].last_use) )
+            lru = i;
+    }
+
+    // the oldest generation ends and its footprint is learned
+    generation_t &g = m_active[lru];
+    if( g.valid ) {
+        m_patterns[g.key].footprint = g.footprint;
+        m_patterns[g.key].valid = true;
+    }
+    g.valid = true;
+    g.region = region;
+    g.key = ((pc >> 3) * 31 + offset) % N_PATTERN;
+    g.footprint = 1u << offset;
+    g.last_use = m_n_access;
+
+    const pattern_t &p = m_patterns[g.key];
+    if( !p.valid )
+        return;
+    unsigned found = 0;
+    for( unsigned l=0; l < m_lines_per_region && found < 4 * m_degree; l++ ) {
+        if( l != offset && (p.footprint & (1u << l)) ) {
+            if( candidate((region * REGION_SIZE) + l * m_line_sz) )
+                found++;
+        }
+    }
+}
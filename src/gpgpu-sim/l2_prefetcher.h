@@ -0,0 +1,163 @@
+#ifndef L2_PREFETCHER_H
+#define L2_PREFETCHER_H
+
+#include <stdio.h>
+#include <deque>
+#include <vector>
+#include "../option_parser.h"
+#include "../abstract_hardware_model.h"
+
+//--------------------------------------------------------------------
+// L2 prefetching
+//
+// A prefetcher is attached to each l2_cache. It is trained by the demand
+// accesses of the bank and queues candidate block addresses; the L2 turns
+// a candidate into an L2_PREFETCH_R read miss (MSHR, miss queue, DRAM)
+// whenever its tag port is not used by a demand access. Only blocks that
+// map to the same sub partition are prefetched.
+//
+// The degree is throttled every epoch from the accuracy of the prefetches
+// issued in it and from the utilization of the memory link of the
+// partition, so prefetches back off when they are wrong or when the link
+// is the bottleneck.
+//--------------------------------------------------------------------
+enum l2_prefetcher_type {
+    L2_PREFETCH_NONE = 0,
+    L2_PREFETCH_NEXT_LINE,
+    L2_PREFETCH_STRIDE,
+    L2_PREFETCH_SPATIAL
+};
+
+struct l2_prefetch_config {
+    void reg_options( option_parser_t opp );
+    void init();
+
+    bool enabled() const { return m_type != L2_PREFETCH_NONE; }
+
+    char *m_type_string;
+    enum l2_prefetcher_type m_type;
+    unsigned m_max_degree;
+    unsigned m_queue_size;
+    unsigned m_epoch;           // throttling interval in core cycles
+    float m_link_high;          // link utilization at which the degree drops
+};
+
+class l2_prefetcher {
+public:
+    static l2_prefetcher *create( const l2_prefetch_config &config, unsigned line_sz, unsigned sub_partition_id,
+                                  const class linear_to_raw_address_translation *address_mapping, class memory_link *link );
+    virtual ~l2_prefetcher() {}
+
+    // demand access of the L2 bank (writebacks excluded)
+    void demand_access( new_addr_type block_addr, address_type pc, bool miss, unsigned time );
+    // demand hit on a prefetched line (late: the prefetch was still in flight)
+    void useful( bool late );
+
+    bool has_candidate() const { return !m_queue.empty(); }
+    new_addr_type pop_candidate();
+    void issued() { m_n_issued++; m_epoch_issued++; }
+
+    void print( FILE *fp ) const;
+
+protected:
+    l2_prefetcher( const l2_prefetch_config &config, unsigned line_sz, unsigned sub_partition_id,
+                   const class linear_to_raw_address_translation *address_mapping, class memory_link *link );
+
+    virtual const char *name() const = 0;
+    virtual void observe( new_addr_type block_addr, address_type pc, bool miss ) = 0;
+
+    // queue block_addr if it belongs to this sub partition
+    bool candidate( new_addr_type block_addr );
+
+    const l2_prefetch_config &m_config;
+    unsigned m_line_sz;
+    unsigned m_degree;
+
+private:
+    void throttle( unsigned time );
+
+    unsigned m_sub_partition_id;
+    const class linear_to_raw_address_translation *m_address_mapping;
+    class memory_link *m_link;
+    std::deque<new_addr_type> m_queue;
+
+    // throttling
+    unsigned long long m_epoch_end;
+    unsigned m_epoch_issued;
+    unsigned m_epoch_useful;
+    unsigned long long m_link_transfer;
+    unsigned long long m_link_total;
+
+    // stats
+    unsigned m_n_demand_miss;
+    unsigned m_n_issued;
+    unsigned m_n_useful;
+    unsigned m_n_late;
+    unsigned m_n_throttle_up;
+    unsigned m_n_throttle_down;
+};
+
+// on a miss, the next lines (of this sub partition)
+class next_line_prefetcher : public l2_prefetcher {
+public:
+    next_line_prefetcher( const l2_prefetch_config &config, unsigned line_sz, unsigned sub_partition_id,
+                          const class linear_to_raw_address_translation *address_mapping, class memory_link *link )
+        : l2_prefetcher(config, line_sz, sub_partition_id, address_mapping, link) {}
+protected:
+    const char *name() const { return "next_line"; }
+    void observe( new_addr_type block_addr, address_type pc, bool miss );
+};
+
+// per-PC stride detection; a stream is a stride of the interleaving
+// distance between blocks of this sub partition
+class stride_prefetcher : public l2_prefetcher {
+public:
+    stride_prefetcher( const l2_prefetch_config &config, unsigned line_sz, unsigned sub_partition_id,
+                       const class linear_to_raw_address_translation *address_mapping, class memory_link *link );
+protected:
+    const char *name() const { return "stride"; }
+    void observe( new_addr_type block_addr, address_type pc, bool miss );
+private:
+    struct entry_t {
+        address_type pc;
+        new_addr_type last_addr;
+        long long stride;
+        unsigned confidence;
+        bool valid;
+    };
+    static const unsigned N_ENTRY = 64;
+    std::vector<entry_t> m_table;
+};
+
+// Spatial footprints: the lines touched in a region during one
+// generation are recorded under the PC and offset of the access that
+// started it, and prefetched when the same PC and offset start a new one.
+class spatial_prefetcher : public l2_prefetcher {
+public:
+    spatial_prefetcher( const l2_prefetch_config &config, unsigned line_sz, unsigned sub_partition_id,
+                        const class linear_to_raw_address_translation *address_mapping, class memory_link *link );
+protected:
+    const char *name() const { return "spatial"; }
+    void observe( new_addr_type block_addr, address_type pc, bool miss );
+private:
+    static const unsigned REGION_SIZE = 2048;
+    static const unsigned N_ACTIVE = 32;
+    static const unsigned N_PATTERN = 1024;
+    struct generation_t {
+        new_addr_type region;
+        unsigned key;
+        unsigned footprint;
+        unsigned long long last_use;
+        bool valid;
+    };
+    struct pattern_t {
+        unsigned footprint;
+        bool valid;
+    };
+    unsigned m_lines_per_region;
+    std::vector<generation_t> m_active;
+    std::vector<pattern_t> m_patterns;
+    unsigned long long m_n_access;
+};
+
+#endif
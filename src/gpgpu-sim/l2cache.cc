@@ -35,6 +35,7 @@
 #include "../option_parser.h"
 #include "mem_fetch.h"
 #include "dram.h"
+#include "stacked_dram.h"
 #include "gpu-cache.h"
 #include "histogram.h"
 #include "l2cache.h"
@@ -44,15 +45,16 @@
 #include "shader.h"
 #include "mem_latency_stat.h"
 #include "l2cache_trace.h"
+#include "parallel.h"
+#include "l2_prefetcher.h"
 
 
 mem_fetch * partition_mf_allocator::alloc(new_addr_type addr, mem_access_type type, unsigned size, bool wr ) const 
 {
-    assert( wr );
     mem_access_t access( type, addr, size, wr );
     mem_fetch *mf = new mem_fetch( access, 
                                    NULL,
-                                   WRITE_PACKET_SIZE, 
+                                   wr? WRITE_PACKET_SIZE : READ_PACKET_SIZE, 
                                    -1, 
                                    -1, 
                                    -1,
@@ -66,7 +68,10 @@ memory_partition_unit::memory_partition_unit( unsigned partition_id,
                                               class memory_stats_t *stats )
 : m_id(partition_id), m_link(link), m_config(config), m_stats(stats), m_arbitration_metadata(config) 
 {
-    m_dram = new dram_t(m_id,m_config,m_stats,this);
+    if( m_config->m_stacked_dram_config.enabled() )
+        m_dram = new stacked_dram_t(m_id,m_config,m_stats,this);
+    else
+        m_dram = new dram_t(m_id,m_config,m_stats,this);
 
     m_sub_partition = new memory_sub_partition*[m_config->m_n_sub_partition_per_memory_channel]; 
     for (unsigned p = 0; p < m_config->m_n_sub_partition_per_memory_channel; p++) {
@@ -253,6 +258,20 @@ void memory_partition_unit::dram_cycle()
     }
 }
 
+bool memory_partition_unit::quiescent( unsigned long long &next_cycle ) const
+{
+    if( !m_dram->idle() ) 
+        return false;
+    if( !m_dram_latency_queue.empty() && m_dram_latency_queue.front().ready_cycle < next_cycle ) 
+        next_cycle = m_dram_latency_queue.front().ready_cycle;
+    return true;
+}
+
+void memory_partition_unit::skip_cycles( unsigned long long n )
+{
+    m_dram->skip_cycles(n);
+}
+
 void memory_partition_unit::set_done( mem_fetch *mf )
 {
     unsigned global_spid = mf->get_sub_partition_id(); 
@@ -277,6 +296,11 @@ void memory_partition_unit::set_dram_power_stats(unsigned &n_cmd,
     m_dram->set_dram_power_stats(n_cmd, n_activity, n_nop, n_act, n_pre, n_rd, n_wr, n_req);
 }
 
+void memory_partition_unit::reg_stats( stat_registry &r ) const
+{
+   m_dram->reg_stats(r);
+}
+
 void memory_partition_unit::print( FILE *fp ) const
 {
     fprintf(fp, "Memory Partition %u: \n", m_id); 
@@ -313,8 +337,11 @@ memory_sub_partition::memory_sub_partition( unsigned sub_partition_id,
     m_L2interface = new L2interface(this);
     m_mf_allocator = new partition_mf_allocator(config);
 
-    if(!m_config->m_L2_config.disabled())
+    if(!m_config->m_L2_config.disabled()) {
        m_L2cache = new l2_cache(L2c_name,m_config->m_L2_config,-1,-1,m_L2interface,m_mf_allocator,IN_PARTITION_L2_MISS_QUEUE);
+       m_L2cache->set_prefetcher(l2_prefetcher::create(m_config->m_L2_prefetch_config, m_config->m_L2_config.get_line_sz(),
+                                                       m_id, &m_config->m_address_mapping, m_link));
+    }
 
     unsigned int icnt_L2;
     unsigned int L2_dram;
@@ -344,7 +371,7 @@ void memory_sub_partition::cache_cycle( unsigned cycle )
     if( !m_config->m_L2_config.disabled()) {
        if ( m_L2cache->access_ready() && !m_L2_icnt_queue->full() ) {
            mem_fetch *mf = m_L2cache->next_access();
-           if(mf->get_access_type() != L2_WR_ALLOC_R){ // Don't pass write allocate read request back to upper level cache
+           if(mf->get_access_type() != L2_WR_ALLOC_R && mf->get_access_type() != L2_PREFETCH_R){ // Don't pass write allocate read or prefetch request back to upper level cache
 				mf->set_reply();
 				mf->set_status(IN_PARTITION_L2_TO_ICNT_QUEUE,gpu_sim_cycle+gpu_tot_sim_cycle);
 				m_L2_icnt_queue->push(mf);
@@ -389,6 +416,7 @@ void memory_sub_partition::cache_cycle( unsigned cycle )
             if ( !output_full && port_free ) {
                 std::list<cache_event> events;
                 enum cache_request_status status = m_L2cache->access(mf->get_addr(),mf,gpu_sim_cycle+gpu_tot_sim_cycle,events);
+                mf_trace(MFT_L2, gpu_sim_cycle+gpu_tot_sim_cycle, mf->get_request_uid(), mf->get_sub_partition_id(), status);
                 bool write_sent = was_write_sent(events);
                 bool read_sent = was_read_sent(events);
 
@@ -426,6 +454,11 @@ void memory_sub_partition::cache_cycle( unsigned cycle )
         }
     }
 
+    // prefetches use the L2 port when no demand access did
+    if ( !m_config->m_L2_config.disabled() && m_L2cache->prefetch_pending() 
+         && m_L2cache->data_port_free() && !L2_dram_queue_full() ) 
+        m_L2cache->issue_prefetch(gpu_sim_cycle+gpu_tot_sim_cycle);
+
     // ROP delay queue
     if( !m_rop.empty() && (cycle >= m_rop.front().ready_cycle) && !m_icnt_L2_queue->full() ) {
         mem_fetch* mf = m_rop.front().req;
@@ -435,6 +468,25 @@ void memory_sub_partition::cache_cycle( unsigned cycle )
     }
 }
 
+bool memory_sub_partition::quiescent( unsigned long long &next_cycle ) const
+{
+    if( !m_icnt_L2_queue->empty() || !m_L2_icnt_queue->empty() ) 
+        return false;
+    if( !L2_dram_queue_empty() || !dram_L2_queue_empty() ) 
+        return false;
+    if( !m_config->m_L2_config.disabled() && (!m_L2cache->idle() || m_L2cache->prefetch_pending()) ) 
+        return false;
+    if( !m_rop.empty() && m_rop.front().ready_cycle < next_cycle ) 
+        next_cycle = m_rop.front().ready_cycle;
+    return true;
+}
+
+void memory_sub_partition::skip_cycles( unsigned long long n )
+{
+    if( !m_config->m_L2_config.disabled() ) 
+        m_L2cache->idle_cycle(n);
+}
+
 bool memory_sub_partition::full() const
 {
     return m_icnt_L2_queue->full();
@@ -465,9 +517,11 @@ void memory_sub_partition::L2_dram_queue_pop()
 {
 #ifdef BPSC
    mem_fetch *mf = m_link->dnlink_top(m_id);
+   sim_thread_pool::lock();
    auto it = L2_dram_set.find(mf);
    assert(it != L2_dram_set.end());
    L2_dram_set.erase(it);
+   sim_thread_pool::unlock();
    m_link->dnlink_pop(m_id);
 #else
    m_L2_dram_queue->pop(); 
@@ -486,7 +540,9 @@ bool memory_sub_partition::L2_dram_queue_full()
 void memory_sub_partition::L2_dram_queue_push(mem_fetch *mf)
 {
 #ifdef BPSC
+    sim_thread_pool::lock();
     L2_dram_set.insert(mf);
+    sim_thread_pool::unlock();
     m_link->dnlink_push(m_id, mf);
 #else
     m_L2_dram_queue->push(mf);
@@ -516,9 +572,11 @@ void memory_sub_partition::dram_L2_queue_pop()
 {
 #ifdef BPSC
     mem_fetch *mf = m_link->uplink_top(m_id);
+    sim_thread_pool::lock();
     auto it = dram_L2_set.find(mf);
     assert(it != dram_L2_set.end());
     dram_L2_set.erase(it);
+    sim_thread_pool::unlock();
     return m_link->uplink_pop(m_id);
 #else
     m_dram_L2_queue->pop();
@@ -537,7 +595,9 @@ bool memory_sub_partition::dram_L2_queue_full() const
 void memory_sub_partition::dram_L2_queue_push( class mem_fetch* mf )
 {
 #ifdef BPSC
+    sim_thread_pool::lock();
     dram_L2_set.insert(mf);
+    sim_thread_pool::unlock();
     m_link->uplink_push(m_id, mf);
 #else
     m_dram_L2_queue->push(mf); 
@@ -614,6 +674,43 @@ void gpgpu_sim::print_dram_stats(FILE *fout) const
     fprintf(fout,"gpgpu_n_dram_requests = %d\n",tot_req );
 }
 
+void memory_sub_partition::warm( new_addr_type addr, bool is_write, unsigned time )
+{
+    if( m_config->m_L2_config.disabled() ) 
+        return;
+    bool wb = false;
+    cache_block_t evicted;
+    enum cache_request_status status = m_L2cache->warm(addr,time,is_write,wb,evicted);
+    // write misses allocate without fetching; only read misses and dirty evictions cross the link
+    if( !is_write && status == MISS ) 
+        warm_link(m_config->m_L2_config.block_addr(addr),false);
+    if( wb ) 
+        warm_link(evicted.m_block_addr,true);
+}
+
+void memory_sub_partition::warm_link( new_addr_type block_addr, bool is_write )
+{
+    // the compressed links only compress 128B blocks (see compressed_dn_link)
+    if( m_config->compress_link == 0 || m_config->m_L2_config.get_line_sz() != 128 ) 
+        return;
+    unsigned char buffer[128];
+    g_the_gpu->get_global_memory()->read(block_addr, 128, buffer);
+    g_comp->warm(mem_fetch::vstream_id(is_write), buffer, block_addr, 128);
+}
+
+void memory_sub_partition::save( FILE *fout ) const
+{
+    if( !m_config->m_L2_config.disabled() ) 
+        m_L2cache->save(fout);
+}
+
+bool memory_sub_partition::load( FILE *fin )
+{
+    if( m_config->m_L2_config.disabled() ) 
+        return true;
+    return m_L2cache->load(fin);
+}
+
 unsigned memory_sub_partition::flushL2() 
 { 
     if (!m_config->m_L2_config.disabled()) {
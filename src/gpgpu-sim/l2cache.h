@@ -69,10 +69,16 @@ public:
    void cache_cycle( unsigned cycle );
    void dram_cycle();
 
+   // event skipping: the DRAM is idle and dram_cycle() cannot change state
+   // before next_cycle (lowered to the DRAM latency queue head)
+   bool quiescent( unsigned long long &next_cycle ) const;
+   void skip_cycles( unsigned long long n );
+
    void set_done( mem_fetch *mf );
 
    void visualizer_print( gzFile visualizer_file ) const;
    void print_stat( FILE *fp ) { m_dram->print_stat(fp); }
+   void reg_stats( class stat_registry &r ) const;
    void visualize() const { m_dram->visualize(); }
    void print( FILE *fp ) const;
 
@@ -156,6 +162,10 @@ public:
    bool busy() const;
 
    void cache_cycle( unsigned cycle );
+   // all queues and the L2 are empty: cache_cycle() cannot change state
+   // before next_cycle (lowered to the ROP queue head)
+   bool quiescent( unsigned long long &next_cycle ) const;
+   void skip_cycles( unsigned long long n );
 
    bool full() const;
    void push( class mem_fetch* mf, unsigned long long clock_cycle );
@@ -165,6 +175,12 @@ public:
 
    unsigned flushL2();
 
+   // functional warm-up of the L2 tags and of the link compressor history
+   void warm( new_addr_type addr, bool is_write, unsigned time );
+   // checkpoint of the L2 tags (the sub-partition queues must be empty)
+   void save( FILE *fout ) const;
+   bool load( FILE *fin );
+
    // interface to L2_dram_queue
    bool L2_dram_queue_empty() const; 
    class mem_fetch* L2_dram_queue_top() const; 
@@ -217,6 +233,8 @@ private:
 
    std::set<mem_fetch*> m_request_tracker;
 
+   void warm_link( new_addr_type block_addr, bool is_write );
+
    friend class L2interface;
 };
 
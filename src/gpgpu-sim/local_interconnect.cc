@@ -0,0 +1,222 @@
+#include "local_interconnect.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+void local_icnt_config::reg_options( option_parser_t opp )
+{
+   option_parser_register(opp, "-icnt_xbar_latency", OPT_UINT32, &m_latency,
+                          "network_mode 2: crossbar pipeline latency in interconnect cycles",
+                          "4");
+   option_parser_register(opp, "-icnt_xbar_flit_size", OPT_UINT32, &m_flit_size,
+                          "network_mode 2: bytes a port moves per interconnect cycle",
+                          "32");
+   option_parser_register(opp, "-icnt_xbar_in_buffer", OPT_UINT32, &m_in_buffer,
+                          "network_mode 2: input buffer per node in flits",
+                          "64");
+   option_parser_register(opp, "-icnt_xbar_out_buffer", OPT_UINT32, &m_out_buffer,
+                          "network_mode 2: output buffer per node in flits",
+                          "64");
+}
+
+local_interconnect::local_interconnect( const local_icnt_config &config )
+   : m_config(config)
+{
+   m_n_shader = 0;
+   m_n_node = 0;
+   m_cycle = 0;
+   m_kernel_start = 0;
+}
+
+void local_interconnect::create( unsigned n_shader, unsigned n_mem )
+{
+   if ( m_config.m_flit_size == 0 || m_config.m_latency == 0 ) {
+      printf("GPGPU-Sim uArch: ERROR ** -icnt_xbar_flit_size and -icnt_xbar_latency must be positive\n");
+      abort();
+   }
+   m_n_shader = n_shader;
+   m_n_node = n_shader + n_mem;
+   for ( unsigned i=0; i < 2; i++ ) {
+      subnet &s = m_subnet[i];
+      s.in.assign(m_n_node, std::deque<packet>());
+      s.in_flits.assign(m_n_node, 0);
+      s.in_free.assign(m_n_node, 0);
+      s.out.assign(m_n_node, std::deque<packet>());
+      s.out_flits.assign(m_n_node, 0);
+      s.out_free.assign(m_n_node, 0);
+      s.rr = 0;
+      s.n_in = 0;
+      s.n_out = 0;
+      memset(&s.kernel, 0, sizeof(stats));
+      memset(&s.total, 0, sizeof(stats));
+   }
+   printf("GPGPU-Sim uArch: local crossbar interconnect, %u shader and %u memory nodes, %u bytes/cycle per port, latency %u\n",
+          n_shader, n_mem, m_config.m_flit_size, m_config.m_latency);
+}
+
+void local_interconnect::init()
+{
+   for ( unsigned i=0; i < 2; i++ ) {
+      stats &k = m_subnet[i].kernel;
+      stats &t = m_subnet[i].total;
+      t.packets += k.packets;
+      t.flits += k.flits;
+      t.latency += k.latency;
+      t.in_stall += k.in_stall;
+      if ( k.max_latency > t.max_latency )
+         t.max_latency = k.max_latency;
+      memset(&k, 0, sizeof(stats));
+   }
+   m_kernel_start = m_cycle;
+}
+
+bool local_interconnect::has_buffer( unsigned input, unsigned size ) const
+{
+   const subnet &s = m_subnet[push_subnet(input)];
+   return s.in_flits[input] + n_flits(size) <= m_config.m_in_buffer;
+}
+
+void local_interconnect::push( unsigned input, unsigned output, void *data, unsigned size )
+{
+   assert( input < m_n_node && output < m_n_node );
+   subnet &s = m_subnet[push_subnet(input)];
+   packet p;
+   p.data = data;
+   p.output = output;
+   p.flits = n_flits(size);
+   if ( p.flits > m_config.m_out_buffer ) {
+      printf("GPGPU-Sim uArch: ERROR ** %u byte packet does not fit the %u flit -icnt_xbar_out_buffer\n",
+             size, m_config.m_out_buffer);
+      abort();
+   }
+   p.push_cycle = m_cycle;
+   p.ready = 0;
+   s.in[input].push_back(p);
+   s.in_flits[input] += p.flits;
+   s.n_in++;
+}
+
+void *local_interconnect::pop( unsigned output )
+{
+   subnet &s = m_subnet[pop_subnet(output)];
+   std::deque<packet> &q = s.out[output];
+   if ( q.empty() || q.front().ready > m_cycle )
+      return NULL;
+   const packet &p = q.front();
+   unsigned long long latency = m_cycle - p.push_cycle;
+   s.kernel.packets++;
+   s.kernel.flits += p.flits;
+   s.kernel.latency += latency;
+   if ( latency > s.kernel.max_latency )
+      s.kernel.max_latency = latency;
+   void *data = p.data;
+   s.out_flits[output] -= p.flits;
+   s.n_out--;
+   q.pop_front();
+   return data;
+}
+
+// every input with a free port offers its oldest packet; an output takes
+// it if the port is free and the whole packet fits in its buffer
+void local_interconnect::arbitrate( subnet &s )
+{
+   unsigned next_rr = s.rr;
+   bool granted = false;
+   for ( unsigned k=0; k < m_n_node && s.n_in; k++ ) {
+      unsigned i = (s.rr + k) % m_n_node;
+      if ( s.in[i].empty() || s.in_free[i] > m_cycle )
+         continue;
+      packet &p = s.in[i].front();
+      unsigned o = p.output;
+      if ( s.out_free[o] > m_cycle || s.out_flits[o] + p.flits > m_config.m_out_buffer ) {
+         s.kernel.in_stall++;
+         continue;
+      }
+      s.in_free[i] = m_cycle + p.flits;
+      s.out_free[o] = m_cycle + p.flits;
+      p.ready = m_cycle + m_config.m_latency + p.flits - 1;
+      s.out_flits[o] += p.flits;
+      s.in_flits[i] -= p.flits;
+      s.out[o].push_back(p);
+      s.in[i].pop_front();
+      s.n_in--;
+      s.n_out++;
+      if ( !granted ) {
+         next_rr = (i + 1) % m_n_node;
+         granted = true;
+      }
+   }
+   s.rr = next_rr;
+}
+
+void local_interconnect::advance()
+{
+   for ( unsigned i=0; i < 2; i++ ) {
+      if ( m_subnet[i].n_in )
+         arbitrate(m_subnet[i]);
+   }
+   m_cycle++;
+}
+
+bool local_interconnect::busy() const
+{
+   return m_subnet[0].n_in || m_subnet[0].n_out || m_subnet[1].n_in || m_subnet[1].n_out;
+}
+
+void local_interconnect::skip( unsigned long long cycles )
+{
+   assert( !busy() );
+   m_cycle += cycles;
+}
+
+void local_interconnect::print_stats( const char *name, const stats &st ) const
+{
+   printf("%s: packets = %llu, flits = %llu, avg latency = %.4f, max latency = %llu, input stalls = %llu\n",
+          name, st.packets, st.flits, st.packets? (double)st.latency / st.packets : 0.0,
+          st.max_latency, st.in_stall);
+}
+
+void local_interconnect::display_stats() const
+{
+   unsigned long long cycles = m_cycle - m_kernel_start;
+   printf("icnt_xbar cycles = %llu\n", cycles);
+   print_stats("icnt_xbar request", m_subnet[0].kernel);
+   print_stats("icnt_xbar reply", m_subnet[1].kernel);
+   for ( unsigned i=0; i < 2; i++ ) {
+      const stats &st = m_subnet[i].kernel;
+      printf("icnt_xbar %s throughput = %.4f flits/cycle\n", i? "reply" : "request",
+             cycles? (double)st.flits / cycles : 0.0);
+   }
+}
+
+void local_interconnect::display_overall_stats() const
+{
+   for ( unsigned i=0; i < 2; i++ ) {
+      stats st = m_subnet[i].total;
+      const stats &k = m_subnet[i].kernel;
+      st.packets += k.packets;
+      st.flits += k.flits;
+      st.latency += k.latency;
+      st.in_stall += k.in_stall;
+      if ( k.max_latency > st.max_latency )
+         st.max_latency = k.max_latency;
+      print_stats(i? "icnt_xbar overall reply" : "icnt_xbar overall request", st);
+   }
+}
+
+void local_interconnect::display_state( FILE *fp ) const
+{
+   fprintf(fp, "GPGPU-Sim uArch: local crossbar interconnect state at cycle %llu\n", m_cycle);
+   for ( unsigned i=0; i < 2; i++ ) {
+      const subnet &s = m_subnet[i];
+      for ( unsigned n=0; n < m_n_node; n++ ) {
+         if ( !s.in[n].empty() )
+            fprintf(fp, "   %s input %u: %zu packets (%u flits), head to %u\n", i? "reply" : "request",
+                    n, s.in[n].size(), s.in_flits[n], s.in[n].front().output);
+         if ( !s.out[n].empty() )
+            fprintf(fp, "   %s output %u: %zu packets (%u flits), head ready at %llu\n", i? "reply" : "request",
+                    n, s.out[n].size(), s.out_flits[n], s.out[n].front().ready);
+      }
+   }
+}
@@ -0,0 +1,96 @@
+#ifndef LOCAL_INTERCONNECT_H
+#define LOCAL_INTERCONNECT_H
+
+#include <stdio.h>
+#include <deque>
+#include <vector>
+#include "../option_parser.h"
+
+//--------------------------------------------------------------------
+// Queueing model of the SM <-> L2 crossbar (-network_mode 2)
+//
+// For runs where the interconnect is not under study. Requests (shaders
+// to memory) and replies (memory to shaders) each cross their own
+// crossbar with one port per node:
+//  - a packet of n flits holds its input and its output port for n
+//    cycles (one flit per port per cycle) and its tail reaches the output
+//    buffer a fixed pipeline latency later;
+//  - there are no VCs: every input is a single FIFO, and its oldest
+//    packet leaves once the output port is free and the output buffer
+//    has room for the whole packet;
+//  - icnt_has_buffer() fails while the input buffer is full, and an
+//    output buffer stays full until the node pops its packets.
+// Inputs are served round robin, starting after the last one that won.
+//--------------------------------------------------------------------
+struct local_icnt_config {
+   void reg_options( option_parser_t opp );
+
+   unsigned m_latency;      // cycles from grant to the head entering the output buffer
+   unsigned m_flit_size;    // bytes per port per cycle
+   unsigned m_in_buffer;    // flits per input
+   unsigned m_out_buffer;   // flits per output
+};
+
+class local_interconnect {
+public:
+   local_interconnect( const local_icnt_config &config );
+
+   void create( unsigned n_shader, unsigned n_mem );
+   void init();
+   bool has_buffer( unsigned input, unsigned size ) const;
+   void push( unsigned input, unsigned output, void *data, unsigned size );
+   void *pop( unsigned output );
+   void advance();
+   bool busy() const;
+   void skip( unsigned long long cycles );
+   unsigned flit_size() const { return m_config.m_flit_size; }
+
+   void display_stats() const;
+   void display_overall_stats() const;
+   void display_state( FILE *fp ) const;
+
+private:
+   struct packet {
+      void *data;
+      unsigned output;
+      unsigned flits;
+      unsigned long long push_cycle;
+      unsigned long long ready;   // tail in the output buffer
+   };
+   struct stats {
+      unsigned long long packets;
+      unsigned long long flits;
+      unsigned long long latency;
+      unsigned long long max_latency;
+      unsigned long long in_stall;   // cycles a head packet waited for its output
+   };
+   struct subnet {
+      std::vector<std::deque<packet> > in;
+      std::vector<unsigned> in_flits;
+      std::vector<unsigned long long> in_free;    // input port busy until
+      std::vector<std::deque<packet> > out;
+      std::vector<unsigned> out_flits;
+      std::vector<unsigned long long> out_free;   // output port busy until
+      unsigned rr;
+      unsigned n_in;     // packets in input buffers
+      unsigned n_out;    // packets in output buffers
+      stats kernel;
+      stats total;
+   };
+
+   // requests travel on subnet 0, replies on subnet 1
+   unsigned push_subnet( unsigned input ) const { return input < m_n_shader? 0 : 1; }
+   unsigned pop_subnet( unsigned output ) const { return output < m_n_shader? 1 : 0; }
+   unsigned n_flits( unsigned size ) const { return (size + m_config.m_flit_size - 1) / m_config.m_flit_size; }
+   void arbitrate( subnet &s );
+   void print_stats( const char *name, const stats &st ) const;
+
+   const local_icnt_config &m_config;
+   unsigned m_n_shader;
+   unsigned m_n_node;
+   unsigned long long m_cycle;
+   unsigned long long m_kernel_start;
+   subnet m_subnet[2];
+};
+
+#endif
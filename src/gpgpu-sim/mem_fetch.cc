@@ -30,6 +30,7 @@
 #include "shader.h"
 #include "visualizer.h"
 #include "gpu-sim.h"
+#include "parallel.h"
 
 unsigned mem_fetch::sm_next_mf_request_uid=1;
 
@@ -41,6 +42,7 @@ mem_fetch::mem_fetch( const mem_access_t &access,
                       unsigned tpc, 
                       const class memory_config *config )
 {
+   sim_thread_pool::ordered(); // request uids follow the serial core order
    m_request_uid = sm_next_mf_request_uid++;
    m_access = access;
    if( inst ) { 
@@ -48,6 +50,7 @@ mem_fetch::mem_fetch( const mem_access_t &access,
        assert( wid == m_inst.warp_id() );
    }
    m_data_size = access.get_size();
+   m_sector_mask = sector_mask(access.get_addr(), access.get_size());
    m_ctrl_size = ctrl_size;
    m_sid = sid;
    m_tpc = tpc;
@@ -61,11 +64,13 @@ mem_fetch::mem_fetch( const mem_access_t &access,
    m_status_change = gpu_sim_cycle + gpu_tot_sim_cycle;
    m_mem_config = config;
    icnt_flit_size = config->icnt_flit_size;
+   mf_trace(MFT_ISSUE, m_timestamp, m_request_uid, sid, access.get_type(), m_data_size, access.get_addr(), wid);
 }
 
 mem_fetch::~mem_fetch()
 {
     m_status = MEM_FETCH_DELETED;
+    mf_trace(MFT_DELETE, gpu_sim_cycle+gpu_tot_sim_cycle, m_request_uid);
 }
 
 #define MF_TUP_BEGIN(X) static const char* Status_str[] = {
@@ -94,10 +99,33 @@ void mem_fetch::print( FILE *fp, bool print_inst ) const
 
 void mem_fetch::set_status( enum mem_fetch_status status, unsigned long long cycle ) 
 {
+    // the trace takes the current cycle, some callers pass none (0)
+    if( status != m_status )
+        mf_trace(MFT_STATUS, gpu_sim_cycle+gpu_tot_sim_cycle, m_request_uid, 0, status);
     m_status = status;
     m_status_change = cycle;
 }
 
+// sectors a write overwrites completely; without a byte mask (writebacks)
+// the whole access is written
+sector_mask_t mem_fetch::get_written_sectors() const
+{
+   if( !get_is_write() )
+      return 0;
+   mem_access_byte_mask_t bytes = m_access.get_byte_mask();
+   if( bytes.none() )
+      return m_sector_mask;
+   sector_mask_t written = 0;
+   for( unsigned s=0; s < SECTOR_CHUNK_SIZE; s++ ) {
+      unsigned b = 0;
+      while( b < SECTOR_SIZE && bytes.test(s*SECTOR_SIZE + b) )
+         b++;
+      if( b == SECTOR_SIZE )
+         written |= 1 << s;
+   }
+   return written & m_sector_mask;
+}
+
 bool mem_fetch::isatomic() const
 {
    if( m_inst.empty() ) return false;
@@ -135,7 +163,11 @@ unsigned mem_fetch::get_num_flits(bool simt_to_mem){
 
 
 unsigned long long mem_fetch::get_vstream_id() const {
-    if (get_is_write()) {
+    return vstream_id(get_is_write());
+}
+
+unsigned long long mem_fetch::vstream_id( bool is_write ) {
+    if (is_write) {
         return 0xFFFFFFFFFFFFFFFFull;
     } else {
         return 0;
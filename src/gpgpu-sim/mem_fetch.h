@@ -47,6 +47,29 @@ enum mf_type {
 #undef MF_TUP
 #undef MF_TUP_END
 
+// A sectored cache splits a 128B line into 32B sectors that are
+// fetched, filled and written back on their own (bit i = sector i).
+#define SECTOR_SIZE 32
+#define SECTOR_CHUNK_SIZE 4
+#define FULL_SECTOR_MASK 0xF
+typedef unsigned char sector_mask_t;
+
+// sectors of its line touched by [addr, addr+size)
+inline sector_mask_t sector_mask( new_addr_type addr, unsigned size )
+{
+    unsigned offset = addr % (SECTOR_SIZE * SECTOR_CHUNK_SIZE);
+    if( size == 0 || offset + size > SECTOR_SIZE * SECTOR_CHUNK_SIZE )
+        return FULL_SECTOR_MASK;
+    unsigned first = offset / SECTOR_SIZE;
+    unsigned last = (offset + size - 1) / SECTOR_SIZE;
+    return ((1u << (last + 1)) - 1) & ~((1u << first) - 1);
+}
+
+inline unsigned sector_count( sector_mask_t mask )
+{
+    return __builtin_popcount(mask);
+}
+
 class mem_fetch {
 public:
     mem_fetch( const mem_access_t &access, 
@@ -77,6 +100,9 @@ public:
    const addrdec_t &get_tlx_addr() const { return m_raw_addr; }
    unsigned get_data_size() const { return m_data_size; }
    void     set_data_size( unsigned size ) { m_data_size=size; }
+   sector_mask_t get_sector_mask() const { return m_sector_mask; }
+   sector_mask_t get_written_sectors() const;
+   void     set_sector_mask( sector_mask_t mask ) { m_sector_mask=mask; }
    unsigned get_ctrl_size() const { return m_ctrl_size; }
    unsigned size() const { return m_data_size+m_ctrl_size; }
    bool is_write() {return m_access.is_write();}
@@ -99,6 +125,7 @@ public:
    //unsigned get_vstream_dst_id() const { return (m_raw_addr.sub_partition<<8) | (m_raw_addr.chip); }
    unsigned get_vstream_dst_id() const { return m_raw_addr.chip; }
    unsigned long long get_vstream_id() const;
+   static unsigned long long vstream_id( bool is_write );
 
    void set_return_timestamp( unsigned t ) { m_timestamp2=t; }
    void set_icnt_receive_time( unsigned t ) { m_icnt_receive_time=t; }
@@ -131,6 +158,7 @@ private:
    // request type, address, size, mask
    mem_access_t m_access;
    unsigned m_data_size; // how much data is being written
+   sector_mask_t m_sector_mask; // sectors of the line carried (sectored caches)
    unsigned m_ctrl_size; // how big would all this meta data be in hardware (does not necessarily match actual size of mem_fetch)
    new_addr_type m_partition_addr; // linear physical address *within* dram partition (partition bank select bits squeezed out)
    addrdec_t m_raw_addr; // raw physical address (i.e., decoded DRAM chip-row-bank-column address)
@@ -37,6 +37,7 @@
 #include "../cuda-sim/ptx-stats.h"
 #include "visualizer.h"
 #include "dram.h"
+#include "parallel.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -168,6 +169,7 @@ void memory_stats_t::memlatstat_dram_access(mem_fetch *mf)
 {
    unsigned dram_id = mf->get_tlx_addr().chip;
    unsigned bank = mf->get_tlx_addr().bk;
+   sim_thread_pool::lock(); // per-shader logs and ptx line stats are shared by all channels
    if (m_memory_config->gpgpu_memlatency_stat) { 
       if (mf->get_is_write()) {
          if ( mf->get_sid() < m_n_shader  ) {   //do not count L2_writebacks here 
@@ -176,14 +178,17 @@ void memory_stats_t::memlatstat_dram_access(mem_fetch *mf)
          }
          totalbankwrites[dram_id][bank]++;
       } else {
-         bankreads[mf->get_sid()][dram_id][bank]++;
-         shader_mem_acc_log( mf->get_sid(), dram_id, bank, 'r');
+         if ( mf->get_sid() < m_n_shader  ) {   //L2 prefetches have no shader
+            bankreads[mf->get_sid()][dram_id][bank]++;
+            shader_mem_acc_log( mf->get_sid(), dram_id, bank, 'r');
+         }
          totalbankreads[dram_id][bank]++;
       }
       mem_access_type_stats[mf->get_access_type()][dram_id][bank]++;
    }
    if (mf->get_pc() != (unsigned)-1) 
       ptx_file_line_stats_add_dram_traffic(mf->get_pc(), mf->get_data_size());
+   sim_thread_pool::unlock();
 }
 
 void memory_stats_t::memlatstat_icnt2mem_pop(mem_fetch *mf)
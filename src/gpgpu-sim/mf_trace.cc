@@ -0,0 +1,348 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#include <algorithm>
+
+#include "mf_trace.h"
+
+void mf_trace_config::reg_options( option_parser_t opp )
+{
+   option_parser_register(opp, "-gpgpu_mf_trace", OPT_CSTR, &m_prefix,
+                          "Write a binary mem_fetch lifecycle trace to <prefix>.<thread>.mft (none = off)",
+                          "none");
+   option_parser_register(opp, "-gpgpu_mf_trace_block", OPT_UINT32, &m_block_events,
+                          "Events per compressed block of -gpgpu_mf_trace",
+                          "65536");
+   option_parser_register(opp, "-gpgpu_mf_trace_zlevel", OPT_INT32, &m_zlevel,
+                          "zlib level of the -gpgpu_mf_trace blocks (1 fastest - 9 smallest)",
+                          "1");
+}
+
+static const char *event_name[MFT_N_TYPE] = {
+   "issue", "status", "l1", "l2", "link", "link_comp", "dram", "delete"
+};
+
+const char *mf_trace_event_name( unsigned type )
+{
+   return (type < MFT_N_TYPE)? event_name[type] : "?";
+}
+
+bool g_mf_trace_on = false;
+
+struct mf_trace_thread {
+   unsigned id;
+   FILE *f;
+   unsigned long long offset;
+   unsigned long long n_events;
+   std::vector<mf_trace_event> events;
+   std::vector<mf_trace_block> blocks;
+   std::vector<unsigned char> zbuf;
+};
+
+static __thread mf_trace_thread *g_mf_trace_thread = NULL;
+
+static bool g_mf_trace_started = false;
+static mf_trace_config g_mf_trace_config;
+static pthread_mutex_t g_mf_trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<mf_trace_thread*> g_mf_trace_threads;
+
+static mf_trace_thread *mf_trace_thread_create()
+{
+   mf_trace_thread *t = new mf_trace_thread;
+   pthread_mutex_lock(&g_mf_trace_mutex);
+   t->id = g_mf_trace_threads.size();
+   g_mf_trace_threads.push_back(t);
+   pthread_mutex_unlock(&g_mf_trace_mutex);
+
+   char name[1024];
+   snprintf(name, sizeof(name), "%s.%u.mft", g_mf_trace_config.m_prefix, t->id);
+   t->f = fopen(name, "wb");
+   if( t->f == NULL ) {
+      printf("GPGPU-Sim uArch: ERROR ** could not open -gpgpu_mf_trace file %s\n", name);
+      exit(1);
+   }
+   mf_trace_header h;
+   memcpy(h.magic, MF_TRACE_MAGIC, 8);
+   h.event_size = sizeof(mf_trace_event);
+   h.thread = t->id;
+   fwrite(&h, sizeof(h), 1, t->f);
+   t->offset = sizeof(h);
+   t->n_events = 0;
+   t->events.reserve(g_mf_trace_config.m_block_events);
+   g_mf_trace_thread = t;
+   return t;
+}
+
+static void flush_block( mf_trace_thread *t )
+{
+   if( t->events.empty() )
+      return;
+   uLong raw = t->events.size() * sizeof(mf_trace_event);
+   uLongf comp = compressBound(raw);
+   t->zbuf.resize(comp);
+   if( compress2(&t->zbuf[0], &comp, (const Bytef*)&t->events[0], raw, g_mf_trace_config.m_zlevel) != Z_OK ) {
+      printf("GPGPU-Sim uArch: ERROR ** -gpgpu_mf_trace block compression failed\n");
+      exit(1);
+   }
+   mf_trace_block_header bh;
+   bh.comp_bytes = comp;
+   bh.n_events = t->events.size();
+   fwrite(&bh, sizeof(bh), 1, t->f);
+   fwrite(&t->zbuf[0], 1, comp, t->f);
+
+   mf_trace_block b;
+   b.offset = t->offset + sizeof(bh);
+   b.comp_bytes = comp;
+   b.n_events = bh.n_events;
+   b.first_cycle = b.last_cycle = t->events[0].cycle;
+   b.min_uid = b.max_uid = t->events[0].uid;
+   for( unsigned i=1; i < t->events.size(); i++ ) {
+      const mf_trace_event &e = t->events[i];
+      b.first_cycle = std::min(b.first_cycle, e.cycle);
+      b.last_cycle = std::max(b.last_cycle, e.cycle);
+      b.min_uid = std::min(b.min_uid, e.uid);
+      b.max_uid = std::max(b.max_uid, e.uid);
+   }
+   t->blocks.push_back(b);
+   t->offset += sizeof(bh) + comp;
+   t->n_events += bh.n_events;
+   t->events.clear();
+}
+
+void mf_trace_record( const mf_trace_event &e )
+{
+   mf_trace_thread *t = g_mf_trace_thread;
+   if( t == NULL )
+      t = mf_trace_thread_create();
+   t->events.push_back(e);
+   if( t->events.size() >= g_mf_trace_config.m_block_events )
+      flush_block(t);
+}
+
+void mf_trace_close()
+{
+   if( !g_mf_trace_on )
+      return;
+   g_mf_trace_on = false;
+   pthread_mutex_lock(&g_mf_trace_mutex);
+   unsigned long long n_events = 0, n_bytes = 0;
+   for( unsigned i=0; i < g_mf_trace_threads.size(); i++ ) {
+      mf_trace_thread *t = g_mf_trace_threads[i];
+      flush_block(t);
+      mf_trace_footer foot;
+      foot.index_offset = t->offset;
+      foot.n_blocks = t->blocks.size();
+      foot.n_events = t->n_events;
+      memcpy(foot.magic, MF_TRACE_INDEX_MAGIC, 8);
+      if( !t->blocks.empty() )
+         fwrite(&t->blocks[0], sizeof(mf_trace_block), t->blocks.size(), t->f);
+      fwrite(&foot, sizeof(foot), 1, t->f);
+      n_bytes += t->offset + t->blocks.size() * sizeof(mf_trace_block) + sizeof(foot);
+      n_events += t->n_events;
+      fclose(t->f);
+      delete t;
+   }
+   printf("GPGPU-Sim uArch: mem_fetch trace %s.*.mft: %zu files, %llu events, %llu bytes (%.2f bytes/event)\n",
+          g_mf_trace_config.m_prefix, g_mf_trace_threads.size(), n_events, n_bytes,
+          n_events? (double)n_bytes / n_events : 0.0);
+   g_mf_trace_threads.clear();
+   pthread_mutex_unlock(&g_mf_trace_mutex);
+   fflush(stdout);
+}
+
+void mf_trace_init( const mf_trace_config &config )
+{
+   if( g_mf_trace_started || !config.enabled() )
+      return;
+   g_mf_trace_started = true;
+   g_mf_trace_config = config;
+   if( g_mf_trace_config.m_block_events == 0 )
+      g_mf_trace_config.m_block_events = 1;
+   g_mf_trace_on = true;
+   atexit(mf_trace_close);
+}
+
+mf_trace_file::mf_trace_file()
+   : m_fd(-1), m_data(NULL), m_size(0), m_indexed(false), m_n_events(0)
+{
+}
+
+mf_trace_file::~mf_trace_file()
+{
+   close();
+}
+
+void mf_trace_file::close()
+{
+   if( m_data )
+      munmap((void*)m_data, m_size);
+   if( m_fd >= 0 )
+      ::close(m_fd);
+   m_fd = -1;
+   m_data = NULL;
+   m_size = 0;
+   m_blocks.clear();
+   m_n_events = 0;
+}
+
+bool mf_trace_file::open( const char *name )
+{
+   close();
+   m_fd = ::open(name, O_RDONLY);
+   if( m_fd < 0 )
+      return false;
+   struct stat st;
+   if( fstat(m_fd, &st) || (size_t)st.st_size < sizeof(mf_trace_header) ) {
+      close();
+      return false;
+   }
+   m_size = st.st_size;
+   void *p = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+   if( p == MAP_FAILED ) {
+      m_data = NULL;
+      close();
+      return false;
+   }
+   m_data = (const unsigned char*)p;
+   const mf_trace_header *h = (const mf_trace_header*)m_data;
+   if( memcmp(h->magic, MF_TRACE_MAGIC, 8) || h->event_size != sizeof(mf_trace_event) ) {
+      close();
+      return false;
+   }
+
+   // index from the footer
+   m_indexed = false;
+   if( m_size >= sizeof(mf_trace_header) + sizeof(mf_trace_footer) ) {
+      mf_trace_footer foot;
+      memcpy(&foot, m_data + m_size - sizeof(foot), sizeof(foot));
+      if( !memcmp(foot.magic, MF_TRACE_INDEX_MAGIC, 8) &&
+          foot.index_offset + foot.n_blocks * sizeof(mf_trace_block) + sizeof(foot) == m_size ) {
+         m_blocks.resize(foot.n_blocks);
+         if( foot.n_blocks )
+            memcpy(&m_blocks[0], m_data + foot.index_offset, foot.n_blocks * sizeof(mf_trace_block));
+         m_n_events = foot.n_events;
+         m_indexed = true;
+         return true;
+      }
+   }
+
+   // no index (the simulation did not exit cleanly): walk the complete blocks
+   size_t off = sizeof(mf_trace_header);
+   std::vector<mf_trace_event> events;
+   while( off + sizeof(mf_trace_block_header) <= m_size ) {
+      mf_trace_block_header bh;
+      memcpy(&bh, m_data + off, sizeof(bh));
+      if( off + sizeof(bh) + bh.comp_bytes > m_size )
+         break;
+      mf_trace_block b;
+      b.offset = off + sizeof(bh);
+      b.comp_bytes = bh.comp_bytes;
+      b.n_events = bh.n_events;
+      m_blocks.push_back(b);
+      if( !read_block(m_blocks.size() - 1, events) ) {
+         m_blocks.pop_back();
+         break;
+      }
+      m_blocks.back().first_cycle = m_blocks.back().last_cycle = events[0].cycle;
+      m_blocks.back().min_uid = m_blocks.back().max_uid = events[0].uid;
+      for( unsigned i=1; i < events.size(); i++ ) {
+         mf_trace_block &last = m_blocks.back();
+         last.first_cycle = std::min(last.first_cycle, events[i].cycle);
+         last.last_cycle = std::max(last.last_cycle, events[i].cycle);
+         last.min_uid = std::min(last.min_uid, events[i].uid);
+         last.max_uid = std::max(last.max_uid, events[i].uid);
+      }
+      m_n_events += bh.n_events;
+      off += sizeof(bh) + bh.comp_bytes;
+   }
+   return true;
+}
+
+bool mf_trace_file::read_block( unsigned i, std::vector<mf_trace_event> &events ) const
+{
+   const mf_trace_block &b = m_blocks[i];
+   if( b.n_events == 0 || b.offset + b.comp_bytes > m_size )
+      return false;
+   events.resize(b.n_events);
+   uLongf raw = b.n_events * sizeof(mf_trace_event);
+   if( uncompress((Bytef*)&events[0], &raw, m_data + b.offset, b.comp_bytes) != Z_OK ||
+       raw != b.n_events * sizeof(mf_trace_event) ) {
+      events.clear();
+      return false;
+   }
+   return true;
+}
+
+mf_trace_reader::~mf_trace_reader()
+{
+   for( unsigned i=0; i < m_files.size(); i++ )
+      delete m_files[i];
+}
+
+bool mf_trace_reader::open( const char *prefix )
+{
+   for( unsigned n=0; ; n++ ) {
+      char name[1024];
+      snprintf(name, sizeof(name), "%s.%u.mft", prefix, n);
+      mf_trace_file *f = new mf_trace_file;
+      if( !f->open(name) ) {
+         delete f;
+         break;
+      }
+      m_files.push_back(f);
+   }
+   m_cursors.resize(m_files.size());
+   seek(0);
+   return !m_files.empty();
+}
+
+void mf_trace_reader::seek( unsigned long long cycle )
+{
+   for( unsigned f=0; f < m_files.size(); f++ ) {
+      cursor &c = m_cursors[f];
+      c.block = 0;
+      while( c.block < m_files[f]->num_blocks() && m_files[f]->block(c.block).last_cycle < cycle )
+         c.block++;
+      c.events.clear();
+      c.pos = 0;
+      if( fill(f) ) {
+         while( c.pos < c.events.size() && c.events[c.pos].cycle < cycle )
+            c.pos++;
+      }
+   }
+}
+
+// makes m_cursors[f] point at an event unless the file is exhausted
+bool mf_trace_reader::fill( unsigned f )
+{
+   cursor &c = m_cursors[f];
+   while( c.pos >= c.events.size() ) {
+      if( c.block >= m_files[f]->num_blocks() )
+         return false;
+      c.pos = 0;
+      if( !m_files[f]->read_block(c.block++, c.events) )
+         c.events.clear();
+   }
+   return true;
+}
+
+bool mf_trace_reader::next( mf_trace_event &e )
+{
+   int best = -1;
+   for( unsigned f=0; f < m_files.size(); f++ ) {
+      if( !fill(f) )
+         continue;
+      if( best < 0 || m_cursors[f].events[m_cursors[f].pos].cycle < m_cursors[best].events[m_cursors[best].pos].cycle )
+         best = f;
+   }
+   if( best < 0 )
+      return false;
+   e = m_cursors[best].events[m_cursors[best].pos++];
+   return true;
+}
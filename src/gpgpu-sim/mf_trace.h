@@ -0,0 +1,174 @@
+#ifndef MF_TRACE_H
+#define MF_TRACE_H
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "../option_parser.h"
+
+//--------------------------------------------------------------------
+// Binary mem_fetch lifecycle trace
+//
+// With -gpgpu_mf_trace <prefix> every mem_fetch records its life as fixed
+// size events: issue, each status change, L1 / L2 outcome, memory link
+// enqueue and compressed size, DRAM bank schedule and delete. Events go
+// to a buffer owned by the calling thread (worker threads of
+// -gpgpu_sim_threads never share one) and each thread writes its own
+// file, <prefix>.<n>.mft. A full buffer of -gpgpu_mf_trace_block events
+// is deflated as one block; at exit an index of the blocks (file offset,
+// events, cycle and uid range) is appended. Disabled, every hook costs
+// one predictable branch.
+//
+// mf_trace_file maps one file and inflates blocks on demand (without the
+// index, e.g. after a crash, it walks the block headers instead);
+// mf_trace_reader merges the files of a trace in cycle order.
+// bench/mf_trace_dump prints the events or a latency breakdown.
+//--------------------------------------------------------------------
+
+enum mf_trace_event_type {
+   MFT_ISSUE = 0,   // where = sid, arg = mem_access_type, aux = warp, value = data size, addr
+   MFT_STATUS,      // arg = new mem_fetch_status
+   MFT_L1,          // where = sid, arg = cache_request_status
+   MFT_L2,          // where = sub partition, arg = cache_request_status
+   MFT_LINK,        // memory link enqueue: where = sub partition, arg = 0 down / 1 up
+   MFT_LINK_COMP,   // compressed size: arg = 0 down / 1 up, value = bits on the link
+   MFT_DRAM,        // bank schedule: where = chip, arg = bank, value = row
+   MFT_DELETE,
+   MFT_N_TYPE
+};
+
+// 32 bytes, written as is (the files are host endian)
+struct mf_trace_event {
+   unsigned long long cycle;
+   unsigned long long addr;
+   unsigned uid;
+   unsigned value;
+   unsigned where;
+   unsigned char type;
+   unsigned char arg;
+   unsigned short aux;
+};
+
+const char *mf_trace_event_name( unsigned type );
+
+struct mf_trace_config {
+   void reg_options( option_parser_t opp );
+
+   bool enabled() const { return m_prefix && strcmp(m_prefix,"none"); }
+
+   char *m_prefix;
+   unsigned m_block_events;
+   int m_zlevel;
+};
+
+extern bool g_mf_trace_on;
+
+// opens tracing (files are created on each thread's first event) and
+// registers mf_trace_close() at exit
+void mf_trace_init( const mf_trace_config &config );
+// deflates the partial blocks and writes the indexes
+void mf_trace_close();
+
+void mf_trace_record( const mf_trace_event &e );
+
+static inline void mf_trace( unsigned char type, unsigned long long cycle, unsigned uid,
+                             unsigned where = 0, unsigned char arg = 0, unsigned value = 0,
+                             unsigned long long addr = 0, unsigned short aux = 0 )
+{
+   if( !g_mf_trace_on )
+      return;
+   mf_trace_event e;
+   e.cycle = cycle;
+   e.addr = addr;
+   e.uid = uid;
+   e.value = value;
+   e.where = where;
+   e.type = type;
+   e.arg = arg;
+   e.aux = aux;
+   mf_trace_record(e);
+}
+
+// on disk: header, blocks (mf_trace_block_header + deflated events),
+// index (mf_trace_block per block), footer
+#define MF_TRACE_MAGIC "MFTRACE1"
+#define MF_TRACE_INDEX_MAGIC "MFTRIDX1"
+
+struct mf_trace_header {
+   char magic[8];
+   unsigned event_size;
+   unsigned thread;
+};
+
+struct mf_trace_block_header {
+   unsigned comp_bytes;
+   unsigned n_events;
+};
+
+struct mf_trace_block {
+   unsigned long long offset;   // of the deflated events
+   unsigned comp_bytes;
+   unsigned n_events;
+   unsigned long long first_cycle;
+   unsigned long long last_cycle;
+   unsigned min_uid;
+   unsigned max_uid;
+};
+
+struct mf_trace_footer {
+   unsigned long long index_offset;
+   unsigned long long n_blocks;
+   unsigned long long n_events;
+   char magic[8];
+};
+
+// one file of a trace, mapped read only
+class mf_trace_file {
+public:
+   mf_trace_file();
+   ~mf_trace_file();
+
+   bool open( const char *name );
+   void close();
+
+   bool indexed() const { return m_indexed; }
+   unsigned num_blocks() const { return m_blocks.size(); }
+   const mf_trace_block &block( unsigned i ) const { return m_blocks[i]; }
+   unsigned long long num_events() const { return m_n_events; }
+   // inflates block i into events
+   bool read_block( unsigned i, std::vector<mf_trace_event> &events ) const;
+
+private:
+   int m_fd;
+   const unsigned char *m_data;
+   size_t m_size;
+   bool m_indexed;
+   unsigned long long m_n_events;
+   std::vector<mf_trace_block> m_blocks;
+};
+
+// all files of a trace (<prefix>.0.mft, <prefix>.1.mft, ...), events in cycle order
+class mf_trace_reader {
+public:
+   ~mf_trace_reader();
+
+   bool open( const char *prefix );
+   unsigned num_files() const { return m_files.size(); }
+   const mf_trace_file &file( unsigned i ) const { return *m_files[i]; }
+   // the next next() returns the first event at or after cycle (skips whole blocks)
+   void seek( unsigned long long cycle );
+   bool next( mf_trace_event &e );
+
+private:
+   struct cursor {
+      unsigned block;
+      size_t pos;
+      std::vector<mf_trace_event> events;
+   };
+   bool fill( unsigned f );
+
+   std::vector<mf_trace_file*> m_files;
+   std::vector<cursor> m_cursors;
+};
+
+#endif
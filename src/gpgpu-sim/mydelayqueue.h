@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <queue>
 #include <set>
+#include <algorithm>
 #include "../abstract_hardware_model.h"
 #include "../cuda-sim/memory.h"
 #include "gpu-sim.h"
@@ -69,6 +70,29 @@ public:
         return result;
     }
 
+    // FLITs popped before the next tail FLIT comes out (-1: none in flight)
+    int next_tail() const
+    {
+        for (unsigned i=m_rd_ptr; i!=m_wr_ptr; i=(i+1)%m_arr_size) {
+            if (m_is_tail_array[i]) {
+                return (i+m_arr_size-m_rd_ptr) % m_arr_size;
+            }
+        }
+        return -1;
+    }
+    // n pops of non-tail FLITs and n pushes of empty FLITs
+    void skip(unsigned n)
+    {
+        for (unsigned i=0; i<n; i++) {
+            assert(!m_is_tail_array[m_rd_ptr]);
+            m_rd_ptr = (m_rd_ptr+1) % m_arr_size;
+            m_data_array[m_wr_ptr] = NULL;
+            m_is_head_array[m_wr_ptr] = false;
+            m_is_tail_array[m_wr_ptr] = false;
+            m_wr_ptr = (m_wr_ptr+1) % m_arr_size;
+        }
+    }
+
     void print() const
     {
         printf("@%8lld %s : %d, %d\n", gpu_sim_cycle, m_name, m_rd_ptr, m_wr_ptr);
@@ -212,14 +236,63 @@ public:
 
         step_link_push(n_flit);
     }
+    // Only FLITs in flight: nothing waits to enter or to be taken out of the
+    // link. n_flit is lowered to the FLITs that can be popped before the next
+    // packet completes, next_cycle to the next timed event.
+    virtual bool quiescent(unsigned long long &next_cycle, unsigned &n_flit) const {
+        if (m_cur_flit_cnt!=0) {
+            return false;
+        }
+        for (unsigned i=0; i<m_src_cnt; i++) {
+            if (!m_ready_list[i].empty()) return false;
+        }
+        for (unsigned i=0; i<m_dst_cnt; i++) {
+            if (!m_complete_list[i].empty()) return false;
+        }
+        int tail = queue->next_tail();
+        if ((tail>=0) && ((unsigned)tail<n_flit)) {
+            n_flit = tail;
+        }
+        return true;
+    }
+    // steps of a quiescent link over n_flit FLITs in total
+    virtual void skip(unsigned n_flit) {
+        m_total_flit_cnt += n_flit;
+        queue->skip(n_flit);
+    }
     void print() const {
         queue->print();
     }
+    unsigned long long get_total_flit_cnt() const { return m_total_flit_cnt; }
+    unsigned long long get_transfer_flit_cnt() const { return m_transfer_flit_cnt; }
+    void save_stat(FILE *fout) const {
+        unsigned long long cnt[4] = { m_total_flit_cnt, m_transfer_flit_cnt, m_transfer_single_flit_cnt, m_transfer_multi_flit_cnt };
+        fwrite(cnt, sizeof(cnt), 1, fout);
+    }
+    bool load_stat(FILE *fin) {
+        unsigned long long cnt[4];
+        if (fread(cnt, sizeof(cnt), 1, fin) != 1) return false;
+        m_total_flit_cnt = cnt[0];
+        m_transfer_flit_cnt = cnt[1];
+        m_transfer_single_flit_cnt = cnt[2];
+        m_transfer_multi_flit_cnt = cnt[3];
+        return true;
+    }
     void print_stat() const {
         printf("%s TOT %f (%lld/%lld)\n", m_name, m_transfer_flit_cnt*1./m_total_flit_cnt, m_transfer_flit_cnt, m_total_flit_cnt);
         printf("%s SIN %f (%lld/%lld)\n", m_name, m_transfer_single_flit_cnt*1./m_total_flit_cnt, m_transfer_single_flit_cnt, m_total_flit_cnt);
         printf("%s MUL %f (%lld/%lld)\n", m_name, m_transfer_multi_flit_cnt*1./m_total_flit_cnt, m_transfer_multi_flit_cnt, m_total_flit_cnt);
     }
+    void reg_stats(stat_registry &stats) const {
+        std::string nm(m_name);
+        stats.reg_counter(nm + ".total_flits", &m_total_flit_cnt);
+        stats.reg_counter(nm + ".transfer_flits", &m_transfer_flit_cnt);
+        stats.reg_counter(nm + ".single_flits", &m_transfer_single_flit_cnt);
+        stats.reg_counter(nm + ".multi_flits", &m_transfer_multi_flit_cnt);
+        stats.reg_ratio(nm + ".TOT", &m_transfer_flit_cnt, &m_total_flit_cnt);
+        stats.reg_ratio(nm + ".SIN", &m_transfer_single_flit_cnt, &m_total_flit_cnt);
+        stats.reg_ratio(nm + ".MUL", &m_transfer_multi_flit_cnt, &m_total_flit_cnt);
+    }
 protected:
     static const unsigned FLIT_SIZE = 128;      // max packet length in terms of FLIP
     static const unsigned HT_OVERHEAD = 128;    // head+tail overheads
@@ -305,6 +378,9 @@ public:
         m_data_array[m_rd_ptr] = NULL;
         m_rd_ptr = (m_rd_ptr+1) % m_arr_size;
     }
+    bool empty() const { return m_rd_ptr==m_wr_ptr; }
+    // first cycle at which top() returns the head entry
+    unsigned long long ready_cycle() const { return m_time_array[m_rd_ptr] + m_latency + 1; }
 
     void print() const
     {
@@ -341,6 +417,22 @@ public:
         m_leftover = 0;
     }
 
+    bool quiescent(unsigned long long &next_cycle, unsigned &n_flit) const {
+        for (unsigned i=0; i<m_src_cnt; i++) {
+            if (!m_ready_long_list[i].empty() || !m_ready_short_list[i].empty()) return false;
+        }
+        if (!m_ready_compressed->empty()) {
+            next_cycle = std::min(next_cycle, m_ready_compressed->ready_cycle());
+        }
+        return oneway_link::quiescent(next_cycle, n_flit);
+    }
+    void skip(unsigned n_flit) {
+        oneway_link::skip(n_flit);
+        if (n_flit) {
+            m_leftover = 0;     // left-over space is discarded
+        }
+    }
+
     void push(unsigned mem_id, mem_fetch *mf) {
         assert(!full(mem_id));
         if ((mf->get_type()==WRITE_REQUEST)||(mf->get_type()==READ_REPLY)) {
@@ -475,7 +567,10 @@ public:
                 if (mf->get_data_size() == 128) {   // for now, compress only 128B blocks only
                     static int cnt = 0;
                     g_the_gpu->get_global_memory()->read(mf->get_addr(), mf->get_data_size(), buffer);
-                    comp_bit_size = g_comp->compress(mf->get_vstream_id(), buffer, mf->get_addr(), mf->get_data_size());
+                    {
+                        HOST_PROF_SCOPE(HP_COMPRESS);
+                        comp_bit_size = g_comp->compress(mf->get_vstream_id(), buffer, mf->get_addr(), mf->get_data_size());
+                    }
                     cnt += comp_bit_size;
                     if (cnt > 1024) {   // spread over two packets
                         cnt -= 1024;
@@ -486,6 +581,7 @@ public:
                     comp_bit_size = mf->get_data_size() * 8;
                 }
 
+                mf_trace(MFT_LINK_COMP, gpu_sim_cycle+gpu_tot_sim_cycle, mf->get_request_uid(), src_id, 0, comp_bit_size);
                 m_ready_compressed->push(mf, comp_bit_size);
                 m_ready_long_list[src_id].pop();
             }
@@ -585,7 +681,10 @@ public:
                     static int cnt = 0;
 
                     g_the_gpu->get_global_memory()->read(mf->get_addr(), mf->get_data_size(), buffer);
-                    comp_bit_size = g_comp->compress(mf->get_vstream_id(), buffer, mf->get_addr(), mf->get_data_size());
+                    {
+                        HOST_PROF_SCOPE(HP_COMPRESS);
+                        comp_bit_size = g_comp->compress(mf->get_vstream_id(), buffer, mf->get_addr(), mf->get_data_size());
+                    }
 
                     cnt += comp_bit_size;
                     if (cnt > 1024) {   // spread over two packets
@@ -598,6 +697,7 @@ public:
                 }
 
                 //printf("PUSH @%08d %p %d\n", gpu_sim_cycle, mf, mf->get_request_uid());
+                mf_trace(MFT_LINK_COMP, gpu_sim_cycle+gpu_tot_sim_cycle, mf->get_request_uid(), src_id, 1, comp_bit_size);
                 m_ready_compressed->push(mf, comp_bit_size);
                 m_ready_long_list[src_id].pop();
             }
@@ -694,6 +794,8 @@ public:
 
         dnlink_remainder = 0.;
         uplink_remainder = 0.;
+        m_snap_transfer_flit = 0;
+        m_snap_total_flit = 0;
     }
     ~memory_link() {
         delete m_dn;
@@ -705,7 +807,10 @@ public:
         dnlink_remainder = (n_flit + dnlink_remainder) - flit_rounded;
     }
     bool dnlink_full(unsigned mem_id) { return m_dn->full(mem_id); }
-    void dnlink_push(unsigned mem_id, mem_fetch *mf) { m_dn->push(mem_id, mf); }
+    void dnlink_push(unsigned mem_id, mem_fetch *mf) {
+        mf_trace(MFT_LINK, gpu_sim_cycle+gpu_tot_sim_cycle, mf->get_request_uid(), mem_id, 0);
+        m_dn->push(mem_id, mf);
+    }
     bool dnlink_empty(unsigned mem_id) { return m_dn->empty(mem_id); }
     mem_fetch *dnlink_top(unsigned mem_id) { return m_dn->top(mem_id); }
     void dnlink_pop(unsigned mem_id) { m_dn->pop(mem_id); }
@@ -716,7 +821,10 @@ public:
         uplink_remainder = (n_flit + uplink_remainder) - flit_rounded;
     }
     bool uplink_full(unsigned mem_id) { return m_up->full(mem_id); }
-    void uplink_push(unsigned mem_id, mem_fetch *mf) { m_up->push(mem_id, mf); }
+    void uplink_push(unsigned mem_id, mem_fetch *mf) {
+        mf_trace(MFT_LINK, gpu_sim_cycle+gpu_tot_sim_cycle, mf->get_request_uid(), mem_id, 1);
+        m_up->push(mem_id, mf);
+    }
     bool uplink_empty(unsigned mem_id) { return m_up->empty(mem_id); }
     mem_fetch *uplink_top(unsigned mem_id) { return m_up->top(mem_id); }
     void uplink_pop(unsigned mem_id) { m_up->pop(mem_id); }
@@ -725,13 +833,73 @@ public:
         m_dn->print();
         m_up->print();
     }
+    // both directions quiescent; n_step is lowered to the DRAM cycles that
+    // can be skipped before a packet comes out of the link
+    bool quiescent(unsigned long long &next_cycle, unsigned long long &n_step) const {
+        unsigned n_flit = (unsigned)-1;
+        if (!m_dn->quiescent(next_cycle, n_flit) || !m_up->quiescent(next_cycle, n_flit)) {
+            return false;
+        }
+        unsigned max_flit_per_step = (unsigned)m_config->n_flit_per_mem_cycle + 1;
+        n_step = std::min(n_step, (unsigned long long)(n_flit / max_flit_per_step));
+        return true;
+    }
+    // n_step DRAM cycles of dnlink_step() and uplink_step() on a quiescent link
+    void skip(unsigned long long n_step, double n_flit) {
+        unsigned dn_flit = 0, up_flit = 0;
+        for (unsigned long long i=0; i<n_step; i++) {
+            unsigned flit_rounded = (unsigned) (n_flit + uplink_remainder);
+            up_flit += flit_rounded;
+            uplink_remainder = (n_flit + uplink_remainder) - flit_rounded;
+            flit_rounded = (unsigned) (n_flit + dnlink_remainder);
+            dn_flit += flit_rounded;
+            dnlink_remainder = (n_flit + dnlink_remainder) - flit_rounded;
+        }
+        m_up->skip(up_flit);
+        m_dn->skip(dn_flit);
+    }
     void print_stat() const {
         m_dn->print_stat();
         m_up->print_stat();
     }
+    void reg_stats(stat_registry &stats) const {
+        m_dn->reg_stats(stats);
+        m_up->reg_stats(stats);
+    }
+    // FLIT slots offered / used by both directions (sampling bandwidth estimate)
+    void get_flit_cnt(unsigned long long &transfer, unsigned long long &total) const {
+        transfer += m_dn->get_transfer_flit_cnt() + m_up->get_transfer_flit_cnt();
+        total += m_dn->get_total_flit_cnt() + m_up->get_total_flit_cnt();
+    }
+    // get_flit_cnt() as of the last snapshot_flit_cnt(), which runs in the
+    // serial part of the L2 cycle: the L2 prefetchers read it from the
+    // sub partition tasks
+    void snapshot_flit_cnt() {
+        m_snap_transfer_flit = 0;
+        m_snap_total_flit = 0;
+        get_flit_cnt(m_snap_transfer_flit, m_snap_total_flit);
+    }
+    void get_flit_cnt_snapshot(unsigned long long &transfer, unsigned long long &total) const {
+        transfer += m_snap_transfer_flit;
+        total += m_snap_total_flit;
+    }
+    // checkpoint of the link counters (the link must be drained)
+    void save_stat(FILE *fout) const {
+        fwrite(&dnlink_remainder, sizeof(dnlink_remainder), 1, fout);
+        fwrite(&uplink_remainder, sizeof(uplink_remainder), 1, fout);
+        m_dn->save_stat(fout);
+        m_up->save_stat(fout);
+    }
+    bool load_stat(FILE *fin) {
+        if (fread(&dnlink_remainder, sizeof(dnlink_remainder), 1, fin) != 1) return false;
+        if (fread(&uplink_remainder, sizeof(uplink_remainder), 1, fin) != 1) return false;
+        return m_dn->load_stat(fin) && m_up->load_stat(fin);
+    }
 protected:
     double dnlink_remainder;
     double uplink_remainder;
+    unsigned long long m_snap_transfer_flit;
+    unsigned long long m_snap_total_flit;
 
     const struct memory_config *m_config;
     char m_nm[256];
@@ -836,12 +1004,16 @@ public:
                 mem_fetch *mf = m_ready_long_list[src_id].front();
                 if (mf->get_data_size() == 128) {   // for now, compress only 128B blocks only
                     g_the_gpu->get_global_memory()->read(mf->get_addr(), mf->get_data_size(), buffer);
-                    comp_bit_size = g_comp->compress(mf->get_vstream_id(), buffer, mf->get_addr(), mf->get_data_size());
+                    {
+                        HOST_PROF_SCOPE(HP_COMPRESS);
+                        comp_bit_size = g_comp->compress(mf->get_vstream_id(), buffer, mf->get_addr(), mf->get_data_size());
+                    }
                     comp_bit_size = ((comp_bit_size+FLIT_SIZE-1)/FLIT_SIZE)*FLIT_SIZE;
                 } else {
                     comp_bit_size = mf->get_data_size() * 8;
                 }
 
+                mf_trace(MFT_LINK_COMP, gpu_sim_cycle+gpu_tot_sim_cycle, mf->get_request_uid(), src_id, 0, comp_bit_size);
                 m_ready_compressed->push(mf, comp_bit_size);
                 m_ready_long_list[src_id].pop();
             }
@@ -937,13 +1109,17 @@ public:
                 mem_fetch *mf = m_ready_long_list[src_id].front();
                 if (mf->get_data_size() == 128) {
                     g_the_gpu->get_global_memory()->read(mf->get_addr(), mf->get_data_size(), buffer);
-                    comp_bit_size = g_comp->compress(mf->get_vstream_id(), buffer, mf->get_addr(), mf->get_data_size());
+                    {
+                        HOST_PROF_SCOPE(HP_COMPRESS);
+                        comp_bit_size = g_comp->compress(mf->get_vstream_id(), buffer, mf->get_addr(), mf->get_data_size());
+                    }
                     comp_bit_size = ((comp_bit_size+FLIT_SIZE-1)/FLIT_SIZE)*FLIT_SIZE;
                 } else {
                     comp_bit_size = mf->get_data_size() * 8;
                 }
 
                 //printf("PUSH @%08d %p %d\n", gpu_sim_cycle, mf, mf->get_request_uid());
+                mf_trace(MFT_LINK_COMP, gpu_sim_cycle+gpu_tot_sim_cycle, mf->get_request_uid(), src_id, 1, comp_bit_size);
                 m_ready_compressed->push(mf, comp_bit_size);
                 m_ready_long_list[src_id].pop();
             }
@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "parallel.h"
+
+// pool and task index of the task running on this thread (NULL outside run())
+static __thread sim_thread_pool *t_pool = NULL;
+static __thread unsigned t_task = 0;
+static __thread bool t_ordered = false;
+
+sim_thread_pool::sim_thread_pool( unsigned n_threads )
+{
+    assert( n_threads > 0 );
+    m_n_threads = n_threads;
+    m_generation = 0;
+    m_exit = false;
+    m_fn = NULL;
+    m_arg = NULL;
+    m_n_tasks = 0;
+    m_next_task = 0;
+    m_done_prefix = 0;
+    m_n_waiting = 0;
+    pthread_mutex_init(&m_mutex, NULL);
+    pthread_cond_init(&m_start_cond, NULL);
+    pthread_cond_init(&m_done_cond, NULL);
+    pthread_mutex_init(&m_shared_mutex, NULL);
+
+    // the thread calling run() is one of the n_threads
+    m_threads.resize(n_threads - 1);
+    for( unsigned i=0; i < m_threads.size(); i++ ) {
+        if( pthread_create(&m_threads[i], NULL, worker_main, this) ) {
+            printf("GPGPU-Sim uArch: ERROR ** cannot create simulation worker thread\n");
+            abort();
+        }
+    }
+}
+
+sim_thread_pool::~sim_thread_pool()
+{
+    pthread_mutex_lock(&m_mutex);
+    m_exit = true;
+    pthread_cond_broadcast(&m_start_cond);
+    pthread_mutex_unlock(&m_mutex);
+    for( unsigned i=0; i < m_threads.size(); i++ )
+        pthread_join(m_threads[i], NULL);
+    pthread_mutex_destroy(&m_mutex);
+    pthread_cond_destroy(&m_start_cond);
+    pthread_cond_destroy(&m_done_cond);
+    pthread_mutex_destroy(&m_shared_mutex);
+}
+
+void *sim_thread_pool::worker_main( void *pool )
+{
+    ((sim_thread_pool*)pool)->worker();
+    return NULL;
+}
+
+void sim_thread_pool::worker()
+{
+    unsigned long long seen = 0;
+    while( true ) {
+        pthread_mutex_lock(&m_mutex);
+        while( m_generation == seen && !m_exit )
+            pthread_cond_wait(&m_start_cond, &m_mutex);
+        if( m_exit ) {
+            pthread_mutex_unlock(&m_mutex);
+            return;
+        }
+        seen = m_generation;
+        pthread_mutex_unlock(&m_mutex);
+        execute_tasks();
+    }
+}
+
+void sim_thread_pool::run( unsigned n_tasks, task_t fn, void *arg )
+{
+    assert( t_pool == NULL ); // no nested runs
+    pthread_mutex_lock(&m_mutex);
+    m_fn = fn;
+    m_arg = arg;
+    m_task_done.assign(n_tasks, false);
+    m_done_prefix = 0;
+    m_next_task = 0;
+    m_n_tasks = n_tasks;
+    m_generation++;
+    pthread_cond_broadcast(&m_start_cond);
+    pthread_mutex_unlock(&m_mutex);
+
+    execute_tasks();
+
+    pthread_mutex_lock(&m_mutex);
+    while( m_done_prefix < n_tasks )
+        pthread_cond_wait(&m_done_cond, &m_mutex);
+    pthread_mutex_unlock(&m_mutex);
+}
+
+void sim_thread_pool::execute_tasks()
+{
+    while( true ) {
+        unsigned idx = __sync_fetch_and_add(&m_next_task, 1);
+        if( idx >= m_n_tasks )
+            break;
+        t_pool = this;
+        t_task = idx;
+        t_ordered = false;
+        m_fn(m_arg, idx);
+        t_pool = NULL;
+        task_done(idx);
+    }
+}
+
+void sim_thread_pool::task_done( unsigned idx )
+{
+    pthread_mutex_lock(&m_mutex);
+    m_task_done[idx] = true;
+    unsigned prefix = m_done_prefix;
+    while( m_done_prefix < m_n_tasks && m_task_done[m_done_prefix] )
+        m_done_prefix++;
+    if( m_done_prefix != prefix && (m_n_waiting || m_done_prefix == m_n_tasks) )
+        pthread_cond_broadcast(&m_done_cond);
+    pthread_mutex_unlock(&m_mutex);
+}
+
+void sim_thread_pool::wait_lower( unsigned idx )
+{
+    pthread_mutex_lock(&m_mutex);
+    m_n_waiting++;
+    while( m_done_prefix < idx )
+        pthread_cond_wait(&m_done_cond, &m_mutex);
+    m_n_waiting--;
+    pthread_mutex_unlock(&m_mutex);
+}
+
+bool sim_thread_pool::in_task()
+{
+    return t_pool != NULL;
+}
+
+void sim_thread_pool::ordered()
+{
+    // once all lower tasks are done the rest of this task stays in order
+    if( !t_pool || t_ordered )
+        return;
+    t_pool->wait_lower(t_task);
+    t_ordered = true;
+}
+
+void sim_thread_pool::lock()
+{
+    if( t_pool )
+        pthread_mutex_lock(&t_pool->m_shared_mutex);
+}
+
+void sim_thread_pool::unlock()
+{
+    if( t_pool )
+        pthread_mutex_unlock(&t_pool->m_shared_mutex);
+}
@@ -0,0 +1,67 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <pthread.h>
+#include <vector>
+
+//--------------------------------------------------------------------
+// Persistent worker pool for stepping independent units (SIMT clusters,
+// memory partitions) of one clock edge concurrently.
+//
+// run() executes task 0..n-1 and returns when all of them are done. Tasks
+// are handed out in index order, and a task that is about to touch state
+// it shares with other tasks in an order-sensitive way (functional memory,
+// interconnect injection, request uids, kernel completion) calls ordered()
+// first: this waits until every lower-numbered task has finished, so the
+// shared side effects happen in exactly the order of the serial loop.
+// Commutative updates (counters, accumulated stats) only need add() or
+// lock()/unlock(). Outside of run() all of these are no-ops.
+//--------------------------------------------------------------------
+class sim_thread_pool {
+public:
+    typedef void (*task_t)( void *arg, unsigned idx );
+
+    sim_thread_pool( unsigned n_threads );
+    ~sim_thread_pool();
+
+    unsigned num_threads() const { return m_n_threads; }
+    void run( unsigned n_tasks, task_t fn, void *arg );
+
+    static bool in_task();
+    static void ordered();
+    static void lock();
+    static void unlock();
+    template<class T, class U> static void add( T &counter, U n )
+    {
+        if( in_task() )
+            __sync_fetch_and_add(&counter, (T)n);
+        else
+            counter += n;
+    }
+
+private:
+    static void *worker_main( void *pool );
+    void worker();
+    void execute_tasks();
+    void task_done( unsigned idx );
+    void wait_lower( unsigned idx );
+
+    unsigned m_n_threads;
+    std::vector<pthread_t> m_threads;
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_start_cond;
+    pthread_cond_t m_done_cond;
+    pthread_mutex_t m_shared_mutex;
+
+    unsigned long long m_generation;
+    bool m_exit;
+    task_t m_fn;
+    void *m_arg;
+    volatile unsigned m_n_tasks;
+    volatile unsigned m_next_task;
+    unsigned m_done_prefix;         // tasks [0, m_done_prefix) have finished
+    unsigned m_n_waiting;
+    std::vector<bool> m_task_done;
+};
+
+#endif
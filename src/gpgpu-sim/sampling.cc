@@ -0,0 +1,325 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "sampling.h"
+#include "gpu-sim.h"
+#include "shader.h"
+#include "l2cache.h"
+#include "addrdec.h"
+#include "mydelayqueue.h"
+#include "../cuda-sim/cuda-sim.h"
+
+extern unsigned long long  gpu_sim_cycle;
+extern unsigned long long  gpu_tot_sim_cycle;
+
+void sampling_config::reg_options( option_parser_t opp )
+{
+    option_parser_register(opp, "-gpgpu_sampling", OPT_INT32, &m_mode,
+                "Sampled simulation (0 = off, 1 = fast-forward whole kernels, 2 = fast-forward instruction intervals)",
+                "0");
+    option_parser_register(opp, "-gpgpu_sampling_kernels", OPT_CSTR, &m_kernel_list_string,
+                "Kernel launch uids simulated in detail with -gpgpu_sampling 1, e.g. 1-3,7 (none = use -gpgpu_sampling_kernel_period)",
+                "none");
+    option_parser_register(opp, "-gpgpu_sampling_kernel_period", OPT_UINT32, &m_kernel_period,
+                "With -gpgpu_sampling 1 and no kernel list, simulate one of every N kernels in detail",
+                "1");
+    option_parser_register(opp, "-gpgpu_sampling_interval", OPT_CSTR, &m_interval_string,
+                "Instructions per interval with -gpgpu_sampling 2 {<fast-forward>:<detailed warm-up>:<detailed window>}",
+                "9000000:100000:1000000");
+    option_parser_register(opp, "-gpgpu_sampling_warmup", OPT_BOOL, &m_warmup,
+                "Warm the L1D/L2 tags and the link compressor history while fast-forwarding",
+                "1");
+    option_parser_register(opp, "-gpgpu_sampling_confidence", OPT_UINT32, &m_confidence,
+                "Confidence level of the reported intervals in percent (90, 95 or 99)",
+                "95");
+}
+
+void sampling_config::init()
+{
+    if( !m_kernel_list.parse(m_kernel_list_string) ) {
+        printf("GPGPU-Sim uArch: error while parsing -gpgpu_sampling_kernels \"%s\"\n", m_kernel_list_string);
+        abort();
+    }
+    if( m_kernel_period == 0 )
+        m_kernel_period = 1;
+
+    m_ff_insn = m_warm_insn = m_detail_insn = 0;
+    if( sscanf(m_interval_string,"%llu:%llu:%llu",&m_ff_insn,&m_warm_insn,&m_detail_insn) != 3 || m_detail_insn == 0 ) {
+        printf("GPGPU-Sim uArch: error while parsing -gpgpu_sampling_interval \"%s\"\n", m_interval_string);
+        abort();
+    }
+    if( m_confidence != 90 && m_confidence != 95 && m_confidence != 99 ) {
+        printf("GPGPU-Sim uArch: -gpgpu_sampling_confidence must be 90, 95 or 99\n");
+        abort();
+    }
+}
+
+bool sampling_config::detailed_kernel( unsigned uid ) const
+{
+    if( m_kernel_list.empty() )
+        return ((uid - 1) % m_kernel_period) == 0;
+    return m_kernel_list.contains(uid);
+}
+
+sampling_controller::sampling_controller( const sampling_config &config, class gpgpu_sim *gpu )
+    : m_config(config), m_gpu(gpu)
+{
+    m_phase = FAST_FORWARD;
+    m_fast_forwarding = false;
+    m_warm_sid = 0;
+    m_phase_start_insn = 0;
+    m_ff_phase_insn = 0;
+    memset(&m_window_start,0,sizeof(m_window_start));
+    m_ff_insn = 0;
+    m_ff_cta = 0;
+    m_ff_kernel = 0;
+    m_warm_access = 0;
+}
+
+bool sampling_controller::fast_forward_kernel( const kernel_info_t &kernel ) const
+{
+    return m_config.m_mode == SAMPLING_KERNEL && !m_config.detailed_kernel(kernel.get_uid());
+}
+
+void sampling_controller::fast_forward( kernel_info_t &kernel )
+{
+    unsigned long long start_insn = m_ff_insn;
+    while( !kernel.no_more_ctas_to_run() )
+        run_functional_cta(kernel);
+    m_ff_kernel++;
+    printf("GPGPU-Sim uArch: sampling fast-forwarded kernel %u \'%s\' (%llu insn)\n",
+           kernel.get_uid(), kernel.name().c_str(), m_ff_insn - start_insn);
+    print(stdout);
+}
+
+void sampling_controller::issue_block2core()
+{
+    if( m_config.m_mode != SAMPLING_INTERVAL )
+        return;
+    while( m_phase == FAST_FORWARD ) {
+        if( m_ff_phase_insn >= m_config.m_ff_insn ) {
+            m_phase = DETAIL_WARMUP;
+            m_phase_start_insn = m_gpu->gpu_tot_sim_insn + m_gpu->gpu_sim_insn;
+            break;
+        }
+        kernel_info_t *kernel = m_gpu->select_kernel();
+        if( !kernel )
+            break;
+        run_functional_cta(*kernel);
+        // no shader core may be bound to the kernel if all its CTAs were fast-forwarded
+        if( kernel->no_more_ctas_to_run() && !kernel->running() )
+            m_gpu->set_kernel_done(kernel);
+    }
+}
+
+void sampling_controller::cycle()
+{
+    if( m_config.m_mode != SAMPLING_INTERVAL )
+        return;
+    unsigned long long insn = m_gpu->gpu_tot_sim_insn + m_gpu->gpu_sim_insn;
+    if( m_phase == DETAIL_WARMUP && (insn - m_phase_start_insn) >= m_config.m_warm_insn ) {
+        m_phase = DETAIL;
+        m_phase_start_insn = insn;
+        open_window();
+    } else if( m_phase == DETAIL && (insn - m_phase_start_insn) >= m_config.m_detail_insn ) {
+        close_window();
+        m_phase = FAST_FORWARD;
+        m_ff_phase_insn = 0;
+    }
+}
+
+void sampling_controller::kernel_begin()
+{
+    if( m_config.m_mode == SAMPLING_KERNEL )
+        open_window();
+}
+
+void sampling_controller::kernel_end()
+{
+    if( m_config.m_mode == SAMPLING_KERNEL ) {
+        close_window();
+        open_window();
+    }
+}
+
+void sampling_controller::run_functional_cta( kernel_info_t &kernel )
+{
+    m_fast_forwarding = true;
+    functionalCoreSim cta(&kernel, m_gpu, m_gpu->getShaderCoreConfig()->warp_size);
+    cta.execute();
+    m_fast_forwarding = false;
+    m_ff_cta++;
+    // spread the fast-forwarded CTAs over the shader cores like the CTA scheduler would
+    m_warm_sid = (m_warm_sid + 1) % m_gpu->getShaderCoreConfig()->num_shader();
+}
+
+void sampling_controller::functional_insn( warp_inst_t &inst )
+{
+    m_ff_insn += inst.active_count();
+    m_ff_phase_insn += inst.active_count();
+    if( !m_config.m_warmup )
+        return;
+    if( !inst.is_load() && !inst.is_store() )
+        return;
+    inst.generate_mem_accesses();
+    unsigned time = gpu_sim_cycle + gpu_tot_sim_cycle;
+    while( !inst.accessq_empty() ) {
+        warm_access(inst.accessq_back(), time);
+        inst.accessq_pop_back();
+    }
+}
+
+void sampling_controller::warm_access( const mem_access_t &access, unsigned time )
+{
+    const shader_core_config *shader_config = m_gpu->getShaderCoreConfig();
+    const memory_config *mem_config = m_gpu->getMemoryConfig();
+    new_addr_type addr = access.get_addr();
+    bool is_write = access.is_write();
+    m_warm_access++;
+
+    // L1D: loads allocate, stores are written through to L2 (constant/texture L1s are not warmed)
+    switch( access.get_type() ) {
+    case GLOBAL_ACC_R:
+    case LOCAL_ACC_R:
+        if( !(access.get_type() == GLOBAL_ACC_R && shader_config->gmem_skip_L1D) ) {
+            bool wb = false;
+            cache_block_t evicted;
+            simt_core_cluster *cluster = m_gpu->m_cluster[shader_config->sid_to_cluster(m_warm_sid)];
+            enum cache_request_status status = cluster->warm_L1D(m_warm_sid,addr,false,time,wb,evicted);
+            if( status == HIT || status == HIT_RESERVED )
+                return;
+        }
+        break;
+    default:
+        break;
+    }
+
+    addrdec_t tlx;
+    mem_config->m_address_mapping.addrdec_tlx(addr,&tlx);
+    m_gpu->m_memory_sub_partition[tlx.sub_partition]->warm(addr,is_write,time);
+}
+
+void sampling_controller::take_snapshot( snapshot_t &s ) const
+{
+    s.insn = m_gpu->gpu_tot_sim_insn + m_gpu->gpu_sim_insn;
+    s.cycle = gpu_tot_sim_cycle + gpu_sim_cycle;
+    s.link_transfer_flit = 0;
+    s.link_total_flit = 0;
+    for( unsigned i=0; i < m_gpu->getMemoryConfig()->m_n_mem_link; i++ )
+        m_gpu->m_memory_link[i]->get_flit_cnt(s.link_transfer_flit,s.link_total_flit);
+}
+
+void sampling_controller::open_window()
+{
+    take_snapshot(m_window_start);
+}
+
+void sampling_controller::close_window()
+{
+    snapshot_t now;
+    take_snapshot(now);
+    if( now.cycle <= m_window_start.cycle || now.insn <= m_window_start.insn )
+        return;
+    snapshot_t delta;
+    delta.insn = now.insn - m_window_start.insn;
+    delta.cycle = now.cycle - m_window_start.cycle;
+    delta.link_transfer_flit = now.link_transfer_flit - m_window_start.link_transfer_flit;
+    delta.link_total_flit = now.link_total_flit - m_window_start.link_total_flit;
+    m_windows.push_back(delta);
+}
+
+// two-sided Student t quantile for n samples (n-1 degrees of freedom)
+double sampling_controller::t_value( unsigned n ) const
+{
+    static const double t90[30] = { 6.314, 2.920, 2.353, 2.132, 2.015, 1.943, 1.895, 1.860, 1.833, 1.812,
+                                    1.796, 1.782, 1.771, 1.761, 1.753, 1.746, 1.740, 1.734, 1.729, 1.725,
+                                    1.721, 1.717, 1.714, 1.711, 1.708, 1.706, 1.703, 1.701, 1.699, 1.697 };
+    static const double t95[30] = { 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+    static const double t99[30] = { 63.657, 9.925, 5.841, 4.604, 4.032, 3.707, 3.499, 3.355, 3.250, 3.169,
+                                    3.106, 3.055, 3.012, 2.977, 2.947, 2.921, 2.898, 2.878, 2.861, 2.845,
+                                    2.831, 2.819, 2.807, 2.797, 2.787, 2.779, 2.771, 2.763, 2.756, 2.750 };
+    assert( n > 1 );
+    unsigned df = n - 1;
+    switch( m_config.m_confidence ) {
+    case 90: return (df <= 30)? t90[df-1] : 1.645;
+    case 99: return (df <= 30)? t99[df-1] : 2.576;
+    default: return (df <= 30)? t95[df-1] : 1.960;
+    }
+}
+
+static void mean_ci( const std::vector<double> &v, double t, double &mean, double &half_width )
+{
+    mean = 0;
+    for( unsigned i=0; i < v.size(); i++ )
+        mean += v[i];
+    mean /= v.size();
+    half_width = 0;
+    if( v.size() > 1 ) {
+        double var = 0;
+        for( unsigned i=0; i < v.size(); i++ )
+            var += (v[i] - mean) * (v[i] - mean);
+        var /= (v.size() - 1);
+        half_width = t * sqrt(var / v.size());
+    }
+}
+
+void sampling_controller::print( FILE *fout ) const
+{
+    if( !enabled() )
+        return;
+    snapshot_t now;
+    take_snapshot(now);
+
+    fprintf(fout, "sampling_mode = %d\n", m_config.m_mode);
+    fprintf(fout, "sampling_ff_kernels = %u\n", m_ff_kernel);
+    fprintf(fout, "sampling_ff_ctas = %llu\n", m_ff_cta);
+    fprintf(fout, "sampling_ff_insn = %llu\n", m_ff_insn);
+    fprintf(fout, "sampling_warm_accesses = %llu\n", m_warm_access);
+    fprintf(fout, "sampling_detailed_insn = %llu\n", now.insn);
+    fprintf(fout, "sampling_detailed_cycle = %llu\n", now.cycle);
+    fprintf(fout, "sampling_windows = %u\n", (unsigned)m_windows.size());
+    if( m_windows.empty() )
+        return;
+
+    // per-window CPI is averaged: fast-forwarded time is linear in CPI, not IPC
+    std::vector<double> cpi, ipc, link_bw, link_util;
+    for( unsigned i=0; i < m_windows.size(); i++ ) {
+        const snapshot_t &w = m_windows[i];
+        cpi.push_back((double)w.cycle / w.insn);
+        ipc.push_back((double)w.insn / w.cycle);
+        // link FLITs are 128 bits (oneway_link::FLIT_SIZE)
+        link_bw.push_back(16.0 * w.link_transfer_flit / w.cycle);
+        link_util.push_back(w.link_total_flit? (double)w.link_transfer_flit / w.link_total_flit : 0.0);
+    }
+    double t = (m_windows.size() > 1)? t_value(m_windows.size()) : 0.0;
+    double cpi_mean, cpi_hw, ipc_mean, ipc_hw, bw_mean, bw_hw, util_mean, util_hw;
+    mean_ci(cpi, t, cpi_mean, cpi_hw);
+    mean_ci(ipc, t, ipc_mean, ipc_hw);
+    mean_ci(link_bw, t, bw_mean, bw_hw);
+    mean_ci(link_util, t, util_mean, util_hw);
+
+    double ff_cycle = m_ff_insn * cpi_mean;
+    double ff_cycle_hw = m_ff_insn * cpi_hw;
+    double tot_insn = (double)now.insn + m_ff_insn;
+    double tot_cycle = now.cycle + ff_cycle;
+    double tot_cycle_lo = now.cycle + ff_cycle - ff_cycle_hw;
+    double tot_cycle_hi = now.cycle + ff_cycle + ff_cycle_hw;
+
+    fprintf(fout, "sampling_confidence = %u%%%s\n", m_config.m_confidence, (m_windows.size() > 1)? "" : " (single window, no interval)");
+    fprintf(fout, "sampling_window_ipc = %12.4f +/- %.4f\n", ipc_mean, ipc_hw);
+    fprintf(fout, "sampling_window_cpi = %12.4f +/- %.4f\n", cpi_mean, cpi_hw);
+    fprintf(fout, "sampling_window_link_bw = %12.4f +/- %.4f (B/cycle)\n", bw_mean, bw_hw);
+    fprintf(fout, "sampling_window_link_util = %12.4f +/- %.4f\n", util_mean, util_hw);
+    fprintf(fout, "sampling_est_tot_insn = %.0f\n", tot_insn);
+    fprintf(fout, "sampling_est_tot_cycle = %.0f [%.0f, %.0f]\n", tot_cycle, tot_cycle_lo, tot_cycle_hi);
+    fprintf(fout, "sampling_est_tot_ipc = %12.4f [%.4f, %.4f]\n", tot_insn / tot_cycle,
+            tot_insn / tot_cycle_hi, (tot_cycle_lo > 0)? tot_insn / tot_cycle_lo : 0.0);
+    fprintf(fout, "sampling_est_tot_link_bytes = %.0f +/- %.0f\n",
+            16.0 * now.link_transfer_flit + bw_mean * ff_cycle,
+            bw_hw * ff_cycle + bw_mean * ff_cycle_hw);
+}
@@ -0,0 +1,112 @@
+#ifndef SAMPLING_H
+#define SAMPLING_H
+
+#include <stdio.h>
+#include <vector>
+#include <utility>
+#include "../option_parser.h"
+#include "../abstract_hardware_model.h"
+#include "gpu-misc.h"
+
+//--------------------------------------------------------------------
+// Sampled simulation
+//
+// Kernel sampling (mode 1) runs the kernels that are not selected for
+// detailed simulation at functional speed. Interval sampling (mode 2)
+// repeats {fast-forward, detailed warm-up, detailed window} inside the
+// timing run; during fast-forward the CTAs are executed functionally
+// instead of being issued to a shader core. In both modes the functional
+// instructions warm the L1D/L2 tag arrays and the link compressor history,
+// and the detailed windows are used to extrapolate cycles, IPC and link
+// bandwidth for the fast-forwarded part.
+//--------------------------------------------------------------------
+enum sampling_mode_t {
+    SAMPLING_OFF = 0,
+    SAMPLING_KERNEL = 1,
+    SAMPLING_INTERVAL = 2
+};
+
+struct sampling_config {
+    void reg_options( option_parser_t opp );
+    void init();
+
+    bool enabled() const { return m_mode != SAMPLING_OFF; }
+    bool detailed_kernel( unsigned uid ) const;
+
+    int m_mode;
+    char *m_kernel_list_string;
+    unsigned m_kernel_period;
+    char *m_interval_string;
+    bool m_warmup;
+    unsigned m_confidence;
+
+    kernel_uid_list m_kernel_list;      // launch uid ranges simulated in detail
+    unsigned long long m_ff_insn;       // functional instructions per fast-forward phase
+    unsigned long long m_warm_insn;     // detailed (unmeasured) instructions before a window
+    unsigned long long m_detail_insn;   // measured instructions per window
+};
+
+class sampling_controller {
+public:
+    sampling_controller( const sampling_config &config, class gpgpu_sim *gpu );
+
+    bool enabled() const { return m_config.enabled(); }
+
+    // kernel sampling: called when a kernel launch reaches the GPU
+    bool fast_forward_kernel( const kernel_info_t &kernel ) const;
+    void fast_forward( kernel_info_t &kernel );
+
+    // interval sampling: called from the timing model on the core clock
+    void issue_block2core();
+    void cycle();
+
+    // detailed kernel boundaries (gpgpu_sim::init / gpgpu_sim::update_stats)
+    void kernel_begin();
+    void kernel_end();
+
+    // called by the functional core for every executed warp instruction
+    bool fast_forwarding() const { return m_fast_forwarding; }
+    void functional_insn( warp_inst_t &inst );
+
+    void print( FILE *fout ) const;
+
+private:
+    enum phase_t {
+        FAST_FORWARD,
+        DETAIL_WARMUP,
+        DETAIL
+    };
+
+    struct snapshot_t {
+        unsigned long long insn;
+        unsigned long long cycle;
+        unsigned long long link_transfer_flit;
+        unsigned long long link_total_flit;
+    };
+
+    void run_functional_cta( kernel_info_t &kernel );
+    void warm_access( const mem_access_t &access, unsigned time );
+    void take_snapshot( snapshot_t &s ) const;
+    void open_window();
+    void close_window();
+    double t_value( unsigned n ) const;
+
+    const sampling_config &m_config;
+    class gpgpu_sim *m_gpu;
+
+    phase_t m_phase;
+    bool m_fast_forwarding;
+    unsigned m_warm_sid;
+    unsigned long long m_phase_start_insn;
+    unsigned long long m_ff_phase_insn;
+    snapshot_t m_window_start;
+    std::vector<snapshot_t> m_windows;  // per-window deltas
+
+    // fast-forward totals
+    unsigned long long m_ff_insn;
+    unsigned long long m_ff_cta;
+    unsigned m_ff_kernel;
+    unsigned long long m_warm_access;
+};
+
+#endif
@@ -31,53 +31,76 @@
 #include "shader_trace.h"
 
 
+extern unsigned g_max_regs_per_thread;
+
 //Constructor
 Scoreboard::Scoreboard( unsigned sid, unsigned n_warps )
-: longopregs()
 {
 	m_sid = sid;
-	//Initialize size of table
-	reg_table.resize(n_warps);
-	longopregs.resize(n_warps);
+	m_n_warps = n_warps;
+	m_n_words = 0;
+	//Initialize size of table from the largest register number parsed so far
+	resize(g_max_regs_per_thread+1);
+	m_n_pending.resize(n_warps, 0);
+}
+
+void Scoreboard::resize(unsigned n_regs)
+{
+	unsigned n_words = (n_regs + WORD_BITS - 1) / WORD_BITS;
+	if( n_words <= m_n_words ) 
+		return;
+	std::vector<word_t> regs(m_n_warps * n_words, 0);
+	std::vector<word_t> longops(m_n_warps * n_words, 0);
+	for( unsigned w=0; w < m_n_warps; w++ ) {
+		for( unsigned i=0; i < m_n_words; i++ ) {
+			regs[w*n_words + i] = reg_table[w*m_n_words + i];
+			longops[w*n_words + i] = longopregs[w*m_n_words + i];
+		}
+	}
+	reg_table.swap(regs);
+	longopregs.swap(longops);
+	m_n_words = n_words;
 }
 
 // Print scoreboard contents
 void Scoreboard::printContents() const
 {
 	printf("scoreboard contents (sid=%d): \n", m_sid);
-	for(unsigned i=0; i<reg_table.size(); i++) {
-		if(reg_table[i].size() == 0 ) continue;
+	for(unsigned i=0; i<m_n_warps; i++) {
+		if(m_n_pending[i] == 0 ) continue;
 		printf("  wid = %2d: ", i);
-		std::set<unsigned>::const_iterator it;
-		for( it=reg_table[i].begin() ; it != reg_table[i].end(); it++ )
-			printf("%u ", *it);
+		for( unsigned r=0; r < m_n_words*WORD_BITS; r++ ) 
+			if( test(reg_table, i, r) ) 
+				printf("%u ", r);
 		printf("\n");
 	}
 }
 
 void Scoreboard::reserveRegister(unsigned wid, unsigned regnum) 
 {
-	if( !(reg_table[wid].find(regnum) == reg_table[wid].end()) ){
+	if( test(reg_table, wid, regnum) ){
 		printf("Error: trying to reserve an already reserved register (sid=%d, wid=%d, regnum=%d).", m_sid, wid, regnum);
         abort();
 	}
     SHADER_DPRINTF( SCOREBOARD,
                     "Reserved Register - warp:%d, reg: %d\n", wid, regnum );
-	reg_table[wid].insert(regnum);
+	set(reg_table, wid, regnum);
+	m_n_pending[wid]++;
 }
 
 // Unmark register as write-pending
 void Scoreboard::releaseRegister(unsigned wid, unsigned regnum) 
 {
-	if( !(reg_table[wid].find(regnum) != reg_table[wid].end()) ) 
+	if( !test(reg_table, wid, regnum) ) 
         return;
     SHADER_DPRINTF( SCOREBOARD,
                     "Release register - warp:%d, reg: %d\n", wid, regnum );
-	reg_table[wid].erase(regnum);
+	clear(reg_table, wid, regnum);
+	m_n_pending[wid]--;
 }
 
 const bool Scoreboard::islongop (unsigned warp_id,unsigned regnum) {
-	return longopregs[warp_id].find(regnum) != longopregs[warp_id].end();
+	return test(longopregs, warp_id, regnum);
 }
 
 void Scoreboard::reserveRegisters(const class warp_inst_t* inst) 
@@ -106,7 +129,7 @@ void Scoreboard::reserveRegisters(const class warp_inst_t* inst)
                                 "New longopreg marked - warp:%d, reg: %d\n",
                                 inst->warp_id(),
                                 inst->out[r] );
-                longopregs[inst->warp_id()].insert(inst->out[r]);
+                set(longopregs, inst->warp_id(), inst->out[r]);
             }
     	}
     }
@@ -122,7 +145,7 @@ void Scoreboard::releaseRegisters(const class warp_inst_t *inst)
                             inst->warp_id(),
                             inst->out[r] );
             releaseRegister(inst->warp_id(), inst->out[r]);
-            longopregs[inst->warp_id()].erase(inst->out[r]);
+            clear(longopregs, inst->warp_id(), inst->out[r]);
         }
     }
 }
@@ -135,31 +158,17 @@ void Scoreboard::releaseRegisters(const class warp_inst_t *inst)
  **/ 
 bool Scoreboard::checkCollision( unsigned wid, const class inst_t *inst ) const
 {
-	// Get list of all input and output registers
-	std::set<int> inst_regs;
-
-	if(inst->out[0] > 0) inst_regs.insert(inst->out[0]);
-	if(inst->out[1] > 0) inst_regs.insert(inst->out[1]);
-	if(inst->out[2] > 0) inst_regs.insert(inst->out[2]);
-	if(inst->out[3] > 0) inst_regs.insert(inst->out[3]);
-	if(inst->in[0] > 0) inst_regs.insert(inst->in[0]);
-	if(inst->in[1] > 0) inst_regs.insert(inst->in[1]);
-	if(inst->in[2] > 0) inst_regs.insert(inst->in[2]);
-	if(inst->in[3] > 0) inst_regs.insert(inst->in[3]);
-	if(inst->pred > 0) inst_regs.insert(inst->pred);
-	if(inst->ar1 > 0) inst_regs.insert(inst->ar1);
-	if(inst->ar2 > 0) inst_regs.insert(inst->ar2);
-
-	// Check for collision, get the intersection of reserved registers and instruction registers
-	std::set<int>::const_iterator it2;
-	for ( it2=inst_regs.begin() ; it2 != inst_regs.end(); it2++ )
-		if(reg_table[wid].find(*it2) != reg_table[wid].end()) {
-			return true;
-		}
-	return false;
-}
-
-bool Scoreboard::pendingWrites(unsigned wid) const
-{
-	return !reg_table[wid].empty();
+	// OR together the pending bits of all input and output registers
+	const word_t *pending = m_n_words ? &reg_table[wid*m_n_words] : NULL;
+	unsigned regs[11] = { inst->out[0], inst->out[1], inst->out[2], inst->out[3],
+	                 inst->in[0], inst->in[1], inst->in[2], inst->in[3],
+	                 (unsigned)inst->pred, (unsigned)inst->ar1, (unsigned)inst->ar2 };
+	word_t hit = 0;
+	for( unsigned i=0; i < 11; i++ ) {
+		unsigned r = regs[i];
+		// unset (0) and negative (huge) register numbers are skipped
+		if( r > 0 && r / WORD_BITS < m_n_words ) 
+			hit |= pending[r / WORD_BITS] >> (r % WORD_BITS);
+	}
+	return hit & 1;
 }
@@ -28,7 +28,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <vector>
-#include <set>
 #include "assert.h"
 
 #ifndef SCOREBOARD_H_
@@ -45,20 +44,46 @@ public:
     void releaseRegister(unsigned wid, unsigned regnum);
 
     bool checkCollision(unsigned wid, const inst_t *inst) const;
-    bool pendingWrites(unsigned wid) const;
+    bool pendingWrites(unsigned wid) const { return m_n_pending[wid] != 0; }
     void printContents() const;
     const bool islongop(unsigned warp_id, unsigned regnum);
 private:
+    typedef unsigned long long word_t;
+    static const unsigned WORD_BITS = 64;
+
     void reserveRegister(unsigned wid, unsigned regnum);
+    void resize(unsigned n_regs);
     int get_sid() const { return m_sid; }
 
+    bool test(const std::vector<word_t> &table, unsigned wid, unsigned regnum) const
+    {
+        unsigned w = regnum / WORD_BITS;
+        if( w >= m_n_words ) 
+            return false;
+        return (table[wid*m_n_words + w] >> (regnum % WORD_BITS)) & 1;
+    }
+    void set(std::vector<word_t> &table, unsigned wid, unsigned regnum)
+    {
+        if( regnum / WORD_BITS >= m_n_words ) 
+            resize(regnum+1);
+        table[wid*m_n_words + regnum/WORD_BITS] |= (word_t)1 << (regnum % WORD_BITS);
+    }
+    void clear(std::vector<word_t> &table, unsigned wid, unsigned regnum)
+    {
+        if( regnum / WORD_BITS < m_n_words ) 
+            table[wid*m_n_words + regnum/WORD_BITS] &= ~((word_t)1 << (regnum % WORD_BITS));
+    }
+
     unsigned m_sid;
+    unsigned m_n_warps;
+    unsigned m_n_words; // words per warp, grows if a kernel with more registers is loaded
 
     // keeps track of pending writes to registers
-    // indexed by warp id, reg_id => pending write count
-    std::vector< std::set<unsigned> > reg_table;
+    // one bit per register, m_n_words words per warp
+    std::vector<word_t> reg_table;
     //Register that depend on a long operation (global, local or tex memory)
-    std::vector< std::set<unsigned> > longopregs;
+    std::vector<word_t> longopregs;
+    std::vector<unsigned> m_n_pending; // number of registers with a pending write, per warp
 };
 
 
@@ -46,6 +46,7 @@
 #include <limits.h>
 #include "traffic_breakdown.h"
 #include "shader_trace.h"
+#include "parallel.h"
 
 #define PRIORITIZE_MSHR_OVER_WB 1
 #define MAX(a,b) (((a)>(b))?(a):(b))
@@ -209,6 +210,11 @@ shader_core_ctx::shader_core_ctx( class gpgpu_sim *gpu,
     for ( int i = 0; i < m_config->gpgpu_num_sched_per_core; ++i ) {
         schedulers[i]->done_adding_supervised_warps();
     }
+
+    // the two level scheduler moves warps between its lists every cycle, even when stalled
+    m_can_sleep = m_config->gpgpu_core_cycle_skip && scheduler != CONCRETE_SCHEDULER_TWO_LEVEL_ACTIVE;
+    m_sleeping = false;
+    m_sleep_distro.resize(schedulers.size(), 0);
     
     //op collector configuration
     enum { SP_CUS, SFU_CUS, MEM_CUS, GEN_CUS };
@@ -300,6 +306,7 @@ shader_core_ctx::shader_core_ctx( class gpgpu_sim *gpu,
 
 void shader_core_ctx::reinit(unsigned start_thread, unsigned end_thread, bool reset_not_completed ) 
 {
+   wake();
    if( reset_not_completed ) {
        m_not_completed = 0;
        m_active_threads.reset();
@@ -603,6 +610,7 @@ void shader_core_ctx::fetch()
 
             // this code checks if this warp has finished executing and can be reclaimed
             if( m_warp[warp_id].hardware_done() && !m_scoreboard->pendingWrites(warp_id) && !m_warp[warp_id].done_exit() ) {
+                sim_thread_pool::ordered(); // CTA/kernel completion
                 bool did_exit=false;
                 for( unsigned t=0; t<m_config->warp_size;t++) {
                     unsigned tid=warp_id*m_config->warp_size+t;
@@ -641,6 +649,7 @@ void shader_core_ctx::fetch()
                                               m_memory_config );
                 std::list<cache_event> events;
                 enum cache_request_status status = m_L1I->access( (new_addr_type)ppc, mf, gpu_sim_cycle+gpu_tot_sim_cycle,events);
+                mf_trace(MFT_L1, gpu_sim_cycle+gpu_tot_sim_cycle, mf->get_request_uid(), m_sid, status);
                 if( status == MISS ) {
                     m_last_warp_fetched=warp_id;
                     m_warp[warp_id].set_imiss_pending();
@@ -683,6 +692,7 @@ void shader_core_ctx::issue_warp( register_set& pipe_reg_set, const warp_inst_t*
     
     m_warp[warp_id].ibuffer_free();
     assert(next_inst->valid());
+    sim_thread_pool::ordered(); // functional execution touches shared memory spaces
     **pipe_reg = *next_inst; // static instruction information
     (*pipe_reg)->issue( active_mask, warp_id, gpu_tot_sim_cycle + gpu_sim_cycle, m_warp[warp_id].get_dynamic_warp_id() ); // dynamic instruction information
     m_stats->shader_cycle_distro[2+(*pipe_reg)->active_count()]++;
@@ -907,13 +917,30 @@ void scheduler_unit::cycle()
         } 
     }
 
-    // issue stall statistics:
+    // issue stall statistics (keep stalled_cycle_distro() in sync):
     if( !valid_inst ) 
-        m_stats->shader_cycle_distro[0]++; // idle or control hazard
+        sim_thread_pool::add(m_stats->shader_cycle_distro[0], 1); // idle or control hazard
     else if( !ready_inst ) 
-        m_stats->shader_cycle_distro[1]++; // waiting for RAW hazards (possibly due to memory) 
+        sim_thread_pool::add(m_stats->shader_cycle_distro[1], 1); // waiting for RAW hazards (possibly due to memory) 
     else if( !issued_inst ) 
-        m_stats->shader_cycle_distro[2]++; // pipeline stalled
+        sim_thread_pool::add(m_stats->shader_cycle_distro[2], 1); // pipeline stalled
+}
+
+unsigned scheduler_unit::stalled_cycle_distro()
+{
+    // cycle() on a core where no warp can issue, flush or exit: only the
+    // scoreboard can hold back a valid instruction
+    order_warps();
+    for ( std::vector< shd_warp_t* >::const_iterator iter = m_next_cycle_prioritized_warps.begin();
+          iter != m_next_cycle_prioritized_warps.end();
+          iter++ ) {
+        if ( (*iter) == NULL || (*iter)->done_exit() ) 
+            continue;
+        unsigned warp_id = (*iter)->get_warp_id();
+        if( !warp(warp_id).waiting() && !warp(warp_id).ibuffer_empty() && warp(warp_id).ibuffer_next_inst() ) 
+            return 1; // waiting for RAW hazards
+    }
+    return 0; // idle
 }
 
 void scheduler_unit::do_on_warp_issued( unsigned warp_id,
@@ -1193,6 +1220,23 @@ void ldst_unit::get_L1D_sub_stats(struct cache_sub_stats &css) const{
     if(m_L1D)
         m_L1D->get_sub_stats(css);
 }
+enum cache_request_status ldst_unit::warm_L1D( new_addr_type addr, bool dirty, unsigned time, bool &wb, cache_block_t &evicted )
+{
+    if( !m_L1D )
+        return MISS;
+    return m_L1D->warm(addr,time,dirty,wb,evicted);
+}
+void ldst_unit::save_L1D( FILE *fout ) const
+{
+    if( m_L1D )
+        m_L1D->save(fout);
+}
+bool ldst_unit::load_L1D( FILE *fin )
+{
+    if( !m_L1D )
+        return true;
+    return m_L1D->load(fin);
+}
 void ldst_unit::get_L1C_sub_stats(struct cache_sub_stats &css) const{
     if(m_L1C)
         m_L1C->get_sub_stats(css);
@@ -1221,18 +1265,40 @@ void shader_core_ctx::warp_inst_complete(const warp_inst_t &inst)
 	  m_stats->m_num_sim_insn[m_sid] += inst.active_count();
 
   m_stats->m_num_sim_winsn[m_sid]++;
-  m_gpu->gpu_sim_insn += inst.active_count();
-  inst.completed(gpu_tot_sim_cycle + gpu_sim_cycle);
+  sim_thread_pool::add(m_gpu->gpu_sim_insn, inst.active_count());
+  if( sim_thread_pool::in_task() ) {
+      // the ptx line stats are shared by all cores; merged after the parallel step
+      unsigned long long latency = gpu_tot_sim_cycle + gpu_sim_cycle - inst.get_issue_cycle();
+      m_deferred_latency.push_back(std::make_pair(inst.pc, (unsigned)(latency * inst.active_count())));
+  } else {
+      inst.completed(gpu_tot_sim_cycle + gpu_sim_cycle);
+  }
 }
 
-void shader_core_ctx::writeback()
+bool shader_core_ctx::retired_this_cycle() const
+{
+    return m_last_inst_gpu_sim_cycle == gpu_sim_cycle && m_last_inst_gpu_tot_sim_cycle == gpu_tot_sim_cycle;
+}
+
+void shader_core_ctx::commit_deferred_stats()
 {
+    for( unsigned i=0; i < m_deferred_latency.size(); i++ ) 
+        ptx_file_line_stats_add_latency(m_deferred_latency[i].first, m_deferred_latency[i].second);
+    m_deferred_latency.clear();
+}
 
+void shader_core_ctx::update_duty_cycle()
+{
 	unsigned max_committed_thread_instructions=m_config->warp_size * (m_config->pipe_widths[EX_WB]); //from the functional units
 	m_stats->m_pipeline_duty_cycle[m_sid]=((float)(m_stats->m_num_sim_insn[m_sid]-m_stats->m_last_num_sim_insn[m_sid]))/max_committed_thread_instructions;
 
     m_stats->m_last_num_sim_insn[m_sid]=m_stats->m_num_sim_insn[m_sid];
     m_stats->m_last_num_sim_winsn[m_sid]=m_stats->m_num_sim_winsn[m_sid];
+}
+
+void shader_core_ctx::writeback()
+{
+    update_duty_cycle();
 
     warp_inst_t** preg = m_pipeline_reg[EX_WB].get_ready();
     warp_inst_t* pipe_reg = (preg==NULL)? NULL:*preg;
@@ -1259,8 +1325,6 @@ void shader_core_ctx::writeback()
         m_scoreboard->releaseRegisters( pipe_reg );
         m_warp[warp_id].dec_inst_in_pipeline();
         warp_inst_complete(*pipe_reg);
-        m_gpu->gpu_sim_insn_last_update_sid = m_sid;
-        m_gpu->gpu_sim_insn_last_update = gpu_sim_cycle;
         m_last_inst_gpu_sim_cycle = gpu_sim_cycle;
         m_last_inst_gpu_tot_sim_cycle = gpu_tot_sim_cycle;
         pipe_reg->clear();
@@ -1338,6 +1402,7 @@ mem_stage_stall_type ldst_unit::process_memory_access_queue( cache_t *cache, war
     mem_fetch *mf = m_mf_allocator->alloc(inst,inst.accessq_back());
     std::list<cache_event> events;
     enum cache_request_status status = cache->access(mf->get_addr(),mf,gpu_sim_cycle+gpu_tot_sim_cycle,events);
+    mf_trace(MFT_L1, gpu_sim_cycle+gpu_tot_sim_cycle, mf->get_request_uid(), mf->get_sid(), status);
     return process_cache_access( cache, mf->get_addr(), inst, events, mf, status );
 }
 
@@ -1352,7 +1417,7 @@ bool ldst_unit::constant_cycle( warp_inst_t &inst, mem_stage_stall_type &rc_fail
       rc_fail = fail; //keep other fails if this didn't fail.
       fail_type = C_MEM;
       if (rc_fail == BK_CONF or rc_fail == COAL_STALL) {
-         m_stats->gpgpu_n_cmem_portconflict++; //coal stalls aren't really a bank conflict, but this maintains previous behavior.
+         sim_thread_pool::add(m_stats->gpgpu_n_cmem_portconflict, 1); //coal stalls aren't really a bank conflict, but this maintains previous behavior.
       }
    }
    return inst.accessq_empty(); //done if empty.
@@ -1712,6 +1777,7 @@ void ldst_unit::writeback()
             if( !m_pipeline_reg[0]->empty() ) {
                 m_next_wb = *m_pipeline_reg[0];
                 if(m_next_wb.isatomic()) {
+                    sim_thread_pool::ordered();
                     m_next_wb.do_atomic();
                     m_core->decrement_atomic_count(m_next_wb.warp_id(), m_next_wb.active_count());
                 }
@@ -1792,6 +1858,20 @@ void ldst_unit::issue( register_set &reg_set )
    pipelined_simd_unit::issue(reg_set);
 }
 */
+bool ldst_unit::idle() const
+{
+    if( !pipelined_simd_unit::idle() || !m_response_fifo.empty() || m_next_global || !m_next_wb.empty() ) 
+        return false;
+    return m_L1T->idle() && m_L1C->idle() && (!m_L1D || m_L1D->idle());
+}
+
+void ldst_unit::idle_cycle( unsigned long long n )
+{
+    m_operand_collector->idle_step(n);
+    m_L1C->idle_cycle(n);
+    if( m_L1D ) m_L1D->idle_cycle(n);
+}
+
 void ldst_unit::cycle()
 {
    writeback();
@@ -1860,8 +1940,8 @@ void ldst_unit::cycle()
 
    if (!done) { // log stall types and return
       assert(rc_fail != NO_RC_FAIL);
-      m_stats->gpgpu_n_stall_shd_mem++;
-      m_stats->gpu_stall_shd_mem_breakdown[type][rc_fail]++;
+      sim_thread_pool::add(m_stats->gpgpu_n_stall_shd_mem, 1);
+      sim_thread_pool::add(m_stats->gpu_stall_shd_mem_breakdown[type][rc_fail], 1);
       return;
    }
 
@@ -2448,6 +2528,67 @@ void shader_core_ctx::cycle()
     issue();
     decode();
     fetch();
+
+    if( m_can_sleep && quiescent() ) {
+        m_sleeping = true;
+        for( unsigned i=0; i < schedulers.size(); i++ ) 
+            m_sleep_distro[i] = schedulers[i]->stalled_cycle_distro();
+    }
+}
+
+// True if the next cycle() cannot change any state other than stats: the
+// pipeline is empty and every warp is done, waiting, or blocked on the
+// scoreboard by a register that only a memory response can release.
+bool shader_core_ctx::quiescent()
+{
+    if( m_inst_fetch_buffer.m_valid || !m_L1I->idle() ) 
+        return false;
+    for( unsigned i=0; i < N_PIPELINE_STAGES; i++ ) 
+        if( m_pipeline_reg[i].has_ready() ) 
+            return false;
+    for( unsigned i=0; i < num_result_bus; i++ ) 
+        if( m_result_bus[i]->any() ) 
+            return false;
+    for( unsigned n=0; n < m_num_function_units; n++ ) 
+        if( !m_fu[n]->idle() ) 
+            return false;
+    if( !m_operand_collector.idle() ) 
+        return false;
+    for( unsigned w=0; w < m_config->max_warps_per_shader; w++ ) {
+        shd_warp_t &warp = m_warp[w];
+        if( warp.done_exit() ) 
+            continue;
+        if( warp.hardware_done() && !m_scoreboard->pendingWrites(w) ) 
+            return false; // fetch() would retire the warp
+        if( !warp.functional_done() && !warp.imiss_pending() && warp.ibuffer_empty() ) 
+            return false; // fetch() would access the L1I
+        if( warp.get_membar() && !m_scoreboard->pendingWrites(w) ) 
+            return false; // waiting() would clear the membar
+        if( warp.waiting() || warp.ibuffer_empty() ) 
+            continue;
+        const warp_inst_t *pI = warp.ibuffer_next_inst();
+        if( !pI ) {
+            if( warp.ibuffer_next_valid() ) 
+                return false; // flush
+            continue;
+        }
+        unsigned pc,rpc;
+        m_simt_stack[w]->get_pdom_stack_top_info(&pc,&rpc);
+        if( pc != pI->pc || !m_scoreboard->checkCollision(w, pI) ) 
+            return false; // control hazard flush or ready to issue
+    }
+    return true;
+}
+
+void shader_core_ctx::skip_cycles( unsigned long long n )
+{
+    m_stats->shader_cycles[m_sid] += n;
+    update_duty_cycle();
+    for( unsigned f=0; f < m_num_function_units; f++ ) 
+        m_fu[f]->idle_cycle(n * m_fu[f]->clock_multiplier());
+    for( unsigned i=0; i < schedulers.size(); i++ ) 
+        sim_thread_pool::add(m_stats->shader_cycle_distro[m_sleep_distro[i]], n);
+    m_L1I->idle_cycle(n);
 }
 
 // Flushes all content of the cache to memory
@@ -2785,6 +2926,7 @@ bool shader_core_ctx::fetch_unit_response_buffer_full() const
 
 void shader_core_ctx::accept_fetch_response( mem_fetch *mf )
 {
+    wake();
     mf->set_status(IN_SHADER_FETCHED,gpu_sim_cycle+gpu_tot_sim_cycle);
     m_L1I->fill(mf,gpu_sim_cycle+gpu_tot_sim_cycle);
 }
@@ -2796,6 +2938,7 @@ bool shader_core_ctx::ldst_unit_response_buffer_full() const
 
 void shader_core_ctx::accept_ldst_unit_response(mem_fetch * mf) 
 {
+   wake();
    m_ldst_unit->fill(mf);
 }
 
@@ -2823,6 +2966,18 @@ void shader_core_ctx::get_L1I_sub_stats(struct cache_sub_stats &css) const{
 void shader_core_ctx::get_L1D_sub_stats(struct cache_sub_stats &css) const{
     m_ldst_unit->get_L1D_sub_stats(css);
 }
+enum cache_request_status shader_core_ctx::warm_L1D( new_addr_type addr, bool dirty, unsigned time, bool &wb, cache_block_t &evicted )
+{
+    return m_ldst_unit->warm_L1D(addr,dirty,time,wb,evicted);
+}
+void shader_core_ctx::save_L1D( FILE *fout ) const
+{
+    m_ldst_unit->save_L1D(fout);
+}
+bool shader_core_ctx::load_L1D( FILE *fin )
+{
+    return m_ldst_unit->load_L1D(fin);
+}
 void shader_core_ctx::get_L1C_sub_stats(struct cache_sub_stats &css) const{
     m_ldst_unit->get_L1C_sub_stats(css);
 }
@@ -2995,6 +3150,14 @@ bool opndcoll_rfu_t::writeback( const warp_inst_t &inst )
    return true;
 }
 
+bool opndcoll_rfu_t::idle() const
+{
+   for( unsigned n=0; n < m_cu.size(); n++ ) 
+      if( !m_cu[n]->is_free() ) 
+         return false;
+   return m_arbiter.idle();
+}
+
 void opndcoll_rfu_t::dispatch_ready_cu()
 {
    for( unsigned p=0; p < m_dispatch_units.size(); ++p ) {
@@ -3164,6 +3327,7 @@ simt_core_cluster::simt_core_cluster( class gpgpu_sim *gpu,
     m_gpu = gpu;
     m_stats = stats;
     m_memory_stats = mstats;
+    m_last_retire_sid = -1;
     m_core = new shader_core_ctx*[ config->n_simt_cores_per_cluster ];
     for( unsigned i=0; i < config->n_simt_cores_per_cluster; i++ ) {
         unsigned sid = m_config->cid_to_sid(i,m_cluster_id);
@@ -3174,8 +3338,14 @@ simt_core_cluster::simt_core_cluster( class gpgpu_sim *gpu,
 
 void simt_core_cluster::core_cycle()
 {
+    m_last_retire_sid = -1;
     for( std::list<unsigned>::iterator it = m_core_sim_order.begin(); it != m_core_sim_order.end(); ++it ) {
-        m_core[*it]->cycle();
+        if( m_core[*it]->sleeping() ) 
+            m_core[*it]->skip_cycles(1);
+        else
+            m_core[*it]->cycle();
+        if( m_core[*it]->retired_this_cycle() ) 
+            m_last_retire_sid = m_core[*it]->get_sid();
     }
 
     if (m_config->simt_core_sim_order == 1) {
@@ -3183,6 +3353,12 @@ void simt_core_cluster::core_cycle()
     }
 }
 
+void simt_core_cluster::commit_deferred_stats()
+{
+    for( unsigned i=0; i < m_config->n_simt_cores_per_cluster; i++ ) 
+        m_core[i]->commit_deferred_stats();
+}
+
 void simt_core_cluster::reinit()
 {
     for( unsigned i=0; i < m_config->n_simt_cores_per_cluster; i++ ) 
@@ -3227,6 +3403,43 @@ unsigned simt_core_cluster::get_n_active_sms() const
     return n;
 }
 
+bool simt_core_cluster::quiescent( bool cores_stepped ) const
+{
+    if( !m_response_fifo.empty() ) 
+        return false;
+    if( !cores_stepped ) 
+        return true;
+    for( unsigned i=0; i < m_config->n_simt_cores_per_cluster; i++ ) 
+        if( !m_core[i]->sleeping() ) 
+            return false;
+    return true;
+}
+
+void simt_core_cluster::skip_cycles( unsigned long long n )
+{
+    for( unsigned i=0; i < m_config->n_simt_cores_per_cluster; i++ ) 
+        m_core[i]->skip_cycles(n);
+    m_last_retire_sid = -1;
+    if (m_config->simt_core_sim_order == 1) {
+        for( unsigned long long r=0; r < n % m_core_sim_order.size(); r++ ) 
+            m_core_sim_order.splice(m_core_sim_order.end(), m_core_sim_order, m_core_sim_order.begin()); 
+    }
+}
+
+bool simt_core_cluster::can_issue_block()
+{
+    for( unsigned i=0; i < m_config->n_simt_cores_per_cluster; i++ ) {
+        kernel_info_t *kernel = m_core[i]->get_kernel();
+        if( kernel == NULL ) {
+            if( m_core[i]->get_not_completed() == 0 && m_gpu->kernel_ctas_left() ) 
+                return true;
+        } else if( !kernel->no_more_ctas_to_run() && (m_core[i]->get_n_active_cta() < m_config->max_cta(*kernel)) ) {
+            return true;
+        }
+    }
+    return false;
+}
+
 unsigned simt_core_cluster::issue_block2core()
 {
     unsigned num_blocks_issued=0;
@@ -3266,6 +3479,7 @@ bool simt_core_cluster::icnt_injection_buffer_full(unsigned size, bool write)
 
 void simt_core_cluster::icnt_inject_request_packet(class mem_fetch *mf)
 {
+    sim_thread_pool::ordered();
     // stats
     if (mf->get_is_write()) m_stats->made_write_mfs++;
     else m_stats->made_read_mfs++;
@@ -3391,6 +3605,25 @@ void simt_core_cluster::get_L1I_sub_stats(struct cache_sub_stats &css) const{
     }
     css = total_css;
 }
+enum cache_request_status simt_core_cluster::warm_L1D( unsigned sid, new_addr_type addr, bool dirty, unsigned time, bool &wb, cache_block_t &evicted )
+{
+    unsigned cid = m_config->sid_to_cid(sid);
+    return m_core[cid]->warm_L1D(addr,dirty,time,wb,evicted);
+}
+void simt_core_cluster::save_L1D( FILE *fout ) const
+{
+    for ( unsigned i = 0; i < m_config->n_simt_cores_per_cluster; ++i ) 
+        m_core[i]->save_L1D(fout);
+}
+bool simt_core_cluster::load_L1D( FILE *fin )
+{
+    for ( unsigned i = 0; i < m_config->n_simt_cores_per_cluster; ++i ) {
+        if( !m_core[i]->load_L1D(fin) ) 
+            return false;
+    }
+    return true;
+}
+
 void simt_core_cluster::get_L1D_sub_stats(struct cache_sub_stats &css) const{
     struct cache_sub_stats temp_css;
     struct cache_sub_stats total_css;
@@ -323,6 +323,8 @@ public:
     // all the derived schedulers.  The scheduler's behaviour can be
     // modified by changing the contents of the m_next_cycle_prioritized_warps list.
     void cycle();
+    // shader_cycle_distro slot cycle() would count on a core that cannot make progress
+    unsigned stalled_cycle_distro();
 
     // These are some common ordering fucntions that the
     // higher order schedulers can take advantage of
@@ -523,6 +525,11 @@ public:
         process_banks();
    }
 
+   // no operand read or collector unit in flight
+   bool idle() const;
+   // n step() calls on an idle operand collector only advance the arbiter priority
+   void idle_step( unsigned long long n ) { m_arbiter.idle_step(n); }
+
    void dump( FILE *fp ) const
    {
       fprintf(fp,"\n");
@@ -746,6 +753,19 @@ private:
          for( unsigned b=0; b < m_num_banks; b++ ) 
             m_allocated_bank[b].reset();
       }
+      bool idle() const
+      {
+         for( unsigned b=0; b < m_num_banks; b++ ) 
+            if( !m_queue[b].empty() ) 
+               return false;
+         return true;
+      }
+      void idle_step( unsigned long long n )
+      {
+         // allocate_reads() with no requests
+         unsigned square = ( m_num_banks > m_num_collectors ) ? m_num_banks : m_num_collectors;
+         m_last_cu = ( m_last_cu + n % square ) % square;
+      }
 
    private:
       unsigned m_num_banks;
@@ -970,6 +990,10 @@ public:
     virtual unsigned clock_multiplier() const { return 1; }
     virtual bool can_issue( const warp_inst_t &inst ) const { return m_dispatch_reg->empty() && !occupied.test(inst.latency); }
     virtual bool stallable() const = 0;
+    // nothing dispatched or in flight: cycle() changes no state
+    virtual bool idle() const { return m_dispatch_reg->empty() && occupied.none(); }
+    // stats of n cycle() calls on an idle unit
+    virtual void idle_cycle( unsigned long long n ) {}
     virtual void print( FILE *fp ) const
     {
         fprintf(fp,"%s dispatch= ", m_name.c_str() );
@@ -1015,6 +1039,13 @@ public:
     {
         return simd_function_unit::can_issue(inst);
     }
+    virtual bool idle() const
+    {
+        for( unsigned stage=0; stage<m_pipeline_depth; stage++ ) 
+            if( !m_pipeline_reg[stage]->empty() ) 
+                return false;
+        return simd_function_unit::idle();
+    }
     virtual void print(FILE *fp) const
     {
         simd_function_unit::print(fp);
@@ -1109,6 +1140,8 @@ public:
 
     virtual void active_lanes_in_pipeline();
     virtual bool stallable() const { return true; }
+    virtual bool idle() const;
+    virtual void idle_cycle( unsigned long long n );
     bool response_buffer_full() const;
     void print(FILE *fout) const;
     void print_cache_stats( FILE *fp, unsigned& dl1_accesses, unsigned& dl1_misses );
@@ -1119,6 +1152,10 @@ public:
     void get_L1C_sub_stats(struct cache_sub_stats &css) const;
     void get_L1T_sub_stats(struct cache_sub_stats &css) const;
 
+    enum cache_request_status warm_L1D( new_addr_type addr, bool dirty, unsigned time, bool &wb, cache_block_t &evicted );
+    void save_L1D( FILE *fout ) const;
+    bool load_L1D( FILE *fin );
+
 protected:
     ldst_unit( mem_fetch_interface *icnt,
                shader_core_mem_fetch_allocator *mf_allocator,
@@ -1287,6 +1324,7 @@ struct shader_core_config : public core_config
 
     int gpgpu_num_sched_per_core;
     int gpgpu_max_insn_issue_per_warp;
+    bool gpgpu_core_cycle_skip; // skip the cycles of cores that wait for memory
 
     //op collector
     int gpgpu_operand_collector_num_units_sp;
@@ -1572,6 +1610,12 @@ public:
 // used by simt_core_cluster:
     // modifiers
     void cycle();
+    // cycle skipping (-gpgpu_core_cycle_skip): a core that cannot make progress
+    // without a memory response or a new CTA sleeps, and skip_cycles() only
+    // accounts the stats its cycle() calls would have collected
+    bool sleeping() const { return m_sleeping; }
+    void skip_cycles( unsigned long long n );
+    void wake() { m_sleeping = false; }
     void reinit(unsigned start_thread, unsigned end_thread, bool reset_not_completed );
     void issue_block2core( class kernel_info_t &kernel );
     void cache_flush();
@@ -1595,6 +1639,7 @@ public:
     unsigned isactive() const {if(m_n_active_cta>0) return 1; else return 0;}
     kernel_info_t *get_kernel() { return m_kernel; }
     unsigned get_sid() const {return m_sid;}
+    bool retired_this_cycle() const;
 
 // used by functional simulation:
     // modifiers
@@ -1614,6 +1659,7 @@ public:
     bool warp_waiting_at_mem_barrier( unsigned warp_id );
     void set_max_cta( const kernel_info_t &kernel );
     void warp_inst_complete(const warp_inst_t &inst);
+    void commit_deferred_stats();
     
     // accessors
     std::list<unsigned> get_regs_written( const inst_t &fvt ) const;
@@ -1626,6 +1672,10 @@ public:
     void get_L1C_sub_stats(struct cache_sub_stats &css) const;
     void get_L1T_sub_stats(struct cache_sub_stats &css) const;
 
+    enum cache_request_status warm_L1D( new_addr_type addr, bool dirty, unsigned time, bool &wb, cache_block_t &evicted );
+    void save_L1D( FILE *fout ) const;
+    bool load_L1D( FILE *fin );
+
     void get_icnt_power_stats(long &n_simt_to_mem, long &n_mem_to_simt) const;
 
 // debug:
@@ -1768,12 +1818,21 @@ public:
     void execute();
     
     void writeback();
+    void update_duty_cycle();
+
+    bool quiescent();
     
     // used in display_pipeline():
     void dump_warp_state( FILE *fout ) const;
     void print_stage(unsigned int stage, FILE *fout) const;
     unsigned long long m_last_inst_gpu_sim_cycle;
     unsigned long long m_last_inst_gpu_tot_sim_cycle;
+    std::vector<std::pair<unsigned,unsigned> > m_deferred_latency; // (pc, latency) of instructions completed in a parallel step
+
+    // cycle skipping
+    bool m_can_sleep;                   // enabled and the schedulers keep no per-cycle state
+    bool m_sleeping;
+    std::vector<unsigned> m_sleep_distro; // per scheduler shader_cycle_distro slot while sleeping
 
     // general information
     unsigned m_sid; // shader id
@@ -1844,9 +1903,15 @@ public:
 
     void core_cycle();
     void icnt_cycle();
+    // event skipping: all cores sleep and no response waits, so core_cycle()
+    // and icnt_cycle() only account stats until a packet arrives
+    bool quiescent( bool cores_stepped ) const;
+    void skip_cycles( unsigned long long n );
 
     void reinit();
     unsigned issue_block2core();
+    // issue_block2core() would bind a kernel or issue a CTA
+    bool can_issue_block();
     void cache_flush();
     bool icnt_injection_buffer_full(unsigned size, bool write);
     void icnt_inject_request_packet(class mem_fetch *mf);
@@ -1876,7 +1941,13 @@ public:
     void get_L1C_sub_stats(struct cache_sub_stats &css) const;
     void get_L1T_sub_stats(struct cache_sub_stats &css) const;
 
+    enum cache_request_status warm_L1D( unsigned sid, new_addr_type addr, bool dirty, unsigned time, bool &wb, cache_block_t &evicted );
+    void save_L1D( FILE *fout ) const;
+    bool load_L1D( FILE *fin );
+
     void get_icnt_stats(long &n_simt_to_mem, long &n_mem_to_simt) const;
+    void commit_deferred_stats();
+    int get_last_retire_sid() const { return m_last_retire_sid; } // -1 if no core retired an instruction in the last core_cycle()
 
 private:
     unsigned m_cluster_id;
@@ -1889,6 +1960,7 @@ private:
     unsigned m_cta_issue_next_core;
     std::list<unsigned> m_core_sim_order;
     std::list<mem_fetch*> m_response_fifo;
+    int m_last_retire_sid;
 };
 
 class shader_memory_interface : public mem_fetch_interface {
@@ -0,0 +1,280 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "snapshot.h"
+#include "gpu-sim.h"
+#include "../cuda-sim/memory.h"
+
+static const char SNAPSHOT_MAGIC[8] = {'G','P','G','P','U','S','N','P'};
+static const unsigned SNAPSHOT_VERSION = 1;
+static const unsigned SNAPSHOT_PAGE_SIZE = 8192;
+
+void snapshot_config::reg_options( option_parser_t opp )
+{
+    option_parser_register(opp, "-snapshot_record", OPT_CSTR, &m_record_file,
+                "Record the device memory image of kernel launches into a snapshot file (none = off)",
+                "none");
+    option_parser_register(opp, "-snapshot_kernels", OPT_CSTR, &m_kernel_list_string,
+                "Kernel launch uids recorded with -snapshot_record, e.g. 1-3,7 (none = every launch)",
+                "none");
+    option_parser_register(opp, "-snapshot_replay", OPT_CSTR, &m_replay_file,
+                "Simulate a single kernel launch from a snapshot file, all other launches run functionally (none = off)",
+                "none");
+    option_parser_register(opp, "-snapshot_replay_kernel", OPT_UINT32, &m_replay_uid,
+                "Kernel launch uid replayed with -snapshot_replay (0 = first launch in the snapshot)",
+                "0");
+}
+
+void snapshot_config::init()
+{
+    if( !m_kernel_list.parse(m_kernel_list_string) ) {
+        printf("GPGPU-Sim uArch: error while parsing -snapshot_kernels \"%s\"\n", m_kernel_list_string);
+        abort();
+    }
+    if( record_enabled() && replay_enabled() ) {
+        printf("GPGPU-Sim uArch: -snapshot_record and -snapshot_replay cannot be used together\n");
+        abort();
+    }
+}
+
+// FNV-1a over 64-bit words
+static unsigned long long page_hash( const unsigned char *data, unsigned size )
+{
+    unsigned long long h = 0xcbf29ce484222325ull;
+    const unsigned long long *w = (const unsigned long long*)data;
+    for( unsigned i=0; i < size/8; i++ ) {
+        h ^= w[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+kernel_snapshot::kernel_snapshot( const snapshot_config &config, gpgpu_sim *gpu )
+    : m_config(config), m_gpu(gpu)
+{
+    m_record_fd = NULL;
+    m_recorded_bytes = 0;
+    m_map = NULL;
+    m_map_size = 0;
+    m_replay_uid = 0;
+    m_replay_kernel = NULL;
+    m_replayed = false;
+    memset(&m_header, 0, sizeof(m_header));
+
+    if( m_config.record_enabled() ) {
+        m_record_fd = fopen(m_config.m_record_file, "w+b");
+        if( !m_record_fd ) {
+            printf("GPGPU-Sim uArch: ERROR ** cannot create snapshot file \"%s\"\n", m_config.m_record_file);
+            abort();
+        }
+        memcpy(m_header.magic, SNAPSHOT_MAGIC, sizeof(m_header.magic));
+        m_header.version = SNAPSHOT_VERSION;
+        m_header.page_size = SNAPSHOT_PAGE_SIZE;
+        m_header.data_offset = SNAPSHOT_PAGE_SIZE;
+        m_header.index_offset = m_header.data_offset;
+        write_index();
+    }
+    if( m_config.replay_enabled() && !open_replay() ) {
+        printf("GPGPU-Sim uArch: ERROR ** cannot read snapshot file \"%s\"\n", m_config.m_replay_file);
+        abort();
+    }
+}
+
+kernel_snapshot::~kernel_snapshot()
+{
+    if( m_record_fd )
+        fclose(m_record_fd);
+    if( m_map )
+        munmap((void*)m_map, m_map_size);
+}
+
+memory_space *kernel_snapshot::get_space( unsigned space, kernel_info_t &kernel )
+{
+    switch( space ) {
+    case SPACE_GLOBAL: return m_gpu->get_global_memory();
+    case SPACE_TEX: return m_gpu->get_tex_memory();
+    case SPACE_SURF: return m_gpu->get_surf_memory();
+    case SPACE_PARAM: return kernel.get_param_memory();
+    default: abort();
+    }
+    return NULL;
+}
+
+launch_skip_t kernel_snapshot::skip_kernel( kernel_info_t &kernel )
+{
+    if( m_record_fd ) {
+        if( m_config.m_kernel_list.empty() || m_config.m_kernel_list.contains(kernel.get_uid()) )
+            record(kernel);
+        return LAUNCH_TIMED;
+    }
+    if( !m_map )
+        return LAUNCH_TIMED;
+
+    if( kernel.get_uid() == m_replay_uid ) {
+        replay(kernel, *m_replay_kernel, (const snapshot_page_ref_t*)(m_replay_kernel+1));
+        m_replayed = true;
+        return LAUNCH_TIMED;
+    }
+    if( m_replayed ) {
+        printf("GPGPU-Sim uArch: kernel uid %u \'%s\' executed functionally (snapshot replay done)\n",
+               kernel.get_uid(), kernel.name().c_str());
+    } else {
+        printf("GPGPU-Sim uArch: kernel uid %u \'%s\' executed functionally (before snapshot kernel uid %u)\n",
+               kernel.get_uid(), kernel.name().c_str(), m_replay_uid);
+    }
+    return LAUNCH_FUNCTIONAL;
+}
+
+void kernel_snapshot::record( kernel_info_t &kernel )
+{
+    snapshot_kernel_t k;
+    memset(&k, 0, sizeof(k));
+    k.uid = kernel.get_uid();
+    strncpy(k.name, kernel.name().c_str(), sizeof(k.name)-1);
+    dim3 grid = kernel.get_grid_dim();
+    dim3 block = kernel.get_cta_dim();
+    k.grid[0] = grid.x; k.grid[1] = grid.y; k.grid[2] = grid.z;
+    k.block[0] = block.x; k.block[1] = block.y; k.block[2] = block.z;
+
+    unsigned long long unique_before = m_header.n_pages;
+    std::vector<snapshot_page_ref_t> refs;
+    std::vector<mem_addr_t> pages;
+    unsigned char buffer[SNAPSHOT_PAGE_SIZE];
+    for( unsigned space=0; space < N_SPACE; space++ ) {
+        memory_space *mem = get_space(space,kernel);
+        assert( mem->get_page_size() == SNAPSHOT_PAGE_SIZE );
+        mem->get_pages(pages);
+        for( unsigned i=0; i < pages.size(); i++ ) {
+            mem->read(pages[i] * SNAPSHOT_PAGE_SIZE, SNAPSHOT_PAGE_SIZE, buffer);
+            snapshot_page_ref_t ref;
+            ref.space = space;
+            ref.page = pages[i];
+            ref.id = store_page(buffer);
+            refs.push_back(ref);
+        }
+    }
+    k.n_refs = refs.size();
+    m_kernels.push_back(k);
+    m_refs.push_back(refs);
+    write_index();
+
+    m_recorded_bytes += (unsigned long long)refs.size() * SNAPSHOT_PAGE_SIZE;
+    printf("GPGPU-Sim uArch: snapshot of kernel uid %u \'%s\': %zu pages, %llu new (%llu unique pages, %.2fx dedup)\n",
+           k.uid, k.name, refs.size(), m_header.n_pages - unique_before, m_header.n_pages,
+           m_header.n_pages ? (double)m_recorded_bytes / (m_header.n_pages * SNAPSHOT_PAGE_SIZE) : 0.);
+}
+
+unsigned long long kernel_snapshot::store_page( const unsigned char *data )
+{
+    unsigned long long h = page_hash(data, SNAPSHOT_PAGE_SIZE);
+    std::pair<std::multimap<unsigned long long,unsigned long long>::iterator,
+              std::multimap<unsigned long long,unsigned long long>::iterator> range = m_page_hash.equal_range(h);
+    unsigned char stored[SNAPSHOT_PAGE_SIZE];
+    for( std::multimap<unsigned long long,unsigned long long>::iterator i=range.first; i != range.second; ++i ) {
+        fseek(m_record_fd, m_header.data_offset + i->second * SNAPSHOT_PAGE_SIZE, SEEK_SET);
+        if( fread(stored, SNAPSHOT_PAGE_SIZE, 1, m_record_fd) == 1 && !memcmp(stored, data, SNAPSHOT_PAGE_SIZE) )
+            return i->second;
+    }
+    // new pages overwrite the old index, which is rewritten after the last page
+    unsigned long long id = m_header.n_pages++;
+    fseek(m_record_fd, m_header.data_offset + id * SNAPSHOT_PAGE_SIZE, SEEK_SET);
+    fwrite(data, SNAPSHOT_PAGE_SIZE, 1, m_record_fd);
+    m_page_hash.insert(std::make_pair(h,id));
+    return id;
+}
+
+void kernel_snapshot::write_index()
+{
+    m_header.index_offset = m_header.data_offset + m_header.n_pages * SNAPSHOT_PAGE_SIZE;
+    m_header.n_kernels = m_kernels.size();
+    fseek(m_record_fd, m_header.index_offset, SEEK_SET);
+    unsigned long long size = 0;
+    for( unsigned n=0; n < m_kernels.size(); n++ ) {
+        fwrite(&m_kernels[n], sizeof(snapshot_kernel_t), 1, m_record_fd);
+        if( !m_refs[n].empty() )
+            fwrite(&m_refs[n][0], sizeof(snapshot_page_ref_t), m_refs[n].size(), m_record_fd);
+        size += sizeof(snapshot_kernel_t) + m_refs[n].size() * sizeof(snapshot_page_ref_t);
+    }
+    m_header.index_size = size;
+    fflush(m_record_fd);
+    if( ftruncate(fileno(m_record_fd), m_header.index_offset + size) != 0 )
+        printf("GPGPU-Sim uArch: WARNING ** cannot truncate snapshot file \"%s\"\n", m_config.m_record_file);
+    fseek(m_record_fd, 0, SEEK_SET);
+    fwrite(&m_header, sizeof(m_header), 1, m_record_fd);
+    fflush(m_record_fd);
+}
+
+bool kernel_snapshot::open_replay()
+{
+    int fd = open(m_config.m_replay_file, O_RDONLY);
+    if( fd < 0 )
+        return false;
+    struct stat st;
+    if( fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(snapshot_header_t) ) {
+        close(fd);
+        return false;
+    }
+    m_map_size = st.st_size;
+    void *map = mmap(NULL, m_map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if( map == MAP_FAILED )
+        return false;
+    m_map = (const unsigned char*)map;
+    memcpy(&m_header, m_map, sizeof(m_header));
+    if( memcmp(m_header.magic, SNAPSHOT_MAGIC, sizeof(m_header.magic)) || m_header.version != SNAPSHOT_VERSION
+        || m_header.page_size != SNAPSHOT_PAGE_SIZE || m_header.n_kernels == 0
+        || m_header.index_offset + m_header.index_size > m_map_size )
+        return false;
+
+    const unsigned char *index = m_map + m_header.index_offset;
+    const unsigned char *index_end = index + m_header.index_size;
+    std::vector<unsigned> uids;
+    for( unsigned n=0; n < m_header.n_kernels; n++ ) {
+        const snapshot_kernel_t *k = (const snapshot_kernel_t*)index;
+        if( index + sizeof(snapshot_kernel_t) > index_end
+            || index + sizeof(snapshot_kernel_t) + k->n_refs * sizeof(snapshot_page_ref_t) > index_end )
+            return false;
+        if( !m_replay_kernel && (!m_config.m_replay_uid || k->uid == m_config.m_replay_uid) )
+            m_replay_kernel = k;
+        uids.push_back(k->uid);
+        index += sizeof(snapshot_kernel_t) + k->n_refs * sizeof(snapshot_page_ref_t);
+    }
+    if( !m_replay_kernel ) {
+        printf("GPGPU-Sim uArch: ERROR ** kernel uid %u (-snapshot_replay_kernel) is not in snapshot \"%s\", recorded uids:",
+               m_config.m_replay_uid, m_config.m_replay_file);
+        for( unsigned n=0; n < uids.size(); n++ )
+            printf(" %u", uids[n]);
+        printf("\n");
+        exit(1);
+    }
+    m_replay_uid = m_replay_kernel->uid;
+    printf("GPGPU-Sim uArch: replaying kernel uid %u from snapshot \"%s\" (%u launches, %llu unique pages)\n",
+           m_replay_uid, m_config.m_replay_file, m_header.n_kernels, m_header.n_pages);
+    return true;
+}
+
+void kernel_snapshot::replay( kernel_info_t &kernel, const snapshot_kernel_t &k, const snapshot_page_ref_t *refs )
+{
+    dim3 grid = kernel.get_grid_dim();
+    dim3 block = kernel.get_cta_dim();
+    if( kernel.name() != k.name || grid.x != k.grid[0] || grid.y != k.grid[1] || grid.z != k.grid[2]
+        || block.x != k.block[0] || block.y != k.block[1] || block.z != k.block[2] ) {
+        printf("GPGPU-Sim uArch: ERROR ** kernel uid %u \'%s\' does not match the snapshot launch \'%s\'\n",
+               kernel.get_uid(), kernel.name().c_str(), k.name);
+        abort();
+    }
+    for( unsigned space=0; space < N_SPACE; space++ )
+        get_space(space,kernel)->clear();
+    for( unsigned i=0; i < k.n_refs; i++ ) {
+        const unsigned char *data = m_map + m_header.data_offset + refs[i].id * SNAPSHOT_PAGE_SIZE;
+        get_space(refs[i].space,kernel)->write(refs[i].page * SNAPSHOT_PAGE_SIZE, SNAPSHOT_PAGE_SIZE, data, NULL, NULL);
+    }
+    printf("GPGPU-Sim uArch: kernel uid %u \'%s\' memory image restored from snapshot (%u pages)\n",
+           k.uid, k.name, k.n_refs);
+}
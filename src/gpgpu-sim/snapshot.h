@@ -0,0 +1,118 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <map>
+#include "../option_parser.h"
+#include "../abstract_hardware_model.h"
+#include "gpu-misc.h"
+
+//--------------------------------------------------------------------
+// Kernel memory snapshots
+//
+// Recording (-snapshot_record) stores the device memory image (global,
+// texture, surface and kernel parameter pages) and the launch geometry of
+// the selected kernel launches, before they run. Pages are deduplicated
+// by content across all recorded launches and stored page-aligned, so a
+// replay maps the file and copies the pages of one launch straight into
+// the functional memory. Replaying (-snapshot_replay) runs the host code
+// again and times only the selected kernel, starting from the recorded
+// image; every other launch is executed functionally, so device memory
+// (and what the host copies back) is the same as in a full run.
+//
+// File layout:
+//   page 0   snapshot_header_t
+//   page 1.. unique pages (page_size bytes each)
+//   index    per launch: snapshot_kernel_t + n_refs x snapshot_page_ref_t
+// The index is rewritten after the last page on every recorded launch, so
+// the file is complete after each launch.
+//--------------------------------------------------------------------
+struct snapshot_config {
+    void reg_options( option_parser_t opp );
+    void init();
+
+    bool record_enabled() const { return m_record_file && strcmp(m_record_file,"none"); }
+    bool replay_enabled() const { return m_replay_file && strcmp(m_replay_file,"none"); }
+
+    char *m_record_file;
+    char *m_kernel_list_string;
+    char *m_replay_file;
+    unsigned m_replay_uid;
+
+    kernel_uid_list m_kernel_list;      // launches recorded (empty = all)
+};
+
+class kernel_snapshot {
+public:
+    kernel_snapshot( const snapshot_config &config, class gpgpu_sim *gpu );
+    ~kernel_snapshot();
+
+    // kernel launch: records the launch, or tells how replay runs it
+    launch_skip_t skip_kernel( kernel_info_t &kernel );
+
+private:
+    enum space_t {
+        SPACE_GLOBAL = 0,
+        SPACE_TEX,
+        SPACE_SURF,
+        SPACE_PARAM,
+        N_SPACE
+    };
+
+    struct snapshot_header_t {
+        char magic[8];
+        unsigned version;
+        unsigned page_size;
+        unsigned long long n_pages;
+        unsigned long long data_offset;
+        unsigned long long index_offset;
+        unsigned long long index_size;
+        unsigned n_kernels;
+    };
+
+    struct snapshot_kernel_t {
+        unsigned uid;
+        char name[256];
+        unsigned grid[3];
+        unsigned block[3];
+        unsigned n_refs;
+    };
+
+    struct snapshot_page_ref_t {
+        unsigned space;
+        unsigned page;
+        unsigned long long id;
+    };
+
+    class memory_space *get_space( unsigned space, kernel_info_t &kernel );
+
+    // record
+    void record( kernel_info_t &kernel );
+    unsigned long long store_page( const unsigned char *data );
+    void write_index();
+
+    // replay
+    bool open_replay();
+    void replay( kernel_info_t &kernel, const snapshot_kernel_t &k, const snapshot_page_ref_t *refs );
+
+    const snapshot_config &m_config;
+    class gpgpu_sim *m_gpu;
+
+    FILE *m_record_fd;
+    snapshot_header_t m_header;
+    std::multimap<unsigned long long, unsigned long long> m_page_hash; // content hash -> page id
+    std::vector<snapshot_kernel_t> m_kernels;
+    std::vector<std::vector<snapshot_page_ref_t> > m_refs;
+    unsigned long long m_recorded_bytes;
+
+    const unsigned char *m_map;
+    size_t m_map_size;
+    unsigned m_replay_uid;
+    const snapshot_kernel_t *m_replay_kernel; // its launch in the mapped index
+    bool m_replayed;
+};
+
+#endif
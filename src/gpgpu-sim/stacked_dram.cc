@@ -0,0 +1,551 @@
+#include "stacked_dram.h"
+#include "gpu-sim.h"
+#include "gpu-misc.h"
+#include "mem_latency_stat.h"
+#include "mem_fetch.h"
+#include "l2cache.h"
+#include <string.h>
+#include <algorithm>
+
+// timing of one stack, overridden by -gpgpu_stacked_dram_opt
+static const char *hbm2_preset =
+   "nch=2:nbk=16:nbkgrp=4:RCD=14:RP=14:RAS=34:RC=48:CL=14:WL=4:CCDS=2:CCDL=4:RRDS=4:RRDL=6:FAW=16:"
+   "WTR=8:WR=16:RTP=4:REFI=3900:RFCpb=90:burst=2:atom=32:TSV=2:vault=0:closed=0";
+static const char *hmc_preset =
+   "nch=4:nbk=8:nbkgrp=1:RCD=14:RP=14:RAS=27:RC=41:CL=14:WL=6:CCDS=4:CCDL=4:RRDS=4:RRDL=4:FAW=20:"
+   "WTR=8:WR=12:RTP=4:REFI=3900:RFCpb=160:burst=4:atom=32:TSV=2:vault=8:closed=1";
+
+void stacked_dram_config::reg_options( option_parser_t opp )
+{
+   option_parser_register(opp, "-gpgpu_dram_model", OPT_CSTR, &m_model_string,
+               "DRAM backend of the memory partitions (gddr, hbm2, hmc)",
+               "gddr");
+   option_parser_register(opp, "-gpgpu_stacked_dram_opt", OPT_CSTR, &m_timing_string,
+               "timing of the hbm2/hmc backend, overriding its preset {nch=<channels>:nbk=<banks>:RCD=<cycles>:...}",
+               "");
+}
+
+void stacked_dram_config::init()
+{
+   if ( !strcmp(m_model_string,"gddr") )
+      m_model = DRAM_MODEL_GDDR;
+   else if ( !strcmp(m_model_string,"hbm2") )
+      m_model = DRAM_MODEL_HBM2;
+   else if ( !strcmp(m_model_string,"hmc") )
+      m_model = DRAM_MODEL_HMC;
+   else {
+      printf("GPGPU-Sim uArch: ERROR ** unknown DRAM model '%s'\n", m_model_string);
+      exit(1);
+   }
+   if ( !enabled() )
+      return;
+
+   option_parser_t opp = option_parser_create();
+   option_parser_register(opp, "nch",    OPT_UINT32, &nch,    "channels per memory partition (pseudo channels / vaults)", "0");
+   option_parser_register(opp, "nbk",    OPT_UINT32, &nbk,    "banks per channel", "0");
+   option_parser_register(opp, "nbkgrp", OPT_UINT32, &nbkgrp, "bank groups per channel", "0");
+   option_parser_register(opp, "RCD",    OPT_UINT32, &tRCD,   "row to column delay", "0");
+   option_parser_register(opp, "RP",     OPT_UINT32, &tRP,    "row precharge", "0");
+   option_parser_register(opp, "RAS",    OPT_UINT32, &tRAS,   "activate to precharge", "0");
+   option_parser_register(opp, "RC",     OPT_UINT32, &tRC,    "activate to activate, same bank", "0");
+   option_parser_register(opp, "CL",     OPT_UINT32, &CL,     "CAS latency", "0");
+   option_parser_register(opp, "WL",     OPT_UINT32, &WL,     "write latency", "0");
+   option_parser_register(opp, "CCDS",   OPT_UINT32, &tCCDS,  "column to column, different bank group", "0");
+   option_parser_register(opp, "CCDL",   OPT_UINT32, &tCCDL,  "column to column, same bank group", "0");
+   option_parser_register(opp, "RRDS",   OPT_UINT32, &tRRDS,  "activate to activate, different bank group", "0");
+   option_parser_register(opp, "RRDL",   OPT_UINT32, &tRRDL,  "activate to activate, same bank group", "0");
+   option_parser_register(opp, "FAW",    OPT_UINT32, &tFAW,   "four activate window", "0");
+   option_parser_register(opp, "WTR",    OPT_UINT32, &tWTR,   "end of write data to read", "0");
+   option_parser_register(opp, "WR",     OPT_UINT32, &tWR,    "end of write data to precharge", "0");
+   option_parser_register(opp, "RTP",    OPT_UINT32, &tRTP,   "read to precharge", "0");
+   option_parser_register(opp, "REFI",   OPT_UINT32, &tREFI,  "refresh interval of a bank (0 = no refresh)", "0");
+   option_parser_register(opp, "RFCpb",  OPT_UINT32, &tRFCpb, "per-bank refresh cycle", "0");
+   option_parser_register(opp, "burst",  OPT_UINT32, &burst,  "data bus cycles per column command", "0");
+   option_parser_register(opp, "atom",   OPT_UINT32, &atom,   "bytes per column command", "0");
+   option_parser_register(opp, "TSV",    OPT_UINT32, &tsv,    "TSV latency of read data", "0");
+   option_parser_register(opp, "vault",  OPT_UINT32, &vault,  "vault controller latency", "0");
+   option_parser_register(opp, "closed", OPT_UINT32, &closed_page, "close the row after each access", "0");
+   option_parser_delimited_string(opp, (m_model == DRAM_MODEL_HMC)? hmc_preset : hbm2_preset, "=:;");
+   if ( m_timing_string && m_timing_string[0] )
+      option_parser_delimited_string(opp, m_timing_string, "=:;");
+   fprintf(stdout, "Stacked DRAM (%s) Options:\n", name());
+   option_parser_print(opp, stdout);
+   option_parser_destroy(opp);
+
+   if ( nch == 0 || nbk == 0 || nbkgrp == 0 || nbk % nbkgrp || burst == 0 || atom == 0 ) {
+      printf("GPGPU-Sim uArch: ERROR ** invalid %s organization (nch=%u nbk=%u nbkgrp=%u burst=%u atom=%u)\n",
+             name(), nch, nbk, nbkgrp, burst, atom);
+      exit(1);
+   }
+   if ( tREFI && tREFI < nbk ) {
+      printf("GPGPU-Sim uArch: ERROR ** %s REFI=%u is shorter than one cycle per bank\n", name(), tREFI);
+      exit(1);
+   }
+   tRTW = (CL + burst + 2 > WL)? CL + burst + 2 - WL : 0;
+}
+
+stacked_dram_t::stacked_dram_t( unsigned int partition_id, const memory_config *config, memory_stats_t *stats,
+                                memory_partition_unit *mp )
+   : dram_t(partition_id, config, stats, mp), m_sconfig(config->m_stacked_dram_config)
+{
+   m_channels.resize(m_sconfig.nch);
+   for ( unsigned ch=0; ch < m_sconfig.nch; ch++ ) {
+      schannel_t &c = m_channels[ch];
+      c.banks.resize(m_sconfig.nbk);
+      for ( unsigned b=0; b < m_sconfig.nbk; b++ ) {
+         sbank_t &bank = c.banks[b];
+         memset(&bank, 0, sizeof(bank));
+         bank.group = b / (m_sconfig.nbk / m_sconfig.nbkgrp);
+      }
+      c.queue = new dram_sched_queue<dram_req_t>(m_sconfig.nbk, queue_limit(), m_config->m_dram_sched_config);
+      c.grp_col_ready.assign(m_sconfig.nbkgrp, 0);
+      c.grp_act_ready.assign(m_sconfig.nbkgrp, 0);
+      c.col_ready = c.act_ready = c.rd_ready = c.wr_ready = 0;
+      for ( unsigned i=0; i < 4; i++ )
+         c.faw[i] = 0;
+      c.faw_head = 0;
+      // stagger the channels so they do not refresh in lock step
+      unsigned ref_interval = m_sconfig.tREFI / m_sconfig.nbk;
+      c.next_ref = ref_interval + (unsigned long long)ref_interval * ch / m_sconfig.nch;
+      c.ref_bank = 0;
+      c.prio = 0;
+      c.n_rd = c.n_wr = c.n_act = c.n_pre = c.n_ref = 0;
+      c.n_bus_busy = 0;
+      c.row_hits = c.row_misses = 0;
+   }
+   m_cycle = 0;
+   m_bus_busy = 0;
+   m_n_queued = 0;
+   m_n_in_bank = 0;
+}
+
+stacked_dram_t::~stacked_dram_t()
+{
+   for ( unsigned ch=0; ch < m_channels.size(); ch++ )
+      delete m_channels[ch].queue;
+}
+
+unsigned stacked_dram_t::pending() const
+{
+   return m_input.size() + m_n_queued;
+}
+
+bool stacked_dram_t::full() const
+{
+   return queue_limit() && pending() >= queue_limit();
+}
+
+unsigned stacked_dram_t::que_length() const
+{
+   return pending();
+}
+
+// The address mapping decodes to the banks of -gpgpu_dram_timing_opt;
+// spread them over the channels of the stack, borrowing low row bits when
+// the stack has more banks than the mapping, consecutive banks going to
+// different channels.
+void stacked_dram_t::map( dram_req_t *req, unsigned &ch ) const
+{
+   unsigned n_banks = m_sconfig.nch * m_sconfig.nbk;
+   unsigned g;
+   if ( n_banks >= m_config->nbk ) {
+      unsigned fold = (n_banks + m_config->nbk - 1) / m_config->nbk;
+      g = (req->bk + m_config->nbk * (req->row % fold)) % n_banks;
+      req->row /= fold;
+   } else {
+      unsigned fold = m_config->nbk / n_banks;
+      g = req->bk % n_banks;
+      req->row = req->row * fold + (req->bk / n_banks) % fold;
+   }
+   ch = g % m_sconfig.nch;
+   req->bk = g / m_sconfig.nch;
+}
+
+void stacked_dram_t::push( class mem_fetch *data )
+{
+   assert(id == data->get_tlx_addr().chip); // Ensure request is in correct memory partition
+
+   dram_req_t *mrq = new dram_req_t(data);
+   data->set_status(IN_PARTITION_MC_INTERFACE_QUEUE,gpu_sim_cycle+gpu_tot_sim_cycle);
+   m_input.push_back(std::make_pair(m_cycle + m_sconfig.vault, mrq));
+
+   n_req += 1;
+   n_req_partial += 1;
+   if ( pending() > max_mrqs_temp )
+      max_mrqs_temp = pending();
+   m_stats->memlatstat_dram_access(data);
+}
+
+void stacked_dram_t::complete( unsigned long long ready, mem_fetch *mf )
+{
+   completion_t c = { ready, mf };
+   std::list<completion_t>::iterator i = m_completions.end();
+   while ( i != m_completions.begin() ) {
+      std::list<completion_t>::iterator prev = i;
+      --prev;
+      if ( prev->ready <= ready )
+         break;
+      i = prev;
+   }
+   m_completions.insert(i, c);
+}
+
+// one ACT, PRE or REF per channel and cycle
+bool stacked_dram_t::issue_row( schannel_t &c, unsigned long long now )
+{
+   const stacked_dram_config &s = m_sconfig;
+   for ( unsigned i=0; i < s.nbk; i++ ) {
+      unsigned b = (i + c.prio) % s.nbk;
+      sbank_t &bank = c.banks[b];
+      if ( bank.refresh ) {
+         if ( bank.open ) {
+            if ( bank.pre_ready > now )
+               continue;
+            bank.open = false;
+            bank.act_ready = std::max(bank.act_ready, now + s.tRP);
+            c.n_pre++;
+            n_pre++; n_pre_partial++;
+            return true;
+         }
+         if ( bank.act_ready > now )
+            continue;
+         bank.refresh = false;
+         bank.act_ready = now + s.tRFCpb;
+         c.n_ref++;
+         return true;
+      }
+      if ( !bank.mrq )
+         continue;
+      if ( bank.open ) {
+         if ( bank.row == bank.mrq->row || bank.pre_ready > now )
+            continue;
+         bank.open = false;
+         bank.act_ready = std::max(bank.act_ready, now + s.tRP);
+         c.n_pre++;
+         n_pre++; n_pre_partial++;
+         return true;
+      }
+      if ( bank.act_ready > now || c.act_ready > now || c.grp_act_ready[bank.group] > now )
+         continue;
+      if ( c.faw[c.faw_head] && c.faw[c.faw_head] + s.tFAW > now )
+         continue;
+      bank.open = true;
+      bank.row = bank.mrq->row;
+      bank.activated = true;
+      bank.col_ready = now + s.tRCD;
+      bank.pre_ready = now + s.tRAS;
+      bank.act_ready = now + s.tRC;
+      c.act_ready = now + s.tRRDS;
+      c.grp_act_ready[bank.group] = now + s.tRRDL;
+      c.faw[c.faw_head] = now;
+      c.faw_head = (c.faw_head + 1) % 4;
+      c.n_act++;
+      n_act++; n_act_partial++;
+      return true;
+   }
+   return false;
+}
+
+// one RD or WR per channel and cycle
+bool stacked_dram_t::issue_col( schannel_t &c, unsigned long long now )
+{
+   const stacked_dram_config &s = m_sconfig;
+   if ( c.col_ready > now )
+      return false;
+   for ( unsigned i=0; i < s.nbk; i++ ) {
+      unsigned b = (i + c.prio) % s.nbk;
+      sbank_t &bank = c.banks[b];
+      dram_req_t *req = bank.mrq;
+      if ( !req || bank.refresh || !bank.open || bank.row != req->row )
+         continue;
+      if ( bank.col_ready > now || c.grp_col_ready[bank.group] > now )
+         continue;
+      bool write = (req->rw == WRITE);
+      if ( (write && c.wr_ready > now) || (!write && c.rd_ready > now) )
+         continue;
+
+      req->data->set_status(IN_PARTITION_DRAM,gpu_sim_cycle+gpu_tot_sim_cycle);
+      req->txbytes += s.atom;
+      c.col_ready = now + s.tCCDS;
+      c.grp_col_ready[bank.group] = now + s.tCCDL;
+      c.n_bus_busy += s.burst;
+      m_bus_busy += s.burst;
+      unsigned long long done;
+      if ( write ) {
+         done = now + s.WL + s.burst;
+         c.rd_ready = std::max(c.rd_ready, done + s.tWTR);
+         bank.pre_ready = std::max(bank.pre_ready, done + s.tWR);
+         c.n_wr++;
+         n_wr++;
+      } else {
+         done = now + s.CL + s.burst + s.tsv;
+         c.wr_ready = std::max(c.wr_ready, now + s.tRTW);
+         bank.pre_ready = std::max(bank.pre_ready, now + s.tRTP);
+         c.n_rd++;
+         n_rd++;
+      }
+      if ( req->txbytes >= req->nbytes ) {
+         if ( bank.activated ) c.row_misses++;
+         else c.row_hits++;
+         bank.n_access++;
+         complete(done, req->data);
+         delete req;
+         bank.mrq = NULL;
+         m_n_in_bank--;
+         if ( s.closed_page ) {
+            // auto-precharge
+            bank.open = false;
+            bank.act_ready = std::max(bank.act_ready, bank.pre_ready + s.tRP);
+            c.n_pre++;
+            n_pre++; n_pre_partial++;
+         }
+      }
+      return true;
+   }
+   return false;
+}
+
+void stacked_dram_t::cycle()
+{
+   const stacked_dram_config &s = m_sconfig;
+   unsigned long long now = m_cycle;
+
+   while ( !m_completions.empty() && m_completions.front().ready <= now ) {
+      mem_fetch *data = m_completions.front().mf;
+      if( data->get_access_type() != L1_WRBK_ACC && data->get_access_type() != L2_WRBK_ACC ) {
+         if ( returnq->full() )
+            break;
+         data->set_status(IN_PARTITION_MC_RETURNQ,gpu_sim_cycle+gpu_tot_sim_cycle);
+         data->set_reply();
+         returnq->push(data);
+      } else {
+         m_memory_partition_unit->set_done(data);
+         delete data;
+      }
+      m_completions.pop_front();
+   }
+
+   while ( !m_input.empty() && m_input.front().first <= now ) {
+      dram_req_t *req = m_input.front().second;
+      m_input.pop_front();
+      unsigned ch;
+      map(req, ch);
+      account_queued(req);
+      m_channels[ch].queue->add(req, req->bk, req->row, dram_sched_queue<dram_req_t>::source(req->data->get_sid()),
+                                req->data->get_is_write(), gpu_sim_cycle + gpu_tot_sim_cycle);
+      m_n_queued++;
+   }
+
+   bool issued = false;
+   for ( unsigned ch=0; ch < m_channels.size(); ch++ ) {
+      schannel_t &c = m_channels[ch];
+      if ( s.tREFI && now >= c.next_ref ) {
+         c.banks[c.ref_bank].refresh = true;
+         c.ref_bank = (c.ref_bank + 1) % s.nbk;
+         c.next_ref += s.tREFI / s.nbk;
+      }
+      for ( unsigned i=0; i < s.nbk; i++ ) {
+         unsigned b = (i + c.prio) % s.nbk;
+         sbank_t &bank = c.banks[b];
+         if ( bank.mrq )
+            continue;
+         bool activate = false;
+         dram_req_t *req = c.queue->schedule(b, bank.open? bank.row : (unsigned)-1,
+                                             gpu_sim_cycle + gpu_tot_sim_cycle, activate);
+         if ( !req )
+            continue;
+         req->data->set_status(IN_PARTITION_MC_BANK_ARB_QUEUE,gpu_sim_cycle+gpu_tot_sim_cycle);
+         bank.mrq = req;
+         mf_trace(MFT_DRAM, gpu_sim_cycle+gpu_tot_sim_cycle, req->data->get_request_uid(), id, b, req->row);
+         bank.activated = false;
+         m_n_queued--;
+         m_n_in_bank++;
+         account_mrq_latency(req);
+      }
+      bool row = issue_row(c, now);
+      bool col = issue_col(c, now);
+      if ( row || col ) {
+         issued = true;
+         c.prio = (c.prio + 1) % s.nbk;
+      }
+   }
+
+   n_cmd++;
+   n_cmd_partial++;
+   if ( !issued ) {
+      n_nop++;
+      n_nop_partial++;
+   }
+   if ( pending() || m_n_in_bank || !m_completions.empty() ) {
+      n_activity++;
+      n_activity_partial++;
+   }
+   // bandwidth utilization of the partition: bus cycles averaged over the channels
+   unsigned util = m_bus_busy / m_channels.size();
+   bwutil_partial += util - bwutil;
+   bwutil = util;
+
+   if ( pending() > max_mrqs )
+      max_mrqs = pending();
+   ave_mrqs += pending();
+   ave_mrqs_partial += pending();
+
+   m_cycle++;
+}
+
+bool stacked_dram_t::idle() const
+{
+   return m_input.empty() && !m_n_queued && !m_n_in_bank && m_completions.empty() && returnq->empty();
+}
+
+// With no request anywhere, a cycle() only flags refreshes and issues the
+// PRE and REF commands they need. Run those cycles from m_cycle to end,
+// visiting only the ones on which a refresh falls due or a flagged bank
+// becomes ready; returns the number of cycles with a command.
+unsigned long long stacked_dram_t::idle_refresh( unsigned long long end )
+{
+   const stacked_dram_config &s = m_sconfig;
+   unsigned long long n_issued = 0;
+   unsigned long long now = m_cycle;
+   while ( now < end ) {
+      bool issued = false;
+      unsigned long long next = end;
+      for ( unsigned ch=0; ch < m_channels.size(); ch++ ) {
+         schannel_t &c = m_channels[ch];
+         if ( s.tREFI && now >= c.next_ref ) {
+            c.banks[c.ref_bank].refresh = true;
+            c.ref_bank = (c.ref_bank + 1) % s.nbk;
+            c.next_ref += s.tREFI / s.nbk;
+         }
+         if ( issue_row(c, now) ) {
+            issued = true;
+            c.prio = (c.prio + 1) % s.nbk;
+         }
+         if ( s.tREFI )
+            next = std::min(next, c.next_ref);
+         for ( unsigned b=0; b < s.nbk; b++ ) {
+            const sbank_t &bank = c.banks[b];
+            if ( bank.refresh )
+               next = std::min(next, bank.open? bank.pre_ready : bank.act_ready);
+         }
+      }
+      if ( issued )
+         n_issued++;
+      now = std::max(next, now + 1);
+   }
+   return n_issued;
+}
+
+void stacked_dram_t::skip_cycles( unsigned long long n )
+{
+   assert( idle() );
+#ifdef DRAM_VERIFY_SKIP
+   // step a copy of the idle state with cycle() to compare against
+   std::vector<schannel_t> channels = m_channels;
+   unsigned long long start = m_cycle;
+   unsigned counters[5] = { n_cmd, n_nop, n_activity, n_pre, bwutil };
+   for ( unsigned long long i=0; i < n; i++ )
+      cycle();
+   std::vector<schannel_t> stepped = m_channels;
+   unsigned stepped_counters[5] = { n_cmd, n_nop, n_activity, n_pre, bwutil };
+   m_channels = channels;
+   m_cycle = start;
+   n_cmd = counters[0]; n_nop = counters[1]; n_activity = counters[2]; n_pre = counters[3]; bwutil = counters[4];
+#endif
+   // no request is pending, so no cycle counts as activity
+   unsigned long long n_issued = idle_refresh(m_cycle + n);
+   n_nop += n - n_issued;
+   n_nop_partial += n - n_issued;
+   n_cmd += n;
+   n_cmd_partial += n;
+   m_cycle += n;
+   // the queue is empty on every skipped cycle (dram_log(SAMPLELOG))
+   StatAddSamples(mrqq_Dist, que_length(), n);
+#ifdef DRAM_VERIFY_SKIP
+   unsigned skipped_counters[5] = { n_cmd, n_nop, n_activity, n_pre, bwutil };
+   bool same = !memcmp(stepped_counters, skipped_counters, sizeof(skipped_counters));
+   for ( unsigned ch=0; ch < m_channels.size() && same; ch++ ) {
+      const schannel_t &a = stepped[ch], &b = m_channels[ch];
+      same = a.next_ref == b.next_ref && a.ref_bank == b.ref_bank && a.prio == b.prio &&
+             a.n_pre == b.n_pre && a.n_ref == b.n_ref;
+      for ( unsigned k=0; k < m_sconfig.nbk && same; k++ ) {
+         const sbank_t &x = a.banks[k], &y = b.banks[k];
+         same = x.open == y.open && x.refresh == y.refresh && x.act_ready == y.act_ready && x.pre_ready == y.pre_ready;
+      }
+   }
+   if ( !same ) {
+      printf("GPGPU-Sim uArch: ERROR ** DRAM[%d] skipping %llu idle cycles at %llu differs from stepping them\n",
+             id, n, start);
+      fflush(stdout);
+      abort();
+   }
+#endif
+}
+
+void stacked_dram_t::print( FILE *simFile ) const
+{
+   const stacked_dram_config &s = m_sconfig;
+   fprintf(simFile,"DRAM[%d] (%s): %u channels x %u bks (%u groups), %s page, atom=%uB burst=%u CL=%u WL=%u, ",
+           id, s.name(), s.nch, s.nbk, s.nbkgrp, s.closed_page? "closed" : "open", s.atom, s.burst, s.CL, s.WL);
+   fprintf(simFile,"tRCD=%u tRAS=%u tRP=%u tRC=%u tFAW=%u tREFI=%u tRFCpb=%u TSV=%u vault=%u\n",
+           s.tRCD, s.tRAS, s.tRP, s.tRC, s.tFAW, s.tREFI, s.tRFCpb, s.tsv, s.vault);
+   fprintf(simFile,"n_cmd=%d n_nop=%d n_act=%d n_pre=%d n_req=%d n_rd=%d n_write=%d bw_util=%.4g\n",
+           n_cmd, n_nop, n_act, n_pre, n_req, n_rd, n_wr,
+           n_cmd? (float)bwutil/n_cmd : 0.0f);
+   fprintf(simFile,"n_activity=%d dram_eff=%.4g\n",
+           n_activity, n_activity? (float)bwutil/n_activity : 0.0f);
+   unsigned long long hits = 0, misses = 0;
+   for ( unsigned ch=0; ch < m_channels.size(); ch++ ) {
+      const schannel_t &c = m_channels[ch];
+      unsigned long long n = c.row_hits + c.row_misses;
+      fprintf(simFile,"ch%u: n_rd=%u n_wr=%u n_act=%u n_pre=%u n_ref=%u bw_util=%.4g row_hit=%.4g\n",
+              ch, c.n_rd, c.n_wr, c.n_act, c.n_pre, c.n_ref,
+              m_cycle? (float)c.n_bus_busy/m_cycle : 0.0f, n? (float)c.row_hits/n : 0.0f);
+      hits += c.row_hits;
+      misses += c.row_misses;
+   }
+   fprintf(simFile,"row_buffer_locality=%.4g (%llu hits, %llu misses)\n",
+           (hits+misses)? (float)hits/(hits+misses) : 0.0f, hits, misses);
+   fprintf(simFile, "dram_util_bins:");
+   for (unsigned i=0;i<10;i++) fprintf(simFile, " %d", dram_util_bins[i]);
+   fprintf(simFile, "\ndram_eff_bins:");
+   for (unsigned i=0;i<10;i++) fprintf(simFile, " %d", dram_eff_bins[i]);
+   fprintf(simFile, "\n");
+   fprintf(simFile, "mrqq: max=%d avg=%g\n", max_mrqs, n_cmd? (float)ave_mrqs/n_cmd : 0.0f);
+}
+
+void stacked_dram_t::print_stat( FILE *simFile )
+{
+   fprintf(simFile,"DRAM (%d, %s): n_cmd=%d n_nop=%d n_act=%d n_pre=%d n_req=%d n_rd=%d n_write=%d bw_util=%.4g ",
+           id, m_sconfig.name(), n_cmd, n_nop, n_act, n_pre, n_req, n_rd, n_wr,
+           n_cmd? (float)bwutil/n_cmd : 0.0f);
+   fprintf(simFile, "mrqq: %d %.4g mrqsmax=%d ", max_mrqs, n_cmd? (float)ave_mrqs/n_cmd : 0.0f, max_mrqs_temp);
+   fprintf(simFile, "\n");
+   for ( unsigned ch=0; ch < m_channels.size(); ch++ ) {
+      const schannel_t &c = m_channels[ch];
+      unsigned long long n = c.row_hits + c.row_misses;
+      fprintf(simFile, " ch%u: bw_util=%.4g row_hit=%.4g", ch,
+              m_cycle? (float)c.n_bus_busy/m_cycle : 0.0f, n? (float)c.row_hits/n : 0.0f);
+   }
+   fprintf(simFile, "\n");
+   max_mrqs_temp = 0;
+}
+
+void stacked_dram_t::visualize() const
+{
+   printf("%s cycle=%llu input=%u queued=%u in_bank=%u completions=%u\n", m_sconfig.name(), m_cycle,
+          (unsigned)m_input.size(), m_n_queued, m_n_in_bank, (unsigned)m_completions.size());
+   for ( unsigned ch=0; ch < m_channels.size(); ch++ ) {
+      const schannel_t &c = m_channels[ch];
+      printf("CH%u: next_ref=%llu ref_bank=%u\n", ch, c.next_ref, c.ref_bank);
+      for ( unsigned b=0; b < m_sconfig.nbk; b++ ) {
+         const sbank_t &bank = c.banks[b];
+         printf(" BK%u: %s row=%03x%s act=%llu col=%llu pre=%llu %p", b, bank.open? "open" : "closed",
+                bank.row, bank.refresh? " refresh" : "", bank.act_ready, bank.col_ready, bank.pre_ready, bank.mrq);
+         if ( bank.mrq )
+            printf(" txf: %d %d", bank.mrq->nbytes, bank.mrq->txbytes);
+         printf("\n");
+      }
+      c.queue->print(stdout);
+   }
+}
@@ -0,0 +1,140 @@
+#ifndef STACKED_DRAM_H
+#define STACKED_DRAM_H
+
+#include <list>
+#include <deque>
+#include <vector>
+#include "../option_parser.h"
+#include "dram.h"
+#include "dram_sched_queue.h"
+
+//--------------------------------------------------------------------
+// Die-stacked DRAM (HBM2 / HMC) behind the dram_t interface.
+//
+// The partition is split into independent channels (HBM2 pseudo
+// channels, HMC vaults), each with its own banks, bank groups, command
+// and data bus and FR-FCFS queue. A channel issues one row command
+// (ACT/PRE/REF) and one column command (RD/WR) per DRAM cycle. Banks are
+// refreshed one at a time (per-bank refresh), so the rest of the channel
+// keeps working. Read data crosses the TSVs on its way out, and with HMC
+// every request first passes the vault controller.
+//
+// HBM2 keeps rows open; HMC closes them after each access.
+//
+// -gpgpu_dram_model selects the backend (gddr is the classic dram_t) and
+// -gpgpu_stacked_dram_opt overrides the timing of the chosen stack in
+// the "name=value:name=value" form of -gpgpu_dram_timing_opt.
+//--------------------------------------------------------------------
+enum dram_model_t {
+   DRAM_MODEL_GDDR = 0,
+   DRAM_MODEL_HBM2,
+   DRAM_MODEL_HMC
+};
+
+struct stacked_dram_config {
+   void reg_options( option_parser_t opp );
+   void init();
+   bool enabled() const { return m_model != DRAM_MODEL_GDDR; }
+   const char *name() const { return m_model == DRAM_MODEL_HMC? "HMC" : "HBM2"; }
+
+   char *m_model_string;
+   char *m_timing_string;
+   enum dram_model_t m_model;
+
+   unsigned nch;      // channels per memory partition (pseudo channels / vaults)
+   unsigned nbk;      // banks per channel
+   unsigned nbkgrp;   // bank groups per channel
+   unsigned tRCD;     // all timing in DRAM command cycles
+   unsigned tRP;
+   unsigned tRAS;
+   unsigned tRC;
+   unsigned CL;
+   unsigned WL;
+   unsigned tCCDS;    // column to column, different bank group
+   unsigned tCCDL;    // column to column, same bank group
+   unsigned tRRDS;    // activate to activate, different bank group
+   unsigned tRRDL;    // activate to activate, same bank group
+   unsigned tFAW;     // four activate window
+   unsigned tWTR;     // end of write data to read
+   unsigned tWR;      // end of write data to precharge
+   unsigned tRTP;     // read to precharge
+   unsigned tREFI;    // every bank is refreshed once per tREFI
+   unsigned tRFCpb;   // per-bank refresh cycle
+   unsigned burst;    // data bus cycles per column command
+   unsigned atom;     // bytes per column command
+   unsigned tsv;      // TSV latency of read data
+   unsigned vault;    // vault controller latency (HMC)
+   unsigned closed_page;
+   unsigned tRTW;     // derived: read to write turnaround
+};
+
+class stacked_dram_t : public dram_t {
+public:
+   stacked_dram_t( unsigned int partition_id, const struct memory_config *config, class memory_stats_t *stats,
+                   class memory_partition_unit *mp );
+   virtual ~stacked_dram_t();
+
+   virtual bool full() const;
+   virtual void print( FILE *simFile ) const;
+   virtual void visualize() const;
+   virtual void print_stat( FILE *simFile );
+   virtual unsigned que_length() const;
+   virtual void push( class mem_fetch *data );
+   virtual void cycle();
+   virtual bool idle() const;
+   virtual void skip_cycles( unsigned long long n );
+
+private:
+   struct sbank_t {
+      bool open;
+      bool refresh;                    // refresh due, no new column commands
+      bool activated;                  // mrq needed an activate
+      unsigned row;
+      unsigned group;
+      unsigned long long act_ready;    // tRP, tRC, tRFCpb
+      unsigned long long col_ready;    // tRCD
+      unsigned long long pre_ready;    // tRAS, tRTP, tWR
+      dram_req_t *mrq;
+      unsigned n_access;
+   };
+   struct schannel_t {
+      std::vector<sbank_t> banks;
+      dram_sched_queue<dram_req_t> *queue;
+      std::vector<unsigned long long> grp_col_ready;  // tCCDL
+      std::vector<unsigned long long> grp_act_ready;  // tRRDL
+      unsigned long long col_ready;    // tCCDS
+      unsigned long long act_ready;    // tRRDS
+      unsigned long long rd_ready;     // tWTR
+      unsigned long long wr_ready;     // tRTW
+      unsigned long long faw[4];       // last four activates
+      unsigned faw_head;
+      unsigned long long next_ref;
+      unsigned ref_bank;
+      unsigned prio;
+      unsigned n_rd, n_wr, n_act, n_pre, n_ref;
+      unsigned long long n_bus_busy;   // data bus cycles
+      unsigned long long row_hits, row_misses;
+   };
+   struct completion_t {
+      unsigned long long ready;
+      mem_fetch *mf;
+   };
+
+   void map( dram_req_t *req, unsigned &ch ) const;
+   bool issue_row( schannel_t &c, unsigned long long now );
+   bool issue_col( schannel_t &c, unsigned long long now );
+   void complete( unsigned long long ready, mem_fetch *mf );
+   unsigned long long idle_refresh( unsigned long long end );
+   unsigned pending() const;
+
+   const stacked_dram_config &m_sconfig;
+   std::vector<schannel_t> m_channels;
+   std::deque<std::pair<unsigned long long,dram_req_t*> > m_input;  // vault controller
+   std::list<completion_t> m_completions;                          // by ready cycle
+   unsigned long long m_cycle;
+   unsigned long long m_bus_busy;   // summed over channels
+   unsigned m_n_queued;
+   unsigned m_n_in_bank;
+};
+
+#endif
@@ -93,6 +93,17 @@ void set_spill_interval (unsigned long long  interval)
    next_spill_cycle = spill_interval;
 }
 
+// first cycle at which try_snap_shot() or spill_log_to_file() does any work
+unsigned long long stat_tool_next_event (unsigned long long  current_cycle)
+{
+   unsigned long long next = (unsigned long long)-1;
+   if (min_snap_shot_interval != 0 && next_snap_shot_cycle >= current_cycle) 
+      next = next_snap_shot_cycle;
+   if (spill_interval != 0 && next_spill_cycle + 1 < next) 
+      next = (next_spill_cycle < current_cycle)? current_cycle : next_spill_cycle + 1;
+   return next;
+}
+
 void spill_log_to_file (FILE *fout, int final, unsigned long long  current_cycle)
 {
    if (!final && spill_interval == 0) return;
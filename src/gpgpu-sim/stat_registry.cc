@@ -0,0 +1,293 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <zlib.h>
+
+#include "stat_registry.h"
+
+static const size_t CSV_BUFFER_SIZE = 64 * 1024;
+
+void stat_registry_config::reg_options( option_parser_t opp )
+{
+    option_parser_register(opp, "-gpgpu_stats_json", OPT_CSTR, &m_json_file,
+                "Append the registered statistics to a JSON Lines file at every kernel end (none = off)",
+                "none");
+    option_parser_register(opp, "-gpgpu_stats_csv", OPT_CSTR, &m_csv_file,
+                "Write a gzip compressed CSV time series of the registered statistics (none = off)",
+                "none");
+    option_parser_register(opp, "-gpgpu_stats_interval", OPT_INT64, &m_interval,
+                "Cycles between two rows of -gpgpu_stats_csv",
+                "10000");
+    option_parser_register(opp, "-gpgpu_stats_zlevel", OPT_INT32, &m_zlevel,
+                "Compression level of -gpgpu_stats_csv (0=no comp, 9=highest)",
+                "6");
+}
+
+stat_registry::stat_registry( const stat_registry_config &config )
+    : m_config(config)
+{
+    m_json_first_write = true;
+    m_csv_first_write = true;
+    m_next_sample = 0;
+    if( m_config.csv_enabled() && m_config.m_interval == 0 ) {
+        printf("GPGPU-Sim uArch: ERROR ** -gpgpu_stats_interval must be positive\n");
+        abort();
+    }
+}
+
+stat_registry::~stat_registry()
+{
+    flush_csv();
+}
+
+void stat_registry::add( stat_kind kind, const std::string &name, const void *a, read_fn read_a,
+                         const void *b, read_fn read_b, unsigned n )
+{
+    entry e;
+    e.kind = kind;
+    e.name = name;
+    e.a = a;
+    e.read_a = read_a;
+    e.b = b;
+    e.read_b = read_b;
+    e.n = n;
+    e.group = NULL;
+    m_entries.push_back(e);
+}
+
+void stat_registry::reg_group( const std::string &name, stat_group_fn fn, const void *arg )
+{
+    add(STAT_GROUP, name, arg, NULL, NULL, NULL, 0);
+    m_entries.back().group = fn;
+}
+
+namespace {
+
+// group members are flattened to group.name
+class prefix_writer : public stat_writer {
+public:
+    prefix_writer( const std::string &prefix, stat_writer &out ) : m_prefix(prefix), m_out(out) {}
+    void value( const std::string &name, double v ) { m_out.value(m_prefix + "." + name, v); }
+private:
+    const std::string &m_prefix;
+    stat_writer &m_out;
+};
+
+class csv_row_writer : public stat_writer {
+public:
+    csv_row_writer( const std::map<std::string,unsigned> &index, std::vector<double> &row )
+        : m_index(index), m_row(row) {}
+    void value( const std::string &name, double v )
+    {
+        std::map<std::string,unsigned>::const_iterator i = m_index.find(name);
+        if( i != m_index.end() )
+            m_row[i->second] = v;
+    }
+private:
+    const std::map<std::string,unsigned> &m_index;
+    std::vector<double> &m_row;
+};
+
+class name_writer : public stat_writer {
+public:
+    name_writer( std::vector<std::string> &names ) : m_names(names) {}
+    void value( const std::string &name, double v ) { m_names.push_back(name); }
+private:
+    std::vector<std::string> &m_names;
+};
+
+void append_number( std::string &out, double v, const char *nan )
+{
+    if( isnan(v) || isinf(v) ) {
+        out += nan;
+        return;
+    }
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.17g", v);
+    out += buf;
+}
+
+void append_json_string( std::string &out, const std::string &s )
+{
+    out += '"';
+    for( unsigned i=0; i < s.size(); i++ ) {
+        unsigned char c = s[i];
+        if( c == '"' || c == '\\' ) {
+            out += '\\';
+            out += c;
+        } else if( c < 0x20 ) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+class json_object_writer : public stat_writer {
+public:
+    json_object_writer( std::string &out ) : m_out(out), m_first(true) {}
+    void value( const std::string &name, double v )
+    {
+        if( !m_first )
+            m_out += ", ";
+        m_first = false;
+        append_json_string(m_out, name);
+        m_out += ": ";
+        append_number(m_out, v, "null");
+    }
+private:
+    std::string &m_out;
+    bool m_first;
+};
+
+}
+
+void stat_registry::collect( stat_writer &out ) const
+{
+    for( unsigned i=0; i < m_entries.size(); i++ ) {
+        const entry &e = m_entries[i];
+        switch( e.kind ) {
+        case STAT_COUNTER:
+            out.value(e.name, e.read_a(e.a, 0));
+            break;
+        case STAT_RATIO: {
+            double den = e.read_b(e.b, 0);
+            out.value(e.name, den? e.read_a(e.a, 0) / den : NAN);
+            break;
+        }
+        case STAT_HISTOGRAM:
+            for( unsigned b=0; b < e.n; b++ ) {
+                char bin[16];
+                snprintf(bin, sizeof(bin), "[%u]", b);
+                out.value(e.name + bin, e.read_a(e.a, b));
+            }
+            break;
+        case STAT_GROUP: {
+            prefix_writer p(e.name, out);
+            e.group(e.a, p);
+            break;
+        }
+        }
+    }
+}
+
+void stat_registry::write_row( unsigned long long cycle )
+{
+    if( m_columns.empty() ) {
+        name_writer names(m_columns);
+        collect(names);
+        m_csv_buffer += "cycle";
+        for( unsigned i=0; i < m_columns.size(); i++ ) {
+            m_column_index[m_columns[i]] = i;
+            m_csv_buffer += ',';
+            m_csv_buffer += m_columns[i];
+        }
+        m_csv_buffer += '\n';
+    }
+    std::vector<double> row(m_columns.size(), NAN);
+    csv_row_writer w(m_column_index, row);
+    collect(w);
+
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%llu", cycle);
+    m_csv_buffer += buf;
+    for( unsigned i=0; i < row.size(); i++ ) {
+        m_csv_buffer += ',';
+        append_number(m_csv_buffer, row[i], "");
+    }
+    m_csv_buffer += '\n';
+    if( m_csv_buffer.size() >= CSV_BUFFER_SIZE )
+        flush_csv();
+
+    // a skipped stretch of cycles yields one row, not one per interval
+    m_next_sample = (cycle / m_config.m_interval + 1) * m_config.m_interval;
+}
+
+void stat_registry::flush_csv()
+{
+    if( m_csv_buffer.empty() )
+        return;
+    gzFile f = gzopen(m_config.m_csv_file, m_csv_first_write? "w" : "a");
+    if( f == NULL ) {
+        printf("GPGPU-Sim uArch: ERROR ** could not open -gpgpu_stats_csv file %s\n", m_config.m_csv_file);
+        abort();
+    }
+    gzsetparams(f, m_config.m_zlevel, Z_DEFAULT_STRATEGY);
+    gzwrite(f, m_csv_buffer.data(), m_csv_buffer.size());
+    gzclose(f);
+    m_csv_first_write = false;
+    m_csv_buffer.clear();
+}
+
+void stat_registry::snapshot( const std::vector<std::string> &kernels, const std::vector<unsigned> &uids,
+                              unsigned long long cycle )
+{
+    if( m_config.csv_enabled() )
+        flush_csv();
+    if( !m_config.json_enabled() )
+        return;
+
+    std::string s = "{\"kernels\": [";
+    for( unsigned i=0; i < kernels.size(); i++ ) {
+        if( i ) s += ", ";
+        append_json_string(s, kernels[i]);
+    }
+    s += "], \"launch_uids\": [";
+    for( unsigned i=0; i < uids.size(); i++ ) {
+        if( i ) s += ", ";
+        append_number(s, uids[i], "null");
+    }
+    s += "], \"cycle\": ";
+    append_number(s, (double)cycle, "null");
+    s += ", \"stats\": {";
+    for( unsigned i=0; i < m_entries.size(); i++ ) {
+        const entry &e = m_entries[i];
+        if( i ) s += ", ";
+        append_json_string(s, e.name);
+        s += ": ";
+        switch( e.kind ) {
+        case STAT_COUNTER:
+            append_number(s, e.read_a(e.a, 0), "null");
+            break;
+        case STAT_RATIO: {
+            double den = e.read_b(e.b, 0);
+            append_number(s, den? e.read_a(e.a, 0) / den : NAN, "null");
+            break;
+        }
+        case STAT_HISTOGRAM:
+            s += '[';
+            for( unsigned b=0; b < e.n; b++ ) {
+                if( b ) s += ", ";
+                append_number(s, e.read_a(e.a, b), "null");
+            }
+            s += ']';
+            break;
+        case STAT_GROUP: {
+            s += '{';
+            json_object_writer w(s);
+            e.group(e.a, w);
+            s += '}';
+            break;
+        }
+        }
+    }
+    s += "}}\n";
+    write_json(s);
+}
+
+void stat_registry::write_json( const std::string &line )
+{
+    // the first kernel end truncates a file left by an earlier run
+    FILE *f = fopen(m_config.m_json_file, m_json_first_write? "w" : "a");
+    if( f == NULL ) {
+        printf("GPGPU-Sim uArch: ERROR ** could not open -gpgpu_stats_json file %s\n", m_config.m_json_file);
+        abort();
+    }
+    fwrite(line.data(), 1, line.size(), f);
+    fclose(f);
+    m_json_first_write = false;
+}
@@ -0,0 +1,118 @@
+#ifndef STAT_REGISTRY_H
+#define STAT_REGISTRY_H
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <map>
+#include "../option_parser.h"
+
+//--------------------------------------------------------------------
+// Machine-readable statistics
+//
+// Components register their counters once, by name, and the registry
+// reads them when it exports; nothing is copied on the simulation path.
+//  - counter:   one value, e.g. "gpu_sim_insn";
+//  - ratio:     num/den evaluated at export time (null when den is 0);
+//  - histogram: a fixed array of bins;
+//  - group:     a callback that writes any number of name/value pairs,
+//               for lists whose length is only known at run time.
+// Exporters:
+//  - JSON (-gpgpu_stats_json): one object per print_stats (kernel end)
+//    with the kernel names, launch uids, cycle and every statistic, one
+//    object per line (JSON Lines). Each line is appended at its kernel
+//    end, so the file is complete after every kernel.
+//  - CSV (-gpgpu_stats_csv): one row every -gpgpu_stats_interval cycles,
+//    gzip compressed like the visualizer log. Columns are fixed by the
+//    first row; histogram bins are named name[i]. Rows are buffered and
+//    appended as a gzip member at each kernel end (or every 64KB), so
+//    zcat and gzip.open read the file at any point of the run.
+//--------------------------------------------------------------------
+struct stat_registry_config {
+    void reg_options( option_parser_t opp );
+
+    bool json_enabled() const { return m_json_file && strcmp(m_json_file,"none"); }
+    bool csv_enabled() const { return m_csv_file && strcmp(m_csv_file,"none"); }
+
+    char *m_json_file;
+    char *m_csv_file;
+    unsigned long long m_interval;
+    int m_zlevel;
+};
+
+class stat_writer {
+public:
+    virtual ~stat_writer() {}
+    virtual void value( const std::string &name, double v ) = 0;
+};
+
+typedef void (*stat_group_fn)( const void *arg, stat_writer &out );
+
+class stat_registry {
+public:
+    stat_registry( const stat_registry_config &config );
+    ~stat_registry();
+
+    template<class T> void reg_counter( const std::string &name, const T *counter )
+    {
+        add(STAT_COUNTER, name, counter, read_as<T>, NULL, NULL, 1);
+    }
+    template<class T, class U> void reg_ratio( const std::string &name, const T *num, const U *den )
+    {
+        add(STAT_RATIO, name, num, read_as<T>, den, read_as<U>, 1);
+    }
+    template<class T> void reg_histogram( const std::string &name, const T *bins, unsigned n )
+    {
+        add(STAT_HISTOGRAM, name, bins, read_bin<T>, NULL, NULL, n);
+    }
+    void reg_group( const std::string &name, stat_group_fn fn, const void *arg );
+
+    bool enabled() const { return m_config.json_enabled() || m_config.csv_enabled(); }
+    // CSV row at total cycle 'cycle', if one is due
+    void sample( unsigned long long cycle )
+    {
+        if( m_config.csv_enabled() && cycle >= m_next_sample )
+            write_row(cycle);
+    }
+    // first cycle that takes a CSV row (-1 = none), bounds event skips
+    unsigned long long next_sample() const { return m_config.csv_enabled()? m_next_sample : (unsigned long long)-1; }
+    // kernel end: JSON snapshot, and the buffered CSV rows go to the file
+    void snapshot( const std::vector<std::string> &kernels, const std::vector<unsigned> &uids, unsigned long long cycle );
+
+private:
+    enum stat_kind { STAT_COUNTER, STAT_RATIO, STAT_HISTOGRAM, STAT_GROUP };
+    typedef double (*read_fn)( const void *p, unsigned i );
+    struct entry {
+        stat_kind kind;
+        std::string name;
+        const void *a;
+        read_fn read_a;
+        const void *b;
+        read_fn read_b;
+        unsigned n;
+        stat_group_fn group;
+    };
+
+    template<class T> static double read_as( const void *p, unsigned i ) { return (double)*(const T*)p; }
+    template<class T> static double read_bin( const void *p, unsigned i ) { return (double)((const T*)p)[i]; }
+    void add( stat_kind kind, const std::string &name, const void *a, read_fn read_a, const void *b, read_fn read_b, unsigned n );
+    // every statistic as flat name/value pairs (histogram bins as name[i])
+    void collect( stat_writer &out ) const;
+    void write_row( unsigned long long cycle );
+    void flush_csv();
+    void write_json( const std::string &line );
+
+    const stat_registry_config &m_config;
+    std::vector<entry> m_entries;
+
+    bool m_json_first_write;
+
+    std::vector<std::string> m_columns;
+    std::map<std::string,unsigned> m_column_index;
+    std::string m_csv_buffer;
+    bool m_csv_first_write;
+    unsigned long long m_next_sample;
+};
+
+#endif
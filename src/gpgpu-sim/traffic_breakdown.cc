@@ -38,6 +38,7 @@ std::string traffic_breakdown::classify_memfetch(class mem_fetch * mf)
    case L2_WRBK_ACC:    
    case L1_WR_ALLOC_R:  
    case L2_WR_ALLOC_R:  
+   case L2_PREFETCH_R:  
       traffic_name = mem_access_type_str(access_type); 
       break; 
    case GLOBAL_ACC_R:   
@@ -0,0 +1,186 @@
+// Host time per interconnect cycle (GPUTrafficManager::_Step) under
+// synthetic GPU traffic.
+//
+// Each network is one of the booksim examples/ configs set up the way
+// GPGPU-Sim drives it: a request and a reply subnet, shader nodes sending
+// read and write requests to memory nodes, and memory nodes answering
+// after a fixed latency. For every network it prints the packets
+// delivered, their mean round trip, a checksum of the delivery order (an
+// optimization of the step loop must leave it unchanged) and the host time
+// per interconnect cycle. Configuration parameters can be appended, e.g.
+// active_set=0 to step every router and channel each cycle, or
+// parallel_subnets=1 to step the request and reply subnets on two threads.
+//
+// build: make CREATE_LIBRARY=1 GPGPUSIM_ROOT=<root> bench/icnt_step_bench
+// usage: bench/icnt_step_bench [cycles] [requests per shader per cycle]
+//                              [config file n_shader n_mem [param=value...]]
+// (run from src/intersim2, the default networks are read from examples/)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "globals.hpp"
+#include "interconnect_interface.hpp"
+#include "intersim_config.hpp"
+#include "flit.hpp"
+#include "../../gpgpu-sim/bench/bench_rng.h"
+
+struct bench_packet {
+   Flit::FlitType type;
+   unsigned src;       // shader
+   unsigned mem;
+   unsigned long long issue;
+   unsigned long long ready;   // reply leaves the memory node
+   unsigned id;
+};
+
+// feeds the interface with bench_packets instead of mem_fetches
+class bench_interface : public InterconnectInterface {
+public:
+   bench_interface( const char *config_file, const std::vector<std::string> &params )
+   {
+      _icnt_config = new IntersimConfig();
+      _icnt_config->ParseFile(config_file);
+      for ( unsigned i=0; i < params.size(); i++ )
+         _icnt_config->ParseString(params[i]);
+      // two subnets with every VC open to every packet type, as in configs/*/*.icnt
+      int last_vc = _icnt_config->GetInt("num_vcs") - 1;
+      _icnt_config->Assign("sim_type", string("gpgpusim"));
+      _icnt_config->Assign("subnets", 2);
+      _icnt_config->Assign("use_map", 0);
+      _icnt_config->Assign("read_request_subnet", 0);
+      _icnt_config->Assign("write_request_subnet", 0);
+      _icnt_config->Assign("read_reply_subnet", 1);
+      _icnt_config->Assign("write_reply_subnet", 1);
+      const char *type[] = { "read_request", "write_request", "read_reply", "write_reply" };
+      for ( unsigned t=0; t < 4; t++ ) {
+         _icnt_config->Assign(string(type[t]) + "_begin_vc", 0);
+         _icnt_config->Assign(string(type[t]) + "_end_vc", last_vc);
+      }
+   }
+protected:
+   virtual int _GetPacketType( void *data ) const { return static_cast<bench_packet*>(data)->type; }
+};
+
+static const unsigned REQ_SIZE = 8;       // read request, write ack
+static const unsigned DATA_SIZE = 136;    // write request, read reply
+static const unsigned MEM_LATENCY = 100;  // request arrival to reply
+static const unsigned WRITE_PCT = 30;
+
+static bench_rng g_rng;
+
+struct result_t {
+   unsigned long long delivered;
+   unsigned long long round_trip;
+   unsigned long long checksum;
+   double ns_per_cycle;
+};
+
+static result_t run( const char *config_file, unsigned n_shader, unsigned n_mem, const std::vector<std::string> &params,
+                     unsigned long long cycles, double rate )
+{
+   bench_interface icnt(config_file, params);
+   g_icnt_interface = &icnt;
+   icnt.CreateInterconnect(n_shader, n_mem);
+   icnt.Init();
+
+   std::vector<bench_packet> pool(n_shader * 64);
+   std::vector<bench_packet*> free_packets;
+   for ( unsigned i=0; i < pool.size(); i++ ) {
+      pool[i].id = i;
+      free_packets.push_back(&pool[i]);
+   }
+   std::vector<std::deque<bench_packet*> > mem_queue(n_mem);
+   unsigned threshold = (unsigned)(rate * (1u << 31));
+
+   result_t r;
+   memset(&r, 0, sizeof(r));
+   g_rng.seed(1);
+   struct timespec t0, t1;
+   clock_gettime(CLOCK_MONOTONIC, &t0);
+   for ( unsigned long long now=0; now < cycles; now++ ) {
+      for ( unsigned s=0; s < n_shader && !free_packets.empty(); s++ ) {
+         if ( g_rng.next() >= threshold )
+            continue;
+         bool write = g_rng.next() % 100 < WRITE_PCT;
+         unsigned size = write? DATA_SIZE : REQ_SIZE;
+         unsigned mem = g_rng.next() % n_mem;
+         if ( !icnt.HasBuffer(s, size) )
+            continue;
+         bench_packet *p = free_packets.back();
+         free_packets.pop_back();
+         p->type = write? Flit::WRITE_REQUEST : Flit::READ_REQUEST;
+         p->src = s;
+         p->mem = mem;
+         p->issue = now;
+         icnt.Push(s, n_shader + mem, p, size);
+      }
+      for ( unsigned m=0; m < n_mem; m++ ) {
+         bench_packet *p = (bench_packet*)icnt.Pop(n_shader + m);
+         if ( p ) {
+            p->ready = now + MEM_LATENCY;
+            mem_queue[m].push_back(p);
+         }
+         if ( mem_queue[m].empty() || mem_queue[m].front()->ready > now )
+            continue;
+         p = mem_queue[m].front();
+         unsigned size = (p->type == Flit::READ_REQUEST)? DATA_SIZE : REQ_SIZE;
+         if ( !icnt.HasBuffer(n_shader + m, size) )
+            continue;
+         mem_queue[m].pop_front();
+         p->type = (p->type == Flit::READ_REQUEST)? Flit::READ_REPLY : Flit::WRITE_REPLY;
+         icnt.Push(n_shader + m, p->src, p, size);
+      }
+      for ( unsigned s=0; s < n_shader; s++ ) {
+         bench_packet *p = (bench_packet*)icnt.Pop(s);
+         if ( !p )
+            continue;
+         r.delivered++;
+         r.round_trip += now - p->issue;
+         r.checksum = r.checksum * 31 + now * 7 + p->id;
+         free_packets.push_back(p);
+      }
+      icnt.Advance();
+   }
+   clock_gettime(CLOCK_MONOTONIC, &t1);
+   double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+   r.ns_per_cycle = ns / cycles;
+   g_icnt_interface = NULL;
+   return r;
+}
+
+static void print_result( const char *name, unsigned n_shader, unsigned n_mem, const result_t &r )
+{
+   printf("%-24s %3u+%-3u delivered %9llu  round trip %7.1f  checksum %016llx  %8.1f ns/cycle\n",
+          name, n_shader, n_mem, r.delivered, r.delivered? (double)r.round_trip / r.delivered : 0.0,
+          r.checksum, r.ns_per_cycle);
+}
+
+int main( int argc, char **argv )
+{
+   unsigned long long cycles = (argc > 1)? strtoull(argv[1], NULL, 0) : 20000;
+   double rate = (argc > 2)? atof(argv[2]) : 0.1;
+   if ( argc > 5 ) {
+      std::vector<std::string> params(argv + 6, argv + argc);
+      unsigned n_shader = strtoul(argv[4], NULL, 0);
+      unsigned n_mem = strtoul(argv[5], NULL, 0);
+      print_result(argv[3], n_shader, n_mem, run(argv[3], n_shader, n_mem, params, cycles, rate));
+      return 0;
+   }
+
+   printf("%llu cycles, %.3f requests per shader per cycle\n", cycles, rate);
+   std::vector<std::string> params;
+   print_result("mesh 8x8", 56, 8, run("examples/mesh88_lat", 56, 8, params, cycles, rate));
+   params.push_back("k = 27");
+   print_result("crossbar (fly k=27 n=1)", 15, 12, run("examples/singleconfig", 15, 12, params, cycles, rate));
+   params.clear();
+   params.push_back("k = 4");
+   params.push_back("n = 3");
+   print_result("fly k=4 n=3", 56, 8, run("examples/singleconfig", 56, 8, params, cycles, rate));
+   return 0;
+}
@@ -47,6 +47,13 @@ BookSimConfig::BookSimConfig( )
   // Physical sub-networks
   _int_map["subnets"] = 1;
 
+  // Step only routers and channels that have work (1), every module (0),
+  // or every module while checking that the skipped ones were idle (2)
+  _int_map["active_set"] = 1;
+
+  // Step each subnet on its own thread (GPU traffic manager only)
+  _int_map["parallel_subnets"] = 0;
+
   //==== Topology options =======================
   AddStrField( "topology", "torus" );
   _int_map["k"] = 8; //network radix
@@ -30,15 +30,20 @@
  *A class for credits
  */
 
+#include <pthread.h>
+
 #include "booksim.hpp"
 #include "credit.hpp"
 
 stack<Credit *> Credit::_all;
-stack<Credit *> Credit::_free;
+vector<Credit::_FreeList> Credit::_free_lists(1);
+__thread int Credit::_free_list = 0;
+static pthread_mutex_t _all_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 Credit::Credit()
 {
   Reset();
+  _next = NULL;
 }
 
 void Credit::Reset()
@@ -50,20 +55,27 @@ void Credit::Reset()
 }
 
 Credit * Credit::New() {
+  _FreeList & l = _free_lists[_free_list];
   Credit * c;
-  if(_free.empty()) {
+  if(!l.head) {
     c = new Credit();
+    pthread_mutex_lock(&_all_mutex);
     _all.push(c);
+    pthread_mutex_unlock(&_all_mutex);
   } else {
-    c = _free.top();
+    c = l.head;
+    l.head = c->_next;
+    --l.count;
     c->Reset();
-    _free.pop();
   }
   return c;
 }
 
 void Credit::Free() {
-  _free.push(this);
+  _FreeList & l = _free_lists[_free_list];
+  _next = l.head;
+  l.head = this;
+  ++l.count;
 }
 
 void Credit::FreeAll() {
@@ -71,9 +83,27 @@ void Credit::FreeAll() {
     delete _all.top();
     _all.pop();
   }
+  for(size_t i = 0; i < _free_lists.size(); ++i) {
+    _free_lists[i].head = NULL;
+    _free_lists[i].count = 0;
+  }
 }
 
+void Credit::SetSubnets( int subnets ) {
+  if((int)_free_lists.size() < subnets + 1) {
+    _FreeList const empty = { NULL, 0 };
+    _free_lists.resize(subnets + 1, empty);
+  }
+}
+
+void Credit::UseSubnet( int subnet ) {
+  _free_list = subnet + 1;
+}
 
 int Credit::OutStanding(){
-  return _all.size()-_free.size();
+  int free_count = 0;
+  for(size_t i = 0; i < _free_lists.size(); ++i) {
+    free_count += _free_lists[i].count;
+  }
+  return _all.size()-free_count;
 }
@@ -30,6 +30,7 @@
 
 #include <set>
 #include <stack>
+#include <vector>
 
 class Credit {
 
@@ -46,11 +47,29 @@ public:
   static Credit * New();
   void Free();
   static void FreeAll();
+  // exact while no subnet is being stepped
   static int OutStanding();
+  // subnets that get a free list of their own
+  static void SetSubnets( int subnets );
+  // until UseSubnet(-1), New and Free of the calling thread use the free
+  // list of this subnet
+  static void UseSubnet( int subnet );
 private:
 
+  // free credits are chained through _next, so New/Free never allocate.
+  // Each subnet has its own free list (with parallel_subnets a credit lives
+  // and dies within one subnet, stepped by one thread); list 0 is used
+  // outside of subnet steps
+  Credit * _next;
+
+  struct _FreeList {
+    Credit * head;
+    int count;
+  };
+
   static stack<Credit *> _all;
-  static stack<Credit *> _free;
+  static vector<_FreeList> _free_lists;
+  static __thread int _free_list;
 
   Credit();
   ~Credit() {}
@@ -38,7 +38,7 @@
 #include "flit.hpp"
 
 stack<Flit *> Flit::_all;
-stack<Flit *> Flit::_free;
+Flit * Flit::_free = NULL;
 
 ostream& operator<<( ostream& os, const Flit& f )
 {
@@ -56,6 +56,7 @@ ostream& operator<<( ostream& os, const Flit& f )
 Flit::Flit() 
 {  
   Reset();
+  _next = NULL;
 }  
 
 void Flit::Reset() 
@@ -84,19 +85,20 @@ void Flit::Reset()
 
 Flit * Flit::New() {
   Flit * f;
-  if(_free.empty()) {
+  if(!_free) {
     f = new Flit;
     _all.push(f);
   } else {
-    f = _free.top();
+    f = _free;
+    _free = f->_next;
     f->Reset();
-    _free.pop();
   }
   return f;
 }
 
 void Flit::Free() {
-  _free.push(this);
+  _next = _free;
+  _free = this;
 }
 
 void Flit::FreeAll() {
@@ -104,4 +106,5 @@ void Flit::FreeAll() {
     delete _all.top();
     _all.pop();
   }
+  _free = NULL;
 }
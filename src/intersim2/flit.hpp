@@ -94,8 +94,11 @@ private:
   Flit();
   ~Flit() {}
 
+  // free flits are chained through _next, so New/Free never allocate
+  Flit * _next;
+
   static stack<Flit *> _all;
-  static stack<Flit *> _free;
+  static Flit * _free;
 
 };
 
@@ -28,10 +28,12 @@
 #include <sstream>
 #include <fstream>
 #include <limits> 
+#include <sched.h>
 
 #include "gputrafficmanager.hpp"
 #include "interconnect_interface.hpp"
 #include "globals.hpp"
+#include "random_utils.hpp"
 
 
 GPUTrafficManager::GPUTrafficManager( const Configuration &config, const vector<Network *> &net)
@@ -47,10 +49,93 @@ GPUTrafficManager::GPUTrafficManager( const Configuration &config, const vector<
       _input_queue[subnet][node].resize(_classes);
     }
   }
+  
+  _ejected_flits.resize(_subnets);
+  _written_flits.resize(_subnets);
+  for ( int subnet = 0; subnet < _subnets; ++subnet) {
+    _ejected_flits[subnet].resize(_nodes, NULL);
+    _written_flits[subnet].resize(_nodes, NULL);
+  }
+  
+  _step_generation = 0;
+  _subnets_done = 0;
+  _sleeping_threads = 0;
+  _stop_threads = false;
+  pthread_mutex_init(&_step_mutex, NULL);
+  pthread_cond_init(&_step_cond, NULL);
+  // each subnet draws from its own generator and keeps its own free
+  // credits, with or without parallel_subnets
+  RandomSubnets(_subnets, config.GetInt("seed"));
+  Credit::SetSubnets(_subnets);
+  if ( config.GetInt("parallel_subnets") && (_subnets > 1) ) {
+    _subnet_thread_args.resize(_subnets);
+    _subnet_threads.resize(_subnets - 1);
+    for ( int subnet = 1; subnet < _subnets; ++subnet ) {
+      _subnet_thread_args[subnet].tm = this;
+      _subnet_thread_args[subnet].subnet = subnet;
+      if ( pthread_create(&_subnet_threads[subnet - 1], NULL, _SubnetThread, &_subnet_thread_args[subnet]) ) {
+        Error("cannot create subnet thread");
+      }
+    }
+  }
 }
 
 GPUTrafficManager::~GPUTrafficManager()
 {
+  _StopSubnetThreads();
+  pthread_mutex_destroy(&_step_mutex);
+  pthread_cond_destroy(&_step_cond);
+}
+
+void * GPUTrafficManager::_SubnetThread( void * arg )
+{
+  _SubnetThreadArg * const a = static_cast<_SubnetThreadArg *>(arg);
+  a->tm->_SubnetWorker(a->subnet);
+  return NULL;
+}
+
+void GPUTrafficManager::_SubnetWorker( int subnet )
+{
+  unsigned seen = 0;
+  while ( true ) {
+    // icnt cycles usually follow each other closely: poll for a while
+    // before going to sleep until _Step wakes this thread
+    for ( int spin = 0; (_step_generation == seen) && (spin < 1000); ++spin ) {
+      sched_yield( );
+    }
+    if ( _step_generation == seen ) {
+      pthread_mutex_lock(&_step_mutex);
+      __sync_fetch_and_add(&_sleeping_threads, 1);
+      while ( _step_generation == seen ) {
+        pthread_cond_wait(&_step_cond, &_step_mutex);
+      }
+      __sync_fetch_and_sub(&_sleeping_threads, 1);
+      pthread_mutex_unlock(&_step_mutex);
+    }
+    __sync_synchronize( );
+    seen = _step_generation;
+    if ( _stop_threads ) {
+      return;
+    }
+    _StepSubnet(subnet);
+    __sync_fetch_and_add(&_subnets_done, 1);
+  }
+}
+
+void GPUTrafficManager::_StopSubnetThreads( )
+{
+  if ( _subnet_threads.empty() ) {
+    return;
+  }
+  _stop_threads = true;
+  __sync_fetch_and_add(&_step_generation, 1);
+  pthread_mutex_lock(&_step_mutex);
+  pthread_cond_broadcast(&_step_cond);
+  pthread_mutex_unlock(&_step_mutex);
+  for ( size_t i = 0; i < _subnet_threads.size(); ++i ) {
+    pthread_join(_subnet_threads[i], NULL);
+  }
+  _subnet_threads.clear();
 }
 
 void GPUTrafficManager::Init()
@@ -343,64 +428,114 @@ void GPUTrafficManager::_Step()
     cout << "WARNING: Possible network deadlock.\n";
   }
   
-  vector<map<int, Flit *> > flits(_subnets);
+  if ( _subnet_threads.empty() ) {
+    for ( int subnet = 0; subnet < _subnets; ++subnet ) {
+      _StepSubnet( subnet );
+    }
+  } else {
+    _subnets_done = 0;
+    __sync_fetch_and_add( &_step_generation, 1 );
+    if ( _sleeping_threads ) {
+      pthread_mutex_lock( &_step_mutex );
+      pthread_cond_broadcast( &_step_cond );
+      pthread_mutex_unlock( &_step_mutex );
+    }
+    _StepSubnet( 0 );
+    while ( _subnets_done < _subnets - 1 ) {
+      sched_yield( );
+    }
+    __sync_synchronize( );
+  }
   
+  // statistics and retirement are shared by the subnets, so they follow
+  // the barrier, in subnet order
   for ( int subnet = 0; subnet < _subnets; ++subnet ) {
     for ( int n = 0; n < _nodes; ++n ) {
-      Flit * const f = _net[subnet]->ReadFlit( n );
+      Flit * f = _written_flits[subnet][n];
       if ( f ) {
-        if(f->watch) {
-          *gWatchOut << GetSimTime() << " | "
-          << "node" << n << " | "
-          << "Ejecting flit " << f->id
-          << " (packet " << f->pid << ")"
-          << " from VC " << f->vc
-          << "." << endl;
+        _written_flits[subnet][n] = NULL;
+        if((_sim_state == warming_up) || (_sim_state == running)) {
+          ++_sent_flits[f->cl][n];
+          if(f->head) {
+            ++_sent_packets[f->cl][n];
+          }
         }
-        g_icnt_interface->WriteOutBuffer(subnet, n, f);
       }
-      
-      g_icnt_interface->Transfer2BoundaryBuffer(subnet, n);
-      Flit* const ejected_flit = g_icnt_interface->GetEjectedFlit(subnet, n);
-      if (ejected_flit) {
-        if(ejected_flit->head)
-          assert(ejected_flit->dest == n);
-        if(ejected_flit->watch) {
-          *gWatchOut << GetSimTime() << " | "
-          << "node" << n << " | "
-          << "Ejected flit " << ejected_flit->id
-          << " (packet " << ejected_flit->pid
-          << " VC " << ejected_flit->vc << ")"
-          << "from ejection buffer." << endl;
-        }
-        flits[subnet].insert(make_pair(n, ejected_flit));
+      f = _ejected_flits[subnet][n];
+      if ( f ) {
+        _ejected_flits[subnet][n] = NULL;
         if((_sim_state == warming_up) || (_sim_state == running)) {
-          ++_accepted_flits[ejected_flit->cl][n];
-          if(ejected_flit->tail) {
-            ++_accepted_packets[ejected_flit->cl][n];
+          ++_accepted_flits[f->cl][n];
+          if(f->tail) {
+            ++_accepted_packets[f->cl][n];
           }
         }
+        _RetireFlit(f, n);
       }
+    }
+  }
+  
+  ++_time;
+  assert(_time);
+  if(gTrace){
+    cout<<"TIME "<<_time<<endl;
+  }
+  
+}
+
+void GPUTrafficManager::_StepSubnet( int subnet )
+{
+  RandomUseSubnet( subnet );
+  Credit::UseSubnet( subnet );
+  
+  for ( int n = 0; n < _nodes; ++n ) {
+    Flit * const f = _net[subnet]->ReadFlit( n );
+    if ( f ) {
+      if(f->watch) {
+        *gWatchOut << GetSimTime() << " | "
+        << "node" << n << " | "
+        << "Ejecting flit " << f->id
+        << " (packet " << f->pid << ")"
+        << " from VC " << f->vc
+        << "." << endl;
+      }
+      g_icnt_interface->WriteOutBuffer(subnet, n, f);
+    }
     
-      // Processing the credit From the network
-      Credit * const c = _net[subnet]->ReadCredit( n );
-      if ( c ) {
+    g_icnt_interface->Transfer2BoundaryBuffer(subnet, n);
+    Flit* const ejected_flit = g_icnt_interface->GetEjectedFlit(subnet, n);
+    if (ejected_flit) {
+      if(ejected_flit->head)
+        assert(ejected_flit->dest == n);
+      if(ejected_flit->watch) {
+        *gWatchOut << GetSimTime() << " | "
+        << "node" << n << " | "
+        << "Ejected flit " << ejected_flit->id
+        << " (packet " << ejected_flit->pid
+        << " VC " << ejected_flit->vc << ")"
+        << "from ejection buffer." << endl;
+      }
+      _ejected_flits[subnet][n] = ejected_flit;
+    }
+  
+    // Processing the credit From the network
+    Credit * const c = _net[subnet]->ReadCredit( n );
+    if ( c ) {
 #ifdef TRACK_FLOWS
-        for(set<int>::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
-          int const vc = *iter;
-          assert(!_outstanding_classes[n][subnet][vc].empty());
-          int cl = _outstanding_classes[n][subnet][vc].front();
-          _outstanding_classes[n][subnet][vc].pop();
-          assert(_outstanding_credits[cl][subnet][n] > 0);
-          --_outstanding_credits[cl][subnet][n];
-        }
-#endif
-        _buf_states[n][subnet]->ProcessCredit(c);
-        c->Free();
+      for(set<int>::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
+        int const vc = *iter;
+        assert(!_outstanding_classes[n][subnet][vc].empty());
+        int cl = _outstanding_classes[n][subnet][vc].front();
+        _outstanding_classes[n][subnet][vc].pop();
+        assert(_outstanding_credits[cl][subnet][n] > 0);
+        --_outstanding_credits[cl][subnet][n];
       }
+#endif
+      _buf_states[n][subnet]->ProcessCredit(c);
+      c->Free();
     }
-    _net[subnet]->ReadInputs( );
   }
+  _net[subnet]->ReadInputs( );
 
 // GPGPUSim will generate/inject packets from interconnection interface
 #if 0
@@ -409,268 +544,251 @@ void GPUTrafficManager::_Step()
   }
 #endif
   
-  for(int subnet = 0; subnet < _subnets; ++subnet) {
+  
+  for(int n = 0; n < _nodes; ++n) {
+    
+    Flit * f = NULL;
+    
+    BufferState * const dest_buf = _buf_states[n][subnet];
+    
+    int const last_class = _last_class[n][subnet];
+    
+    int class_limit = _classes;
+    
+    if(_hold_switch_for_packet) {
+      deque<Flit *> const & pp = _input_queue[subnet][n][last_class];
+      if(!pp.empty() && !pp.front()->head &&
+         !dest_buf->IsFullFor(pp.front()->vc)) {
+        f = pp.front();
+        assert(f->vc == _last_vc[n][subnet][last_class]);
+        
+        // if we're holding the connection, we don't need to check that class
+        // again in the for loop
+        --class_limit;
+      }
+    }
     
-    for(int n = 0; n < _nodes; ++n) {
+    for(int i = 1; i <= class_limit; ++i) {
       
-      Flit * f = NULL;
+      int const c = (last_class + i) % _classes;
       
-      BufferState * const dest_buf = _buf_states[n][subnet];
+      deque<Flit *> const & pp = _input_queue[subnet][n][c];
       
-      int const last_class = _last_class[n][subnet];
+      if(pp.empty()) {
+        continue;
+      }
       
-      int class_limit = _classes;
+      Flit * const cf = pp.front();
+      assert(cf);
+      assert(cf->cl == c);
       
-      if(_hold_switch_for_packet) {
-        list<Flit *> const & pp = _input_queue[subnet][n][last_class];
-        if(!pp.empty() && !pp.front()->head &&
-           !dest_buf->IsFullFor(pp.front()->vc)) {
-          f = pp.front();
-          assert(f->vc == _last_vc[n][subnet][last_class]);
-          
-          // if we're holding the connection, we don't need to check that class
-          // again in the for loop
-          --class_limit;
-        }
+      assert(cf->subnetwork == subnet);
+      
+      if(f && (f->pri >= cf->pri)) {
+        continue;
       }
       
-      for(int i = 1; i <= class_limit; ++i) {
-        
-        int const c = (last_class + i) % _classes;
-        
-        list<Flit *> const & pp = _input_queue[subnet][n][c];
+      if(cf->head && cf->vc == -1) { // Find first available VC
         
-        if(pp.empty()) {
-          continue;
+        OutputSet route_set;
+        _rf(NULL, cf, -1, &route_set, true);
+        set<OutputSet::sSetElement> const & os = route_set.GetSet();
+        assert(os.size() == 1);
+        OutputSet::sSetElement const & se = *os.begin();
+        assert(se.output_port == -1);
+        int vc_start = se.vc_start;
+        int vc_end = se.vc_end;
+        int vc_count = vc_end - vc_start + 1;
+        if(_noq) {
+          assert(_lookahead_routing);
+          const FlitChannel * inject = _net[subnet]->GetInject(n);
+          const Router * router = inject->GetSink();
+          assert(router);
+          int in_channel = inject->GetSinkPort();
+          
+          // NOTE: Because the lookahead is not for injection, but for the
+          // first hop, we have to temporarily set cf's VC to be non-negative
+          // in order to avoid seting of an assertion in the routing function.
+          cf->vc = vc_start;
+          _rf(router, cf, in_channel, &cf->la_route_set, false);
+          cf->vc = -1;
+          
+          if(cf->watch) {
+            *gWatchOut << GetSimTime() << " | "
+            << "node" << n << " | "
+            << "Generating lookahead routing info for flit " << cf->id
+            << " (NOQ)." << endl;
+          }
+          set<OutputSet::sSetElement> const sl = cf->la_route_set.GetSet();
+          assert(sl.size() == 1);
+          int next_output = sl.begin()->output_port;
+          vc_count /= router->NumOutputs();
+          vc_start += next_output * vc_count;
+          vc_end = vc_start + vc_count - 1;
+          assert(vc_start >= se.vc_start && vc_start <= se.vc_end);
+          assert(vc_end >= se.vc_start && vc_end <= se.vc_end);
+          assert(vc_start <= vc_end);
         }
-        
-        Flit * const cf = pp.front();
-        assert(cf);
-        assert(cf->cl == c);
-        
-        assert(cf->subnetwork == subnet);
-        
-        if(f && (f->pri >= cf->pri)) {
-          continue;
+        if(cf->watch) {
+          *gWatchOut << GetSimTime() << " | " << FullName() << " | "
+          << "Finding output VC for flit " << cf->id
+          << ":" << endl;
         }
-        
-        if(cf->head && cf->vc == -1) { // Find first available VC
-          
-          OutputSet route_set;
-          _rf(NULL, cf, -1, &route_set, true);
-          set<OutputSet::sSetElement> const & os = route_set.GetSet();
-          assert(os.size() == 1);
-          OutputSet::sSetElement const & se = *os.begin();
-          assert(se.output_port == -1);
-          int vc_start = se.vc_start;
-          int vc_end = se.vc_end;
-          int vc_count = vc_end - vc_start + 1;
-          if(_noq) {
-            assert(_lookahead_routing);
-            const FlitChannel * inject = _net[subnet]->GetInject(n);
-            const Router * router = inject->GetSink();
-            assert(router);
-            int in_channel = inject->GetSinkPort();
-            
-            // NOTE: Because the lookahead is not for injection, but for the
-            // first hop, we have to temporarily set cf's VC to be non-negative
-            // in order to avoid seting of an assertion in the routing function.
-            cf->vc = vc_start;
-            _rf(router, cf, in_channel, &cf->la_route_set, false);
-            cf->vc = -1;
-            
+        for(int i = 1; i <= vc_count; ++i) {
+          int const lvc = _last_vc[n][subnet][c];
+          int const vc =
+          (lvc < vc_start || lvc > vc_end) ?
+          vc_start :
+          (vc_start + (lvc - vc_start + i) % vc_count);
+          assert((vc >= vc_start) && (vc <= vc_end));
+          if(!dest_buf->IsAvailableFor(vc)) {
             if(cf->watch) {
-              *gWatchOut << GetSimTime() << " | "
-              << "node" << n << " | "
-              << "Generating lookahead routing info for flit " << cf->id
-              << " (NOQ)." << endl;
+              *gWatchOut << GetSimTime() << " | " << FullName() << " | "
+              << "  Output VC " << vc << " is busy." << endl;
             }
-            set<OutputSet::sSetElement> const sl = cf->la_route_set.GetSet();
-            assert(sl.size() == 1);
-            int next_output = sl.begin()->output_port;
-            vc_count /= router->NumOutputs();
-            vc_start += next_output * vc_count;
-            vc_end = vc_start + vc_count - 1;
-            assert(vc_start >= se.vc_start && vc_start <= se.vc_end);
-            assert(vc_end >= se.vc_start && vc_end <= se.vc_end);
-            assert(vc_start <= vc_end);
-          }
-          if(cf->watch) {
-            *gWatchOut << GetSimTime() << " | " << FullName() << " | "
-            << "Finding output VC for flit " << cf->id
-            << ":" << endl;
-          }
-          for(int i = 1; i <= vc_count; ++i) {
-            int const lvc = _last_vc[n][subnet][c];
-            int const vc =
-            (lvc < vc_start || lvc > vc_end) ?
-            vc_start :
-            (vc_start + (lvc - vc_start + i) % vc_count);
-            assert((vc >= vc_start) && (vc <= vc_end));
-            if(!dest_buf->IsAvailableFor(vc)) {
+          } else {
+            if(dest_buf->IsFullFor(vc)) {
               if(cf->watch) {
                 *gWatchOut << GetSimTime() << " | " << FullName() << " | "
-                << "  Output VC " << vc << " is busy." << endl;
+                << "  Output VC " << vc << " is full." << endl;
               }
             } else {
-              if(dest_buf->IsFullFor(vc)) {
-                if(cf->watch) {
-                  *gWatchOut << GetSimTime() << " | " << FullName() << " | "
-                  << "  Output VC " << vc << " is full." << endl;
-                }
-              } else {
-                if(cf->watch) {
-                  *gWatchOut << GetSimTime() << " | " << FullName() << " | "
-                  << "  Selected output VC " << vc << "." << endl;
-                }
-                cf->vc = vc;
-                break;
+              if(cf->watch) {
+                *gWatchOut << GetSimTime() << " | " << FullName() << " | "
+                << "  Selected output VC " << vc << "." << endl;
               }
+              cf->vc = vc;
+              break;
             }
           }
         }
-        
-        if(cf->vc == -1) {
+      }
+      
+      if(cf->vc == -1) {
+        if(cf->watch) {
+          *gWatchOut << GetSimTime() << " | " << FullName() << " | "
+          << "No output VC found for flit " << cf->id
+          << "." << endl;
+        }
+      } else {
+        if(dest_buf->IsFullFor(cf->vc)) {
           if(cf->watch) {
             *gWatchOut << GetSimTime() << " | " << FullName() << " | "
-            << "No output VC found for flit " << cf->id
+            << "Selected output VC " << cf->vc
+            << " is full for flit " << cf->id
             << "." << endl;
           }
         } else {
-          if(dest_buf->IsFullFor(cf->vc)) {
-            if(cf->watch) {
-              *gWatchOut << GetSimTime() << " | " << FullName() << " | "
-              << "Selected output VC " << cf->vc
-              << " is full for flit " << cf->id
-              << "." << endl;
-            }
-          } else {
-            f = cf;
-          }
+          f = cf;
         }
       }
+    }
+    
+    if(f) {
       
-      if(f) {
-        
-        assert(f->subnetwork == subnet);
-        
-        int const c = f->cl;
+      assert(f->subnetwork == subnet);
+      
+      int const c = f->cl;
+      
+      if(f->head) {
         
-        if(f->head) {
-          
-          if (_lookahead_routing) {
-            if(!_noq) {
-              const FlitChannel * inject = _net[subnet]->GetInject(n);
-              const Router * router = inject->GetSink();
-              assert(router);
-              int in_channel = inject->GetSinkPort();
-              _rf(router, f, in_channel, &f->la_route_set, false);
-              if(f->watch) {
-                *gWatchOut << GetSimTime() << " | "
-                << "node" << n << " | "
-                << "Generating lookahead routing info for flit " << f->id
-                << "." << endl;
-              }
-            } else if(f->watch) {
+        if (_lookahead_routing) {
+          if(!_noq) {
+            const FlitChannel * inject = _net[subnet]->GetInject(n);
+            const Router * router = inject->GetSink();
+            assert(router);
+            int in_channel = inject->GetSinkPort();
+            _rf(router, f, in_channel, &f->la_route_set, false);
+            if(f->watch) {
               *gWatchOut << GetSimTime() << " | "
               << "node" << n << " | "
-              << "Already generated lookahead routing info for flit " << f->id
-              << " (NOQ)." << endl;
+              << "Generating lookahead routing info for flit " << f->id
+              << "." << endl;
             }
-          } else {
-            f->la_route_set.Clear();
+          } else if(f->watch) {
+            *gWatchOut << GetSimTime() << " | "
+            << "node" << n << " | "
+            << "Already generated lookahead routing info for flit " << f->id
+            << " (NOQ)." << endl;
           }
-          
-          dest_buf->TakeBuffer(f->vc);
-          _last_vc[n][subnet][c] = f->vc;
+        } else {
+          f->la_route_set.Clear();
         }
         
-        _last_class[n][subnet] = c;
-        
-        _input_queue[subnet][n][c].pop_front();
-        
+        dest_buf->TakeBuffer(f->vc);
+        _last_vc[n][subnet][c] = f->vc;
+      }
+      
+      _last_class[n][subnet] = c;
+      
+      _input_queue[subnet][n][c].pop_front();
+      
 #ifdef TRACK_FLOWS
-        ++_outstanding_credits[c][subnet][n];
-        _outstanding_classes[n][subnet][f->vc].push(c);
+      ++_outstanding_credits[c][subnet][n];
+      _outstanding_classes[n][subnet][f->vc].push(c);
 #endif
-        
-        dest_buf->SendingFlit(f);
-        
-        if(_pri_type == network_age_based) {
-          f->pri = numeric_limits<int>::max() - _time;
-          assert(f->pri >= 0);
-        }
-        
-        if(f->watch) {
-          *gWatchOut << GetSimTime() << " | "
-          << "node" << n << " | "
-          << "Injecting flit " << f->id
-          << " into subnet " << subnet
-          << " at time " << _time
-          << " with priority " << f->pri
-          << "." << endl;
-        }
-        f->itime = _time;
-        
-        // Pass VC "back"
-        if(!_input_queue[subnet][n][c].empty() && !f->tail) {
-          Flit * const nf = _input_queue[subnet][n][c].front();
-          nf->vc = f->vc;
-        }
-        
-        if((_sim_state == warming_up) || (_sim_state == running)) {
-          ++_sent_flits[c][n];
-          if(f->head) {
-            ++_sent_packets[c][n];
-          }
-        }
-        
+      
+      dest_buf->SendingFlit(f);
+      
+      if(_pri_type == network_age_based) {
+        f->pri = numeric_limits<int>::max() - _time;
+        assert(f->pri >= 0);
+      }
+      
+      if(f->watch) {
+        *gWatchOut << GetSimTime() << " | "
+        << "node" << n << " | "
+        << "Injecting flit " << f->id
+        << " into subnet " << subnet
+        << " at time " << _time
+        << " with priority " << f->pri
+        << "." << endl;
+      }
+      f->itime = _time;
+      
+      // Pass VC "back"
+      if(!_input_queue[subnet][n][c].empty() && !f->tail) {
+        Flit * const nf = _input_queue[subnet][n][c].front();
+        nf->vc = f->vc;
+      }
+      
+      _written_flits[subnet][n] = f;
+      
 #ifdef TRACK_FLOWS
-        ++_injected_flits[c][n];
+      ++_injected_flits[c][n];
 #endif
-        
-        _net[subnet]->WriteFlit(f, n);
-        
-      }
+      
+      _net[subnet]->WriteFlit(f, n);
+      
     }
   }
   //Send the credit To the network
-  for(int subnet = 0; subnet < _subnets; ++subnet) {
-    for(int n = 0; n < _nodes; ++n) {
-      map<int, Flit *>::const_iterator iter = flits[subnet].find(n);
-      if(iter != flits[subnet].end()) {
-        Flit * const f = iter->second;
-
-        f->atime = _time;
-        if(f->watch) {
-          *gWatchOut << GetSimTime() << " | "
-          << "node" << n << " | "
-          << "Injecting credit for VC " << f->vc
-          << " into subnet " << subnet
-          << "." << endl;
-        }
-        Credit * const c = Credit::New();
-        c->vc.insert(f->vc);
-        _net[subnet]->WriteCredit(c, n);
-        
+  for(int n = 0; n < _nodes; ++n) {
+    Flit * const f = _ejected_flits[subnet][n];
+    if(f) {
+      f->atime = _time;
+      if(f->watch) {
+        *gWatchOut << GetSimTime() << " | "
+        << "node" << n << " | "
+        << "Injecting credit for VC " << f->vc
+        << " into subnet " << subnet
+        << "." << endl;
+      }
+      Credit * const c = Credit::New();
+      c->vc.insert(f->vc);
+      _net[subnet]->WriteCredit(c, n);
+      
 #ifdef TRACK_FLOWS
-        ++_ejected_flits[f->cl][n];
+      ++_ejected_flits[f->cl][n];
 #endif
-        
-        _RetireFlit(f, n);
-      }
+      
     }
-    flits[subnet].clear();
-    // _InteralStep here
-    _net[subnet]->Evaluate( );
-    _net[subnet]->WriteOutputs( );
-  }
-  
-  ++_time;
-  assert(_time);
-  if(gTrace){
-    cout<<"TIME "<<_time<<endl;
   }
+  // _InteralStep here
+  _net[subnet]->Evaluate( );
+  _net[subnet]->WriteOutputs( );
   
+  RandomUseSubnet( -1 );
+  Credit::UseSubnet( -1 );
 }
 
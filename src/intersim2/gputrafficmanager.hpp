@@ -30,7 +30,8 @@
 
 #include <iostream>
 #include <vector>
-#include <list>
+#include <deque>
+#include <pthread.h>
 
 #include "config_utils.hpp"
 #include "stats.hpp"
@@ -47,8 +48,40 @@ protected:
   virtual int  _IssuePacket( int source, int cl );
   virtual void _Step();
   
+  // one cycle of one subnet: ejection into the boundary buffers, injection
+  // from _input_queue, credits and the network itself. Touches only state
+  // of that subnet; what is shared is done by _Step after every subnet ran
+  void _StepSubnet( int subnet );
+  
+  // parallel_subnets: subnets 1 and up step on their own thread while the
+  // caller of _Step steps subnet 0, with a barrier at the end of the cycle
+  struct _SubnetThreadArg {
+    GPUTrafficManager * tm;
+    int subnet;
+  };
+  static void * _SubnetThread( void * arg );
+  void _SubnetWorker( int subnet );
+  void _StopSubnetThreads( );
+  
+  vector<pthread_t> _subnet_threads;
+  vector<_SubnetThreadArg> _subnet_thread_args;
+  pthread_mutex_t _step_mutex;
+  pthread_cond_t _step_cond;
+  volatile unsigned _step_generation;   // bumped to start a cycle
+  volatile int _subnets_done;
+  volatile int _sleeping_threads;
+  volatile bool _stop_threads;
+  
   // record size of _partial_packets for each subnet
-  vector<vector<vector<list<Flit *> > > > _input_queue;
+  vector<vector<vector<deque<Flit *> > > > _input_queue;
+  
+  // flit ejected at each node this cycle, credited back at the end of _Step
+  // size: [subnets][nodes]
+  vector<vector<Flit *> > _ejected_flits;
+  
+  // flit injected at each node this cycle, counted at the end of _Step
+  // size: [subnets][nodes]
+  vector<vector<Flit *> > _written_flits;
   
 public:
   
@@ -169,17 +169,7 @@ void InterconnectInterface::Push(unsigned input_deviceID, unsigned output_device
     }
   }
 
-  //TODO: Remove mem_fetch to reduce dependency
-  Flit::FlitType packet_type;
-  mem_fetch* mf = static_cast<mem_fetch*>(data);
-
-  switch (mf->get_type()) {
-    case READ_REQUEST:  packet_type = Flit::READ_REQUEST   ;break;
-    case WRITE_REQUEST: packet_type = Flit::WRITE_REQUEST  ;break;
-    case READ_REPLY:    packet_type = Flit::READ_REPLY     ;break;
-    case WRITE_ACK:     packet_type = Flit::WRITE_REPLY    ;break;
-    default: assert (0);
-  }
+  Flit::FlitType packet_type = static_cast<Flit::FlitType>(_GetPacketType(data));
 
   //TODO: _include_queuing ?
   _traffic_manager->_GeneratePacket( input_icntID, -1, 0 /*class*/, _traffic_manager->_time, subnet, n_flits, packet_type, data, output_icntID);
@@ -190,6 +180,21 @@ void InterconnectInterface::Push(unsigned input_deviceID, unsigned output_device
 //  }
 }
 
+int InterconnectInterface::_GetPacketType(void* data) const
+{
+  //TODO: Remove mem_fetch to reduce dependency
+  mem_fetch* mf = static_cast<mem_fetch*>(data);
+
+  switch (mf->get_type()) {
+    case READ_REQUEST:  return Flit::READ_REQUEST;
+    case WRITE_REQUEST: return Flit::WRITE_REQUEST;
+    case READ_REPLY:    return Flit::READ_REPLY;
+    case WRITE_ACK:     return Flit::WRITE_REPLY;
+    default: assert (0);
+  }
+  return Flit::ANY_TYPE;
+}
+
 void* InterconnectInterface::Pop(unsigned deviceID)
 {
   int icntID = _node_map[deviceID];
@@ -250,6 +255,33 @@ bool InterconnectInterface::Busy() const
   return false;
 }
 
+bool InterconnectInterface::Idle() const
+{
+  if (Busy())
+    return false;
+  for (int s = 0; s < _subnets; ++s) {
+    for (unsigned n=0; n < (_n_shader+_n_mem); ++n) {
+      if (!_ejected_flit_queue[s][n].empty())
+        return false;
+      for (int vc=0; vc<_vcs; ++vc) {
+        if (!_ejection_buffer[s][n][vc].empty())
+          return false;
+      }
+    }
+    if (!_net[s]->Idle())
+      return false;
+  }
+  return true;
+}
+
+void InterconnectInterface::Skip(unsigned long long cycles)
+{
+  assert(Idle());
+  for (int s = 0; s < _subnets; ++s)
+    _net[s]->Skip(cycles);
+  _traffic_manager->_time += cycles;
+}
+
 bool InterconnectInterface::HasBuffer(unsigned deviceID, unsigned int size) const
 {
   bool has_buffer = false;
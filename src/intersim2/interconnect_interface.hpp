@@ -57,6 +57,9 @@ public:
   virtual void* Pop(unsigned ouput_deviceID);
   virtual void Advance();
   virtual bool Busy() const;
+  // nothing in flight or buffered, including credits; Skip() then only advances the clock
+  virtual bool Idle() const;
+  virtual void Skip(unsigned long long cycles);
   virtual bool HasBuffer(unsigned deviceID, unsigned int size) const;
   virtual void DisplayStats() const;
   virtual void DisplayOverallStats() const;
@@ -92,6 +95,9 @@ protected:
   };
   typedef queue<Flit*> _EjectionBufferItem;
   
+  // Flit::FlitType of the packet carrying data (a mem_fetch in GPGPU-Sim)
+  virtual int _GetPacketType(void* data) const;
+  
   void _CreateBuffer( );
   void _CreateNodeMap(unsigned n_shader, unsigned n_mem, unsigned n_node, int use_map);
   void _DisplayMap(int dim,int count);
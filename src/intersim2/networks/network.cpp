@@ -56,6 +56,9 @@ Network::Network( const Configuration &config, const string & name ) :
   _nodes    = -1; 
   _channels = -1;
   _classes  = config.GetInt("classes");
+  _active_set = config.GetInt("active_set");
+  _active_set_ready = false;
+  _cycle = 0;
 }
 
 Network::~Network( )
@@ -179,8 +182,57 @@ void Network::_Alloc( )
   }
 }
 
+void Network::_InitActiveSet( )
+{
+  _active.assign(_timed_modules.begin(), _timed_modules.end());
+  for(size_t i = 0; i < _active.size(); ++i) {
+    _active[i]->SetWakeList(&_woken);
+  }
+  _active_set_ready = true;
+}
+
+// modules woken during the last cycle join the active set; with active_set
+// 1 a router catches up on the clock edges it slept through
+void Network::_MergeWoken( )
+{
+  for(size_t i = 0; i < _woken.size(); ++i) {
+    TimedModule * const m = _woken[i];
+    if(_active_set == 1) {
+      m->Skip(_cycle - m->SleepCycle() - 1);
+    }
+    _active.push_back(m);
+  }
+  _woken.clear();
+}
+
+// a sleeping module with work means a missing Wake(), so stepping only the
+// active set would not match stepping every module
+void Network::_CheckSleeping( ) const
+{
+  for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
+      iter != _timed_modules.end();
+      ++iter) {
+    if(!(*iter)->Awake() && !(*iter)->Idle()) {
+      (*iter)->Error("active_set: module has work but is asleep");
+    }
+  }
+}
+
 void Network::ReadInputs( )
 {
+  if(_active_set) {
+    if(!_active_set_ready) {
+      _InitActiveSet( );
+    }
+    _MergeWoken( );
+    if(_active_set == 1) {
+      for(size_t i = 0; i < _active.size(); ++i) {
+        _active[i]->ReadInputs( );
+      }
+      return;
+    }
+    _CheckSleeping( );
+  }
   for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
       iter != _timed_modules.end();
       ++iter) {
@@ -190,6 +242,15 @@ void Network::ReadInputs( )
 
 void Network::Evaluate( )
 {
+  if(_active_set == 1) {
+    for(size_t i = 0; i < _active.size(); ++i) {
+      _active[i]->Evaluate( );
+    }
+    return;
+  }
+  if(_active_set) {
+    _CheckSleeping( );
+  }
   for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
       iter != _timed_modules.end();
       ++iter) {
@@ -199,11 +260,79 @@ void Network::Evaluate( )
 
 void Network::WriteOutputs( )
 {
-  for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
-      iter != _timed_modules.end();
-      ++iter) {
-    (*iter)->WriteOutputs( );
+  if(_active_set == 1) {
+    for(size_t i = 0; i < _active.size(); ++i) {
+      _active[i]->WriteOutputs( );
+    }
+  } else {
+    if(_active_set) {
+      _CheckSleeping( );
+    }
+    for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
+        iter != _timed_modules.end();
+        ++iter) {
+      (*iter)->WriteOutputs( );
+    }
+  }
+  if(_active_set) {
+    // put the modules that ran out of work to sleep
+    size_t n = 0;
+    for(size_t i = 0; i < _active.size(); ++i) {
+      TimedModule * const m = _active[i];
+      if(!m->TrySleep(_cycle)) {
+        _active[n++] = m;
+      }
+    }
+    _active.resize(n);
+  }
+  ++_cycle;
+}
+
+template<class T>
+static bool _ChannelsIdle( vector<T *> const & channels )
+{
+  for(size_t i = 0; i < channels.size(); ++i) {
+    if(!channels[i]->Idle( )) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Network::Idle( ) const
+{
+  if(_active_set_ready) {
+    // sleeping modules are idle
+    for(size_t i = 0; i < _active.size(); ++i) {
+      if(!_active[i]->Idle( )) {
+        return false;
+      }
+    }
+    return _woken.empty();
+  }
+  for(size_t r = 0; r < _routers.size(); ++r) {
+    if(!_routers[r]->Idle( )) {
+      return false;
+    }
+  }
+  return _ChannelsIdle(_inject) && _ChannelsIdle(_inject_cred) &&
+    _ChannelsIdle(_eject) && _ChannelsIdle(_eject_cred) &&
+    _ChannelsIdle(_chan) && _ChannelsIdle(_chan_cred);
+}
+
+void Network::Skip( int cycles )
+{
+  if(_active_set == 1 && _active_set_ready) {
+    // sleeping routers catch up when woken
+    for(size_t i = 0; i < _active.size(); ++i) {
+      _active[i]->Skip(cycles);
+    }
+  } else {
+    for(size_t r = 0; r < _routers.size(); ++r) {
+      _routers[r]->Skip(cycles);
+    }
   }
+  _cycle += cycles;
 }
 
 void Network::WriteFlit( Flit *f, int source )
@@ -66,6 +66,18 @@ protected:
 
   deque<TimedModule *> _timed_modules;
 
+  // active-set scheduling (config active_set): modules with work are in
+  // _active, the others sleep until a channel wakes them into _woken
+  int _active_set;
+  bool _active_set_ready;
+  int _cycle;
+  vector<TimedModule *> _active;
+  vector<TimedModule *> _woken;
+
+  void _InitActiveSet( );
+  void _MergeWoken( );
+  void _CheckSleeping( ) const;
+
   virtual void _ComputeSize( const Configuration &config ) = 0;
   virtual void _BuildNet( const Configuration &config ) = 0;
 
@@ -94,6 +106,11 @@ public:
   virtual void Evaluate( );
   virtual void WriteOutputs( );
 
+  // no flit or credit anywhere in the network
+  bool Idle( ) const;
+  // advance an idle network by the given number of cycles
+  void Skip( int cycles );
+
   void Display( ostream & os = cout ) const;
   void DumpChannelMap( ostream & os = cout, string const & prefix = "" ) const;
   void DumpNodeMap( ostream & os = cout, string const & prefix = "" ) const;
@@ -33,12 +33,30 @@ void   ran_start(long seed);
 long   ran_next( );
 void   ranf_start(long seed);
 double ranf_next( );
+void   ran_subnets_start( int subnets, long seed );
+void   ran_use_subnet( int subnet );
+void   ranf_subnets_start( int subnets, long seed );
+void   ranf_use_subnet( int subnet );
 
 inline void RandomSeed( long seed ) {
   ran_start( seed );
   ranf_start( seed );
 }
 
+// Seeds one generator per subnet from the seed and the subnet id
+inline void RandomSubnets( int subnets, long seed ) {
+  ran_subnets_start( subnets, seed );
+  ranf_subnets_start( subnets, seed );
+}
+
+// Until RandomUseSubnet(-1), the calling thread draws from the generator of
+// this subnet, so runs repeat whether or not subnets step on their own
+// threads (parallel_subnets)
+inline void RandomUseSubnet( int subnet ) {
+  ran_use_subnet( subnet );
+  ranf_use_subnet( subnet );
+}
+
 inline unsigned long RandomIntLong( ) {
   return ran_next( );
 }
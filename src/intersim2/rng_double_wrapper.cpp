@@ -25,10 +25,61 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <string.h>
+#include <vector>
+
 #define main rng_double_main
 #include "rng-double.c"
 
+// a generator of its own for each subnet, as in rng_wrapper.cpp
+struct ranf_stream {
+  double u[KK];
+  double buf[QUALITY];
+  double *ptr;   // next number in buf, NULL before the first draw
+};
+
+static std::vector<ranf_stream> ranf_streams;
+static __thread ranf_stream *ranf_cur = NULL;
+
+void ranf_subnets_start( int subnets, long seed )
+{
+  // ranf_start() seeds the global generator, whose state is kept aside
+  std::vector<double> u(ran_u, ran_u + KK);
+  std::vector<double> buf(ranf_arr_buf, ranf_arr_buf + QUALITY);
+  double *ptr = ranf_arr_ptr;
+  ranf_streams.resize( subnets );
+  for ( int s = 0; s < subnets; ++s ) {
+    ranf_start( (seed + 1 + s) & 0x3fffffff );
+    memcpy( ranf_streams[s].u, ran_u, sizeof(ran_u) );
+    ranf_streams[s].ptr = NULL;
+  }
+  memcpy( ran_u, &u[0], sizeof(ran_u) );
+  memcpy( ranf_arr_buf, &buf[0], sizeof(ranf_arr_buf) );
+  ranf_arr_ptr = ptr;
+}
+
+void ranf_use_subnet( int subnet )
+{
+  ranf_cur = (subnet < 0) ? NULL : &ranf_streams[subnet];
+}
+
 double ranf_next( )
 {
-  return ranf_arr_next( );
+  if ( !ranf_cur ) {
+    return ranf_arr_next( );
+  }
+  ranf_stream &s = *ranf_cur;
+  if ( s.ptr && (*s.ptr >= 0) ) {
+    return *s.ptr++;
+  }
+  // ranf_arr_cycle() and ranf_array() on the state of the stream
+  double *aa = s.buf;
+  int i, j;
+  for ( j = 0; j < KK; j++ ) aa[j] = s.u[j];
+  for ( ; j < QUALITY; j++ ) aa[j] = mod_sum(aa[j-KK], aa[j-LL]);
+  for ( i = 0; i < LL; i++, j++ ) s.u[i] = mod_sum(aa[j-KK], aa[j-LL]);
+  for ( ; i < KK; i++, j++ ) s.u[i] = mod_sum(aa[j-KK], s.u[i-LL]);
+  s.buf[KK] = -1;
+  s.ptr = s.buf + 1;
+  return s.buf[0];
 }
@@ -25,10 +25,62 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <string.h>
+#include <vector>
+
 #define main rng_main
 #include "rng.c"
 
+// a generator of its own for each subnet (ran_subnets_start); the numbers a
+// subnet draws then do not depend on which thread steps the other subnets
+struct ran_stream {
+  long x[KK];
+  long buf[QUALITY];
+  long *ptr;   // next number in buf, NULL before the first draw
+};
+
+static std::vector<ran_stream> ran_streams;
+static __thread ran_stream *ran_cur = NULL;
+
+void ran_subnets_start( int subnets, long seed )
+{
+  // ran_start() seeds the global generator, whose state is kept aside
+  std::vector<long> x(ran_x, ran_x + KK);
+  std::vector<long> buf(ran_arr_buf, ran_arr_buf + QUALITY);
+  long *ptr = ran_arr_ptr;
+  ran_streams.resize( subnets );
+  for ( int s = 0; s < subnets; ++s ) {
+    ran_start( (seed + 1 + s) & (MM - 1) );
+    memcpy( ran_streams[s].x, ran_x, sizeof(ran_x) );
+    ran_streams[s].ptr = NULL;
+  }
+  memcpy( ran_x, &x[0], sizeof(ran_x) );
+  memcpy( ran_arr_buf, &buf[0], sizeof(ran_arr_buf) );
+  ran_arr_ptr = ptr;
+}
+
+void ran_use_subnet( int subnet )
+{
+  ran_cur = (subnet < 0) ? NULL : &ran_streams[subnet];
+}
+
 long ran_next( )
 {
-  return ran_arr_next( );
+  if ( !ran_cur ) {
+    return ran_arr_next( );
+  }
+  ran_stream &s = *ran_cur;
+  if ( s.ptr && (*s.ptr >= 0) ) {
+    return *s.ptr++;
+  }
+  // ran_arr_cycle() and ran_array() on the state of the stream
+  long *aa = s.buf;
+  int i, j;
+  for ( j = 0; j < KK; j++ ) aa[j] = s.x[j];
+  for ( ; j < QUALITY; j++ ) aa[j] = mod_diff(aa[j-KK], aa[j-LL]);
+  for ( i = 0; i < LL; i++, j++ ) s.x[i] = mod_diff(aa[j-KK], aa[j-LL]);
+  for ( ; i < KK; i++, j++ ) s.x[i] = mod_diff(aa[j-KK], s.x[i-LL]);
+  s.buf[KK] = -1;
+  s.ptr = s.buf + 1;
+  return s.buf[0];
 }
@@ -282,6 +282,19 @@ void IQRouter::_InternalStep( )
   _switchMonitor->cycle( );
 }
 
+bool IQRouter::Idle( ) const
+{
+  if(_active || !_in_queue_flits.empty() || !_proc_credits.empty() || !_out_queue_credits.empty())
+    return false;
+  for(int output = 0; output < _outputs; ++output)
+    if(!_output_buffer[output].empty())
+      return false;
+  for(int input = 0; input < _inputs; ++input)
+    if(!_credit_buffer[input].empty())
+      return false;
+  return true;
+}
+
 void IQRouter::WriteOutputs( )
 {
   _SendFlits( );
@@ -160,6 +160,7 @@ public:
 
   virtual void ReadInputs( );
   virtual void WriteOutputs( );
+  virtual bool Idle( ) const;
   
   void Display( ostream & os = cout ) const;
 
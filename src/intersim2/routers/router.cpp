@@ -92,6 +92,7 @@ void Router::AddInputChannel( FlitChannel *channel, CreditChannel *backchannel )
   _input_channels.push_back( channel );
   _input_credits.push_back( backchannel );
   channel->SetSink( this, _input_channels.size() - 1 ) ;
+  channel->SetReceiver( this );
 }
 
 void Router::AddOutputChannel( FlitChannel *channel, CreditChannel *backchannel )
@@ -100,6 +101,7 @@ void Router::AddOutputChannel( FlitChannel *channel, CreditChannel *backchannel
   _output_credits.push_back( backchannel );
   _channel_faults.push_back( false );
   channel->SetSource( this, _output_channels.size() - 1 ) ;
+  backchannel->SetReceiver( this );
 }
 
 void Router::Evaluate( )
@@ -111,6 +113,19 @@ void Router::Evaluate( )
   }
 }
 
+void Router::Skip( int cycles )
+{
+  if( _internal_speedup == 1.0 ) {
+    return;
+  }
+  for( int i = 0; i < cycles; ++i ) {
+    _partial_internal_cycles += _internal_speedup;
+    while( _partial_internal_cycles >= 1.0 ) {
+      _partial_internal_cycles -= 1.0;
+    }
+  }
+}
+
 void Router::OutChannelFault( int c, bool fault )
 {
   assert( ( c >= 0 ) && ( (size_t)c < _channel_faults.size( ) ) );
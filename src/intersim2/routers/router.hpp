@@ -113,6 +113,11 @@ public:
 
   virtual void ReadInputs( ) = 0;
   virtual void Evaluate( );
+
+  // Idle(): no flit or credit inside the router, so stepping it only
+  // advances the internal clock, which Skip() does in bulk
+  virtual bool Idle( ) const { return false; }
+  virtual void Skip( int cycles );
   virtual void WriteOutputs( ) = 0;
 
   void OutChannelFault( int c, bool fault = true );
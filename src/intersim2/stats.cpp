@@ -114,6 +114,21 @@ void Stats::AddSample( double val )
   _hist[b]++;
 }
 
+void Stats::AddSample( double val, int count )
+{
+  if ( count <= 0 ) return;
+  _num_samples += count;
+  _sample_sum += val * count;
+
+  _max = !(val <= _max) ? val : _max;
+  _min = !(val >= _min) ? val : _min;
+
+  int b = (int)fmax(floor( val / _bin_size ), 0.0);
+  b = (b >= _num_bins) ? (_num_bins - 1) : b;
+
+  _hist[b] += count;
+}
+
 void Stats::Display( ostream & os ) const
 {
   os << *this << endl;
@@ -62,6 +62,8 @@ public:
   inline void AddSample( int val ) {
     AddSample( (double)val );
   }
+  // count samples of the same value (exact for integer values)
+  void AddSample( double val, int count );
 
   int GetBin(int b){ return _hist[b];}
 
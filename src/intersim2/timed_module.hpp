@@ -28,17 +28,55 @@
 #ifndef _TIMED_MODULE_HPP_
 #define _TIMED_MODULE_HPP_
 
+#include <vector>
+
 #include "module.hpp"
 
 class TimedModule : public Module {
 
 public:
-  TimedModule(Module * parent, string const & name) : Module(parent, name) {}
+  TimedModule(Module * parent, string const & name)
+    : Module(parent, name), _wake_list(NULL), _awake(true), _woken(false), _sleep_cycle(0) {}
   virtual ~TimedModule() {}
   
   virtual void ReadInputs() = 0;
   virtual void Evaluate() = 0;
   virtual void WriteOutputs() = 0;
+
+  // nothing to do until new input arrives: stepping the module only
+  // advances its clock, which Skip() does in bulk
+  virtual bool Idle() const { return false; }
+  virtual void Skip(int cycles) {}
+
+  // Active-set scheduling (see Network): an idle module is put to sleep
+  // and is not stepped until whoever hands it input calls Wake(). Input
+  // handed to a module that is still awake but looks idle (it has not
+  // read it yet) keeps it awake for another cycle.
+  void SetWakeList(vector<TimedModule *> * wake_list) { _wake_list = wake_list; }
+  inline void Wake() {
+    _woken = true;
+    if(!_awake) {
+      _awake = true;
+      _wake_list->push_back(this);
+    }
+  }
+  inline bool Awake() const { return _awake; }
+  inline bool TrySleep(int cycle) {
+    if(_woken || !Idle()) {
+      _woken = false;
+      return false;
+    }
+    _awake = false;
+    _sleep_cycle = cycle;
+    return true;
+  }
+  inline int SleepCycle() const { return _sleep_cycle; }
+
+private:
+  vector<TimedModule *> * _wake_list;
+  bool _awake;
+  bool _woken;
+  int _sleep_cycle;
 };
 
 #endif
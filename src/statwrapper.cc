@@ -18,6 +18,11 @@ void StatAddSample (void * st, int val)
    ((Stats *)st)->AddSample(val);
 }
 
+void StatAddSamples (void * st, int val, int count)
+{
+   ((Stats *)st)->AddSample((double)val, count);
+}
+
 double StatAverage(void * st) 
 {
    return((Stats *)st)->Average();
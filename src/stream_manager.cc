@@ -154,9 +154,19 @@ void stream_operation::do_operation( gpgpu_sim *gpu )
         if( gpu->can_start_kernel() ) {
         	gpu->set_cache_config(m_kernel->name());
         	printf("kernel \'%s\' transfer to GPU hardware scheduler\n", m_kernel->name().c_str() );
-            if( m_sim_mode )
+            launch_skip_t skip = gpu->get_checkpoint()->skip_kernel( *m_kernel );
+            if( skip == LAUNCH_TIMED )
+                skip = gpu->get_snapshot()->skip_kernel( *m_kernel );
+            if( skip == LAUNCH_COVERED ) {
+                extern stream_manager *g_stream_manager;
+                g_stream_manager->register_finished_kernel( m_kernel->get_uid() );
+            } else if( m_sim_mode || skip == LAUNCH_FUNCTIONAL )
                 gpgpu_cuda_ptx_sim_main_func( *m_kernel );
-            else
+            else if( gpu->get_sampler()->fast_forward_kernel( *m_kernel ) ) {
+                extern stream_manager *g_stream_manager;
+                gpu->get_sampler()->fast_forward( *m_kernel );
+                g_stream_manager->register_finished_kernel( m_kernel->get_uid() );
+            } else
                 gpu->launch( m_kernel );
         }
         break;